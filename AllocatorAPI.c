@@ -0,0 +1,746 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "AllocatorAPI.h"
+
+//Memory policies of mbind, from linux/mempolicy.h
+#define PAGE_MPOL_PREFERRED 1
+#define PAGE_MPOL_INTERLEAVE 3
+
+/**
+ * Free object of a slab, the link is stored in the object itself
+ */
+typedef struct slabObject {
+    struct slabObject* next;
+} SlabObject;
+
+/**
+ * Free objects of one size class
+ */
+typedef struct slabCache {
+    SlabObject* head;
+    int count;
+} SlabCache;
+
+/**
+ * One mmap region of a page allocator, a chunk or a large object
+ */
+typedef struct pageMapping {
+    struct pageMapping* next;
+    void* memory;
+    size_t length;
+    PageBacking backing;    //What the system granted, not what the policy asked for
+    bool placed;    //Placed by mbind
+} PageMapping;
+
+/**
+ * State of a page allocator
+ */
+typedef struct pageAllocator {
+    Allocator allocator;
+    PagePolicy policy;
+    PageMapping* chunks;
+    PageMapping* large;
+    unsigned char* chunkNext;    //Unused part of the newest chunk
+    size_t chunkLeft;
+    SlabObject* freeLists[PAGE_SMALL_MAX_BYTES / SLAB_CLASS_BYTES];
+    unsigned long nodeMask[PAGE_MAX_NUMA_NODES / (8 * sizeof(unsigned long))];    //Nodes mbind places memory on
+    PageStats stats;
+} PageAllocator;
+
+static void* slabAlloc(void* state, size_t size);
+static void slabRelease(void* state, void* toRelease, size_t size);
+static void* pageAlloc(void* state, size_t size);
+
+static Allocator slabAllocator = {slabAlloc, slabRelease, NULL, NULL, NULL};
+
+//Objects given back by threads that had too many or exited, and the slabs themselves
+static pthread_mutex_t slabLock = PTHREAD_MUTEX_INITIALIZER;
+static SlabCache sharedCaches[SLAB_CLASSES];
+
+static _Thread_local SlabCache threadCaches[SLAB_CLASSES];
+static _Thread_local bool threadRegistered = false;
+
+static pthread_key_t flushKey;
+static pthread_once_t flushKeyOnce = PTHREAD_ONCE_INIT;
+
+void* allocatorAlloc(Allocator* allocator, size_t size) {
+    if (allocator == NULL) {
+        return malloc(size);
+    }
+
+    return allocator->alloc(allocator->state, size);
+}
+
+void allocatorRelease(Allocator* allocator, void* toRelease, size_t size) {
+    if (toRelease == NULL) {
+        return;
+    }
+
+    if (allocator == NULL) {
+        free(toRelease);
+    }
+    else if (allocator->release != NULL) {
+        allocator->release(allocator->state, toRelease, size);
+    }
+}
+
+void* allocatorAllocBulk(Allocator* allocator, size_t size) {
+    if (allocator == NULL || allocator->allocBulk == NULL) {
+        return malloc(size);
+    }
+
+    return allocator->allocBulk(allocator->state, size);
+}
+
+void allocatorReleaseBulk(Allocator* allocator, void* toRelease, size_t size) {
+    if (toRelease == NULL) {
+        return;
+    }
+
+    if (allocator == NULL || allocator->releaseBulk == NULL) {
+        free(toRelease);
+    }
+    else {
+        allocator->releaseBulk(allocator->state, toRelease, size);
+    }
+}
+
+bool allocatorReleasesEach(Allocator* allocator) {
+    return allocator == NULL || allocator->release != NULL;
+}
+
+size_t allocatorFootprint(Allocator* allocator, size_t size) {
+    if (allocator == NULL) {
+#ifdef __GLIBC__
+        //One size_t header, 16 byte granularity and a 32 byte minimum chunk
+        size_t chunk = (size + sizeof(size_t) + 15) & ~(size_t)15;
+        return chunk < 32 ? 32 : chunk;
+#else
+        return size;
+#endif
+    }
+
+    if (allocator->alloc == slabAlloc && size > 0 && size <= SLAB_MAX_BYTES) {
+        return (size + SLAB_CLASS_BYTES - 1) / SLAB_CLASS_BYTES * SLAB_CLASS_BYTES;
+    }
+
+    if (allocator->alloc == pageAlloc) {
+        if (size > PAGE_SMALL_MAX_BYTES) {
+            return allocatorBulkFootprint(allocator, size);
+        }
+        return size == 0 ? SLAB_CLASS_BYTES : (size + SLAB_CLASS_BYTES - 1) / SLAB_CLASS_BYTES * SLAB_CLASS_BYTES;
+    }
+
+    //Arenas keep objects 16 byte aligned, other allocators are assumed exact
+    return allocator->release == NULL ? (size + 15) & ~(size_t)15 : size;
+}
+
+size_t allocatorBulkFootprint(Allocator* allocator, size_t size) {
+    if (allocator == NULL || allocator->allocBulk == NULL) {
+        return allocatorFootprint(NULL, size);
+    }
+
+    //Bulk arrays are whole mappings, huge pages only once they fill one
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    if (allocator->alloc == pageAlloc) {
+        PageAllocator* pages = allocator->state;
+        if (pages->policy.backing != PAGES_SMALL && size >= pages->stats.hugePageBytes) {
+            page = pages->stats.hugePageBytes;
+        }
+    }
+
+    return (size + page - 1) / page * page;
+}
+
+/**
+ * Hands every object cached by an exiting thread back to the shared pool
+ * @param void* unused pthread key value
+ * @return void
+ */
+static void flushThreadCaches(void* unused) {
+    (void)unused;
+
+    pthread_mutex_lock(&slabLock);
+    for (int i = 0; i < SLAB_CLASSES; i++) {
+        SlabCache* cache = &threadCaches[i];
+        while (cache->head != NULL) {
+            SlabObject* object = cache->head;
+            cache->head = object->next;
+            object->next = sharedCaches[i].head;
+            sharedCaches[i].head = object;
+            sharedCaches[i].count++;
+        }
+        cache->count = 0;
+    }
+    pthread_mutex_unlock(&slabLock);
+}
+
+static void createFlushKey(void) {
+    pthread_key_create(&flushKey, flushThreadCaches);
+}
+
+/**
+ * Makes sure the calling thread's caches are flushed when it exits
+ * @return void
+ */
+static void registerThread(void) {
+    pthread_once(&flushKeyOnce, createFlushKey);
+    //Any non NULL value makes the destructor run
+    pthread_setspecific(flushKey, &threadRegistered);
+    threadRegistered = true;
+}
+
+/**
+ * Fills an empty thread cache, first from the shared pool and otherwise by
+ * carving a new slab. Must be called with slabLock held.
+ * @param int sizeClass
+ * @return false if a new slab could not be allocated
+ */
+static bool refillCache(int sizeClass) {
+    SlabCache* cache = &threadCaches[sizeClass];
+    SlabCache* shared = &sharedCaches[sizeClass];
+
+    if (shared->head != NULL) {
+        //Move at most half a cache worth so one thread does not drain the pool
+        while (shared->head != NULL && cache->count < SLAB_CACHE_LIMIT / 2) {
+            SlabObject* object = shared->head;
+            shared->head = object->next;
+            shared->count--;
+            object->next = cache->head;
+            cache->head = object;
+            cache->count++;
+        }
+        return true;
+    }
+
+    size_t objectSize = (size_t)(sizeClass + 1) * SLAB_CLASS_BYTES;
+    unsigned char* slab = aligned_alloc(SLAB_CLASS_BYTES, SLAB_BYTES);
+    if (slab == NULL) {
+        return false;
+    }
+
+    //Link from the back so objects are handed out in address order
+    size_t numObjects = SLAB_BYTES / objectSize;
+    for (size_t i = numObjects; i > 0; i--) {
+        SlabObject* object = (SlabObject*)(slab + (i - 1) * objectSize);
+        object->next = cache->head;
+        cache->head = object;
+        cache->count++;
+    }
+
+    return true;
+}
+
+static void* slabAlloc(void* state, size_t size) {
+    (void)state;
+
+    if (size == 0 || size > SLAB_MAX_BYTES) {
+        return malloc(size);
+    }
+
+    int sizeClass = (int)((size - 1) / SLAB_CLASS_BYTES);
+    SlabCache* cache = &threadCaches[sizeClass];
+
+    if (cache->head == NULL) {
+        if (!threadRegistered) {
+            registerThread();
+        }
+
+        pthread_mutex_lock(&slabLock);
+        bool refilled = refillCache(sizeClass);
+        pthread_mutex_unlock(&slabLock);
+
+        if (!refilled) {
+            return NULL;
+        }
+    }
+
+    SlabObject* object = cache->head;
+    cache->head = object->next;
+    cache->count--;
+
+    return object;
+}
+
+static void slabRelease(void* state, void* toRelease, size_t size) {
+    (void)state;
+
+    if (size == 0 || size > SLAB_MAX_BYTES) {
+        free(toRelease);
+        return;
+    }
+
+    int sizeClass = (int)((size - 1) / SLAB_CLASS_BYTES);
+    SlabCache* cache = &threadCaches[sizeClass];
+
+    //A thread that only frees must still give its cache back when it exits
+    if (!threadRegistered) {
+        registerThread();
+    }
+
+    SlabObject* object = toRelease;
+    object->next = cache->head;
+    cache->head = object;
+    cache->count++;
+
+    if (cache->count <= SLAB_CACHE_LIMIT) {
+        return;
+    }
+
+    //Give half back so a thread that only frees does not hoard memory
+    SlabCache* shared = &sharedCaches[sizeClass];
+    pthread_mutex_lock(&slabLock);
+    while (cache->count > SLAB_CACHE_LIMIT / 2) {
+        object = cache->head;
+        cache->head = object->next;
+        cache->count--;
+        object->next = shared->head;
+        shared->head = object;
+        shared->count++;
+    }
+    pthread_mutex_unlock(&slabLock);
+}
+
+Allocator* getSlabAllocator(void) {
+    return &slabAllocator;
+}
+
+/**
+ * Allocates a chunk able to hold at least size bytes
+ * @param size_t capacity
+ * @return the chunk, NULL on failure
+ */
+static ArenaChunk* createArenaChunk(size_t capacity) {
+    ArenaChunk* chunk = malloc(sizeof(ArenaChunk) + capacity);
+    if (chunk == NULL) {
+        return NULL;
+    }
+
+    chunk->next = NULL;
+    chunk->used = 0;
+    chunk->capacity = capacity;
+
+    return chunk;
+}
+
+static void* arenaAlloc(void* state, size_t size) {
+    Arena* arena = state;
+
+    //Keep every object 16 byte aligned
+    size = (size + 15) & ~(size_t)15;
+    if (size == 0) {
+        size = 16;
+    }
+
+    ArenaChunk* chunk = arena->chunks;
+    if (chunk == NULL || chunk->capacity - chunk->used < size) {
+        ArenaChunk* newChunk = createArenaChunk(size > arena->chunkSize ? size : arena->chunkSize);
+        if (newChunk == NULL) {
+            return NULL;
+        }
+        newChunk->next = chunk;
+        arena->chunks = newChunk;
+        chunk = newChunk;
+    }
+
+    void* memory = chunk->memory + chunk->used;
+    chunk->used += size;
+
+    return memory;
+}
+
+Allocator* createArenaAllocator(size_t chunkSize) {
+    Arena* arena = malloc(sizeof(Arena));
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    arena->chunkSize = chunkSize == 0 ? ARENA_DEFAULT_CHUNK_BYTES : (chunkSize + 15) & ~(size_t)15;
+    arena->chunks = NULL;
+    arena->allocator.alloc = arenaAlloc;
+    arena->allocator.release = NULL;
+    arena->allocator.state = arena;
+    arena->allocator.allocBulk = NULL;
+    arena->allocator.releaseBulk = NULL;
+
+    return &arena->allocator;
+}
+
+void resetArenaAllocator(Allocator* arena) {
+    if (arena == NULL) {
+        return;
+    }
+
+    Arena* theArena = arena->state;
+    ArenaChunk* chunk = theArena->chunks;
+    if (chunk == NULL) {
+        return;
+    }
+
+    //The newest chunk is first, keep it if it is a regular sized one
+    ArenaChunk* kept = NULL;
+    while (chunk != NULL) {
+        ArenaChunk* next = chunk->next;
+        if (kept == NULL && chunk->capacity == theArena->chunkSize) {
+            kept = chunk;
+            kept->next = NULL;
+            kept->used = 0;
+        }
+        else {
+            free(chunk);
+        }
+        chunk = next;
+    }
+
+    theArena->chunks = kept;
+}
+
+void destroyArenaAllocator(Allocator* arena) {
+    if (arena == NULL) {
+        return;
+    }
+
+    Arena* theArena = arena->state;
+    ArenaChunk* chunk = theArena->chunks;
+    while (chunk != NULL) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    free(theArena);
+}
+
+/**
+ * Reads the default huge page size from /proc/meminfo
+ * @return the size in bytes, 2MB if it cannot be read
+ */
+static size_t readHugePageBytes(void) {
+    size_t bytes = 2 * 1024 * 1024;
+    FILE* meminfo = fopen("/proc/meminfo", "r");
+    if (meminfo == NULL) {
+        return bytes;
+    }
+
+    char line[128];
+    size_t kilobytes;
+    while (fgets(line, sizeof(line), meminfo) != NULL) {
+        if (sscanf(line, "Hugepagesize: %zu kB", &kilobytes) == 1) {
+            bytes = kilobytes * 1024;
+            break;
+        }
+    }
+
+    fclose(meminfo);
+    return bytes;
+}
+
+/**
+ * Sets the bit of every online NUMA node, read from sysfs as a list such as "0-1,3"
+ * @param PageAllocator pages
+ * @return number of online nodes, 1 if there is no NUMA information
+ */
+static int readOnlineNodes(PageAllocator* pages) {
+    memset(pages->nodeMask, 0, sizeof(pages->nodeMask));
+    FILE* online = fopen("/sys/devices/system/node/online", "r");
+    if (online == NULL) {
+        return 1;
+    }
+
+    int count = 0;
+    int first;
+    int last;
+    char separator = ',';
+    while (separator == ',' && fscanf(online, "%d", &first) == 1) {
+        last = first;
+        if (fscanf(online, "%c", &separator) == 1 && separator == '-') {
+            if (fscanf(online, "%d", &last) != 1 || fscanf(online, "%c", &separator) != 1) {
+                separator = '\n';
+            }
+        }
+        for (int node = first; node <= last && node < PAGE_MAX_NUMA_NODES; node++) {
+            pages->nodeMask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+            count++;
+        }
+    }
+
+    fclose(online);
+    return count > 0 ? count : 1;
+}
+
+/**
+ * Applies the NUMA placement of the policy to a fresh mapping, before its pages are touched
+ * @param PageAllocator pages
+ * @param void* memory
+ * @param size_t length
+ * @return true if mbind placed the mapping
+ */
+static bool placePages(PageAllocator* pages, void* memory, size_t length) {
+#ifdef SYS_mbind
+    if (pages->policy.placement == NUMA_DEFAULT || pages->stats.numaNodes < 2) {
+        return false;
+    }
+
+    int mode = pages->policy.placement == NUMA_INTERLEAVE ? PAGE_MPOL_INTERLEAVE : PAGE_MPOL_PREFERRED;
+    //The kernel reads one bit less than maxnode
+    return syscall(SYS_mbind, memory, length, mode, pages->nodeMask, PAGE_MAX_NUMA_NODES + 1, 0) == 0;
+#else
+    (void)pages;
+    (void)memory;
+    (void)length;
+    return false;
+#endif
+}
+
+/**
+ * Maps at least length bytes with the backing of the policy, falling back
+ * from explicit to transparent huge pages to base pages
+ * @param PageAllocator pages
+ * @param PageMapping mapping set to the memory, length and backing mapped
+ * @param size_t length bytes wanted
+ * @return false on failure
+ */
+static bool mapPages(PageAllocator* pages, PageMapping* mapping, size_t length) {
+    size_t huge = pages->stats.hugePageBytes;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    bool wantsHuge = pages->policy.backing != PAGES_SMALL && length >= huge;
+    size_t hugeLength = (length + huge - 1) / huge * huge;
+
+    mapping->memory = NULL;
+#ifdef MAP_HUGETLB
+    if (wantsHuge && pages->policy.backing == PAGES_EXPLICIT) {
+        void* memory = mmap(NULL, hugeLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            mapping->memory = memory;
+            mapping->length = hugeLength;
+            mapping->backing = PAGES_EXPLICIT;
+        }
+    }
+#endif
+
+    if (mapping->memory == NULL && wantsHuge) {
+        //Map a huge page more than needed and trim both ends to a huge page boundary
+        unsigned char* raw = mmap(NULL, hugeLength + huge, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            return false;
+        }
+        unsigned char* aligned = (unsigned char*)(((size_t)raw + huge - 1) & ~(huge - 1));
+        if (aligned > raw) {
+            munmap(raw, aligned - raw);
+        }
+        if (aligned < raw + huge) {
+            munmap(aligned + hugeLength, raw + huge - aligned);
+        }
+
+        mapping->memory = aligned;
+        mapping->length = hugeLength;
+        mapping->backing = PAGES_SMALL;
+#ifdef MADV_HUGEPAGE
+        if (madvise(aligned, hugeLength, MADV_HUGEPAGE) == 0) {
+            mapping->backing = PAGES_TRANSPARENT;
+        }
+#endif
+    }
+
+    if (mapping->memory == NULL) {
+        length = (length + page - 1) / page * page;
+        void* memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return false;
+        }
+        mapping->memory = memory;
+        mapping->length = length;
+        mapping->backing = PAGES_SMALL;
+    }
+
+    mapping->placed = placePages(pages, mapping->memory, mapping->length);
+
+    return true;
+}
+
+/**
+ * Adds a mapping to the stats of its allocator, or takes it off
+ * @param PageAllocator pages
+ * @param PageMapping mapping
+ * @param bool add false to take it off
+ * @return void
+ */
+static void countMapping(PageAllocator* pages, PageMapping* mapping, bool add) {
+    size_t* counters[] = {
+        &pages->stats.mappedBytes,
+        mapping->backing == PAGES_EXPLICIT ? &pages->stats.explicitHugeBytes : NULL,
+        mapping->backing == PAGES_TRANSPARENT ? &pages->stats.transparentHugeBytes : NULL,
+        mapping->placed ? &pages->stats.placedBytes : NULL
+    };
+
+    for (int i = 0; i < 4; i++) {
+        if (counters[i] != NULL) {
+            *counters[i] = add ? *counters[i] + mapping->length : *counters[i] - mapping->length;
+        }
+    }
+}
+
+/**
+ * Maps memory and records it in a list of mappings
+ * @param PageAllocator pages
+ * @param PageMapping** list
+ * @param size_t length
+ * @return the mapping, NULL on failure
+ */
+static PageMapping* addMapping(PageAllocator* pages, PageMapping** list, size_t length) {
+    PageMapping* mapping = malloc(sizeof(PageMapping));
+    if (mapping == NULL) {
+        return NULL;
+    }
+
+    if (!mapPages(pages, mapping, length)) {
+        free(mapping);
+        return NULL;
+    }
+    mapping->next = *list;
+    *list = mapping;
+    countMapping(pages, mapping, true);
+
+    return mapping;
+}
+
+static void* pageAllocBulk(void* state, size_t size) {
+    PageMapping* mapping = addMapping(state, &((PageAllocator*)state)->large, size == 0 ? 1 : size);
+    return mapping == NULL ? NULL : mapping->memory;
+}
+
+static void pageReleaseBulk(void* state, void* toRelease, size_t size) {
+    PageAllocator* pages = state;
+    (void)size;
+
+    for (PageMapping** link = &pages->large; *link != NULL; link = &(*link)->next) {
+        PageMapping* mapping = *link;
+        if (mapping->memory == toRelease) {
+            *link = mapping->next;
+            countMapping(pages, mapping, false);
+            munmap(mapping->memory, mapping->length);
+            free(mapping);
+            return;
+        }
+    }
+}
+
+static void* pageAlloc(void* state, size_t size) {
+    PageAllocator* pages = state;
+
+    if (size > PAGE_SMALL_MAX_BYTES) {
+        return pageAllocBulk(state, size);
+    }
+
+    size = size == 0 ? SLAB_CLASS_BYTES : (size + SLAB_CLASS_BYTES - 1) / SLAB_CLASS_BYTES * SLAB_CLASS_BYTES;
+    SlabObject** freeList = &pages->freeLists[size / SLAB_CLASS_BYTES - 1];
+    if (*freeList != NULL) {
+        SlabObject* object = *freeList;
+        *freeList = object->next;
+        return object;
+    }
+
+    if (pages->chunkLeft < size) {
+        PageMapping* chunk = addMapping(pages, &pages->chunks, pages->policy.chunkSize);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        pages->chunkNext = chunk->memory;
+        pages->chunkLeft = chunk->length;
+    }
+
+    void* memory = pages->chunkNext;
+    pages->chunkNext += size;
+    pages->chunkLeft -= size;
+
+    return memory;
+}
+
+static void pageRelease(void* state, void* toRelease, size_t size) {
+    PageAllocator* pages = state;
+
+    if (size > PAGE_SMALL_MAX_BYTES) {
+        pageReleaseBulk(state, toRelease, size);
+        return;
+    }
+
+    size = size == 0 ? SLAB_CLASS_BYTES : (size + SLAB_CLASS_BYTES - 1) / SLAB_CLASS_BYTES * SLAB_CLASS_BYTES;
+    SlabObject* object = toRelease;
+    object->next = pages->freeLists[size / SLAB_CLASS_BYTES - 1];
+    pages->freeLists[size / SLAB_CLASS_BYTES - 1] = object;
+}
+
+Allocator* createPageAllocator(PagePolicy policy) {
+    PageAllocator* pages = calloc(1, sizeof(PageAllocator));
+    if (pages == NULL) {
+        return NULL;
+    }
+
+    pages->stats.hugePageBytes = readHugePageBytes();
+    pages->stats.numaNodes = readOnlineNodes(pages);
+
+    //Local placement prefers the node of the creating thread over the others
+    if (policy.placement == NUMA_LOCAL) {
+        unsigned int cpu;
+        unsigned int node = 0;
+#ifdef SYS_getcpu
+        if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0 || node >= PAGE_MAX_NUMA_NODES) {
+            node = 0;
+        }
+#endif
+        (void)cpu;
+        memset(pages->nodeMask, 0, sizeof(pages->nodeMask));
+        pages->nodeMask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    }
+
+    if (policy.chunkSize == 0) {
+        policy.chunkSize = PAGE_DEFAULT_CHUNK_BYTES;
+    }
+    if (policy.chunkSize < PAGE_SMALL_MAX_BYTES) {
+        policy.chunkSize = PAGE_SMALL_MAX_BYTES;
+    }
+    pages->policy = policy;
+
+    pages->allocator.alloc = pageAlloc;
+    pages->allocator.release = pageRelease;
+    pages->allocator.state = pages;
+    pages->allocator.allocBulk = pageAllocBulk;
+    pages->allocator.releaseBulk = pageReleaseBulk;
+
+    return &pages->allocator;
+}
+
+PageStats getPageAllocatorStats(Allocator* allocator) {
+    PageStats stats = {0, 0, 0, 0, 0, 0};
+    if (allocator == NULL) {
+        return stats;
+    }
+
+    return ((PageAllocator*)allocator->state)->stats;
+}
+
+void destroyPageAllocator(Allocator* allocator) {
+    if (allocator == NULL) {
+        return;
+    }
+
+    PageAllocator* pages = allocator->state;
+    PageMapping* lists[2] = {pages->chunks, pages->large};
+    for (int i = 0; i < 2; i++) {
+        PageMapping* mapping = lists[i];
+        while (mapping != NULL) {
+            PageMapping* next = mapping->next;
+            munmap(mapping->memory, mapping->length);
+            free(mapping);
+            mapping = next;
+        }
+    }
+
+    free(pages);
+}
@@ -0,0 +1,262 @@
+#ifndef ALLOCATOR_ALLOCATORAPI_H
+#define ALLOCATOR_ALLOCATORAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+/**
+ * Requests up to this size are served from size classes SLAB_CLASS_BYTES
+ * apart, anything larger goes straight to malloc
+ */
+#define SLAB_CLASS_BYTES 16
+#define SLAB_CLASSES 16
+#define SLAB_MAX_BYTES (SLAB_CLASS_BYTES * SLAB_CLASSES)
+
+/**
+ * Size of each block carved into objects of one size class
+ */
+#define SLAB_BYTES (64 * 1024)
+
+/**
+ * Objects of one size class a thread keeps for itself before handing half
+ * of them back to the shared pool
+ */
+#define SLAB_CACHE_LIMIT 256
+
+/**
+ * Default size of each block an arena allocates from
+ */
+#define ARENA_DEFAULT_CHUNK_BYTES (1024 * 1024)
+
+/**
+ * Default size of each block a page allocator maps for small objects,
+ * a multiple of every common huge page size up to 32MB
+ */
+#define PAGE_DEFAULT_CHUNK_BYTES (32 * 1024 * 1024)
+
+/**
+ * Largest object a page allocator carves from its chunks, in size classes
+ * SLAB_CLASS_BYTES apart. Larger objects get a mapping of their own.
+ */
+#define PAGE_SMALL_MAX_BYTES 4096
+
+/**
+ * Most NUMA nodes a page allocator places memory on
+ */
+#define PAGE_MAX_NUMA_NODES 64
+
+/**
+ * Memory source for the nodes of a structure. Structures created with a NULL
+ * allocator use malloc and free.
+ * release is NULL for allocators that only give memory back all at once,
+ * structures then skip freeing their nodes one by one.
+ * allocBulk and releaseBulk serve large arrays such as hash table slots and
+ * compacted node blocks, which are released one by one whatever the
+ * allocator. They are NULL for allocators that leave those to malloc.
+ */
+typedef struct allocator {
+    void* (*alloc)(void* state, size_t size);
+    void (*release)(void* state, void* toRelease, size_t size);
+    void* state;
+    void* (*allocBulk)(void* state, size_t size);
+    void (*releaseBulk)(void* state, void* toRelease, size_t size);
+} Allocator;
+
+/**
+ * Bytes held by a structure, as reported by its memory usage function.
+ * payload: the data pointers (and keys) the user stored
+ * metadata: links, balance information and headers the structure needs
+ * slack: bytes allocated but holding nothing, such as empty slots, spare
+ * capacity, freed slots of a compacted block and allocator rounding
+ */
+typedef struct memoryUsage {
+    size_t payload;
+    size_t metadata;
+    size_t slack;
+} MemoryUsage;
+
+/**
+ * Block of arena memory, objects are handed out from memory in order
+ */
+typedef struct arenaChunk {
+    struct arenaChunk* next;
+    size_t used;
+    size_t capacity;
+    _Alignas(16) unsigned char memory[];
+} ArenaChunk;
+
+/**
+ * Region allocator: allocation bumps a pointer, releasing single objects does
+ * nothing, and everything goes at once when the arena is reset or destroyed.
+ * Not thread safe.
+ */
+typedef struct arena {
+    Allocator allocator;
+    ArenaChunk* chunks;
+    size_t chunkSize;
+} Arena;
+
+/**
+ * Pages backing the memory of a page allocator
+ */
+typedef enum pageBacking {
+    PAGES_SMALL,    //Base pages only
+    PAGES_TRANSPARENT,    //Huge page aligned mappings advised with MADV_HUGEPAGE, promoted by the kernel when it can
+    PAGES_EXPLICIT    //MAP_HUGETLB pages from the reserved pool, PAGES_TRANSPARENT once the pool is empty
+} PageBacking;
+
+/**
+ * NUMA placement of the memory of a page allocator. Either one falls back to
+ * the process policy when mbind is unavailable or there is only one node.
+ */
+typedef enum numaPlacement {
+    NUMA_DEFAULT,    //Process policy, normally the node of the thread that first touches each page
+    NUMA_LOCAL,    //Prefer the node the allocator was created on, whichever thread touches the pages
+    NUMA_INTERLEAVE    //Spread pages round robin over every online node
+} NumaPlacement;
+
+/**
+ * How a page allocator gets its memory
+ */
+typedef struct pagePolicy {
+    PageBacking backing;
+    NumaPlacement placement;
+    size_t chunkSize;    //Bytes mapped at a time for small objects, 0 for PAGE_DEFAULT_CHUNK_BYTES
+} PagePolicy;
+
+/**
+ * Memory a page allocator has mapped, and how much of it got the backing
+ * and placement its policy asked for
+ */
+typedef struct pageStats {
+    size_t mappedBytes;
+    size_t explicitHugeBytes;    //Mapped with MAP_HUGETLB
+    size_t transparentHugeBytes;    //Huge page aligned and advised with MADV_HUGEPAGE
+    size_t placedBytes;    //Placed by mbind
+    size_t hugePageBytes;    //Default huge page size of the system
+    int numaNodes;    //Online nodes found, 1 without NUMA
+} PageStats;
+
+/**
+ * Allocates size bytes from allocator, or with malloc if allocator is NULL
+ * @param Allocator allocator
+ * @param size_t size
+ * @return pointer to the memory, NULL on failure
+ */
+void* allocatorAlloc(Allocator* allocator, size_t size);
+
+/**
+ * Gives memory back to the allocator it came from
+ * @param Allocator allocator the memory was allocated from, NULL for malloc
+ * @param void* toRelease
+ * @param size_t size the size it was allocated with
+ * @return void
+ */
+void allocatorRelease(Allocator* allocator, void* toRelease, size_t size);
+
+/**
+ * Allocates a large array from allocator, with malloc if allocator is NULL or
+ * has no bulk allocation
+ * @param Allocator allocator
+ * @param size_t size
+ * @return pointer to the memory, NULL on failure
+ */
+void* allocatorAllocBulk(Allocator* allocator, size_t size);
+
+/**
+ * Gives an array from allocatorAllocBulk back
+ * @param Allocator allocator the array was allocated from, NULL for malloc
+ * @param void* toRelease
+ * @param size_t size the size it was allocated with
+ * @return void
+ */
+void allocatorReleaseBulk(Allocator* allocator, void* toRelease, size_t size);
+
+/**
+ * Checks if memory from this allocator has to be released object by object
+ * @param Allocator allocator
+ * @return false for arenas, true otherwise
+ */
+bool allocatorReleasesEach(Allocator* allocator);
+
+/**
+ * Estimates the bytes one object of size bytes really takes from an allocator,
+ * including its rounding and, for malloc on glibc, the chunk header
+ * @param Allocator allocator, NULL for malloc
+ * @param size_t size
+ * @return the footprint, at least size
+ */
+size_t allocatorFootprint(Allocator* allocator, size_t size);
+
+/**
+ * Estimates the bytes an array of size bytes from allocatorAllocBulk really takes
+ * @param Allocator allocator, NULL for malloc
+ * @param size_t size
+ * @return the footprint, at least size
+ */
+size_t allocatorBulkFootprint(Allocator* allocator, size_t size);
+
+/**
+ * Returns the shared size-class slab allocator. It is thread safe: each
+ * thread allocates from and releases to its own cache of free objects per
+ * size class, and only takes a lock to move a batch of objects between its
+ * cache and the shared pool. Objects of one size sit next to each other in
+ * 64KB slabs, which are kept for reuse and never returned to the system.
+ * @return the slab allocator
+ */
+Allocator* getSlabAllocator(void);
+
+/**
+ * Creates an arena allocator
+ * @param size_t chunkSize bytes to allocate at a time, 0 for ARENA_DEFAULT_CHUNK_BYTES
+ * @return Newly created allocator, NULL on allocation failure
+ */
+Allocator* createArenaAllocator(size_t chunkSize);
+
+/**
+ * Releases every allocation made from an arena at once, keeping one chunk for reuse.
+ * Structures using the arena must have been destroyed first.
+ * @param Allocator arena made by createArenaAllocator
+ * @return void
+ */
+void resetArenaAllocator(Allocator* arena);
+
+/**
+ * Frees an arena and all memory allocated from it
+ * @param Allocator arena made by createArenaAllocator
+ * @return void
+ */
+void destroyArenaAllocator(Allocator* arena);
+
+/**
+ * Creates a page allocator: small objects are carved from large mmap chunks
+ * and recycled through per size class free lists, larger objects and bulk
+ * arrays get mappings of their own that are unmapped on release. Every
+ * mapping gets the huge pages and NUMA placement of policy where the system
+ * allows, before any page is touched, and silently gets less otherwise;
+ * getPageAllocatorStats tells what was granted. Pass it to
+ * createTableWithAllocator, initializeListWithAllocator or
+ * createBinTreeWithAllocator to back slot arrays and node pools whose random
+ * access would otherwise miss the TLB. Not thread safe.
+ * @param PagePolicy policy
+ * @return Newly created allocator, NULL on allocation failure
+ */
+Allocator* createPageAllocator(PagePolicy policy);
+
+/**
+ * Reports what a page allocator has mapped
+ * @param Allocator allocator made by createPageAllocator
+ * @return PageStats stats, all zero if allocator is NULL
+ */
+PageStats getPageAllocatorStats(Allocator* allocator);
+
+/**
+ * Unmaps everything allocated from a page allocator and frees it. Structures
+ * using it must have been destroyed first.
+ * @param Allocator allocator made by createPageAllocator
+ * @return void
+ */
+void destroyPageAllocator(Allocator* allocator);
+
+#endif //ALLOCATOR_ALLOCATORAPI_H
@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "BPlusTreeAPI.h"
+
+#define BPLUS_MAX_HEIGHT 64
+
+/**
+ * Counts the keys less than key over the whole array. Empty slots hold
+ * BPLUS_EMPTY_KEY, so the fixed trip count lets the compiler vectorize it.
+ */
+static int countLess(const BPlusKey* keys, BPlusKey key, int size) {
+    int position = 0;
+
+    for (int i = 0; i < size; i++) {
+        position += keys[i] < key;
+    }
+
+    return position;
+}
+
+static int leafPosition(BPlusLeaf* leaf, BPlusKey key) {
+    return countLess(leaf->keys, key, BPLUS_LEAF_KEYS);
+}
+
+/**
+ * Index of the child that may hold key, keys equal to a separator live to its right
+ */
+static int childPosition(BPlusInner* inner, BPlusKey key) {
+    int position = countLess(inner->keys, key, BPLUS_INNER_KEYS);
+
+    if (position < inner->header.count && inner->keys[position] == key) {
+        position++;
+    }
+
+    return position;
+}
+
+static BPlusLeaf* createLeaf(void) {
+    BPlusLeaf* leaf = aligned_alloc(64, sizeof(BPlusLeaf));
+    if (leaf == NULL) {
+        return NULL;
+    }
+
+    leaf->header.count = 0;
+    leaf->header.isLeaf = 1;
+    leaf->next = NULL;
+    for (int i = 0; i < (int)BPLUS_LEAF_KEYS; i++) {
+        leaf->keys[i] = BPLUS_EMPTY_KEY;
+    }
+
+    return leaf;
+}
+
+static BPlusInner* createInner(void) {
+    BPlusInner* inner = aligned_alloc(64, sizeof(BPlusInner));
+    if (inner == NULL) {
+        return NULL;
+    }
+
+    inner->header.count = 0;
+    inner->header.isLeaf = 0;
+    for (int i = 0; i < (int)BPLUS_INNER_KEYS; i++) {
+        inner->keys[i] = BPLUS_EMPTY_KEY;
+    }
+
+    return inner;
+}
+
+/**
+ * Descends to the leaf that may hold key
+ */
+static BPlusLeaf* findLeaf(BPlusTree* theTree, BPlusKey key) {
+    BPlusNode* node = theTree->root;
+
+    while (!node->isLeaf) {
+        BPlusInner* inner = (BPlusInner*)node;
+        node = inner->children[childPosition(inner, key)];
+    }
+
+    return (BPlusLeaf*)node;
+}
+
+BPlusTree* createBPlusTree(void (*deleteFunction)(void* toBeDeleted)) {
+    BPlusTree* toReturn = malloc(sizeof(BPlusTree));
+    if (toReturn == NULL) {
+        return NULL;
+    }
+
+    BPlusLeaf* leaf = createLeaf();
+    if (leaf == NULL) {
+        free(toReturn);
+        return NULL;
+    }
+
+    toReturn->root = &leaf->header;
+    toReturn->first = leaf;
+    toReturn->height = 1;
+    toReturn->count = 0;
+    toReturn->deleteData = deleteFunction;
+
+    return toReturn;
+}
+
+static void destroyBPlusNode(BPlusNode* node, void (*deleteData)(void* toBeDeleted)) {
+    if (node->isLeaf) {
+        BPlusLeaf* leaf = (BPlusLeaf*)node;
+        for (int i = 0; i < leaf->header.count; i++) {
+            deleteData(leaf->values[i]);
+        }
+    }
+    else {
+        //Recursion depth is the height of the tree, a handful of levels
+        BPlusInner* inner = (BPlusInner*)node;
+        for (int i = 0; i <= inner->header.count; i++) {
+            destroyBPlusNode(inner->children[i], deleteData);
+        }
+    }
+
+    free(node);
+}
+
+void destroyBPlusTree(BPlusTree* toDestroy) {
+    if (toDestroy == NULL) {
+        return;
+    }
+
+    destroyBPlusNode(toDestroy->root, toDestroy->deleteData);
+    free(toDestroy);
+}
+
+/**
+ * Inserts separator and its right child into inner at position. A full inner
+ * node is split into sibling, which the caller allocated beforehand so the
+ * split cannot fail halfway up the tree.
+ * @return sibling if inner was split, with *promoted set to the key moving up, NULL if it fit
+ */
+static BPlusInner* insertIntoInner(BPlusInner* inner, int position, BPlusKey separator, BPlusNode* right, BPlusInner* sibling, BPlusKey* promoted) {
+    int count = inner->header.count;
+
+    if (count < (int)BPLUS_INNER_KEYS) {
+        memmove(&inner->keys[position + 1], &inner->keys[position], sizeof(BPlusKey) * (count - position));
+        memmove(&inner->children[position + 2], &inner->children[position + 1], sizeof(BPlusNode*) * (count - position));
+        inner->keys[position] = separator;
+        inner->children[position + 1] = right;
+        inner->header.count++;
+        return NULL;
+    }
+
+    //Lay the full node plus the new entry out in order, then deal it into two halves
+    BPlusKey keys[BPLUS_INNER_KEYS + 1];
+    BPlusNode* children[BPLUS_INNER_KEYS + 2];
+    memcpy(keys, inner->keys, sizeof(BPlusKey) * position);
+    keys[position] = separator;
+    memcpy(&keys[position + 1], &inner->keys[position], sizeof(BPlusKey) * (count - position));
+    memcpy(children, inner->children, sizeof(BPlusNode*) * (position + 1));
+    children[position + 1] = right;
+    memcpy(&children[position + 2], &inner->children[position + 1], sizeof(BPlusNode*) * (count - position));
+
+    int total = count + 1;
+    int leftCount = total / 2;
+    int rightCount = total - leftCount - 1;
+
+    for (int i = 0; i < (int)BPLUS_INNER_KEYS; i++) {
+        inner->keys[i] = i < leftCount ? keys[i] : BPLUS_EMPTY_KEY;
+    }
+    memcpy(inner->children, children, sizeof(BPlusNode*) * (leftCount + 1));
+    inner->header.count = leftCount;
+
+    *promoted = keys[leftCount];
+    memcpy(sibling->keys, &keys[leftCount + 1], sizeof(BPlusKey) * rightCount);
+    memcpy(sibling->children, &children[leftCount + 1], sizeof(BPlusNode*) * (rightCount + 1));
+    sibling->header.count = rightCount;
+
+    return sibling;
+}
+
+bool addToBPlusTree(BPlusTree* theTree, BPlusKey key, void* data) {
+    if (theTree == NULL || key == BPLUS_EMPTY_KEY) {
+        return false;
+    }
+
+    //Remember the path so splits can be pushed back up without parent pointers
+    BPlusInner* path[BPLUS_MAX_HEIGHT];
+    int positions[BPLUS_MAX_HEIGHT];
+    int depth = 0;
+
+    BPlusNode* node = theTree->root;
+    while (!node->isLeaf) {
+        BPlusInner* inner = (BPlusInner*)node;
+        path[depth] = inner;
+        positions[depth] = childPosition(inner, key);
+        node = inner->children[positions[depth]];
+        depth++;
+    }
+
+    BPlusLeaf* leaf = (BPlusLeaf*)node;
+    int position = leafPosition(leaf, key);
+    if (position < leaf->header.count && leaf->keys[position] == key) {
+        return true;
+    }
+
+    int count = leaf->header.count;
+    if (count < (int)BPLUS_LEAF_KEYS) {
+        memmove(&leaf->keys[position + 1], &leaf->keys[position], sizeof(BPlusKey) * (count - position));
+        memmove(&leaf->values[position + 1], &leaf->values[position], sizeof(void*) * (count - position));
+        leaf->keys[position] = key;
+        leaf->values[position] = data;
+        leaf->header.count++;
+        theTree->count++;
+        return true;
+    }
+
+    //Allocate every node the split needs before changing anything: the leaf's sibling,
+    //one sibling per full ancestor the separator passes through, and a new root if they all are
+    BPlusLeaf* sibling = createLeaf();
+    BPlusInner* spares[BPLUS_MAX_HEIGHT + 1];
+    int numSpares = 0;
+    int level = depth - 1;
+    while (level >= 0 && path[level]->header.count == (int)BPLUS_INNER_KEYS) {
+        level--;
+        numSpares++;
+    }
+    if (level < 0) {
+        numSpares++;
+    }
+
+    int made = 0;
+    bool allocated = sibling != NULL;
+    while (allocated && made < numSpares) {
+        spares[made] = createInner();
+        allocated = spares[made] != NULL;
+        made += allocated;
+    }
+    if (!allocated) {
+        for (int i = 0; i < made; i++) {
+            free(spares[i]);
+        }
+        free(sibling);
+        return false;
+    }
+
+    //Split the full leaf in half and put the new entry on the correct side
+    int leftCount = (count + 1) / 2;
+    int moved = count - leftCount;
+    memcpy(sibling->keys, &leaf->keys[leftCount], sizeof(BPlusKey) * moved);
+    memcpy(sibling->values, &leaf->values[leftCount], sizeof(void*) * moved);
+    for (int i = leftCount; i < count; i++) {
+        leaf->keys[i] = BPLUS_EMPTY_KEY;
+    }
+    leaf->header.count = leftCount;
+    sibling->header.count = moved;
+    sibling->next = leaf->next;
+    leaf->next = sibling;
+
+    BPlusLeaf* target = position <= leftCount ? leaf : sibling;
+    int targetPosition = position <= leftCount ? position : position - leftCount;
+    int targetCount = target->header.count;
+    memmove(&target->keys[targetPosition + 1], &target->keys[targetPosition], sizeof(BPlusKey) * (targetCount - targetPosition));
+    memmove(&target->values[targetPosition + 1], &target->values[targetPosition], sizeof(void*) * (targetCount - targetPosition));
+    target->keys[targetPosition] = key;
+    target->values[targetPosition] = data;
+    target->header.count++;
+    theTree->count++;
+
+    //Push the separator up until a parent has room
+    BPlusKey separator = sibling->keys[0];
+    BPlusNode* right = &sibling->header;
+    int nextSpare = 0;
+    while (depth > 0) {
+        depth--;
+        BPlusKey promoted;
+        BPlusInner* split = insertIntoInner(path[depth], positions[depth], separator, right, spares[nextSpare], &promoted);
+        if (split == NULL) {
+            return true;
+        }
+        nextSpare++;
+        separator = promoted;
+        right = &split->header;
+    }
+
+    //The root itself split, grow the tree by one level
+    BPlusInner* root = spares[nextSpare];
+    root->keys[0] = separator;
+    root->children[0] = theTree->root;
+    root->children[1] = right;
+    root->header.count = 1;
+    theTree->root = &root->header;
+    theTree->height++;
+
+    return true;
+}
+
+void removeFromBPlusTree(BPlusTree* theTree, BPlusKey key) {
+    if (theTree == NULL) {
+        return;
+    }
+
+    BPlusLeaf* leaf = findLeaf(theTree, key);
+    int position = leafPosition(leaf, key);
+    int count = leaf->header.count;
+
+    if (position >= count || leaf->keys[position] != key) {
+        return;
+    }
+
+    theTree->deleteData(leaf->values[position]);
+    memmove(&leaf->keys[position], &leaf->keys[position + 1], sizeof(BPlusKey) * (count - position - 1));
+    memmove(&leaf->values[position], &leaf->values[position + 1], sizeof(void*) * (count - position - 1));
+    leaf->keys[count - 1] = BPLUS_EMPTY_KEY;
+    leaf->header.count--;
+    theTree->count--;
+}
+
+void* findInBPlusTree(BPlusTree* theTree, BPlusKey key) {
+    if (theTree == NULL) {
+        return NULL;
+    }
+
+    BPlusLeaf* leaf = findLeaf(theTree, key);
+    int position = leafPosition(leaf, key);
+
+    if (position < leaf->header.count && leaf->keys[position] == key) {
+        return leaf->values[position];
+    }
+    else {
+        return NULL;
+    }
+}
+
+BPlusIterator createBPlusIterator(BPlusTree* theTree, BPlusKey key) {
+    BPlusIterator iter;
+
+    iter.leaf = findLeaf(theTree, key);
+    iter.index = leafPosition(iter.leaf, key);
+
+    return iter;
+}
+
+void* nextBPlusElement(BPlusIterator* iter, BPlusKey* key) {
+    //Skip past exhausted and emptied leaves
+    while (iter->leaf != NULL && iter->index >= iter->leaf->header.count) {
+        iter->leaf = iter->leaf->next;
+        iter->index = 0;
+    }
+
+    if (iter->leaf == NULL) {
+        return NULL;
+    }
+
+    if (key != NULL) {
+        *key = iter->leaf->keys[iter->index];
+    }
+    return iter->leaf->values[iter->index++];
+}
+
+int rangeScanBPlusTree(BPlusTree* theTree, BPlusKey lo, BPlusKey hi, void* out[], int max) {
+    if (theTree == NULL || out == NULL) {
+        return 0;
+    }
+
+    BPlusIterator iter = createBPlusIterator(theTree, lo);
+    int found = 0;
+    BPlusKey key;
+    void* data;
+
+    while (found < max && (data = nextBPlusElement(&iter, &key)) != NULL && key <= hi) {
+        out[found++] = data;
+    }
+
+    return found;
+}
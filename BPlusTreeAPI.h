@@ -0,0 +1,148 @@
+#ifndef BPLUSTREE_BPLUSTREEAPI_H
+#define BPLUSTREE_BPLUSTREEAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+
+/**
+ * Size in bytes of every node, pick 64 for one cache line or 256 for four.
+ * Override at compile time with -DBPLUS_NODE_BYTES=64
+ */
+#ifndef BPLUS_NODE_BYTES
+#define BPLUS_NODE_BYTES 256
+#endif
+
+/**
+ * Keys are fixed size integers so a node can keep them in one contiguous array
+ */
+typedef long long BPlusKey;
+
+/**
+ * Unused key slots hold this value so in-node search can scan the whole array without branching
+ */
+#define BPLUS_EMPTY_KEY LLONG_MAX
+
+/**
+ * Number of entries that fit in a node of BPLUS_NODE_BYTES
+ */
+#define BPLUS_LEAF_KEYS ((BPLUS_NODE_BYTES - 2 * sizeof(int) - sizeof(void*)) / (sizeof(BPlusKey) + sizeof(void*)))
+#define BPLUS_INNER_KEYS ((BPLUS_NODE_BYTES - 2 * sizeof(int) - sizeof(void*)) / (sizeof(BPlusKey) + sizeof(void*)))
+
+/**
+ * Header shared by leaf and inner nodes
+ */
+typedef struct bPlusNode {
+    int count;    //Number of keys in use
+    int isLeaf;
+} BPlusNode;
+
+/**
+ * Leaf node, holds the data and is linked to the next leaf for range scans
+ */
+typedef struct bPlusLeaf {
+    BPlusNode header;
+    BPlusKey keys[BPLUS_LEAF_KEYS];
+    void* values[BPLUS_LEAF_KEYS];
+    struct bPlusLeaf* next;
+} BPlusLeaf;
+
+/**
+ * Inner node, children[i] holds the keys k with keys[i - 1] <= k < keys[i]
+ */
+typedef struct bPlusInner {
+    BPlusNode header;
+    BPlusKey keys[BPLUS_INNER_KEYS];
+    BPlusNode* children[BPLUS_INNER_KEYS + 1];
+} BPlusInner;
+
+/**
+ * Definition of the B+tree
+ */
+typedef struct bPlusTree {
+    BPlusNode* root;
+    BPlusLeaf* first;    //Leftmost leaf, start of a full scan
+    int height;    //Number of levels, 1 when the root is a leaf
+    int count;
+    void (*deleteData)(void* toBeDeleted);
+} BPlusTree;
+
+/**
+ * B+tree iterator structure. Walks the linked leaves in key order.
+ */
+typedef struct bPlusIter {
+    BPlusLeaf* leaf;
+    int index;
+} BPlusIterator;
+
+/**
+ * Allocates memory for an empty B+tree
+ * @param deleteFunction function pointer to delete a single piece of data from the tree
+ * @return Newly created tree, NULL on allocation failure
+ */
+BPlusTree* createBPlusTree(void (*deleteFunction)(void* toBeDeleted));
+
+/**
+ * Remove all items and free memory
+ * @param BPlusTree toDestroy
+ * @return void
+ */
+void destroyBPlusTree(BPlusTree* toDestroy);
+
+/**
+ * Add data under key. Duplicate keys are not added, like addToTree, and
+ * BPLUS_EMPTY_KEY is reserved. Every node a split needs is allocated before
+ * the tree changes, so running out of memory leaves the tree as it was.
+ * @param BPlusTree theTree
+ * @param BPlusKey key
+ * @param void* data
+ * @return false if key is BPLUS_EMPTY_KEY or memory ran out, data is then not stored
+ */
+bool addToBPlusTree(BPlusTree* theTree, BPlusKey key, void* data);
+
+/**
+ * Remove the key and delete its data. Nodes are not merged when they
+ * become underfull, their memory is released by destroyBPlusTree.
+ * @param BPlusTree theTree
+ * @param BPlusKey key
+ * @return void
+ */
+void removeFromBPlusTree(BPlusTree* theTree, BPlusKey key);
+
+/**
+ * Searches the tree for the key
+ * @param BPlusTree theTree
+ * @param BPlusKey key
+ * @return NULL if fail, otherwise return data
+ */
+void* findInBPlusTree(BPlusTree* theTree, BPlusKey key);
+
+/**
+ * Creates an iterator positioned at the first key not less than key
+ * @param BPlusTree theTree
+ * @param BPlusKey key
+ * @return BPlusIterator
+ */
+BPlusIterator createBPlusIterator(BPlusTree* theTree, BPlusKey key);
+
+/**
+ * Returns the data the iterator is on and moves it to the next key
+ * @param BPlusIterator iter
+ * @param BPlusKey* key set to the key of the returned data, may be NULL
+ * @return NULL once the end is reached, otherwise the data
+ */
+void* nextBPlusElement(BPlusIterator* iter, BPlusKey* key);
+
+/**
+ * Copies the data of every key in [lo, hi] into out, in key order
+ * @param BPlusTree theTree
+ * @param BPlusKey lo
+ * @param BPlusKey hi
+ * @param void* out[] array of at least max elements
+ * @param int max
+ * @return number of elements written to out
+ */
+int rangeScanBPlusTree(BPlusTree* theTree, BPlusKey lo, BPlusKey hi, void* out[], int max);
+
+#endif //BPLUSTREE_BPLUSTREEAPI_H
@@ -1,21 +1,43 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
 #include "BinarySearchTreeAPI.h"
-#define DEBUG false
+#include "InstrumentAPI.h"
 
-TreeNode* createTreeNode(TreeDataPtr data) {
-    //Create the treeNode, initialize values, then return the dynamically created treeNode
-    TreeNode* toReturn = malloc(sizeof(TreeNode));
+/**
+ * Creates a TreeNode from allocator, malloc when allocator is NULL
+ * @return the new node, NULL on allocation failure
+ */
+static TreeNode* allocateTreeNode(Allocator* allocator, TreeDataPtr data) {
+    TreeNode* toReturn = allocatorAlloc(allocator, sizeof(TreeNode));
+    if (toReturn == NULL) {
+        return NULL;
+    }
+    STAT_RECORD(STATS_TREE, STAT_ALLOCS, sizeof(TreeNode));
     toReturn->data = data;
     toReturn->left = NULL;
     toReturn->right = NULL;
     toReturn->parent = NULL;
+    toReturn->height = 1;
+    toReturn->size = 1;
+    toReturn->maxEnd = 0;
 
     return toReturn;
 }
 
+TreeNode* createTreeNode(TreeDataPtr data) {
+    //Create the treeNode, initialize values, then return the dynamically created treeNode
+    return allocateTreeNode(NULL, data);
+}
+
 Tree* createBinTree(CompareFunc compare, DeleteFunc del, PrintFunc print) {
+    return createBinTreeWithMode(compare, del, print, TREE_UNBALANCED);
+}
+
+Tree* createBinTreeWithMode(CompareFunc compare, DeleteFunc del, PrintFunc print, TreeMode mode) {
     //Create the tree, initialize values, then return the dynamically created tree
     Tree* toReturn = malloc(sizeof(Tree));
     toReturn->root = NULL;
@@ -23,53 +45,363 @@ Tree* createBinTree(CompareFunc compare, DeleteFunc del, PrintFunc print) {
     toReturn->printFunc = print;
     toReturn->deleteFunc = del;
     toReturn->compareFunc = compare;
+    toReturn->mode = mode;
+    toReturn->nodeBlock = NULL;
+    toReturn->blockSize = 0;
+    toReturn->startFunc = NULL;
+    toReturn->endFunc = NULL;
+    toReturn->allocator = NULL;
 
     return toReturn;
 }
 
+Tree* createBinTreeWithAllocator(CompareFunc compare, DeleteFunc del, PrintFunc print, TreeMode mode, Allocator* allocator) {
+    Tree* toReturn = createBinTreeWithMode(compare, del, print, mode);
+    if (toReturn == NULL) {
+        return NULL;
+    }
+
+    toReturn->allocator = allocator;
+
+    return toReturn;
+}
+
+Tree* createIntervalTree(CompareFunc compare, DeleteFunc del, PrintFunc print, EndpointFunc start, EndpointFunc end) {
+    Tree* toReturn = createBinTreeWithMode(compare, del, print, TREE_INTERVAL);
+    if (toReturn == NULL) {
+        return NULL;
+    }
+
+    toReturn->startFunc = start;
+    toReturn->endFunc = end;
+
+    return toReturn;
+}
+
+/**
+ * Links block[lo..hi] into a perfectly balanced subtree, the middle element becoming its root
+ */
+static TreeNode* linkSorted(TreeNode* block, TreeDataPtr data[], int lo, int hi, TreeNode* parent) {
+    if (lo > hi) {
+        return NULL;
+    }
+
+    //Recursion depth is only log2(n) since each half is built separately
+    int mid = lo + (hi - lo) / 2;
+    TreeNode* treeNode = &block[mid];
+    treeNode->data = data[mid];
+    treeNode->parent = parent;
+    treeNode->left = linkSorted(block, data, lo, mid - 1, treeNode);
+    treeNode->right = linkSorted(block, data, mid + 1, hi, treeNode);
+
+    int left = getHeight(treeNode->left);
+    int right = getHeight(treeNode->right);
+    treeNode->height = (left > right ? left : right) + 1;
+    treeNode->size = hi - lo + 1;
+
+    return treeNode;
+}
+
+Tree* buildTreeFromSorted(TreeDataPtr data[], int n, CompareFunc compare, DeleteFunc del, PrintFunc print, TreeMode mode) {
+    //Interval trees need the endpoint functions to set maxEnd, see createIntervalTree
+    if (mode == TREE_INTERVAL) {
+        return NULL;
+    }
+
+    Tree* toReturn = createBinTreeWithMode(compare, del, print, mode);
+
+    if (n <= 0) {
+        return toReturn;
+    }
+
+    //One allocation for every node, laid out in order so in-order scans walk memory forwards
+    toReturn->nodeBlock = allocatorAllocBulk(toReturn->allocator, sizeof(TreeNode) * n);
+    if (toReturn->nodeBlock == NULL) {
+        free(toReturn);
+        return NULL;
+    }
+    toReturn->blockSize = n;
+    toReturn->root = linkSorted(toReturn->nodeBlock, data, 0, n - 1, NULL);
+    toReturn->count = n;
+
+    return toReturn;
+}
+
+/**
+ * Checks if a node was allocated as part of block
+ */
+static bool isInBlock(TreeNode* treeNode, TreeNode* block, int blockSize) {
+    uintptr_t address = (uintptr_t)treeNode;
+    uintptr_t start = (uintptr_t)block;
+
+    return block != NULL && address >= start && address < start + sizeof(TreeNode) * blockSize;
+}
+
+/**
+ * Gives a node back to the tree's allocator unless it lives in the tree's node block, which is released as a whole
+ */
+static void releaseNode(Tree* theTree, TreeNode* treeNode) {
+    if (!isInBlock(treeNode, theTree->nodeBlock, theTree->blockSize)) {
+        allocatorRelease(theTree->allocator, treeNode, sizeof(TreeNode));
+        STAT_RECORD(STATS_TREE, STAT_FREES, sizeof(TreeNode));
+    }
+}
+
+/**
+ * Deletes the data of every node without recursion or a stack: rotating left
+ * children up turns the tree into a right spine that is consumed from the top.
+ * Nodes inside block are left for the caller to free in one go, the rest go
+ * back to allocator. del may be NULL when the data is not owned by the tree.
+ */
+static void destroyNodes(TreeNode* treeNode, DeleteFunc del, TreeNode* block, int blockSize, Allocator* allocator) {
+    while (treeNode != NULL) {
+        if (treeNode->left != NULL) {
+            TreeNode* left = treeNode->left;
+            treeNode->left = left->right;
+            left->right = treeNode;
+            treeNode = left;
+        }
+        else {
+            TreeNode* next = treeNode->right;
+            if (del != NULL) {
+                del(treeNode->data);
+            }
+            if (!isInBlock(treeNode, block, blockSize)) {
+                allocatorRelease(allocator, treeNode, sizeof(TreeNode));
+                STAT_RECORD(STATS_TREE, STAT_FREES, sizeof(TreeNode));
+            }
+            treeNode = next;
+        }
+    }
+}
+
+/**
+ * Recomputes the height and size of a node from its children, and the
+ * largest interval end for trees made by createIntervalTree. theTree may be NULL.
+ */
+static void updateNode(Tree* theTree, TreeNode* treeNode) {
+    int left = getHeight(treeNode->left);
+    int right = getHeight(treeNode->right);
+
+    treeNode->height = (left > right ? left : right) + 1;
+    treeNode->size = getSize(treeNode->left) + getSize(treeNode->right) + 1;
+
+    if (theTree != NULL && theTree->endFunc != NULL) {
+        long long maxEnd = theTree->endFunc(treeNode->data);
+        if (treeNode->left != NULL && treeNode->left->maxEnd > maxEnd) {
+            maxEnd = treeNode->left->maxEnd;
+        }
+        if (treeNode->right != NULL && treeNode->right->maxEnd > maxEnd) {
+            maxEnd = treeNode->right->maxEnd;
+        }
+        treeNode->maxEnd = maxEnd;
+    }
+}
+
+/**
+ * Puts newChild where oldChild hangs off parent, or at the root if parent is NULL
+ */
+static void replaceChild(Tree* theTree, TreeNode* parent, TreeNode* oldChild, TreeNode* newChild) {
+    if (parent == NULL) {
+        theTree->root = newChild;
+    }
+    else if (parent->left == oldChild) {
+        parent->left = newChild;
+    }
+    else {
+        parent->right = newChild;
+    }
+
+    if (newChild != NULL) {
+        newChild->parent = parent;
+    }
+}
+
+static TreeNode* rotateLeft(Tree* theTree, TreeNode* treeNode) {
+    TreeNode* pivot = treeNode->right;
+
+    replaceChild(theTree, treeNode->parent, treeNode, pivot);
+    treeNode->right = pivot->left;
+    if (pivot->left != NULL) {
+        pivot->left->parent = treeNode;
+    }
+    pivot->left = treeNode;
+    treeNode->parent = pivot;
+
+    updateNode(theTree, treeNode);
+    updateNode(theTree, pivot);
+    return pivot;
+}
+
+static TreeNode* rotateRight(Tree* theTree, TreeNode* treeNode) {
+    TreeNode* pivot = treeNode->left;
+
+    replaceChild(theTree, treeNode->parent, treeNode, pivot);
+    treeNode->left = pivot->right;
+    if (pivot->right != NULL) {
+        pivot->right->parent = treeNode;
+    }
+    pivot->right = treeNode;
+    treeNode->parent = pivot;
+
+    updateNode(theTree, treeNode);
+    updateNode(theTree, pivot);
+    return pivot;
+}
+
+/**
+ * Restores the AVL property at a node whose children differ in height by at most 2
+ * @return the node now at the top of the subtree
+ */
+static TreeNode* rebalance(Tree* theTree, TreeNode* treeNode) {
+    int balance = getHeight(treeNode->left) - getHeight(treeNode->right);
+
+    if (balance > 1) {
+        //Left-right case needs the left child turned first
+        if (getHeight(treeNode->left->left) < getHeight(treeNode->left->right)) {
+            rotateLeft(theTree, treeNode->left);
+        }
+        return rotateRight(theTree, treeNode);
+    }
+    else if (balance < -1) {
+        //Right-left case needs the right child turned first
+        if (getHeight(treeNode->right->right) < getHeight(treeNode->right->left)) {
+            rotateRight(theTree, treeNode->right);
+        }
+        return rotateLeft(theTree, treeNode);
+    }
+
+    return treeNode;
+}
+
+/**
+ * Rotates a node above its parent
+ */
+static void rotateUp(Tree* theTree, TreeNode* treeNode) {
+    if (treeNode->parent->left == treeNode) {
+        rotateRight(theTree, treeNode->parent);
+    }
+    else {
+        rotateLeft(theTree, treeNode->parent);
+    }
+}
+
+/**
+ * Moves a node to the root with zig-zig and zig-zag steps. Every ancestor is
+ * rotated bottom up, so heights and sizes on the path end up correct without a retrace.
+ */
+static void splay(Tree* theTree, TreeNode* treeNode) {
+    while (treeNode->parent != NULL) {
+        TreeNode* parent = treeNode->parent;
+        TreeNode* grandparent = parent->parent;
+
+        if (grandparent == NULL) {
+            rotateUp(theTree, treeNode);
+        }
+        else if ((grandparent->left == parent) == (parent->left == treeNode)) {
+            //Zig-zig turns the grandparent first, which roughly halves the depth of the path
+            rotateUp(theTree, parent);
+            rotateUp(theTree, treeNode);
+        }
+        else {
+            rotateUp(theTree, treeNode);
+            rotateUp(theTree, treeNode);
+        }
+    }
+}
+
+/**
+ * Walks from a changed node up to the root fixing heights, and rebalancing in AVL mode
+ */
+static void retrace(Tree* theTree, TreeNode* treeNode) {
+    while (treeNode != NULL) {
+        updateNode(theTree, treeNode);
+        if (theTree->mode == TREE_AVL || theTree->mode == TREE_INTERVAL) {
+            treeNode = rebalance(theTree, treeNode);
+        }
+        treeNode = treeNode->parent;
+    }
+}
+
 void destroyBinTree(Tree* toDestroy) {
     //Check if the tree is NULL, if it is, there's nothing to delete
     if (toDestroy == NULL) {
         return;
     }
-    destroyBinTreeSub(toDestroy->root, toDestroy->deleteFunc);
+    //Arena nodes go all at once with the arena, so without data to delete there is nothing to walk
+    if (toDestroy->deleteFunc != NULL || allocatorReleasesEach(toDestroy->allocator)) {
+        destroyNodes(toDestroy->root, toDestroy->deleteFunc, toDestroy->nodeBlock, toDestroy->blockSize, toDestroy->allocator);
+    }
+    allocatorReleaseBulk(toDestroy->allocator, toDestroy->nodeBlock, sizeof(TreeNode) * toDestroy->blockSize);
     free(toDestroy);
 }
 
 void destroyBinTreeSub(TreeNode* tempNode, DeleteFunc del) {
-    if (tempNode == NULL) {
-        return;
+    destroyNodes(tempNode, del, NULL, 0, NULL);
+}
+
+/**
+ * Walks down from *link calling compare once per level and hangs a new node
+ * off the last node visited, allocated from allocator
+ * @return the new node, NULL if equal data is already in the tree or allocation failed
+ */
+static TreeNode* attachNewNode(TreeNode** link, TreeDataPtr data, CompareFunc compare, Allocator* allocator) {
+    TreeNode* parent = NULL;
+    STAT_LOCAL(compares);
+
+    while (*link != NULL) {
+        int result = compare((*link)->data, data);
+        STAT_INC(compares);
+        if (result == 0) {
+            STAT_RECORD(STATS_TREE, STAT_COMPARES, compares);
+            return NULL;
+        }
+        parent = *link;
+        link = result < 0 ? &parent->right : &parent->left;
+    }
+
+    //One compare per level, the new node goes one below the last
+    STAT_RECORD(STATS_TREE, STAT_COMPARES, compares);
+    STAT_RECORD(STATS_TREE, STAT_DEPTH, compares + 1);
+
+    TreeNode* newNode = allocateTreeNode(allocator, data);
+    if (newNode == NULL) {
+        return NULL;
     }
+    newNode->parent = parent;
+    *link = newNode;
 
-    destroyBinTreeSub(tempNode->left, del);
-    destroyBinTreeSub(tempNode->right, del);
-    del(tempNode->data);
+    return newNode;
 }
 
 void addToTree(Tree* theTree, TreeDataPtr data) {
-    if (theTree->root == NULL) {
-        theTree->root = insert(theTree->root, data, theTree->compareFunc);
-        theTree->count++;
-    }
-    else {
-        insert(theTree->root, data, theTree->compareFunc);
+    TreeNode* newNode = attachNewNode(&theTree->root, data, theTree->compareFunc, theTree->allocator);
+
+    //Duplicates are not added
+    if (newNode != NULL) {
         theTree->count++;
+        if (theTree->mode == TREE_SPLAY) {
+            splay(theTree, newNode);
+        }
+        else {
+            retrace(theTree, newNode);
+        }
     }
 }
 
 TreeNode* insert(TreeNode* treeNode, TreeDataPtr data, CompareFunc compare) {
     //Base case: Tree is empty - Create node with data
     if (treeNode == NULL) {
-        treeNode = createTreeNode(data);
+        return createTreeNode(data);
     }
 
-    //Recurse to the right if the treeNode is more than the current data
-    if (compare(treeNode->data, data) < 0) {
-        treeNode->right = insert(treeNode->right, data, compare);
-    }
-    //Recurse to the left if the treeNode is less than the current data
-    else if (compare(treeNode->data, data) > 0) {
-        treeNode->left = insert(treeNode->left, data, compare);
+    //Fix heights on the path from the new node back up to treeNode
+    TreeNode* newNode = attachNewNode(&treeNode, data, compare, NULL);
+    if (newNode != NULL) {
+        TreeNode* stop = treeNode->parent;
+        for (TreeNode* tempNode = newNode->parent; tempNode != stop; tempNode = tempNode->parent) {
+            updateNode(NULL, tempNode);
+        }
     }
 
     //Return
@@ -77,16 +409,36 @@ TreeNode* insert(TreeNode* treeNode, TreeDataPtr data, CompareFunc compare) {
 }
 
 void removeFromTree(Tree* theTree, TreeDataPtr data) {
-    TreeNode* tempNode = createTreeNode(data);
-    TreeNode* returnedNode = removeFromTreeSub(tempNode, data, theTree->compareFunc, theTree->deleteFunc);
+    TreeNode* tempNode = findInTreeSub(theTree->root, data, theTree->compareFunc);
+
+    if (tempNode == NULL) {
+        return;
+    }
 
-    if (returnedNode == NULL) {
-        printf("Successfully deleted\n");
+    if (theTree->deleteFunc != NULL) {
+        theTree->deleteFunc(tempNode->data);
     }
-    else {
-        printf("Unsuccessful deletion attempt\n");
+
+    //A node with two children takes its successor's data and the successor is unlinked instead
+    if (hasTwoChildren(tempNode) == 1) {
+        TreeNode* successor = findMin(tempNode->right);
+        tempNode->data = successor->data;
+        tempNode = successor;
     }
 
+    //The node now has at most one child, which takes its place
+    TreeNode* parent = tempNode->parent;
+    TreeNode* child = tempNode->left != NULL ? tempNode->left : tempNode->right;
+    replaceChild(theTree, parent, tempNode, child);
+    releaseNode(theTree, tempNode);
+    theTree->count--;
+
+    if (theTree->mode == TREE_SPLAY && parent != NULL) {
+        splay(theTree, parent);
+    }
+    else {
+        retrace(theTree, parent);
+    }
 }
 
 TreeNode* removeFromTreeSub(TreeNode *tempNode, TreeDataPtr data, CompareFunc compare, DeleteFunc del) {
@@ -94,43 +446,79 @@ TreeNode* removeFromTreeSub(TreeNode *tempNode, TreeDataPtr data, CompareFunc co
         return tempNode;
     }
     else if (compare(data, tempNode->data) < 0) {
-        removeFromTreeSub(tempNode->left, data, compare, del);
+        tempNode->left = removeFromTreeSub(tempNode->left, data, compare, del);
+        if (tempNode->left != NULL) {
+            tempNode->left->parent = tempNode;
+        }
     }
     else if (compare(data, tempNode->data) > 0) {
-        removeFromTreeSub(tempNode->right, data, compare, del);
+        tempNode->right = removeFromTreeSub(tempNode->right, data, compare, del);
+        if (tempNode->right != NULL) {
+            tempNode->right->parent = tempNode;
+        }
     }
     else {
         if (isLeaf(tempNode) == 1) {
             del(tempNode->data);
             free(tempNode);
-            //tempNode = NULL;
+            return NULL;
         }
         else if (hasOneChild(tempNode) == 1) {
-            if (tempNode->left == NULL) {
-                TreeNode *temp = tempNode;
-                tempNode = tempNode->right;
-                del(temp->data);
-                free(temp);
-                //temp = NULL;
-            }
-            else {
-                TreeNode *temp = tempNode;
-                tempNode = tempNode->left;
-                del(temp->data);
-                free(temp);
-                //temp = NULL;
-            }
+            TreeNode *temp = tempNode;
+            tempNode = tempNode->left != NULL ? tempNode->left : tempNode->right;
+            tempNode->parent = temp->parent;
+            del(temp->data);
+            free(temp);
+            return tempNode;
         }
         else {
+            //Swap data with the successor, which is then the leftmost match in the right subtree
             TreeNode *temp = findMin(tempNode->right);
+            TreeDataPtr removed = tempNode->data;
             tempNode->data = temp->data;
-            removeFromTreeSub(tempNode->right, tempNode->data, compare, del);
+            temp->data = removed;
+            tempNode->right = removeFromTreeSub(tempNode->right, removed, compare, del);
+            if (tempNode->right != NULL) {
+                tempNode->right->parent = tempNode;
+            }
         }
     }
+    updateNode(NULL, tempNode);
     return tempNode;
 }
 
+/**
+ * findInTree for TREE_SPLAY mode, splays the match or the last node visited
+ */
+static TreeDataPtr splayFind(Tree* theTree, TreeDataPtr data) {
+    TreeNode* treeNode = theTree->root;
+    TreeNode* last = NULL;
+    STAT_LOCAL(compares);
+
+    while (treeNode != NULL) {
+        int result = theTree->compareFunc(treeNode->data, data);
+        STAT_INC(compares);
+        last = treeNode;
+        if (result == 0) {
+            break;
+        }
+        treeNode = result < 0 ? treeNode->right : treeNode->left;
+    }
+    STAT_RECORD(STATS_TREE, STAT_COMPARES, compares);
+    STAT_RECORD(STATS_TREE, STAT_DEPTH, compares);
+
+    if (last != NULL) {
+        splay(theTree, last);
+    }
+
+    return treeNode != NULL ? treeNode->data : NULL;
+}
+
 TreeDataPtr findInTree(Tree* theTree, TreeDataPtr data) {
+    if (theTree->mode == TREE_SPLAY) {
+        return splayFind(theTree, data);
+    }
+
     //Send data to recursive function for searching
     TreeNode* returned = findInTreeSub(theTree->root, data, theTree->compareFunc);
 
@@ -144,18 +532,103 @@ TreeDataPtr findInTree(Tree* theTree, TreeDataPtr data) {
 }
 
 TreeNode* findInTreeSub(TreeNode* treeNode, TreeDataPtr data, CompareFunc compare) {
-    //Base case: Check if the treeNode is the data - if it is, return it
-    if (treeNode == NULL || compare(treeNode->data, data) == 0) {
-        return treeNode;
+    //One compare per level, so the count is also the depth reached
+    STAT_LOCAL(compares);
+
+    while (treeNode != NULL) {
+        int result = compare(treeNode->data, data);
+        STAT_INC(compares);
+
+        //Check if the treeNode is the data - if it is, return it
+        if (result == 0) {
+            STAT_RECORD(STATS_TREE, STAT_COMPARES, compares);
+            STAT_RECORD(STATS_TREE, STAT_DEPTH, compares);
+            return treeNode;
+        }
+        //Go to the right if the treeNode is less than the data, otherwise to the left
+        treeNode = result < 0 ? treeNode->right : treeNode->left;
     }
-    //Recurse to the right if the treeNode is more than the current data
-    else if (compare(treeNode->data, data) < 0) {
-        return findInTreeSub(treeNode->right, data, compare);
+
+    STAT_RECORD(STATS_TREE, STAT_COMPARES, compares);
+    STAT_RECORD(STATS_TREE, STAT_DEPTH, compares);
+    return NULL;
+}
+
+/**
+ * Progress of one lookup in findManyInTree. Every step ends with a prefetch
+ * and moves on to another lookup, so the line has arrived when it comes round again.
+ */
+typedef enum batchStage {
+    BATCH_LOAD_NODE,    //The node is on its way, its data pointer is not known yet
+    BATCH_LOAD_DATA    //The data is on its way, compare on the next visit
+} BatchStage;
+
+typedef struct batchLookup {
+    TreeNode* node;
+    int index;    //Position in keys, -1 while the slot is idle
+    BatchStage stage;
+} BatchLookup;
+
+int findManyInTree(Tree* theTree, TreeDataPtr keys[], int n, TreeDataPtr out[]) {
+    if (theTree == NULL || keys == NULL || out == NULL) {
+        return 0;
     }
-    //Recurse to the left if the treeNode is less than the current data
-    else {
-        return findInTreeSub(treeNode->left, data, compare);
+
+    BatchLookup lookups[TREE_BATCH_LOOKUPS];
+    int started = 0;
+    int finished = 0;
+    int found = 0;
+
+    for (int i = 0; i < TREE_BATCH_LOOKUPS; i++) {
+        lookups[i].index = -1;
+    }
+
+    while (finished < n) {
+        for (int i = 0; i < TREE_BATCH_LOOKUPS; i++) {
+            BatchLookup* lookup = &lookups[i];
+
+            if (lookup->index < 0) {
+                if (started < n) {
+                    lookup->index = started++;
+                    lookup->node = theTree->root;
+                    lookup->stage = BATCH_LOAD_NODE;
+                }
+                continue;
+            }
+
+            TreeNode* treeNode = lookup->node;
+            if (treeNode == NULL) {
+                out[lookup->index] = NULL;
+                lookup->index = -1;
+                finished++;
+                continue;
+            }
+
+            if (lookup->stage == BATCH_LOAD_NODE) {
+                __builtin_prefetch(treeNode->data);
+                lookup->stage = BATCH_LOAD_DATA;
+                continue;
+            }
+
+            int result = theTree->compareFunc(treeNode->data, keys[lookup->index]);
+            if (result == 0) {
+                out[lookup->index] = treeNode->data;
+                lookup->index = -1;
+                finished++;
+                found++;
+                continue;
+            }
+
+            treeNode = result < 0 ? treeNode->right : treeNode->left;
+            if (treeNode != NULL) {
+                __builtin_prefetch(treeNode);
+            }
+            lookup->node = treeNode;
+            lookup->stage = BATCH_LOAD_NODE;
+        }
     }
+
+    return found;
 }
 
 TreeDataPtr getRootData(Tree* theTree) {
@@ -209,6 +682,377 @@ void printPostOrderSub(Tree* theTree, TreeNode* treeNode, PrintFunc printData) {
     printData(treeNode->data);
 }
 
+int visitInOrder(Tree* theTree, VisitFunc visit, void* context) {
+    if (theTree == NULL || theTree->root == NULL) {
+        return 0;
+    }
+
+    for (TreeNode* treeNode = findMin(theTree->root); treeNode != NULL; treeNode = findSuccessor(treeNode)) {
+        int result = visit(treeNode->data, context);
+        if (result != 0) {
+            return result;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Next node in pre order within the subtree rooted at top, NULL once it is done
+ */
+static TreeNode* nextPreOrder(TreeNode* treeNode, TreeNode* top) {
+    if (treeNode->left != NULL) {
+        return treeNode->left;
+    }
+    if (treeNode->right != NULL) {
+        return treeNode->right;
+    }
+
+    //Climb until we come up from a left child whose sibling has not been visited
+    while (treeNode != top) {
+        TreeNode* parent = treeNode->parent;
+        if (parent->left == treeNode && parent->right != NULL) {
+            return parent->right;
+        }
+        treeNode = parent;
+    }
+
+    return NULL;
+}
+
+/**
+ * Visits the subtree rooted at top in pre order, checking stop before every element
+ */
+static int visitSubtree(TreeNode* top, VisitFunc visit, void* context, atomic_int* stop) {
+    for (TreeNode* treeNode = top; treeNode != NULL; treeNode = nextPreOrder(treeNode, top)) {
+        if (stop != NULL && atomic_load_explicit(stop, memory_order_relaxed) != 0) {
+            return 0;
+        }
+        int result = visit(treeNode->data, context);
+        if (result != 0) {
+            return result;
+        }
+    }
+
+    return 0;
+}
+
+int visitPreOrder(Tree* theTree, VisitFunc visit, void* context) {
+    if (theTree == NULL || theTree->root == NULL) {
+        return 0;
+    }
+
+    return visitSubtree(theTree->root, visit, context, NULL);
+}
+
+/**
+ * First node in post order of a subtree, the leaf reached by going left whenever possible
+ */
+static TreeNode* firstPostOrder(TreeNode* treeNode) {
+    while (isLeaf(treeNode) == 0) {
+        treeNode = treeNode->left != NULL ? treeNode->left : treeNode->right;
+    }
+
+    return treeNode;
+}
+
+int visitPostOrder(Tree* theTree, VisitFunc visit, void* context) {
+    if (theTree == NULL || theTree->root == NULL) {
+        return 0;
+    }
+
+    TreeNode* treeNode = firstPostOrder(theTree->root);
+    while (treeNode != NULL) {
+        int result = visit(treeNode->data, context);
+        if (result != 0) {
+            return result;
+        }
+
+        //The parent comes next after its right child, or after its left child when there is no right
+        TreeNode* parent = treeNode->parent;
+        if (parent == NULL || parent->right == treeNode || parent->right == NULL) {
+            treeNode = parent;
+        }
+        else {
+            treeNode = firstPostOrder(parent->right);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * A piece of work for visitParallel: a whole subtree, or a single node whose subtree was cut up
+ */
+typedef struct visitTask {
+    TreeNode* treeNode;
+    bool whole;
+} VisitTask;
+
+typedef struct parallelVisit {
+    VisitTask* tasks;
+    int numTasks;
+    VisitFunc visit;
+    atomic_int nextTask;
+    atomic_int result; //First nonzero result, which also tells the other threads to stop
+} ParallelVisit;
+
+typedef struct visitWorker {
+    ParallelVisit* shared;
+    void* context;
+    pthread_t thread;
+} VisitWorker;
+
+static void* runVisitWorker(void* arg) {
+    VisitWorker* worker = arg;
+    ParallelVisit* shared = worker->shared;
+    int task;
+
+    while ((task = atomic_fetch_add(&shared->nextTask, 1)) < shared->numTasks) {
+        VisitTask* visitTask = &shared->tasks[task];
+        int result;
+
+        if (atomic_load_explicit(&shared->result, memory_order_relaxed) != 0) {
+            break;
+        }
+        if (visitTask->whole) {
+            result = visitSubtree(visitTask->treeNode, shared->visit, worker->context, &shared->result);
+        }
+        else {
+            result = shared->visit(visitTask->treeNode->data, worker->context);
+        }
+
+        if (result != 0) {
+            int expected = 0;
+            atomic_compare_exchange_strong(&shared->result, &expected, result);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+int visitParallel(Tree* theTree, VisitFunc visit, void* contexts[], int numThreads) {
+    if (theTree == NULL || theTree->root == NULL) {
+        return 0;
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+
+    //Cut the largest subtrees first until there are enough pieces, each cut leaves a single node task
+    int target = numThreads * TREE_VISIT_TASKS_PER_THREAD;
+    int grain = theTree->count / target;
+    VisitTask* tasks = malloc(sizeof(VisitTask) * (2 * target + 1));
+    if (tasks == NULL) {
+        return visitPreOrder(theTree, visit, contexts != NULL ? contexts[0] : NULL);
+    }
+
+    int numTasks = 0;
+    tasks[numTasks++] = (VisitTask){theTree->root, true};
+    for (int i = 0; i < numTasks && numTasks + 2 <= 2 * target + 1; i++) {
+        TreeNode* treeNode = tasks[i].treeNode;
+        if (getSize(treeNode) <= grain || isLeaf(treeNode) == 1) {
+            continue;
+        }
+        tasks[i].whole = false;
+        if (treeNode->left != NULL) {
+            tasks[numTasks++] = (VisitTask){treeNode->left, true};
+        }
+        if (treeNode->right != NULL) {
+            tasks[numTasks++] = (VisitTask){treeNode->right, true};
+        }
+    }
+
+    ParallelVisit shared;
+    shared.tasks = tasks;
+    shared.numTasks = numTasks;
+    shared.visit = visit;
+    atomic_init(&shared.nextTask, 0);
+    atomic_init(&shared.result, 0);
+
+    VisitWorker* workers = malloc(sizeof(VisitWorker) * numThreads);
+    if (workers == NULL) {
+        free(tasks);
+        return visitPreOrder(theTree, visit, contexts != NULL ? contexts[0] : NULL);
+    }
+
+    for (int i = 0; i < numThreads; i++) {
+        workers[i].shared = &shared;
+        workers[i].context = contexts != NULL ? contexts[i] : NULL;
+    }
+
+    //The calling thread is worker 0, the others are forked here and joined below.
+    //If a thread cannot be started the rest of the tasks go to those that were.
+    int started = 1;
+    while (started < numThreads && pthread_create(&workers[started].thread, NULL, runVisitWorker, &workers[started]) == 0) {
+        started++;
+    }
+    runVisitWorker(&workers[0]);
+    for (int i = 1; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    free(workers);
+    free(tasks);
+
+    return atomic_load(&shared.result);
+}
+
+int visitOverlapping(Tree* theTree, long long lo, long long hi, VisitFunc visit, void* context) {
+    if (theTree == NULL || theTree->endFunc == NULL) {
+        return 0;
+    }
+
+    //Interval trees are AVL balanced, so the path held here stays well under 64 nodes
+    TreeNode* stack[64];
+    int depth = 0;
+    TreeNode* treeNode = theTree->root;
+
+    while (treeNode != NULL || depth > 0) {
+        if (treeNode != NULL) {
+            //Nothing in a subtree ending before lo can overlap
+            if (treeNode->maxEnd < lo) {
+                treeNode = NULL;
+            }
+            else {
+                stack[depth++] = treeNode;
+                treeNode = treeNode->left;
+            }
+            continue;
+        }
+
+        treeNode = stack[--depth];
+        //Nodes are visited in start order, so once one starts after hi so does every later one
+        if (theTree->startFunc(treeNode->data) > hi) {
+            return 0;
+        }
+        if (theTree->endFunc(treeNode->data) >= lo) {
+            int result = visit(treeNode->data, context);
+            if (result != 0) {
+                return result;
+            }
+        }
+        treeNode = treeNode->right;
+    }
+
+    return 0;
+}
+
+typedef struct overlapCollector {
+    TreeDataPtr* out;
+    int max;
+    int found;
+} OverlapCollector;
+
+static int collectOverlap(void* data, void* context) {
+    OverlapCollector* collector = context;
+
+    if (collector->found == collector->max) {
+        return 1;
+    }
+    collector->out[collector->found++] = data;
+    return 0;
+}
+
+int findOverlapping(Tree* theTree, long long lo, long long hi, TreeDataPtr out[], int max) {
+    if (out == NULL || max <= 0) {
+        return 0;
+    }
+
+    OverlapCollector collector = {out, max, 0};
+    visitOverlapping(theTree, lo, hi, collectOverlap, &collector);
+
+    return collector.found;
+}
+
+MemoryUsage getTreeMemoryUsage(Tree* theTree) {
+    MemoryUsage usage = {0, 0, 0};
+    if (theTree == NULL) {
+        return usage;
+    }
+
+    size_t nodeFootprint = allocatorFootprint(theTree->allocator, sizeof(TreeNode));
+    int inBlock = 0;
+
+    usage.metadata = sizeof(Tree);
+    for (TreeNode* treeNode = findMin(theTree->root); treeNode != NULL; treeNode = findSuccessor(treeNode)) {
+        usage.payload += sizeof(treeNode->data);
+        usage.metadata += sizeof(TreeNode) - sizeof(treeNode->data);
+        if (isInBlock(treeNode, theTree->nodeBlock, theTree->blockSize)) {
+            inBlock++;
+        }
+        else {
+            usage.slack += nodeFootprint - sizeof(TreeNode);
+        }
+    }
+
+    //Block nodes freed by removeFromTree stay allocated until the block goes
+    if (theTree->nodeBlock != NULL) {
+        size_t blockBytes = sizeof(TreeNode) * theTree->blockSize;
+        usage.slack += sizeof(TreeNode) * (theTree->blockSize - inBlock) + allocatorBulkFootprint(theTree->allocator, blockBytes) - blockBytes;
+    }
+
+    return usage;
+}
+
+/**
+ * Maps a node of the old tree to its copy, whose address compactTree left in the old node's data
+ */
+static TreeNode* movedNode(TreeNode* treeNode) {
+    return treeNode == NULL ? NULL : treeNode->data;
+}
+
+bool compactTree(Tree* theTree) {
+    if (theTree == NULL) {
+        return false;
+    }
+
+    int count = getSize(theTree->root);
+    if (count == 0) {
+        allocatorReleaseBulk(theTree->allocator, theTree->nodeBlock, sizeof(TreeNode) * theTree->blockSize);
+        theTree->nodeBlock = NULL;
+        theTree->blockSize = 0;
+        return true;
+    }
+
+    TreeNode* block = allocatorAllocBulk(theTree->allocator, sizeof(TreeNode) * count);
+    TreeNode** oldNodes = malloc(sizeof(TreeNode*) * count);
+    if (block == NULL || oldNodes == NULL) {
+        allocatorReleaseBulk(theTree->allocator, block, sizeof(TreeNode) * count);
+        free(oldNodes);
+        return false;
+    }
+
+    //Copy in order and leave each copy's address in the old node, the old links stay intact
+    int i = 0;
+    for (TreeNode* treeNode = findMin(theTree->root); treeNode != NULL; treeNode = findSuccessor(treeNode)) {
+        block[i] = *treeNode;
+        oldNodes[i] = treeNode;
+        treeNode->data = &block[i];
+        i++;
+    }
+
+    for (i = 0; i < count; i++) {
+        block[i].left = movedNode(block[i].left);
+        block[i].right = movedNode(block[i].right);
+        block[i].parent = movedNode(block[i].parent);
+    }
+    theTree->root = movedNode(theTree->root);
+
+    //Arena nodes stay in the arena until it is reset
+    for (i = 0; i < count; i++) {
+        releaseNode(theTree, oldNodes[i]);
+    }
+    free(oldNodes);
+
+    allocatorReleaseBulk(theTree->allocator, theTree->nodeBlock, sizeof(TreeNode) * theTree->blockSize);
+    theTree->nodeBlock = block;
+    theTree->blockSize = count;
+
+    return true;
+}
+
 int isTreeEmpty(Tree* theTree) {
     if (theTree->root == NULL) {
         //Return 1 because theTree is empty (It does not have a root node)
@@ -265,22 +1109,212 @@ TreeNode* findMin(TreeNode* treeNode) {
     return treeNode;
 }
 
-int getHeight(TreeNode* treeNode) {
-    //Base case: treeNode doesn't exist
-    if (treeNode == NULL) {
-        return 0;
+TreeNode* findMax(TreeNode* treeNode) {
+    //BST will always have higher numbers on right - Traverse the entire right side to find the maximum treeNode
+    while (treeNode->right != NULL) {
+        treeNode = treeNode->right;
+    }
+    return treeNode;
+}
+
+TreeNode* findSuccessor(TreeNode* treeNode) {
+    if (treeNode->right != NULL) {
+        return findMin(treeNode->right);
+    }
+
+    //Climb until we come up from a left child
+    while (treeNode->parent != NULL && treeNode->parent->right == treeNode) {
+        treeNode = treeNode->parent;
+    }
+    return treeNode->parent;
+}
+
+TreeNode* findPredecessor(TreeNode* treeNode) {
+    if (treeNode->left != NULL) {
+        return findMax(treeNode->left);
+    }
+
+    //Climb until we come up from a right child
+    while (treeNode->parent != NULL && treeNode->parent->left == treeNode) {
+        treeNode = treeNode->parent;
+    }
+    return treeNode->parent;
+}
+
+TreeIterator createTreeIterator(Tree* theTree) {
+    TreeIterator iter;
+
+    iter.tree = theTree;
+    iter.current = theTree->root == NULL ? NULL : findMin(theTree->root);
+    iter.upper = NULL;
+
+    return iter;
+}
+
+/**
+ * Finds the first node that is after data, or not before it when inclusive is set
+ */
+static TreeNode* findBound(Tree* theTree, TreeDataPtr data, bool inclusive) {
+    TreeNode* treeNode = theTree->root;
+    TreeNode* bound = NULL;
+
+    while (treeNode != NULL) {
+        int result = theTree->compareFunc(treeNode->data, data);
+
+        if (result > 0 || (inclusive && result == 0)) {
+            bound = treeNode;
+            treeNode = treeNode->left;
+        }
+        else {
+            treeNode = treeNode->right;
+        }
+    }
+
+    return bound;
+}
+
+TreeIterator treeLowerBound(Tree* theTree, TreeDataPtr data) {
+    TreeIterator iter;
+
+    iter.tree = theTree;
+    iter.current = findBound(theTree, data, true);
+    iter.upper = NULL;
+
+    return iter;
+}
+
+TreeIterator treeUpperBound(Tree* theTree, TreeDataPtr data) {
+    TreeIterator iter;
+
+    iter.tree = theTree;
+    iter.current = findBound(theTree, data, false);
+    iter.upper = NULL;
+
+    return iter;
+}
+
+TreeDataPtr nextTreeElement(TreeIterator* iter) {
+    TreeNode* tmp = iter->current;
+
+    //Range iterators end at the first element past the upper bound
+    if (tmp != NULL && iter->upper != NULL && iter->tree->compareFunc(tmp->data, iter->upper) > 0) {
+        iter->current = NULL;
+        tmp = NULL;
+    }
+
+    if (tmp != NULL) {
+        iter->current = findSuccessor(tmp);
+        return tmp->data;
+    }
+    else {
+        return NULL;
+    }
+}
+
+TreeDataPtr prevTreeElement(TreeIterator* iter) {
+    TreeNode* tmp;
+
+    //Stepping back from the end gives the largest element
+    if (iter->current == NULL) {
+        tmp = iter->tree->root == NULL ? NULL : findMax(iter->tree->root);
     }
     else {
-        int left = getHeight(treeNode->left);
-        int right = getHeight(treeNode->right);
+        tmp = findPredecessor(iter->current);
+    }
+
+    if (tmp != NULL) {
+        iter->current = tmp;
+        return tmp->data;
+    }
+    else {
+        return NULL;
+    }
+}
+
+TreeIterator treeRangeIterator(Tree* theTree, TreeDataPtr lo, TreeDataPtr hi) {
+    TreeIterator iter = treeLowerBound(theTree, lo);
+
+    iter.upper = hi;
+
+    return iter;
+}
+
+/**
+ * Counts the elements before data, or not after it when inclusive is set,
+ * adding whole left subtrees through their size on the way down
+ */
+static int countBelow(Tree* theTree, TreeDataPtr data, bool inclusive) {
+    TreeNode* treeNode = theTree->root;
+    int count = 0;
+
+    while (treeNode != NULL) {
+        int result = theTree->compareFunc(treeNode->data, data);
+
+        if (result < 0 || (inclusive && result == 0)) {
+            count += getSize(treeNode->left) + 1;
+            treeNode = treeNode->right;
+        }
+        else {
+            treeNode = treeNode->left;
+        }
+    }
+
+    return count;
+}
+
+int treeRank(Tree* theTree, TreeDataPtr data) {
+    return countBelow(theTree, data, false);
+}
 
-        if (left > right) {
-            return (left + 1);
+TreeDataPtr treeSelect(Tree* theTree, int k) {
+    TreeNode* treeNode = theTree->root;
+
+    if (k < 0 || k >= getSize(treeNode)) {
+        return NULL;
+    }
+
+    while (treeNode != NULL) {
+        int leftSize = getSize(treeNode->left);
+
+        if (k < leftSize) {
+            treeNode = treeNode->left;
+        }
+        else if (k == leftSize) {
+            return treeNode->data;
         }
         else {
-            return (right + 1);
+            k -= leftSize + 1;
+            treeNode = treeNode->right;
         }
     }
+
+    return NULL;
+}
+
+int treeRangeCount(Tree* theTree, TreeDataPtr lo, TreeDataPtr hi) {
+    int count = countBelow(theTree, hi, true) - countBelow(theTree, lo, false);
+
+    return count > 0 ? count : 0;
+}
+
+int getSize(TreeNode* treeNode) {
+    if (treeNode == NULL) {
+        return 0;
+    }
+    else {
+        return treeNode->size;
+    }
+}
+
+int getHeight(TreeNode* treeNode) {
+    //Base case: treeNode doesn't exist
+    if (treeNode == NULL) {
+        return 0;
+    }
+    else {
+        //Heights are kept up to date by every insert, remove and rotation
+        return treeNode->height;
+    }
 }
 
 //int findMaxSide(int leftSide, int rightSide) {
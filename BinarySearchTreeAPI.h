@@ -1,18 +1,44 @@
 #ifndef BINSEARCHTREE_BINARYSEARCHTREEAPI_H
 #define BINSEARCHTREE_BINARYSEARCHTREEAPI_H
 
+#include "AllocatorAPI.h"
+
 /**
  * Function pointer typedefs
  */
 typedef int (*CompareFunc)(const void* a, const void* b);
 typedef void (*DeleteFunc)(void* data);
 typedef void (*PrintFunc)(void* data);
+typedef int (*VisitFunc)(void* data, void* context); //Return 0 to continue, anything else stops the traversal
+typedef long long (*EndpointFunc)(const void* data); //Start or end of the interval a piece of data covers
 
 /**
  * Typedef the void* to make the API cleaner and more readable
  */
 typedef void* TreeDataPtr;
 
+/**
+ * Number of independent lookups findManyInTree interleaves, enough to
+ * cover a memory access with the work of the other lookups
+ */
+#define TREE_BATCH_LOOKUPS 16
+
+/**
+ * visitParallel cuts the tree into about this many subtrees per thread, so
+ * threads that finish early can take more work
+ */
+#define TREE_VISIT_TASKS_PER_THREAD 8
+
+/**
+ * Balancing strategy used by a tree
+ */
+typedef enum treeMode {
+    TREE_UNBALANCED,    //Plain binary search tree, the shape follows the insertion order
+    TREE_AVL,    //Height balanced after every insert and remove, height stays O(log n)
+    TREE_SPLAY,    //Every insert and findInTree splays the node to the root, so frequently used data stays near the top
+    TREE_INTERVAL    //AVL balanced, and every node tracks the largest interval end in its subtree, see createIntervalTree
+} TreeMode;
+
 /**
  * A single binary tree node with left and right branches
  * void *data
@@ -22,6 +48,9 @@ typedef struct binTreeNode {
     struct binTreeNode* left;
     struct binTreeNode* right;
     struct binTreeNode* parent; //Optional but useful
+    int height; //(1-Based) height of the subtree rooted at this node
+    int size; //Number of nodes in the subtree rooted at this node
+    long long maxEnd; //Largest interval end in the subtree, only kept up to date by interval trees
     //Tree* parentTree; //Optional but gets you access to function pointers
 } TreeNode;
 
@@ -34,10 +63,27 @@ typedef struct binTree {
     DeleteFunc deleteFunc;
     PrintFunc printFunc;
     int count;
+    TreeMode mode;
+    TreeNode* nodeBlock; //Nodes allocated together by buildTreeFromSorted or compactTree, NULL otherwise
+    int blockSize;
+    EndpointFunc startFunc; //Interval of each piece of data, NULL unless made by createIntervalTree
+    EndpointFunc endFunc;
+    Allocator* allocator; //Where nodes added later come from, NULL for malloc
     //Additions must work with abstract data types
     //Additional function pointers to generalize tree
 } Tree;
 
+/**
+ * Tree iterator structure. Walks the tree in order through parent pointers,
+ * without recursion, at O(1) amortized per step.
+ * current is the node nextTreeElement returns next, NULL once past the end.
+ */
+typedef struct treeIter {
+    Tree* tree;
+    TreeNode* current;
+    TreeDataPtr upper; //Iteration ends after the last element not greater than upper, NULL for no bound
+} TreeIterator;
+
 /**
  * Creates a TreeNode. TreeNode children are set to NULL and data is set
  * to the passed in data
@@ -56,14 +102,67 @@ TreeNode* createTreeNode(TreeDataPtr data);
 Tree* createBinTree(CompareFunc compare, DeleteFunc del, PrintFunc print);
 
 /**
- * Remove all items and free memory
+ * Allocates memory for a tree with the given balancing mode and assigned function pointers
+ * @param compare Function pointer to compare data in tree Nodes
+ * @param del Function pointer to delete data from tree Nodes
+ * @param print Function pointer to print data from tree Nodes
+ * @param mode TREE_AVL to keep the tree balanced, TREE_UNBALANCED for a plain BST
+ * @return Newly created tree
+ */
+Tree* createBinTreeWithMode(CompareFunc compare, DeleteFunc del, PrintFunc print, TreeMode mode);
+
+/**
+ * Allocates memory for a tree whose nodes come from allocator. Nodes of one slab or arena
+ * sit next to each other instead of being spread over the heap. With an arena allocator
+ * destroyBinTree does not free nodes one by one, and when del is NULL it does not walk
+ * the tree at all: the nodes are released when the arena is reset or destroyed.
+ * The block made by compactTree comes from the allocator's bulk allocation.
+ * @param compare Function pointer to compare data in tree Nodes
+ * @param del Function pointer to delete data from tree Nodes, NULL if the tree does not own its data
+ * @param print Function pointer to print data from tree Nodes
+ * @param mode Balancing mode of the tree
+ * @param allocator Allocator for the nodes, NULL for malloc. It must outlive the tree
+ * @return Newly created tree
+ */
+Tree* createBinTreeWithAllocator(CompareFunc compare, DeleteFunc del, PrintFunc print, TreeMode mode, Allocator* allocator);
+
+/**
+ * Allocates memory for an AVL balanced interval tree, where each piece of
+ * data covers the closed interval [start(data), end(data)]
+ * @pre compare orders data by start first, ties broken by any other field
+ * @param compare Function pointer to compare data in tree Nodes
+ * @param del Function pointer to delete data from tree Nodes
+ * @param print Function pointer to print data from tree Nodes
+ * @param start Function pointer giving the start of the interval of a piece of data
+ * @param end Function pointer giving the end of the interval of a piece of data
+ * @return Newly created tree
+ */
+Tree* createIntervalTree(CompareFunc compare, DeleteFunc del, PrintFunc print, EndpointFunc start, EndpointFunc end);
+
+/**
+ * Builds a perfectly balanced tree from data already sorted by compare, in O(n).
+ * Every node comes from a single allocation that is released as a whole by destroyBinTree.
+ * @pre data is strictly increasing according to compare
+ * @param data Array of n elements to store in the tree
+ * @param n Number of elements in data
+ * @param compare Function pointer to compare data in tree Nodes
+ * @param del Function pointer to delete data from tree Nodes
+ * @param print Function pointer to print data from tree Nodes
+ * @param mode Balancing mode used for later inserts and removes, not TREE_INTERVAL
+ * @return Newly created tree, NULL on allocation failure or if mode is TREE_INTERVAL
+ */
+Tree* buildTreeFromSorted(TreeDataPtr data[], int n, CompareFunc compare, DeleteFunc del, PrintFunc print, TreeMode mode);
+
+/**
+ * Remove all items and free memory, without recursion
  * @param Tree toDestroy
  * @return void
  */
 void destroyBinTree(Tree* toDestroy);
 
 /**
- * Recursive call for destroyBinTree to delete every treeNode of a tree
+ * Deletes the data and frees every treeNode of a subtree, without recursion.
+ * Not for trees made by buildTreeFromSorted, use destroyBinTree on those.
  * @param TreeNode tempNode
  * @param DeleteFunc del
  * @return void
@@ -79,11 +178,12 @@ void destroyBinTreeSub(TreeNode* tempNode, DeleteFunc del);
 void addToTree(Tree* theTree, TreeDataPtr data);
 
 /**
- * Recursively find where to insert the new Node
+ * Iteratively find where to insert the new Node, comparing once per level.
+ * Does not rebalance, use addToTree on balanced trees.
  * @param TreeNode treeNode
  * @param TreeDataPtr data
  * @param CompareFunc compare
- * @return void
+ * @return TreeNode root of the subtree
  */
 TreeNode* insert(TreeNode* treeNode, TreeDataPtr data, CompareFunc compare);
 
@@ -96,16 +196,19 @@ TreeNode* insert(TreeNode* treeNode, TreeDataPtr data, CompareFunc compare);
 void removeFromTree(Tree* theTree, TreeDataPtr data);
 
 /**
- * Recursive delete function for tree
+ * Recursive delete function for tree. Keeps parent pointers and heights
+ * but never rebalances, use removeFromTree on balanced trees and trees
+ * made by buildTreeFromSorted.
  * @param TreeNode tempNode
  * @param TreeDataPtr data
  * @param CompareFunc compare
- * @return TreeNode
+ * @return TreeNode new root of the subtree
  */
 TreeNode* removeFromTreeSub(TreeNode* tempNode, TreeDataPtr data, CompareFunc compare, DeleteFunc del);
 
 /**
- * Searches the tree for the target data
+ * Searches the tree for the target data. In TREE_SPLAY mode the node found,
+ * or the last node visited on a miss, is splayed to the root.
  * @param Tree theTree
  * @param TreeDataPtr data
  * @return NULL if fail, otherwise return data
@@ -113,14 +216,26 @@ TreeNode* removeFromTreeSub(TreeNode* tempNode, TreeDataPtr data, CompareFunc co
 TreeDataPtr findInTree(Tree* theTree, TreeDataPtr data);
 
 /**
- * Recursively finds the treeNode in the tree
+ * Iteratively finds the treeNode in the tree, comparing once per level
  * @param TreeNode treeNode
  * @param TreeDataPtr data
  * @param CompareFunc compare
- * @return void
+ * @return NULL if fail, otherwise the treeNode holding data
  */
 TreeNode* findInTreeSub(TreeNode* treeNode, TreeDataPtr data, CompareFunc compare);
 
+/**
+ * Searches the tree for many keys at once, keeping TREE_BATCH_LOOKUPS
+ * traversals in flight and switching between them while the next node of
+ * each is prefetched. Does not restructure the tree in TREE_SPLAY mode.
+ * @param Tree theTree
+ * @param TreeDataPtr keys[] n keys to search for
+ * @param int n
+ * @param TreeDataPtr out[] set to the data found for each key, NULL if not in the tree
+ * @return number of keys found
+ */
+int findManyInTree(Tree* theTree, TreeDataPtr keys[], int n, TreeDataPtr out[]);
+
 /**
  * Get data from the root of the tree if it exists
  * @param Tree theTree
@@ -179,6 +294,96 @@ void printPostOrder(Tree* theTree, PrintFunc printData);
  */
 void printPostOrderSub(Tree* theTree, TreeNode* treeNode, PrintFunc printData);
 
+/**
+ * Calls visit on every element in order, without recursion
+ * @param Tree theTree
+ * @param VisitFunc visit
+ * @param void* context passed to every call of visit
+ * @return 0 if every element was visited, otherwise the value that stopped the traversal
+ */
+int visitInOrder(Tree* theTree, VisitFunc visit, void* context);
+
+/**
+ * Calls visit on every element in pre order, without recursion
+ * @param Tree theTree
+ * @param VisitFunc visit
+ * @param void* context passed to every call of visit
+ * @return 0 if every element was visited, otherwise the value that stopped the traversal
+ */
+int visitPreOrder(Tree* theTree, VisitFunc visit, void* context);
+
+/**
+ * Calls visit on every element in post order, without recursion
+ * @param Tree theTree
+ * @param VisitFunc visit
+ * @param void* context passed to every call of visit
+ * @return 0 if every element was visited, otherwise the value that stopped the traversal
+ */
+int visitPostOrder(Tree* theTree, VisitFunc visit, void* context);
+
+/**
+ * Calls visit on every element from numThreads threads, in no particular
+ * order. The tree is cut into subtrees by size and the threads take them
+ * from a shared queue. Thread i passes contexts[i] to visit, so each thread
+ * can aggregate into its own context, to be combined by the caller.
+ * A nonzero return from any thread stops the others at their next element.
+ * The tree must not change during the traversal.
+ * @param Tree theTree
+ * @param VisitFunc visit
+ * @param void* contexts[] one context per thread, or NULL
+ * @param int numThreads
+ * @return 0 if every element was visited, otherwise the value that stopped the traversal
+ */
+int visitParallel(Tree* theTree, VisitFunc visit, void* contexts[], int numThreads);
+
+/**
+ * Finds the data whose interval overlaps [lo, hi] in an interval tree. The
+ * tree is walked in start order, skipping subtrees whose largest end is below
+ * lo and stopping at the first start above hi. Intervals that start before hi
+ * but end before lo are still walked past inside subtrees that hold a result,
+ * so k results cost O(min(n, k log n)) rather than O(log n + k).
+ * @param Tree theTree made by createIntervalTree
+ * @param long long lo
+ * @param long long hi
+ * @param TreeDataPtr out[] array of at least max elements, filled in start order
+ * @param int max
+ * @return number of elements written to out
+ */
+int findOverlapping(Tree* theTree, long long lo, long long hi, TreeDataPtr out[], int max);
+
+/**
+ * Calls visit on each piece of data whose interval overlaps [lo, hi], in start order,
+ * walking the tree like findOverlapping
+ * @param Tree theTree made by createIntervalTree
+ * @param long long lo
+ * @param long long hi
+ * @param VisitFunc visit
+ * @param void* context passed to every call of visit
+ * @return 0 if every overlap was visited, otherwise the value that stopped the search
+ */
+int visitOverlapping(Tree* theTree, long long lo, long long hi, VisitFunc visit, void* context);
+
+/**
+ * Reports the bytes held by a tree. Payload is the data pointer of every node,
+ * metadata the tree struct and the links, heights and sizes of the nodes, slack
+ * the allocator rounding and the removed nodes still inside the node block.
+ * The data itself belongs to the caller and is not counted.
+ * @param Tree theTree
+ * @return MemoryUsage usage, all zero if theTree is NULL
+ */
+MemoryUsage getTreeMemoryUsage(Tree* theTree);
+
+/**
+ * Copies every node into one block laid out in order and frees the old nodes,
+ * so after long churn an in-order scan walks memory forwards again and the
+ * nodes of removed data are given back. The shape of the tree is unchanged.
+ * TreeNode pointers and iterators taken before the call are no longer valid.
+ * The tree must not be used by other threads during the call.
+ * @param Tree theTree
+ * @return false if the block could not be allocated, the tree is then unchanged
+ */
+bool compactTree(Tree* theTree);
+
 /**
  * Checks if a tree is empty
  * @param Tree theTree
@@ -215,7 +420,110 @@ int hasOneChild(TreeNode* treeNode);
 TreeNode* findMin(TreeNode* treeNode);
 
 /**
- * Gets the height of a particular Node in the tree
+ * Finds the maximum value given a specific treeNode
+ * @param TreeNode treeNode
+ * @return TreeNode
+ */
+TreeNode* findMax(TreeNode* treeNode);
+
+/**
+ * Finds the next treeNode in order using parent pointers
+ * @param TreeNode treeNode
+ * @return NULL if treeNode is the maximum, otherwise the next TreeNode
+ */
+TreeNode* findSuccessor(TreeNode* treeNode);
+
+/**
+ * Finds the previous treeNode in order using parent pointers
+ * @param TreeNode treeNode
+ * @return NULL if treeNode is the minimum, otherwise the previous TreeNode
+ */
+TreeNode* findPredecessor(TreeNode* treeNode);
+
+/**
+ * Creates an iterator positioned at the smallest element of the tree
+ * @param Tree theTree
+ * @return TreeIterator
+ */
+TreeIterator createTreeIterator(Tree* theTree);
+
+/**
+ * Creates an iterator positioned at the first element not less than data
+ * @param Tree theTree
+ * @param TreeDataPtr data
+ * @return TreeIterator, at the end if every element is less than data
+ */
+TreeIterator treeLowerBound(Tree* theTree, TreeDataPtr data);
+
+/**
+ * Creates an iterator positioned at the first element greater than data
+ * @param Tree theTree
+ * @param TreeDataPtr data
+ * @return TreeIterator, at the end if no element is greater than data
+ */
+TreeIterator treeUpperBound(Tree* theTree, TreeDataPtr data);
+
+/**
+ * Returns the element the iterator is on and moves it to the next one.
+ * The tree must not be modified while the iterator is in use.
+ * @param TreeIterator iter
+ * @return NULL once the end is reached, otherwise the data
+ */
+TreeDataPtr nextTreeElement(TreeIterator* iter);
+
+/**
+ * Moves the iterator back one element and returns it. Stepping back from the
+ * end gives the largest element, so the next nextTreeElement call returns
+ * the same element again.
+ * @param TreeIterator iter
+ * @return NULL if the iterator is already at the smallest element, otherwise the data
+ */
+TreeDataPtr prevTreeElement(TreeIterator* iter);
+
+/**
+ * Creates an iterator over the elements in [lo, hi], positioned at the first of them.
+ * Only forward iteration stops at hi, prevTreeElement is not bounded by lo.
+ * @param Tree theTree
+ * @param TreeDataPtr lo
+ * @param TreeDataPtr hi
+ * @return TreeIterator
+ */
+TreeIterator treeRangeIterator(Tree* theTree, TreeDataPtr lo, TreeDataPtr hi);
+
+/**
+ * Counts the elements less than data in O(log n) on a balanced tree
+ * @param Tree theTree
+ * @param TreeDataPtr data
+ * @return (0-Based) rank data has or would have in the tree
+ */
+int treeRank(Tree* theTree, TreeDataPtr data);
+
+/**
+ * Finds the k-th smallest element in O(log n) on a balanced tree
+ * @param Tree theTree
+ * @param int k (0-Based) rank of the element
+ * @return NULL if k is out of range, otherwise the data
+ */
+TreeDataPtr treeSelect(Tree* theTree, int k);
+
+/**
+ * Counts the elements in [lo, hi] in O(log n) on a balanced tree
+ * @param Tree theTree
+ * @param TreeDataPtr lo
+ * @param TreeDataPtr hi
+ * @return number of elements between lo and hi, both included
+ */
+int treeRangeCount(Tree* theTree, TreeDataPtr lo, TreeDataPtr hi);
+
+/**
+ * Gets the number of nodes in the subtree of a particular Node in O(1)
+ * @param TreeNode *treeNode
+ * @return 0 for NULL, otherwise the subtree size
+ */
+int getSize(TreeNode* treeNode);
+
+/**
+ * Gets the height of a particular Node in the tree in O(1)
  * @param TreeNode *treeNode
  * @return (1-Based) height for the tree
  */
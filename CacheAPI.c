@@ -0,0 +1,529 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "CacheAPI.h"
+
+/**
+ * FNV-1a over the whole key, case sensitive unlike hashNode. The low bits
+ * pick the bucket and the high bits the shard.
+ */
+static unsigned long long hashKey(const char* key) {
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for (const unsigned char* ptr = (const unsigned char*)key; *ptr != '\0'; ptr++) {
+        hash ^= *ptr;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * Sets up an empty cache in place
+ * @return false if the buckets could not be allocated
+ */
+static bool initializeCache(Cache* cache, size_t capacity, CachePolicy policy, void (*deleteFunction)(void* toBeDeleted)) {
+    cache->buckets = calloc(CACHE_MIN_BUCKETS, sizeof(CacheEntry*));
+    if (cache->buckets == NULL) {
+        return false;
+    }
+
+    cache->numBuckets = CACHE_MIN_BUCKETS;
+    cache->policy = policy;
+    cache->capacity = capacity;
+    cache->bytes = 0;
+    cache->count = 0;
+    cache->evictions = 0;
+    cache->probation = (CacheList){NULL, NULL, 0};
+    cache->protectedList = (CacheList){NULL, NULL, 0};
+    cache->hand = NULL;
+    cache->deleteData = deleteFunction;
+
+    return true;
+}
+
+Cache* createCache(size_t capacity, CachePolicy policy, void (*deleteFunction)(void* toBeDeleted)) {
+    Cache* cache = malloc(sizeof(Cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    if (!initializeCache(cache, capacity, policy, deleteFunction)) {
+        free(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+/**
+ * Frees every entry and the buckets, leaving the struct itself
+ */
+static void clearCache(Cache* cache) {
+    CacheList* lists[] = {&cache->probation, &cache->protectedList};
+
+    for (int i = 0; i < 2; i++) {
+        CacheEntry* entry = lists[i]->head;
+        while (entry != NULL) {
+            CacheEntry* next = entry->next;
+            if (cache->deleteData != NULL) {
+                cache->deleteData(entry->data);
+            }
+            free(entry);
+            entry = next;
+        }
+    }
+
+    free(cache->buckets);
+    cache->buckets = NULL;
+}
+
+void destroyCache(Cache* toDestroy) {
+    if (toDestroy == NULL) {
+        return;
+    }
+
+    clearCache(toDestroy);
+    free(toDestroy);
+}
+
+static CacheEntry* findEntry(Cache* cache, const char* key, unsigned long long hash) {
+    CacheEntry* entry = cache->buckets[hash & (cache->numBuckets - 1)];
+
+    while (entry != NULL && (entry->hash != hash || strcmp(entry->key, key) != 0)) {
+        entry = entry->hashNext;
+    }
+
+    return entry;
+}
+
+static void unlinkFromList(CacheList* list, CacheEntry* entry) {
+    if (entry->previous != NULL) {
+        entry->previous->next = entry->next;
+    }
+    else {
+        list->head = entry->next;
+    }
+
+    if (entry->next != NULL) {
+        entry->next->previous = entry->previous;
+    }
+    else {
+        list->tail = entry->previous;
+    }
+
+    entry->previous = NULL;
+    entry->next = NULL;
+    list->bytes -= entry->size;
+}
+
+static void pushFront(CacheList* list, CacheEntry* entry) {
+    entry->previous = NULL;
+    entry->next = list->head;
+    if (list->head != NULL) {
+        list->head->previous = entry;
+    }
+    else {
+        list->tail = entry;
+    }
+    list->head = entry;
+    list->bytes += entry->size;
+}
+
+/**
+ * Links entry in just behind the clock hand, so the hand reaches it last
+ */
+static void insertBehindHand(Cache* cache, CacheEntry* entry) {
+    CacheList* list = &cache->probation;
+
+    if (cache->hand == NULL) {
+        pushFront(list, entry);
+        cache->hand = entry;
+        return;
+    }
+
+    CacheEntry* hand = cache->hand;
+    entry->next = hand;
+    entry->previous = hand->previous;
+    if (hand->previous != NULL) {
+        hand->previous->next = entry;
+    }
+    else {
+        list->head = entry;
+    }
+    hand->previous = entry;
+    list->bytes += entry->size;
+}
+
+/**
+ * Moves the clock hand one entry on, wrapping from the tail to the head
+ */
+static void advanceHand(Cache* cache) {
+    cache->hand = cache->hand->next != NULL ? cache->hand->next : cache->probation.head;
+}
+
+static CacheList* listOf(Cache* cache, CacheEntry* entry) {
+    return entry->isProtected ? &cache->protectedList : &cache->probation;
+}
+
+/**
+ * Unlinks an entry from its bucket and list and frees it, deleting its data
+ */
+static void removeEntry(Cache* cache, CacheEntry* entry, bool deleteData) {
+    CacheEntry** link = &cache->buckets[entry->hash & (cache->numBuckets - 1)];
+    while (*link != entry) {
+        link = &(*link)->hashNext;
+    }
+    *link = entry->hashNext;
+
+    if (cache->hand == entry) {
+        advanceHand(cache);
+        if (cache->hand == entry) {
+            cache->hand = NULL;
+        }
+    }
+    unlinkFromList(listOf(cache, entry), entry);
+
+    cache->bytes -= entry->size;
+    cache->count--;
+    if (deleteData && cache->deleteData != NULL) {
+        cache->deleteData(entry->data);
+    }
+    free(entry);
+}
+
+/**
+ * Marks an entry as used according to the policy
+ */
+static void touchEntry(Cache* cache, CacheEntry* entry) {
+    switch (cache->policy) {
+        case CACHE_LRU:
+            if (cache->probation.head != entry) {
+                unlinkFromList(&cache->probation, entry);
+                pushFront(&cache->probation, entry);
+            }
+            break;
+        case CACHE_SLRU: {
+            if (entry->isProtected) {
+                if (cache->protectedList.head != entry) {
+                    unlinkFromList(&cache->protectedList, entry);
+                    pushFront(&cache->protectedList, entry);
+                }
+                break;
+            }
+
+            //Second hit: promote, and demote the coldest protected entries to make room
+            unlinkFromList(&cache->probation, entry);
+            entry->isProtected = true;
+            pushFront(&cache->protectedList, entry);
+
+            size_t protectedCapacity = cache->capacity / 100 * CACHE_PROTECTED_PERCENT + cache->capacity % 100 * CACHE_PROTECTED_PERCENT / 100;
+            while (cache->protectedList.bytes > protectedCapacity && cache->protectedList.tail != entry) {
+                CacheEntry* demoted = cache->protectedList.tail;
+                unlinkFromList(&cache->protectedList, demoted);
+                demoted->isProtected = false;
+                pushFront(&cache->probation, demoted);
+            }
+            break;
+        }
+        case CACHE_CLOCK:
+            //Skip the store when the bit is already set, hits stay read only
+            if (!atomic_load_explicit(&entry->referenced, memory_order_relaxed)) {
+                atomic_store_explicit(&entry->referenced, true, memory_order_relaxed);
+            }
+            break;
+    }
+}
+
+bool evictFromCache(Cache* cache) {
+    if (cache == NULL || cache->count == 0) {
+        return false;
+    }
+
+    CacheEntry* victim;
+    if (cache->policy == CACHE_CLOCK) {
+        //Give every referenced entry a second chance, at most one full turn
+        while (atomic_load_explicit(&cache->hand->referenced, memory_order_relaxed)) {
+            atomic_store_explicit(&cache->hand->referenced, false, memory_order_relaxed);
+            advanceHand(cache);
+        }
+        victim = cache->hand;
+    }
+    else {
+        victim = cache->probation.tail != NULL ? cache->probation.tail : cache->protectedList.tail;
+    }
+
+    removeEntry(cache, victim, true);
+    cache->evictions++;
+
+    return true;
+}
+
+/**
+ * Doubles the buckets and redistributes the entries by their stored hash
+ */
+static void growBuckets(Cache* cache) {
+    size_t numBuckets = cache->numBuckets * 2;
+    CacheEntry** buckets = calloc(numBuckets, sizeof(CacheEntry*));
+    if (buckets == NULL) {
+        //Chains just get longer
+        return;
+    }
+
+    for (size_t i = 0; i < cache->numBuckets; i++) {
+        CacheEntry* entry = cache->buckets[i];
+        while (entry != NULL) {
+            CacheEntry* next = entry->hashNext;
+            CacheEntry** bucket = &buckets[entry->hash & (numBuckets - 1)];
+            entry->hashNext = *bucket;
+            *bucket = entry;
+            entry = next;
+        }
+    }
+
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->numBuckets = numBuckets;
+}
+
+static bool putHashed(Cache* cache, const char* key, unsigned long long hash, void* data, size_t size) {
+    if (size > cache->capacity) {
+        return false;
+    }
+
+    size_t keyLength = strlen(key) + 1;
+    CacheEntry* entry = malloc(sizeof(CacheEntry) + keyLength);
+    if (entry == NULL) {
+        return false;
+    }
+
+    CacheEntry* existing = findEntry(cache, key, hash);
+    if (existing != NULL) {
+        removeEntry(cache, existing, existing->data != data);
+    }
+
+    while (cache->bytes + size > cache->capacity) {
+        evictFromCache(cache);
+    }
+
+    entry->data = data;
+    entry->size = size;
+    entry->hash = hash;
+    entry->isProtected = false;
+    atomic_init(&entry->referenced, false);
+    memcpy(entry->key, key, keyLength);
+
+    if (cache->count >= cache->numBuckets) {
+        growBuckets(cache);
+    }
+    CacheEntry** bucket = &cache->buckets[hash & (cache->numBuckets - 1)];
+    entry->hashNext = *bucket;
+    *bucket = entry;
+
+    if (cache->policy == CACHE_CLOCK) {
+        insertBehindHand(cache, entry);
+    }
+    else {
+        pushFront(&cache->probation, entry);
+    }
+
+    cache->bytes += size;
+    cache->count++;
+
+    return true;
+}
+
+bool putInCache(Cache* cache, const char* key, void* data, size_t size) {
+    if (cache == NULL || key == NULL) {
+        return false;
+    }
+
+    return putHashed(cache, key, hashKey(key), data, size);
+}
+
+void* getFromCache(Cache* cache, const char* key) {
+    if (cache == NULL || key == NULL) {
+        return NULL;
+    }
+
+    CacheEntry* entry = findEntry(cache, key, hashKey(key));
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    touchEntry(cache, entry);
+    return entry->data;
+}
+
+void* peekInCache(Cache* cache, const char* key) {
+    if (cache == NULL || key == NULL) {
+        return NULL;
+    }
+
+    CacheEntry* entry = findEntry(cache, key, hashKey(key));
+    return entry != NULL ? entry->data : NULL;
+}
+
+bool touchInCache(Cache* cache, const char* key) {
+    if (cache == NULL || key == NULL) {
+        return false;
+    }
+
+    CacheEntry* entry = findEntry(cache, key, hashKey(key));
+    if (entry == NULL) {
+        return false;
+    }
+
+    touchEntry(cache, entry);
+    return true;
+}
+
+void removeFromCache(Cache* cache, const char* key) {
+    if (cache == NULL || key == NULL) {
+        return;
+    }
+
+    CacheEntry* entry = findEntry(cache, key, hashKey(key));
+    if (entry != NULL) {
+        removeEntry(cache, entry, true);
+    }
+}
+
+MemoryUsage getCacheMemoryUsage(Cache* cache) {
+    MemoryUsage usage = {0, 0, 0};
+    if (cache == NULL) {
+        return usage;
+    }
+
+    usage.metadata = sizeof(Cache);
+    for (size_t i = 0; i < cache->numBuckets; i++) {
+        if (cache->buckets[i] == NULL) {
+            usage.slack += sizeof(CacheEntry*);
+            continue;
+        }
+        usage.metadata += sizeof(CacheEntry*);
+
+        for (CacheEntry* entry = cache->buckets[i]; entry != NULL; entry = entry->hashNext) {
+            size_t bytes = sizeof(CacheEntry) + strlen(entry->key) + 1;
+            usage.payload += bytes - sizeof(CacheEntry) + sizeof(entry->data);
+            usage.metadata += sizeof(CacheEntry) - sizeof(entry->data);
+            usage.slack += allocatorFootprint(NULL, bytes) - bytes;
+        }
+    }
+
+    return usage;
+}
+
+ShardedCache* createShardedCache(size_t capacity, CachePolicy policy, void (*deleteFunction)(void* toBeDeleted), int numShards) {
+    int shards = 1;
+    while (shards < numShards) {
+        shards *= 2;
+    }
+
+    ShardedCache* cache = malloc(sizeof(ShardedCache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->shards = aligned_alloc(_Alignof(CacheShard), sizeof(CacheShard) * shards);
+    if (cache->shards == NULL) {
+        free(cache);
+        return NULL;
+    }
+
+    for (int i = 0; i < shards; i++) {
+        if (!initializeCache(&cache->shards[i].cache, capacity / shards, policy, deleteFunction)) {
+            cache->numShards = i;
+            destroyShardedCache(cache);
+            return NULL;
+        }
+        pthread_rwlock_init(&cache->shards[i].lock, NULL);
+    }
+    cache->numShards = shards;
+
+    return cache;
+}
+
+void destroyShardedCache(ShardedCache* toDestroy) {
+    if (toDestroy == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < toDestroy->numShards; i++) {
+        clearCache(&toDestroy->shards[i].cache);
+        pthread_rwlock_destroy(&toDestroy->shards[i].lock);
+    }
+
+    free(toDestroy->shards);
+    free(toDestroy);
+}
+
+/**
+ * Picks the shard from the high bits of the hash, the buckets use the low ones
+ */
+static CacheShard* shardOf(ShardedCache* cache, unsigned long long hash) {
+    return &cache->shards[(hash >> 40) & (unsigned long long)(cache->numShards - 1)];
+}
+
+bool putInShardedCache(ShardedCache* cache, const char* key, void* data, size_t size) {
+    if (cache == NULL || key == NULL) {
+        return false;
+    }
+
+    unsigned long long hash = hashKey(key);
+    CacheShard* shard = shardOf(cache, hash);
+
+    pthread_rwlock_wrlock(&shard->lock);
+    bool added = putHashed(&shard->cache, key, hash, data, size);
+    pthread_rwlock_unlock(&shard->lock);
+
+    return added;
+}
+
+bool readFromShardedCache(ShardedCache* cache, const char* key, void (*reader)(void* data, void* context), void* context) {
+    if (cache == NULL || key == NULL) {
+        return false;
+    }
+
+    unsigned long long hash = hashKey(key);
+    CacheShard* shard = shardOf(cache, hash);
+
+    //A CLOCK hit only sets an atomic bit, so readers can share the shard
+    bool shared = shard->cache.policy == CACHE_CLOCK;
+    if (shared) {
+        pthread_rwlock_rdlock(&shard->lock);
+    }
+    else {
+        pthread_rwlock_wrlock(&shard->lock);
+    }
+
+    CacheEntry* entry = findEntry(&shard->cache, key, hash);
+    if (entry != NULL) {
+        touchEntry(&shard->cache, entry);
+        if (reader != NULL) {
+            reader(entry->data, context);
+        }
+    }
+
+    pthread_rwlock_unlock(&shard->lock);
+
+    return entry != NULL;
+}
+
+void removeFromShardedCache(ShardedCache* cache, const char* key) {
+    if (cache == NULL || key == NULL) {
+        return;
+    }
+
+    unsigned long long hash = hashKey(key);
+    CacheShard* shard = shardOf(cache, hash);
+
+    pthread_rwlock_wrlock(&shard->lock);
+    CacheEntry* entry = findEntry(&shard->cache, key, hash);
+    if (entry != NULL) {
+        removeEntry(&shard->cache, entry, true);
+    }
+    pthread_rwlock_unlock(&shard->lock);
+}
@@ -0,0 +1,213 @@
+#ifndef CACHE_CACHEAPI_H
+#define CACHE_CACHEAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "AllocatorAPI.h"
+
+/**
+ * Share of an SLRU cache's capacity the protected segment may hold, in percent
+ */
+#define CACHE_PROTECTED_PERCENT 80
+
+/**
+ * Bucket count of a new cache. Buckets double whenever entries outnumber them.
+ */
+#define CACHE_MIN_BUCKETS 16
+
+/**
+ * Eviction policy of a cache
+ */
+typedef enum cachePolicy {
+    CACHE_LRU,    //Evicts the least recently used entry, every hit moves its entry to the front
+    CACHE_SLRU,    //New entries start on probation and move to a protected segment on their second hit, so one scan cannot flush the entries in use
+    CACHE_CLOCK    //Second chance: a hit only sets a bit, the hand skips and clears set bits when evicting. Hits take a read lock in a sharded cache
+} CachePolicy;
+
+/**
+ * Entry holding one key, linked into its hash bucket and its recency list
+ * at once, so finding, touching and evicting it never walk a list
+ */
+typedef struct cacheEntry {
+    void* data;
+    size_t size;    //Bytes charged against the capacity
+    unsigned long long hash;
+    struct cacheEntry* hashNext;
+    struct cacheEntry* previous;
+    struct cacheEntry* next;
+    bool isProtected;    //In the protected segment of an SLRU cache
+    atomic_bool referenced;    //Used since the clock hand last passed, CLOCK only
+    char key[];    //Copy of the key, allocated with the entry
+} CacheEntry;
+
+/**
+ * Recency list, most recently used entry at the head
+ */
+typedef struct cacheList {
+    CacheEntry* head;
+    CacheEntry* tail;
+    size_t bytes;
+} CacheList;
+
+/**
+ * Definition of the cache. LRU and CLOCK keep every entry in probation,
+ * SLRU splits them between probation and protectedList.
+ */
+typedef struct cache {
+    CachePolicy policy;
+    size_t capacity;    //Most bytes held at once
+    size_t bytes;
+    size_t count;
+    size_t evictions;
+    CacheEntry** buckets;
+    size_t numBuckets;    //Power of two
+    CacheList probation;
+    CacheList protectedList;
+    CacheEntry* hand;    //Next entry the clock looks at, CLOCK only
+    void (*deleteData)(void* toBeDeleted);    //Called on the data of every evicted, removed or replaced entry
+} Cache;
+
+/**
+ * One shard of a sharded cache, on its own cache lines
+ */
+typedef struct cacheShard {
+    _Alignas(64) pthread_rwlock_t lock;
+    Cache cache;
+} CacheShard;
+
+/**
+ * Thread safe cache split into independently locked shards by key hash
+ */
+typedef struct shardedCache {
+    CacheShard* shards;
+    int numShards;    //Power of two
+} ShardedCache;
+
+/**
+ * Allocates memory for an empty cache
+ * @param capacity most bytes held at once, as charged by putInCache
+ * @param policy eviction policy
+ * @param deleteFunction function pointer to delete a single piece of data from the cache, may be NULL
+ * @return Newly created cache, NULL on allocation failure
+ */
+Cache* createCache(size_t capacity, CachePolicy policy, void (*deleteFunction)(void* toBeDeleted));
+
+/**
+ * Remove all entries, deleting their data, and free memory
+ * @param Cache toDestroy
+ * @return void
+ */
+void destroyCache(Cache* toDestroy);
+
+/**
+ * Adds data under key, charging size bytes. Entries are evicted by the policy
+ * until it fits. An entry already under key is replaced and its data deleted,
+ * unless it is the same pointer; the new entry starts over as a new one.
+ * @param Cache cache
+ * @param const char* key copied into the entry
+ * @param void* data
+ * @param size_t size bytes to charge, 1 for a cache bounded by its number of entries
+ * @return false if size is above the capacity or memory ran out, data is then still the caller's
+ */
+bool putInCache(Cache* cache, const char* key, void* data, size_t size);
+
+/**
+ * Looks up key and marks its entry as used
+ * @param Cache cache
+ * @param const char* key
+ * @return NULL if the key is not cached, otherwise its data
+ */
+void* getFromCache(Cache* cache, const char* key);
+
+/**
+ * Looks up key without marking its entry as used
+ * @param Cache cache
+ * @param const char* key
+ * @return NULL if the key is not cached, otherwise its data
+ */
+void* peekInCache(Cache* cache, const char* key);
+
+/**
+ * Marks the entry of key as used, like a hit
+ * @param Cache cache
+ * @param const char* key
+ * @return false if the key is not cached
+ */
+bool touchInCache(Cache* cache, const char* key);
+
+/**
+ * Removes the entry of key and deletes its data
+ * @param Cache cache
+ * @param const char* key
+ * @return void
+ */
+void removeFromCache(Cache* cache, const char* key);
+
+/**
+ * Evicts the entry the policy picks next and deletes its data
+ * @param Cache cache
+ * @return false if the cache was empty
+ */
+bool evictFromCache(Cache* cache);
+
+/**
+ * Reports the bytes held by the cache. Payload is the key bytes and data
+ * pointers of every entry, metadata the links, hashes, sizes, used buckets
+ * and the cache struct, slack the empty buckets and allocator rounding.
+ * The data itself is charged by putInCache and not counted here.
+ * @param Cache cache
+ * @return MemoryUsage usage, all zero if cache is NULL
+ */
+MemoryUsage getCacheMemoryUsage(Cache* cache);
+
+/**
+ * Allocates memory for an empty sharded cache, the capacity is split evenly between the shards
+ * @param capacity most bytes held at once by all shards together
+ * @param policy eviction policy of every shard
+ * @param deleteFunction function pointer to delete a single piece of data from the cache, may be NULL
+ * @param numShards number of shards, rounded up to a power of two
+ * @return Newly created cache, NULL on allocation failure
+ */
+ShardedCache* createShardedCache(size_t capacity, CachePolicy policy, void (*deleteFunction)(void* toBeDeleted), int numShards);
+
+/**
+ * Remove all entries, deleting their data, and free memory. No other thread may use the cache.
+ * @param ShardedCache toDestroy
+ * @return void
+ */
+void destroyShardedCache(ShardedCache* toDestroy);
+
+/**
+ * Thread safe putInCache on the shard of key
+ * @param ShardedCache cache
+ * @param const char* key copied into the entry
+ * @param void* data
+ * @param size_t size bytes to charge
+ * @return false if size is above a shard's capacity or memory ran out, data is then still the caller's
+ */
+bool putInShardedCache(ShardedCache* cache, const char* key, void* data, size_t size);
+
+/**
+ * Thread safe lookup. Another thread may evict and delete the data as soon as
+ * the shard is unlocked, so reader is called on it while the shard is still
+ * locked. CLOCK shards only take a read lock, so readers run in parallel.
+ * @param ShardedCache cache
+ * @param const char* key
+ * @param void (*reader)(void* data, void* context) called with the data if the key is cached, may be NULL
+ * @param void* context passed to reader
+ * @return false if the key is not cached
+ */
+bool readFromShardedCache(ShardedCache* cache, const char* key, void (*reader)(void* data, void* context), void* context);
+
+/**
+ * Thread safe removeFromCache on the shard of key
+ * @param ShardedCache cache
+ * @param const char* key
+ * @return void
+ */
+void removeFromShardedCache(ShardedCache* cache, const char* key);
+
+#endif //CACHE_CACHEAPI_H
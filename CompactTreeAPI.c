@@ -0,0 +1,415 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "CompactTreeAPI.h"
+
+#define COMPACT_CHUNK_MASK (COMPACT_CHUNK_NODES - 1)
+
+static inline CompactNode* nodeAt(const CompactTree* theTree, uint32_t index) {
+    return (CompactNode*)(theTree->chunks[index >> COMPACT_CHUNK_SHIFT] + (size_t)(index & COMPACT_CHUNK_MASK) * theTree->stride);
+}
+
+/**
+ * Data of a node as the caller sees it: the stored pointer, or the address of the inline copy
+ */
+static inline TreeDataPtr dataOf(const CompactTree* theTree, CompactNode* node) {
+    if (theTree->inlineBytes > 0) {
+        return node + 1;
+    }
+    return *(TreeDataPtr*)(node + 1);
+}
+
+static size_t chunkBytes(const CompactTree* theTree) {
+    return (size_t)theTree->stride * COMPACT_CHUNK_NODES;
+}
+
+CompactTree* createCompactTree(CompareFunc compare, DeleteFunc del, PrintFunc print, size_t inlineBytes, Allocator* allocator) {
+    //Rounded up to 8 so the links and data of every slot stay aligned
+    size_t payload = inlineBytes > 0 ? (inlineBytes + 7) / 8 * 8 : sizeof(TreeDataPtr);
+    if (payload > UINT32_MAX - sizeof(CompactNode)) {
+        return NULL;
+    }
+
+    CompactTree* toReturn = malloc(sizeof(CompactTree));
+    if (toReturn == NULL) {
+        return NULL;
+    }
+
+    toReturn->chunks = NULL;
+    toReturn->numChunks = 0;
+    toReturn->maxChunks = 0;
+    toReturn->used = 0;
+    toReturn->freeList = COMPACT_NIL;
+    toReturn->root = COMPACT_NIL;
+    toReturn->stride = (uint32_t)(sizeof(CompactNode) + payload);
+    toReturn->inlineBytes = (uint32_t)inlineBytes;
+    toReturn->count = 0;
+    toReturn->compareFunc = compare;
+    toReturn->deleteFunc = del;
+    toReturn->printFunc = print;
+    toReturn->allocator = allocator;
+
+    return toReturn;
+}
+
+/**
+ * Smallest node of the subtree rooted at index
+ */
+static uint32_t findMinIndex(const CompactTree* theTree, uint32_t index) {
+    while (nodeAt(theTree, index)->left != COMPACT_NIL) {
+        index = nodeAt(theTree, index)->left;
+    }
+    return index;
+}
+
+/**
+ * Next node in order using parent links
+ * @return COMPACT_NIL if index is the maximum
+ */
+static uint32_t findSuccessorIndex(const CompactTree* theTree, uint32_t index) {
+    CompactNode* node = nodeAt(theTree, index);
+    if (node->right != COMPACT_NIL) {
+        return findMinIndex(theTree, node->right);
+    }
+
+    uint32_t parent = node->parent;
+    while (parent != COMPACT_NIL && nodeAt(theTree, parent)->right == index) {
+        index = parent;
+        parent = nodeAt(theTree, parent)->parent;
+    }
+    return parent;
+}
+
+void destroyCompactTree(CompactTree* toDestroy) {
+    if (toDestroy == NULL) {
+        return;
+    }
+
+    if (toDestroy->deleteFunc != NULL && toDestroy->root != COMPACT_NIL) {
+        for (uint32_t index = findMinIndex(toDestroy, toDestroy->root); index != COMPACT_NIL; index = findSuccessorIndex(toDestroy, index)) {
+            toDestroy->deleteFunc(dataOf(toDestroy, nodeAt(toDestroy, index)));
+        }
+    }
+
+    for (uint32_t i = 0; i < toDestroy->numChunks; i++) {
+        allocatorReleaseBulk(toDestroy->allocator, toDestroy->chunks[i], chunkBytes(toDestroy));
+    }
+    free(toDestroy->chunks);
+    free(toDestroy);
+}
+
+/**
+ * Takes a slot from the free list, or the next unused one, adding a chunk when the last is full
+ * @return index of the slot, COMPACT_NIL if memory ran out or the pool is full
+ */
+static uint32_t allocateSlot(CompactTree* theTree) {
+    if (theTree->freeList != COMPACT_NIL) {
+        uint32_t index = theTree->freeList;
+        theTree->freeList = nodeAt(theTree, index)->left;
+        return index;
+    }
+    if (theTree->used > COMPACT_MAX_NODES) {
+        return COMPACT_NIL;
+    }
+
+    if (theTree->used == theTree->numChunks * (size_t)COMPACT_CHUNK_NODES) {
+        if (theTree->numChunks == theTree->maxChunks) {
+            uint32_t maxChunks = theTree->maxChunks == 0 ? 4 : theTree->maxChunks * 2;
+            unsigned char** chunks = realloc(theTree->chunks, sizeof(unsigned char*) * maxChunks);
+            if (chunks == NULL) {
+                return COMPACT_NIL;
+            }
+            theTree->chunks = chunks;
+            theTree->maxChunks = maxChunks;
+        }
+
+        unsigned char* chunk = allocatorAllocBulk(theTree->allocator, chunkBytes(theTree));
+        if (chunk == NULL) {
+            return COMPACT_NIL;
+        }
+        theTree->chunks[theTree->numChunks++] = chunk;
+
+        //Slot 0 is the sentinel, its height of 0 is read for missing children
+        if (theTree->used == 0) {
+            memset(chunk, 0, theTree->stride);
+            theTree->used = 1;
+        }
+    }
+
+    return theTree->used++;
+}
+
+static inline uint32_t heightOf(const CompactTree* theTree, uint32_t index) {
+    return nodeAt(theTree, index)->height;
+}
+
+static void updateHeight(CompactTree* theTree, CompactNode* node) {
+    uint32_t left = heightOf(theTree, node->left);
+    uint32_t right = heightOf(theTree, node->right);
+
+    node->height = (left > right ? left : right) + 1;
+}
+
+/**
+ * Puts newChild where oldChild hangs off parent, or at the root if parent is COMPACT_NIL
+ */
+static void replaceChild(CompactTree* theTree, uint32_t parent, uint32_t oldChild, uint32_t newChild) {
+    if (parent == COMPACT_NIL) {
+        theTree->root = newChild;
+    }
+    else if (nodeAt(theTree, parent)->left == oldChild) {
+        nodeAt(theTree, parent)->left = newChild;
+    }
+    else {
+        nodeAt(theTree, parent)->right = newChild;
+    }
+
+    if (newChild != COMPACT_NIL) {
+        nodeAt(theTree, newChild)->parent = parent;
+    }
+}
+
+static uint32_t rotateLeft(CompactTree* theTree, uint32_t index) {
+    CompactNode* node = nodeAt(theTree, index);
+    uint32_t pivotIndex = node->right;
+    CompactNode* pivot = nodeAt(theTree, pivotIndex);
+
+    replaceChild(theTree, node->parent, index, pivotIndex);
+    node->right = pivot->left;
+    if (pivot->left != COMPACT_NIL) {
+        nodeAt(theTree, pivot->left)->parent = index;
+    }
+    pivot->left = index;
+    node->parent = pivotIndex;
+
+    updateHeight(theTree, node);
+    updateHeight(theTree, pivot);
+    return pivotIndex;
+}
+
+static uint32_t rotateRight(CompactTree* theTree, uint32_t index) {
+    CompactNode* node = nodeAt(theTree, index);
+    uint32_t pivotIndex = node->left;
+    CompactNode* pivot = nodeAt(theTree, pivotIndex);
+
+    replaceChild(theTree, node->parent, index, pivotIndex);
+    node->left = pivot->right;
+    if (pivot->right != COMPACT_NIL) {
+        nodeAt(theTree, pivot->right)->parent = index;
+    }
+    pivot->right = index;
+    node->parent = pivotIndex;
+
+    updateHeight(theTree, node);
+    updateHeight(theTree, pivot);
+    return pivotIndex;
+}
+
+/**
+ * Restores the AVL property at a node whose children differ in height by at most 2
+ * @return the node now at the top of the subtree
+ */
+static uint32_t rebalance(CompactTree* theTree, uint32_t index) {
+    CompactNode* node = nodeAt(theTree, index);
+    int balance = (int)heightOf(theTree, node->left) - (int)heightOf(theTree, node->right);
+
+    if (balance > 1) {
+        //Left-right case needs the left child turned first
+        CompactNode* left = nodeAt(theTree, node->left);
+        if (heightOf(theTree, left->left) < heightOf(theTree, left->right)) {
+            rotateLeft(theTree, node->left);
+        }
+        return rotateRight(theTree, index);
+    }
+    else if (balance < -1) {
+        //Right-left case needs the right child turned first
+        CompactNode* right = nodeAt(theTree, node->right);
+        if (heightOf(theTree, right->right) < heightOf(theTree, right->left)) {
+            rotateRight(theTree, node->right);
+        }
+        return rotateLeft(theTree, index);
+    }
+
+    return index;
+}
+
+/**
+ * Walks from a changed node up to the root fixing heights and rebalancing
+ */
+static void retrace(CompactTree* theTree, uint32_t index) {
+    while (index != COMPACT_NIL) {
+        updateHeight(theTree, nodeAt(theTree, index));
+        index = rebalance(theTree, index);
+        index = nodeAt(theTree, index)->parent;
+    }
+}
+
+bool addToCompactTree(CompactTree* theTree, TreeDataPtr data) {
+    if (theTree == NULL) {
+        return false;
+    }
+
+    //Walk down comparing once per level
+    uint32_t parent = COMPACT_NIL;
+    uint32_t index = theTree->root;
+    int result = 0;
+    while (index != COMPACT_NIL) {
+        result = theTree->compareFunc(dataOf(theTree, nodeAt(theTree, index)), data);
+        if (result == 0) {
+            //Duplicates are not added
+            return true;
+        }
+        parent = index;
+        index = result < 0 ? nodeAt(theTree, index)->right : nodeAt(theTree, index)->left;
+    }
+
+    uint32_t newIndex = allocateSlot(theTree);
+    if (newIndex == COMPACT_NIL) {
+        return false;
+    }
+
+    CompactNode* newNode = nodeAt(theTree, newIndex);
+    newNode->left = COMPACT_NIL;
+    newNode->right = COMPACT_NIL;
+    newNode->parent = parent;
+    newNode->height = 1;
+    if (theTree->inlineBytes > 0) {
+        memcpy(newNode + 1, data, theTree->inlineBytes);
+    }
+    else {
+        *(TreeDataPtr*)(newNode + 1) = data;
+    }
+
+    if (parent == COMPACT_NIL) {
+        theTree->root = newIndex;
+    }
+    else if (result < 0) {
+        nodeAt(theTree, parent)->right = newIndex;
+    }
+    else {
+        nodeAt(theTree, parent)->left = newIndex;
+    }
+    theTree->count++;
+    retrace(theTree, parent);
+
+    return true;
+}
+
+/**
+ * Iteratively finds the node holding data, comparing once per level
+ * @return COMPACT_NIL if fail, otherwise the index of the node
+ */
+static uint32_t findIndex(CompactTree* theTree, TreeDataPtr data) {
+    uint32_t index = theTree->root;
+
+    while (index != COMPACT_NIL) {
+        CompactNode* node = nodeAt(theTree, index);
+        int result = theTree->compareFunc(dataOf(theTree, node), data);
+        if (result == 0) {
+            return index;
+        }
+        index = result < 0 ? node->right : node->left;
+    }
+
+    return COMPACT_NIL;
+}
+
+void removeFromCompactTree(CompactTree* theTree, TreeDataPtr data) {
+    if (theTree == NULL) {
+        return;
+    }
+
+    uint32_t index = findIndex(theTree, data);
+    if (index == COMPACT_NIL) {
+        return;
+    }
+
+    CompactNode* node = nodeAt(theTree, index);
+    if (theTree->deleteFunc != NULL) {
+        theTree->deleteFunc(dataOf(theTree, node));
+    }
+
+    uint32_t retraceFrom;
+    if (node->left != COMPACT_NIL && node->right != COMPACT_NIL) {
+        //The successor node takes this node's place, so inline data of other nodes never moves
+        uint32_t successorIndex = findMinIndex(theTree, node->right);
+        CompactNode* successor = nodeAt(theTree, successorIndex);
+
+        if (successor->parent == index) {
+            retraceFrom = successorIndex;
+        }
+        else {
+            retraceFrom = successor->parent;
+            replaceChild(theTree, successor->parent, successorIndex, successor->right);
+            successor->right = node->right;
+            nodeAt(theTree, node->right)->parent = successorIndex;
+        }
+
+        replaceChild(theTree, node->parent, index, successorIndex);
+        successor->left = node->left;
+        nodeAt(theTree, node->left)->parent = successorIndex;
+        successor->height = node->height;
+    }
+    else {
+        //The node has at most one child, which takes its place
+        retraceFrom = node->parent;
+        replaceChild(theTree, node->parent, index, node->left != COMPACT_NIL ? node->left : node->right);
+    }
+
+    node->left = theTree->freeList;
+    theTree->freeList = index;
+    theTree->count--;
+    retrace(theTree, retraceFrom);
+}
+
+TreeDataPtr findInCompactTree(CompactTree* theTree, TreeDataPtr data) {
+    if (theTree == NULL) {
+        return NULL;
+    }
+
+    uint32_t index = findIndex(theTree, data);
+    if (index == COMPACT_NIL) {
+        return NULL;
+    }
+
+    return dataOf(theTree, nodeAt(theTree, index));
+}
+
+int visitCompactTreeInOrder(CompactTree* theTree, VisitFunc visit, void* context) {
+    if (theTree == NULL || theTree->root == COMPACT_NIL) {
+        return 0;
+    }
+
+    for (uint32_t index = findMinIndex(theTree, theTree->root); index != COMPACT_NIL; index = findSuccessorIndex(theTree, index)) {
+        int result = visit(dataOf(theTree, nodeAt(theTree, index)), context);
+        if (result != 0) {
+            return result;
+        }
+    }
+
+    return 0;
+}
+
+MemoryUsage getCompactTreeMemoryUsage(CompactTree* theTree) {
+    MemoryUsage usage = {0, 0, 0};
+    if (theTree == NULL) {
+        return usage;
+    }
+
+    size_t payload = theTree->inlineBytes > 0 ? theTree->inlineBytes : sizeof(TreeDataPtr);
+    size_t slots = (size_t)theTree->numChunks * COMPACT_CHUNK_NODES;
+
+    usage.payload = theTree->count * payload;
+    usage.metadata = sizeof(CompactTree) + sizeof(unsigned char*) * theTree->maxChunks + theTree->count * sizeof(CompactNode);
+
+    //Padding after inline data, then every slot not holding a node: sentinel, freed and never used
+    usage.slack = theTree->count * (theTree->stride - sizeof(CompactNode) - payload);
+    usage.slack += (slots - theTree->count) * theTree->stride;
+    if (theTree->numChunks > 0) {
+        usage.slack += theTree->numChunks * (allocatorBulkFootprint(theTree->allocator, chunkBytes(theTree)) - chunkBytes(theTree));
+    }
+
+    return usage;
+}
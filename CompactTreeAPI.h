@@ -0,0 +1,124 @@
+#ifndef COMPACTTREE_COMPACTTREEAPI_H
+#define COMPACTTREE_COMPACTTREEAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "BinarySearchTreeAPI.h"
+
+/**
+ * Index that refers to no node. Slot 0 of the pool is a sentinel of height 0.
+ */
+#define COMPACT_NIL 0
+
+/**
+ * Nodes live in chunks of 2^COMPACT_CHUNK_SHIFT slots that never move, so
+ * indices and inline data stay put as the pool grows. Chunk pages are only
+ * touched as slots are handed out.
+ */
+#define COMPACT_CHUNK_SHIFT 16
+#define COMPACT_CHUNK_NODES (1u << COMPACT_CHUNK_SHIFT)
+
+/**
+ * Most nodes a compact tree holds, every index but COMPACT_NIL and UINT32_MAX
+ */
+#define COMPACT_MAX_NODES (UINT32_MAX - 1)
+
+/**
+ * Links of a pool node, 16 bytes against the 48 of a TreeNode. The data
+ * follows right after: a pointer, or the data itself in an inline tree.
+ */
+typedef struct compactNode {
+    uint32_t left;
+    uint32_t right;
+    uint32_t parent;
+    uint32_t height; //(1-Based) height of the subtree rooted at this node
+} CompactNode;
+
+/**
+ * AVL tree whose nodes live in a pool and link to each other by 32 bit
+ * index. A node takes 24 bytes with a data pointer, or 16 plus the payload
+ * rounded up to 8 bytes when the data is stored inline, and there is no
+ * per node allocation. Nodes of removed data are reused by later adds.
+ */
+typedef struct compactTree {
+    unsigned char** chunks;
+    uint32_t numChunks;
+    uint32_t maxChunks;
+    uint32_t used; //Slots handed out so far, the sentinel included
+    uint32_t freeList; //Slots of removed nodes, chained through left
+    uint32_t root;
+    uint32_t stride; //Bytes of a node with its data
+    uint32_t inlineBytes; //Bytes of inline data, 0 when the tree stores data pointers
+    size_t count;
+    CompareFunc compareFunc;
+    DeleteFunc deleteFunc;
+    PrintFunc printFunc;
+    Allocator* allocator; //Where chunks come from, NULL for malloc
+} CompactTree;
+
+/**
+ * Allocates memory for an empty compact tree. With inlineBytes 0 the tree
+ * stores data pointers like a Tree. Otherwise addToCompactTree copies
+ * inlineBytes bytes of plain data into the node, and compare, del and print
+ * get pointers to those copies, which stay valid until their data is removed.
+ * @param compare Function pointer to compare data in tree Nodes
+ * @param del Function pointer to delete data from tree Nodes, may be NULL
+ * @param print Function pointer to print data from tree Nodes
+ * @param inlineBytes Bytes of data stored in each node, 0 to store pointers
+ * @param allocator Allocator for the chunks, NULL for malloc. It must outlive the tree
+ * @return Newly created tree, NULL on allocation failure
+ */
+CompactTree* createCompactTree(CompareFunc compare, DeleteFunc del, PrintFunc print, size_t inlineBytes, Allocator* allocator);
+
+/**
+ * Remove all items, deleting their data, and free memory
+ * @param CompactTree toDestroy
+ * @return void
+ */
+void destroyCompactTree(CompactTree* toDestroy);
+
+/**
+ * Add data to a tree. Like addToTree, data equal to some already in the tree is not added.
+ * @param CompactTree theTree
+ * @param TreeDataPtr data the pointer to store, or the bytes to copy in an inline tree
+ * @return false if memory ran out or the tree holds COMPACT_MAX_NODES nodes
+ */
+bool addToCompactTree(CompactTree* theTree, TreeDataPtr data);
+
+/**
+ * Remove data from the tree, deleting it
+ * @param CompactTree theTree
+ * @param TreeDataPtr data
+ * @return void
+ */
+void removeFromCompactTree(CompactTree* theTree, TreeDataPtr data);
+
+/**
+ * Searches the tree for the target data
+ * @param CompactTree theTree
+ * @param TreeDataPtr data
+ * @return NULL if fail, otherwise the data, or its copy in an inline tree
+ */
+TreeDataPtr findInCompactTree(CompactTree* theTree, TreeDataPtr data);
+
+/**
+ * Calls visit on every element in order, without recursion
+ * @param CompactTree theTree
+ * @param VisitFunc visit
+ * @param void* context passed to every call of visit
+ * @return 0 if every element was visited, otherwise the value that stopped the traversal
+ */
+int visitCompactTreeInOrder(CompactTree* theTree, VisitFunc visit, void* context);
+
+/**
+ * Reports the bytes held by a tree. Payload is the data pointer or inline
+ * data of every node, metadata the tree struct, chunk table and node links,
+ * slack the padding, unused and freed slots and allocator rounding.
+ * @param CompactTree theTree
+ * @return MemoryUsage usage, all zero if theTree is NULL
+ */
+MemoryUsage getCompactTreeMemoryUsage(CompactTree* theTree);
+
+#endif //COMPACTTREE_COMPACTTREEAPI_H
@@ -0,0 +1,654 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <sched.h>
+#include "ConcurrentTreeAPI.h"
+
+#define NODE_OBSOLETE 1
+#define NODE_LOCKED 2
+
+/**
+ * One slot per thread inside a concurrent tree: 0 when outside, otherwise
+ * the epoch the thread entered at shifted left by one, with the low bit set
+ */
+typedef struct epochSlot {
+    _Alignas(64) atomic_uint_fast64_t state;
+    atomic_bool inUse;
+} EpochSlot;
+
+static EpochSlot epochSlots[CONCURRENT_TREE_MAX_THREADS];
+static atomic_uint_fast64_t globalEpoch = 1;
+static pthread_key_t slotKey;
+static pthread_once_t slotKeyOnce = PTHREAD_ONCE_INIT;
+static _Thread_local int threadSlot = -1;
+static _Thread_local int threadNesting = 0;
+
+static void releaseSlot(void* slot) {
+    EpochSlot* epochSlot = &epochSlots[(intptr_t)slot - 1];
+    atomic_store_explicit(&epochSlot->state, 0, memory_order_release);
+    atomic_store_explicit(&epochSlot->inUse, false, memory_order_release);
+}
+
+static void createSlotKey(void) {
+    pthread_key_create(&slotKey, releaseSlot);
+}
+
+/**
+ * Claims a free epoch slot for the calling thread, given back when the thread exits
+ */
+static int claimSlot(void) {
+    pthread_once(&slotKeyOnce, createSlotKey);
+
+    while (true) {
+        for (int i = 0; i < CONCURRENT_TREE_MAX_THREADS; i++) {
+            bool expected = false;
+            if (!atomic_load_explicit(&epochSlots[i].inUse, memory_order_relaxed) &&
+                atomic_compare_exchange_strong(&epochSlots[i].inUse, &expected, true)) {
+                pthread_setspecific(slotKey, (void*)(intptr_t)(i + 1));
+                return i;
+            }
+        }
+        //Every slot is taken, wait for a thread to exit
+        sched_yield();
+    }
+}
+
+void enterConcurrentTree(void) {
+    if (threadNesting++ > 0) {
+        return;
+    }
+
+    if (threadSlot < 0) {
+        threadSlot = claimSlot();
+    }
+
+    uint_fast64_t epoch = atomic_load_explicit(&globalEpoch, memory_order_relaxed);
+    atomic_store_explicit(&epochSlots[threadSlot].state, (epoch << 1) | 1, memory_order_relaxed);
+    //The slot must be visible before any node is read
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void exitConcurrentTree(void) {
+    if (--threadNesting > 0) {
+        return;
+    }
+
+    atomic_store_explicit(&epochSlots[threadSlot].state, 0, memory_order_release);
+}
+
+/**
+ * Moves the global epoch forward if every thread inside a tree has seen the current one
+ */
+static uint_fast64_t tryAdvanceEpoch(void) {
+    uint_fast64_t epoch = atomic_load(&globalEpoch);
+
+    atomic_thread_fence(memory_order_seq_cst);
+    for (int i = 0; i < CONCURRENT_TREE_MAX_THREADS; i++) {
+        uint_fast64_t state = atomic_load_explicit(&epochSlots[i].state, memory_order_acquire);
+        if ((state & 1) && (state >> 1) != epoch) {
+            return epoch;
+        }
+    }
+
+    if (atomic_compare_exchange_strong(&globalEpoch, &epoch, epoch + 1)) {
+        return epoch + 1;
+    }
+    return epoch;
+}
+
+static void freeRetired(ConcurrentTree* theTree, RetiredItem* retired) {
+    if (retired->isNode) {
+        ConcurrentTreeNode* node = retired->item;
+        if (theTree->deleteFunc != NULL) {
+            theTree->deleteFunc(atomic_load_explicit(&node->data, memory_order_relaxed));
+        }
+        free(node);
+    }
+    else if (theTree->deleteFunc != NULL) {
+        theTree->deleteFunc(retired->item);
+    }
+}
+
+/**
+ * Queues an unlinked node or removed data until no thread can still be reading it.
+ * Anything retired at epoch e is unreachable once the global epoch reaches e + 2.
+ */
+static void retire(ConcurrentTree* theTree, void* item, bool isNode) {
+    pthread_mutex_lock(&theTree->retireLock);
+
+    if (theTree->retiredCount == theTree->retiredCapacity) {
+        int capacity = theTree->retiredCapacity == 0 ? CONCURRENT_TREE_RETIRE_BATCH * 2 : theTree->retiredCapacity * 2;
+        RetiredItem* retired = realloc(theTree->retired, sizeof(RetiredItem) * capacity);
+        if (retired == NULL) {
+            //Leaking is the only safe choice without somewhere to park the item
+            pthread_mutex_unlock(&theTree->retireLock);
+            return;
+        }
+        theTree->retired = retired;
+        theTree->retiredCapacity = capacity;
+    }
+
+    RetiredItem* entry = &theTree->retired[theTree->retiredCount++];
+    entry->item = item;
+    entry->isNode = isNode;
+    entry->epoch = atomic_load(&globalEpoch);
+
+    if (theTree->retiredCount >= CONCURRENT_TREE_RETIRE_BATCH) {
+        uint_fast64_t epoch = tryAdvanceEpoch();
+        int kept = 0;
+        for (int i = 0; i < theTree->retiredCount; i++) {
+            if (theTree->retired[i].epoch + 2 <= epoch) {
+                freeRetired(theTree, &theTree->retired[i]);
+            }
+            else {
+                theTree->retired[kept++] = theTree->retired[i];
+            }
+        }
+        theTree->retiredCount = kept;
+    }
+
+    pthread_mutex_unlock(&theTree->retireLock);
+}
+
+/**
+ * Waits out a writer and returns false if the node was unlinked
+ */
+static bool readLock(ConcurrentTreeNode* node, uint_fast64_t* version) {
+    uint_fast64_t current;
+
+    while ((current = atomic_load_explicit(&node->version, memory_order_acquire)) & NODE_LOCKED) {
+        sched_yield();
+    }
+    *version = current;
+
+    return (current & NODE_OBSOLETE) == 0;
+}
+
+/**
+ * Checks that nothing read from the node since readLock was changed underneath
+ */
+static bool validate(ConcurrentTreeNode* node, uint_fast64_t version) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&node->version, memory_order_relaxed) == version;
+}
+
+/**
+ * Locks the node only if it is still at the version that was read
+ */
+static bool upgradeLock(ConcurrentTreeNode* node, uint_fast64_t version) {
+    if (!atomic_compare_exchange_strong_explicit(&node->version, &version, version | NODE_LOCKED,
+                                                 memory_order_acquire, memory_order_relaxed)) {
+        return false;
+    }
+
+    //Readers that see any of the following stores must also see the lock bit
+    atomic_thread_fence(memory_order_release);
+    return true;
+}
+
+static bool tryLock(ConcurrentTreeNode* node) {
+    uint_fast64_t version = atomic_load_explicit(&node->version, memory_order_relaxed);
+
+    if (version & (NODE_LOCKED | NODE_OBSOLETE)) {
+        return false;
+    }
+    return upgradeLock(node, version);
+}
+
+static bool isObsolete(ConcurrentTreeNode* node) {
+    return (atomic_load_explicit(&node->version, memory_order_acquire) & NODE_OBSOLETE) != 0;
+}
+
+/**
+ * Unlocks and bumps the version so optimistic readers of the node restart
+ */
+static void writeUnlock(ConcurrentTreeNode* node) {
+    atomic_fetch_add_explicit(&node->version, NODE_LOCKED, memory_order_release);
+}
+
+static void writeUnlockObsolete(ConcurrentTreeNode* node) {
+    atomic_fetch_add_explicit(&node->version, NODE_LOCKED | NODE_OBSOLETE, memory_order_release);
+}
+
+/**
+ * Unlocks without a version change, for nodes whose search fields were not touched
+ */
+static void unlockUnchanged(ConcurrentTreeNode* node) {
+    atomic_fetch_sub_explicit(&node->version, NODE_LOCKED, memory_order_release);
+}
+
+static ConcurrentTreeNode* loadChild(ConcurrentTreeNode* node, bool right) {
+    return atomic_load_explicit(right ? &node->right : &node->left, memory_order_acquire);
+}
+
+static void storeChild(ConcurrentTreeNode* node, bool right, ConcurrentTreeNode* child) {
+    atomic_store_explicit(right ? &node->right : &node->left, child, memory_order_release);
+}
+
+static int nodeHeight(ConcurrentTreeNode* node) {
+    return node == NULL ? 0 : atomic_load_explicit(&node->height, memory_order_relaxed);
+}
+
+static void updateHeight(ConcurrentTreeNode* node) {
+    int left = nodeHeight(loadChild(node, false));
+    int right = nodeHeight(loadChild(node, true));
+
+    atomic_store_explicit(&node->height, 1 + (left > right ? left : right), memory_order_relaxed);
+}
+
+static ConcurrentTreeNode* createNode(TreeDataPtr data, ConcurrentTreeNode* parent) {
+    ConcurrentTreeNode* node = malloc(sizeof(ConcurrentTreeNode));
+    if (node == NULL) {
+        return NULL;
+    }
+
+    atomic_init(&node->version, 0);
+    atomic_init(&node->data, data);
+    atomic_init(&node->left, NULL);
+    atomic_init(&node->right, NULL);
+    atomic_init(&node->parent, parent);
+    atomic_init(&node->height, 1);
+    atomic_init(&node->routing, false);
+
+    return node;
+}
+
+ConcurrentTree* createConcurrentTree(CompareFunc compare, DeleteFunc del) {
+    ConcurrentTree* toReturn = malloc(sizeof(ConcurrentTree));
+    if (toReturn == NULL) {
+        return NULL;
+    }
+
+    atomic_init(&toReturn->holder.version, 0);
+    atomic_init(&toReturn->holder.data, NULL);
+    atomic_init(&toReturn->holder.left, NULL);
+    atomic_init(&toReturn->holder.right, NULL);
+    atomic_init(&toReturn->holder.parent, NULL);
+    atomic_init(&toReturn->holder.height, 0);
+    atomic_init(&toReturn->holder.routing, false);
+    toReturn->compareFunc = compare;
+    toReturn->deleteFunc = del;
+    atomic_init(&toReturn->count, 0);
+    pthread_mutex_init(&toReturn->retireLock, NULL);
+    toReturn->retired = NULL;
+    toReturn->retiredCount = 0;
+    toReturn->retiredCapacity = 0;
+
+    return toReturn;
+}
+
+void destroyConcurrentTree(ConcurrentTree* toDestroy) {
+    if (toDestroy == NULL) {
+        return;
+    }
+
+    //No thread is inside the tree any more, so every node can go without waiting on epochs
+    ConcurrentTreeNode* node = atomic_load(&toDestroy->holder.right);
+    while (node != NULL) {
+        ConcurrentTreeNode* left = atomic_load_explicit(&node->left, memory_order_relaxed);
+        if (left != NULL) {
+            //Rotate the left child up so the walk needs no stack
+            atomic_store_explicit(&node->left, atomic_load_explicit(&left->right, memory_order_relaxed), memory_order_relaxed);
+            atomic_store_explicit(&left->right, node, memory_order_relaxed);
+            node = left;
+        }
+        else {
+            ConcurrentTreeNode* right = atomic_load_explicit(&node->right, memory_order_relaxed);
+            if (toDestroy->deleteFunc != NULL) {
+                toDestroy->deleteFunc(atomic_load_explicit(&node->data, memory_order_relaxed));
+            }
+            free(node);
+            node = right;
+        }
+    }
+
+    for (int i = 0; i < toDestroy->retiredCount; i++) {
+        freeRetired(toDestroy, &toDestroy->retired[i]);
+    }
+    free(toDestroy->retired);
+    pthread_mutex_destroy(&toDestroy->retireLock);
+    free(toDestroy);
+}
+
+/**
+ * Lifts child over its parent node, whose own parent is above. All three must be locked.
+ */
+static void rotateUp(ConcurrentTreeNode* above, ConcurrentTreeNode* node, ConcurrentTreeNode* child) {
+    bool childOnRight = loadChild(node, true) == child;
+    ConcurrentTreeNode* inner = loadChild(child, !childOnRight);
+
+    storeChild(node, childOnRight, inner);
+    if (inner != NULL) {
+        //The moved subtree keeps its key range, so only writers need to see this. Parent
+        //links are stored with release because fixAfterChange follows them without a lock
+        atomic_store_explicit(&inner->parent, node, memory_order_release);
+    }
+    storeChild(child, !childOnRight, node);
+    atomic_store_explicit(&node->parent, child, memory_order_release);
+    storeChild(above, loadChild(above, true) == node, child);
+    atomic_store_explicit(&child->parent, above, memory_order_release);
+
+    updateHeight(node);
+    updateHeight(child);
+}
+
+/**
+ * Walks up from a changed node, fixing heights, rotating where the AVL
+ * condition is broken and unlinking routing nodes that lost a child.
+ * Locks are only ever taken parent first and by trying, so a writer that
+ * loses a race backs off instead of waiting while holding a lock.
+ */
+static void fixAfterChange(ConcurrentTree* theTree, ConcurrentTreeNode* node) {
+    while (node != &theTree->holder) {
+        ConcurrentTreeNode* parent = atomic_load_explicit(&node->parent, memory_order_acquire);
+
+        if (!tryLock(parent)) {
+            if (isObsolete(node)) {
+                return;
+            }
+            sched_yield();
+            continue;
+        }
+        //The node may have been rotated under another parent before the lock was taken
+        if (atomic_load_explicit(&node->parent, memory_order_acquire) != parent) {
+            unlockUnchanged(parent);
+            continue;
+        }
+        if (!tryLock(node)) {
+            unlockUnchanged(parent);
+            if (isObsolete(node)) {
+                return;
+            }
+            sched_yield();
+            continue;
+        }
+
+        ConcurrentTreeNode* left = loadChild(node, false);
+        ConcurrentTreeNode* right = loadChild(node, true);
+
+        if (atomic_load_explicit(&node->routing, memory_order_relaxed) && (left == NULL || right == NULL)) {
+            ConcurrentTreeNode* child = left != NULL ? left : right;
+            storeChild(parent, loadChild(parent, true) == node, child);
+            if (child != NULL) {
+                atomic_store_explicit(&child->parent, parent, memory_order_release);
+            }
+            writeUnlockObsolete(node);
+            writeUnlock(parent);
+            retire(theTree, node, true);
+            node = parent;
+            continue;
+        }
+
+        int balance = nodeHeight(left) - nodeHeight(right);
+        if (balance >= -1 && balance <= 1) {
+            int height = atomic_load_explicit(&node->height, memory_order_relaxed);
+            updateHeight(node);
+            bool changed = height != atomic_load_explicit(&node->height, memory_order_relaxed);
+            unlockUnchanged(node);
+            unlockUnchanged(parent);
+            if (!changed) {
+                return;
+            }
+            node = parent;
+            continue;
+        }
+
+        ConcurrentTreeNode* heavy = balance > 1 ? left : right;
+        if (!tryLock(heavy)) {
+            unlockUnchanged(node);
+            unlockUnchanged(parent);
+            sched_yield();
+            continue;
+        }
+
+        ConcurrentTreeNode* outer = loadChild(heavy, balance < -1);
+        ConcurrentTreeNode* inner = loadChild(heavy, balance > 1);
+        if (nodeHeight(inner) > nodeHeight(outer)) {
+            //Double rotation, the inner grandchild becomes the top of this subtree
+            if (!tryLock(inner)) {
+                unlockUnchanged(heavy);
+                unlockUnchanged(node);
+                unlockUnchanged(parent);
+                sched_yield();
+                continue;
+            }
+            rotateUp(node, heavy, inner);
+            rotateUp(parent, node, inner);
+            writeUnlock(inner);
+        }
+        else {
+            rotateUp(parent, node, heavy);
+        }
+
+        writeUnlock(heavy);
+        writeUnlock(node);
+        writeUnlock(parent);
+        node = parent;
+    }
+}
+
+TreeDataPtr findInConcurrentTree(ConcurrentTree* theTree, TreeDataPtr data) {
+    if (theTree == NULL) {
+        return NULL;
+    }
+
+    enterConcurrentTree();
+
+    TreeDataPtr found = NULL;
+    bool restart = true;
+    while (restart) {
+        restart = false;
+
+        ConcurrentTreeNode* parent = &theTree->holder;
+        uint_fast64_t parentVersion;
+        readLock(parent, &parentVersion);
+        ConcurrentTreeNode* node = loadChild(parent, true);
+
+        while (node != NULL) {
+            uint_fast64_t version;
+            //Checking the parent again proves node was still its child when its version was read
+            if (!readLock(node, &version) || !validate(parent, parentVersion)) {
+                restart = true;
+                break;
+            }
+
+            TreeDataPtr nodeData = atomic_load_explicit(&node->data, memory_order_relaxed);
+            int result = theTree->compareFunc(nodeData, data);
+            if (result == 0) {
+                bool routing = atomic_load_explicit(&node->routing, memory_order_relaxed);
+                if (!validate(node, version)) {
+                    restart = true;
+                    break;
+                }
+                found = routing ? NULL : nodeData;
+                break;
+            }
+
+            ConcurrentTreeNode* child = loadChild(node, result < 0);
+            if (!validate(node, version)) {
+                restart = true;
+                break;
+            }
+            parent = node;
+            parentVersion = version;
+            node = child;
+        }
+    }
+
+    exitConcurrentTree();
+
+    return found;
+}
+
+void addToConcurrentTree(ConcurrentTree* theTree, TreeDataPtr data) {
+    if (theTree == NULL) {
+        return;
+    }
+
+    enterConcurrentTree();
+
+    bool restart = true;
+    while (restart) {
+        restart = false;
+
+        ConcurrentTreeNode* parent = &theTree->holder;
+        uint_fast64_t parentVersion;
+        readLock(parent, &parentVersion);
+        bool right = true;
+        ConcurrentTreeNode* node = loadChild(parent, true);
+
+        while (true) {
+            if (node == NULL) {
+                //Only the parent changes, and only if nothing moved since it was read
+                if (!upgradeLock(parent, parentVersion)) {
+                    restart = true;
+                    break;
+                }
+                ConcurrentTreeNode* newNode = createNode(data, parent);
+                if (newNode == NULL) {
+                    unlockUnchanged(parent);
+                    break;
+                }
+                storeChild(parent, right, newNode);
+                writeUnlock(parent);
+                atomic_fetch_add_explicit(&theTree->count, 1, memory_order_relaxed);
+                fixAfterChange(theTree, parent);
+                break;
+            }
+
+            uint_fast64_t version;
+            if (!readLock(node, &version) || !validate(parent, parentVersion)) {
+                restart = true;
+                break;
+            }
+
+            int result = theTree->compareFunc(atomic_load_explicit(&node->data, memory_order_relaxed), data);
+            if (result == 0) {
+                if (!atomic_load_explicit(&node->routing, memory_order_relaxed)) {
+                    restart = !validate(node, version);
+                    break;
+                }
+                //Revive a routing node in place, its old data is deleted once unreachable
+                if (!upgradeLock(node, version)) {
+                    restart = true;
+                    break;
+                }
+                TreeDataPtr old = atomic_load_explicit(&node->data, memory_order_relaxed);
+                atomic_store_explicit(&node->data, data, memory_order_relaxed);
+                atomic_store_explicit(&node->routing, false, memory_order_relaxed);
+                writeUnlock(node);
+                atomic_fetch_add_explicit(&theTree->count, 1, memory_order_relaxed);
+                retire(theTree, old, false);
+                break;
+            }
+
+            ConcurrentTreeNode* child = loadChild(node, result < 0);
+            if (!validate(node, version)) {
+                restart = true;
+                break;
+            }
+            parent = node;
+            parentVersion = version;
+            right = result < 0;
+            node = child;
+        }
+    }
+
+    exitConcurrentTree();
+}
+
+void removeFromConcurrentTree(ConcurrentTree* theTree, TreeDataPtr data) {
+    if (theTree == NULL) {
+        return;
+    }
+
+    enterConcurrentTree();
+
+    bool restart = true;
+    while (restart) {
+        restart = false;
+
+        ConcurrentTreeNode* parent = &theTree->holder;
+        uint_fast64_t parentVersion;
+        readLock(parent, &parentVersion);
+        bool right = true;
+        ConcurrentTreeNode* node = loadChild(parent, true);
+
+        while (node != NULL) {
+            uint_fast64_t version;
+            if (!readLock(node, &version) || !validate(parent, parentVersion)) {
+                restart = true;
+                break;
+            }
+
+            int result = theTree->compareFunc(atomic_load_explicit(&node->data, memory_order_relaxed), data);
+            if (result != 0) {
+                ConcurrentTreeNode* child = loadChild(node, result < 0);
+                if (!validate(node, version)) {
+                    restart = true;
+                    break;
+                }
+                parent = node;
+                parentVersion = version;
+                right = result < 0;
+                node = child;
+                continue;
+            }
+
+            bool routing = atomic_load_explicit(&node->routing, memory_order_relaxed);
+            ConcurrentTreeNode* left = loadChild(node, false);
+            ConcurrentTreeNode* rightChild = loadChild(node, true);
+            if (!validate(node, version)) {
+                restart = true;
+                break;
+            }
+            if (routing) {
+                break;
+            }
+
+            if (left != NULL && rightChild != NULL) {
+                //Unlinking would move a key between nodes under running searches, keep the node to route them
+                if (!upgradeLock(node, version)) {
+                    restart = true;
+                    break;
+                }
+                atomic_store_explicit(&node->routing, true, memory_order_relaxed);
+                writeUnlock(node);
+                atomic_fetch_sub_explicit(&theTree->count, 1, memory_order_relaxed);
+                break;
+            }
+
+            //Lock parent then node, both only if unchanged since the search saw them
+            if (!upgradeLock(parent, parentVersion)) {
+                restart = true;
+                break;
+            }
+            if (!upgradeLock(node, version)) {
+                unlockUnchanged(parent);
+                restart = true;
+                break;
+            }
+            ConcurrentTreeNode* child = left != NULL ? left : rightChild;
+            storeChild(parent, right, child);
+            if (child != NULL) {
+                atomic_store_explicit(&child->parent, parent, memory_order_release);
+            }
+            writeUnlockObsolete(node);
+            writeUnlock(parent);
+            atomic_fetch_sub_explicit(&theTree->count, 1, memory_order_relaxed);
+            retire(theTree, node, true);
+            fixAfterChange(theTree, parent);
+            break;
+        }
+    }
+
+    exitConcurrentTree();
+}
+
+int getConcurrentTreeCount(ConcurrentTree* theTree) {
+    if (theTree == NULL) {
+        return 0;
+    }
+
+    return atomic_load_explicit(&theTree->count, memory_order_relaxed);
+}
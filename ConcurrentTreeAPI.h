@@ -0,0 +1,129 @@
+#ifndef CONCURRENTTREE_CONCURRENTTREEAPI_H
+#define CONCURRENTTREE_CONCURRENTTREEAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "BinarySearchTreeAPI.h"
+
+/**
+ * Most threads that can be inside concurrent trees at the same time
+ */
+#define CONCURRENT_TREE_MAX_THREADS 1024
+
+/**
+ * Number of retired nodes and data a tree collects before trying to reclaim them
+ */
+#define CONCURRENT_TREE_RETIRE_BATCH 64
+
+/**
+ * A single node of a concurrent tree. The version is a lock word: bit 0 marks
+ * a node that has been unlinked, bit 1 is the write lock and the rest counts
+ * modifications. Readers never write to nodes, they read a version, read the
+ * fields and check that the version did not change.
+ * parent and height are only used by writers, while holding locks.
+ */
+typedef struct concurrentTreeNode {
+    atomic_uint_fast64_t version;
+    _Atomic(TreeDataPtr) data;
+    _Atomic(struct concurrentTreeNode*) left;
+    _Atomic(struct concurrentTreeNode*) right;
+    _Atomic(struct concurrentTreeNode*) parent;
+    atomic_int height;
+    atomic_bool routing; //The data was removed but the node still guides searches to its children
+} ConcurrentTreeNode;
+
+/**
+ * Node or data waiting for every reader that might still see it to finish
+ */
+typedef struct retiredItem {
+    void* item;
+    bool isNode; //Nodes are freed and their data deleted, otherwise only the data is deleted
+    uint64_t epoch;
+} RetiredItem;
+
+/**
+ * Definition of the concurrent tree. An AVL tree with relaxed balance:
+ * searches are optimistic and validated through node versions, writers lock
+ * only the nodes they change, and unlinked nodes and removed data are freed
+ * once no thread inside the tree can still reach them (epoch reclamation).
+ * A removed node with two children stays in place as a routing node until
+ * rebalancing can unlink it, so keys never move between nodes.
+ */
+typedef struct concurrentTree {
+    ConcurrentTreeNode holder; //Sentinel whose right child is the root, so the root is changed under a lock
+    CompareFunc compareFunc;
+    DeleteFunc deleteFunc;
+    atomic_int count;
+    pthread_mutex_t retireLock;
+    RetiredItem* retired;
+    int retiredCount;
+    int retiredCapacity;
+} ConcurrentTree;
+
+/**
+ * Allocates memory for a concurrent tree and assigns function pointers
+ * @param compare Function pointer to compare data in tree Nodes
+ * @param del Function pointer to delete data from tree Nodes, may be NULL
+ * @return Newly created tree, NULL on allocation failure
+ */
+ConcurrentTree* createConcurrentTree(CompareFunc compare, DeleteFunc del);
+
+/**
+ * Remove all items and free memory. No other thread may be using the tree.
+ * @param ConcurrentTree toDestroy
+ * @return void
+ */
+void destroyConcurrentTree(ConcurrentTree* toDestroy);
+
+/**
+ * Add data to the tree. Thread safe. Duplicates are not added.
+ * @param ConcurrentTree theTree
+ * @param TreeDataPtr data
+ * @return void
+ */
+void addToConcurrentTree(ConcurrentTree* theTree, TreeDataPtr data);
+
+/**
+ * Remove data from the tree. Thread safe. The stored data is deleted once
+ * no thread can still be reading it.
+ * @param ConcurrentTree theTree
+ * @param TreeDataPtr data
+ * @return void
+ */
+void removeFromConcurrentTree(ConcurrentTree* theTree, TreeDataPtr data);
+
+/**
+ * Searches the tree for the target data. Thread safe and never writes to the tree.
+ * The returned data may be deleted as soon as another thread removes it,
+ * unless the caller is between enterConcurrentTree and exitConcurrentTree.
+ * @param ConcurrentTree theTree
+ * @param TreeDataPtr data
+ * @return NULL if fail, otherwise return data
+ */
+TreeDataPtr findInConcurrentTree(ConcurrentTree* theTree, TreeDataPtr data);
+
+/**
+ * Marks the calling thread as reading, so no data it finds is deleted until
+ * exitConcurrentTree. Calls may be nested.
+ * @return void
+ */
+void enterConcurrentTree(void);
+
+/**
+ * Ends the section started by the matching enterConcurrentTree
+ * @return void
+ */
+void exitConcurrentTree(void);
+
+/**
+ * Number of items in the tree. Only exact while no other thread is writing.
+ * @param ConcurrentTree theTree
+ * @return int
+ */
+int getConcurrentTreeCount(ConcurrentTree* theTree);
+
+#endif //CONCURRENTTREE_CONCURRENTTREEAPI_H
@@ -3,7 +3,7 @@
 #include <string.h>
 #include <stdbool.h>
 #include "DoublyLinkedListAPI.h"
-#define DEBUG false
+#include "InstrumentAPI.h"
 
 List initializeList(char* (*printFunction)(void* toBePrinted),void (*deleteFunction)(void* toBeDeleted),int (*compareFunction)(const void* first,const void* second)) {
     List tmpList;
@@ -14,6 +14,17 @@ List initializeList(char* (*printFunction)(void* toBePrinted),void (*deleteFunct
     tmpList.compare = compareFunction;
     tmpList.printData = printFunction;
     tmpList.length = 0;
+    tmpList.allocator = NULL;
+    tmpList.nodeBlock = NULL;
+    tmpList.blockSize = 0;
+
+    return tmpList;
+}
+
+List initializeListWithAllocator(char* (*printFunction)(void* toBePrinted),void (*deleteFunction)(void* toBeDeleted),int (*compareFunction)(const void* first,const void* second), Allocator* allocator) {
+    List tmpList = initializeList(printFunction, deleteFunction, compareFunction);
+
+    tmpList.allocator = allocator;
 
     return tmpList;
 }
@@ -34,12 +45,51 @@ Node* initializeNode(void* data) {
     return tmpNode;
 }
 
+/**
+ * Creates a node with the list's allocator
+ *@return the new node, NULL on allocation failure
+ *@param list the list the node will be linked into
+ *@param data pointer to the data of the node
+ **/
+static Node* allocateListNode(List* list, void* data) {
+    Node* tmpNode = allocatorAlloc(list->allocator, sizeof(Node));
+
+    if (tmpNode == NULL){
+        return NULL;
+    }
+    STAT_RECORD(STATS_LIST, STAT_ALLOCS, sizeof(Node));
+
+    tmpNode->data = data;
+    tmpNode->previous = NULL;
+    tmpNode->next = NULL;
+
+    return tmpNode;
+}
+
+/**
+ * Gives a node back to the list's allocator unless it lives in the block made by compactList
+ *@param list the list the node was unlinked from
+ *@param node the node to release
+ **/
+static void releaseListNode(List* list, Node* node) {
+    if (list->nodeBlock != NULL && node >= list->nodeBlock && node < list->nodeBlock + list->blockSize){
+        return;
+    }
+
+    allocatorRelease(list->allocator, node, sizeof(Node));
+    STAT_RECORD(STATS_LIST, STAT_FREES, sizeof(Node));
+}
+
 void insertFront(List* list, void* toBeAdded) {
     if (list == NULL || toBeAdded == NULL){
         return;
     }
 
-    Node* newNode = initializeNode(toBeAdded);
+    Node* newNode = allocateListNode(list, toBeAdded);
+
+    if (newNode == NULL){
+        return;
+    }
 
     if (list->head == NULL && list->tail == NULL){
         list->head = newNode;
@@ -58,7 +108,11 @@ void insertBack(List* list, void* toBeAdded) {
         return;
     }
 
-    Node* newNode = initializeNode(toBeAdded);
+    Node* newNode = allocateListNode(list, toBeAdded);
+
+    if (newNode == NULL){
+        return;
+    }
 
     if (list->head == NULL && list->tail == NULL){
         list->head = newNode;
@@ -78,18 +132,31 @@ void clearList(List* list) {
     }
 
     if (list->head == NULL && list->tail == NULL){
+        allocatorReleaseBulk(list->allocator, list->nodeBlock, sizeof(Node) * list->blockSize);
+        list->nodeBlock = NULL;
+        list->blockSize = 0;
         return;
     }
 
     Node* tmp;
 
+    //Arena nodes go all at once with the arena, only the data may still need deleting
+    if (list->deleteData == NULL && !allocatorReleasesEach(list->allocator)){
+        list->head = NULL;
+    }
+
     while (list->head != NULL){
-        list->deleteData(list->head->data);
+        if (list->deleteData != NULL){
+            list->deleteData(list->head->data);
+        }
         tmp = list->head;
         list->head = list->head->next;
-        free(tmp);
+        releaseListNode(list, tmp);
     }
 
+    allocatorReleaseBulk(list->allocator, list->nodeBlock, sizeof(Node) * list->blockSize);
+    list->nodeBlock = NULL;
+    list->blockSize = 0;
     list->head = NULL;
     list->tail = NULL;
     list->length = 0;
@@ -106,29 +173,29 @@ void insertSorted(List* list, void* toBeAdded) {
     }
 
     if (list->compare(toBeAdded, list->head->data) <= 0){
+        STAT_RECORD(STATS_LIST, STAT_COMPARES, 1);
         insertFront(list, toBeAdded);
         return;
     }
 
     if (list->compare(toBeAdded, list->tail->data) > 0){
+        STAT_RECORD(STATS_LIST, STAT_COMPARES, 2);
         insertBack(list, toBeAdded);
         return;
     }
 
     Node* currNode = list->head;
+    STAT_LOCAL(compares);
 
     while (currNode != NULL){
+        STAT_INC(compares);
         if (list->compare(toBeAdded, currNode->data) <= 0){
+            STAT_RECORD(STATS_LIST, STAT_COMPARES, compares + 2);
 
-            char* currDescr = list->printData(currNode->data);
-            char* newDescr = list->printData(toBeAdded);
-
-            printf("Inserting %s before %s\n", newDescr, currDescr);
-
-            free(currDescr);
-            free(newDescr);
-
-            Node* newNode = initializeNode(toBeAdded);
+            Node* newNode = allocateListNode(list, toBeAdded);
+            if (newNode == NULL){
+                return;
+            }
             newNode->next = currNode;
             newNode->previous = currNode->previous;
             currNode->previous->next = newNode;
@@ -150,9 +217,12 @@ void* deleteDataFromList(List* list, void* toBeDeleted) {
     }
 
     Node* tmp = list->head;
+    STAT_LOCAL(compares);
 
     while(tmp != NULL){
+        STAT_INC(compares);
         if (list->compare(toBeDeleted, tmp->data) == 0){
+            STAT_RECORD(STATS_LIST, STAT_COMPARES, compares);
             //Unlink the node
             Node* delNode = tmp;
 
@@ -169,7 +239,7 @@ void* deleteDataFromList(List* list, void* toBeDeleted) {
             }
 
             void* data = delNode->data;
-            free(delNode);
+            releaseListNode(list, delNode);
             list->length--;
 
             return data;
@@ -179,9 +249,31 @@ void* deleteDataFromList(List* list, void* toBeDeleted) {
         }
     }
 
+    STAT_RECORD(STATS_LIST, STAT_COMPARES, compares);
     return NULL;
 }
 
+void* removeFromFront(List* list) {
+    if (list == NULL || list->head == NULL){
+        return NULL;
+    }
+
+    Node* delNode = list->head;
+    void* data = delNode->data;
+
+    list->head = delNode->next;
+    if (list->head != NULL){
+        list->head->previous = NULL;
+    }else{
+        list->tail = NULL;
+    }
+
+    releaseListNode(list, delNode);
+    list->length--;
+
+    return data;
+}
+
 void* getFromFront(List list) {
     if (list.head == NULL){
         return NULL;
@@ -249,16 +341,137 @@ void* findElement(List list, bool (*customCompare)(const void* first,const void*
     }
     else {
         Node* temp = list.head;
+        STAT_LOCAL(compares);
 
         while (temp != NULL) {
+            STAT_INC(compares);
             if (customCompare(temp->data, searchRecord) == true) {
+                STAT_RECORD(STATS_LIST, STAT_COMPARES, compares);
                 return temp->data;
             }
             else {
                 temp = temp->next;
             }
         }
+
+        STAT_RECORD(STATS_LIST, STAT_COMPARES, compares);
     }
 
     return NULL;
 }
+
+int findManyInList(List list, bool (*customCompare)(const void* first,const void* second), const void* searchRecords[], int n, void* out[]) {
+    if (searchRecords == NULL || out == NULL || n <= 0) {
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        out[i] = NULL;
+    }
+
+    //Indexes of the records still looking for a match, kept packed at the front
+    int* pending = malloc(sizeof(int) * n);
+    if (pending == NULL) {
+        int found = 0;
+        for (int i = 0; i < n; i++) {
+            out[i] = findElement(list, customCompare, searchRecords[i]);
+            found += out[i] != NULL;
+        }
+        return found;
+    }
+
+    int numPending = 0;
+    for (int i = 0; i < n; i++) {
+        if (searchRecords[i] != NULL) {
+            pending[numPending++] = i;
+        }
+    }
+
+    int found = 0;
+    Node* temp = list.head;
+    while (temp != NULL && numPending > 0) {
+        //Start loading the next element so it overlaps with the comparisons on this one
+        Node* next = temp->next;
+        if (next != NULL) {
+            __builtin_prefetch(next);
+        }
+
+        for (int i = 0; i < numPending; i++) {
+            if (customCompare(temp->data, searchRecords[pending[i]]) == true) {
+                out[pending[i]] = temp->data;
+                found++;
+                pending[i--] = pending[--numPending];
+            }
+        }
+
+        temp = next;
+    }
+
+    free(pending);
+    return found;
+}
+
+MemoryUsage getListMemoryUsage(List list) {
+    MemoryUsage usage = {0, 0, 0};
+    size_t nodeFootprint = allocatorFootprint(list.allocator, sizeof(Node));
+    int inBlock = 0;
+
+    for (Node* tmp = list.head; tmp != NULL; tmp = tmp->next){
+        usage.payload += sizeof(tmp->data);
+        usage.metadata += sizeof(tmp->previous) + sizeof(tmp->next);
+        if (list.nodeBlock != NULL && tmp >= list.nodeBlock && tmp < list.nodeBlock + list.blockSize){
+            inBlock++;
+        }else{
+            usage.slack += nodeFootprint - sizeof(Node);
+        }
+    }
+
+    //Block nodes removed since the last compaction stay allocated until the next one
+    if (list.nodeBlock != NULL){
+        size_t blockBytes = sizeof(Node) * list.blockSize;
+        usage.slack += sizeof(Node) * (list.blockSize - inBlock) + allocatorBulkFootprint(list.allocator, blockBytes) - blockBytes;
+    }
+
+    return usage;
+}
+
+bool compactList(List* list) {
+    if (list == NULL){
+        return false;
+    }
+
+    if (list->head == NULL){
+        allocatorReleaseBulk(list->allocator, list->nodeBlock, sizeof(Node) * list->blockSize);
+        list->nodeBlock = NULL;
+        list->blockSize = 0;
+        return true;
+    }
+
+    Node* block = allocatorAllocBulk(list->allocator, sizeof(Node) * list->length);
+    if (block == NULL){
+        return false;
+    }
+
+    int i = 0;
+    Node* tmp = list->head;
+    while (tmp != NULL){
+        Node* next = tmp->next;
+
+        block[i].data = tmp->data;
+        block[i].previous = i > 0 ? &block[i - 1] : NULL;
+        block[i].next = next != NULL ? &block[i + 1] : NULL;
+        //Arena nodes stay in the arena until it is reset
+        releaseListNode(list, tmp);
+
+        tmp = next;
+        i++;
+    }
+
+    allocatorReleaseBulk(list->allocator, list->nodeBlock, sizeof(Node) * list->blockSize);
+    list->nodeBlock = block;
+    list->blockSize = list->length;
+    list->head = &block[0];
+    list->tail = &block[list->length - 1];
+
+    return true;
+}
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <stdbool.h>
 #include <assert.h>
+#include "AllocatorAPI.h"
 
 /**
  * Node of a linked list. This list is doubly linked, meaning that it has points to both the node immediately in front 
@@ -31,6 +32,9 @@ typedef struct listHead {
     void (*deleteData)(void* toBeDeleted);
     int (*compare)(const void* first,const void* second);
     char* (*printData)(void* toBePrinted);
+    Allocator* allocator;
+    Node* nodeBlock;    //Nodes repacked by compactList, NULL if it was never called
+    int blockSize;    //Number of nodes in nodeBlock
 } List;
 
 /**
@@ -50,6 +54,18 @@ typedef struct iter {
 **/
 List initializeList(char* (*printFunction)(void* toBePrinted),void (*deleteFunction)(void* toBeDeleted),int (*compareFunction)(const void* first,const void* second));
 
+/** Same as initializeList, but the nodes of the list are allocated from allocator instead of malloc.
+* With an arena allocator clearList does not free the nodes, and when deleteFunction is NULL it does not
+* walk the list at all; the nodes are released when the arena is reset or destroyed.
+* The block made by compactList comes from the allocator's bulk allocation, such as the huge pages of a page allocator.
+*@return the list struct
+*@param printFunction function pointer to print a single node of the list
+*@param deleteFunction function pointer to delete a single piece of data from the list, NULL if the list does not own its data
+*@param compareFunction function pointer to compare two nodes of the list in order to test for equality or order
+*@param allocator allocator for the nodes, NULL for malloc. It must outlive the list
+**/
+List initializeListWithAllocator(char* (*printFunction)(void* toBePrinted),void (*deleteFunction)(void* toBeDeleted),int (*compareFunction)(const void* first,const void* second), Allocator* allocator);
+
 /**Function for creating a node for the linked list. 
 * This node contains abstracted (void *) data as well as previous and next
 * pointers to connect to other nodes in the list
@@ -107,6 +123,13 @@ void insertSorted(List* list, void* toBeAdded);
  **/
 void* deleteDataFromList(List* list, void* toBeDeleted);
 
+/** Removes the first node of the list without searching and returns its data. The data is not deleted.
+ *@pre List must exist and have memory allocated to it
+ *@param list pointer to the _tDummy head of the list
+ *@return on success: void * pointer to the data that was at the head  on failure or empty list: NULL
+ **/
+void* removeFromFront(List* list);
+
 /**Returns a pointer to the data at the front of the list. Does not alter list structure.
  *@pre The list exists and has memory allocated to it
  *@param the list struct
@@ -172,4 +195,36 @@ int getLength(List list);
  **/
 void* findElement(List list, bool (*customCompare)(const void* first,const void* second), const void* searchRecord);
 
+/** Function that searches for many elements in a single pass over the list. The next element is
+ * prefetched while the current one is checked against every search record not matched yet, so the
+ * list is walked once instead of once per record.
+ *@pre List exists and is valid.  Comparator function has been provided.
+ *@post List remains unchanged.
+ *@return The number of search records that matched an element.
+ *@param list - a list sruct
+ *@param customCompare - a pointer to comparator fuction for customizing the search
+ *@param searchRecords - an array of n pointers to search data
+ *@param n - the number of search records
+ *@param out - an array of n pointers, set to the data of the first element matching each record, or NULL
+ **/
+int findManyInList(List list, bool (*customCompare)(const void* first,const void* second), const void* searchRecords[], int n, void* out[]);
+
+/** Reports the bytes held by the nodes of the list. Payload is the data pointer of every node, metadata
+ * the previous and next links, slack the allocator rounding and the released nodes of the compacted block.
+ * The List struct belongs to the caller and the data to the user, neither is counted.
+ *@pre List must exist, but does not have to have elements.
+ *@param list - the list struct.
+ *@return the usage
+ **/
+MemoryUsage getListMemoryUsage(List list);
+
+/** Copies every node into one contiguous block in list order and frees the old nodes, so a list that
+ * went through long churn is walked in address order again and gives back the memory of removed nodes.
+ * Node pointers taken before the call are no longer valid, data pointers are unchanged.
+ *@pre List must exist, but does not have to have elements.
+ *@param list pointer to the _tDummy head of the list
+ *@return false if the block could not be allocated, the list is then unchanged
+ **/
+bool compactList(List* list);
+
 #endif
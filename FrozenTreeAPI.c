@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "FrozenTreeAPI.h"
+
+/**
+ * Position after k in an in-order walk of the implicit tree of count positions
+ */
+static int nextEytzinger(int k, int count) {
+    if (2 * k + 1 <= count) {
+        //Leftmost position of the right subtree
+        k = 2 * k + 1;
+        while (2 * k <= count) {
+            k = 2 * k;
+        }
+        return k;
+    }
+
+    //Climb while coming up from a right child, then once more
+    while (k & 1) {
+        k >>= 1;
+    }
+    return k >> 1;
+}
+
+/**
+ * Turns the position reached by a branch free descent back into the lower bound:
+ * the path went right after the answer and left ever since, so drop the trailing
+ * left turns (1 bits) and the final right turn (0 bit)
+ */
+static int restoreLowerBound(unsigned long long k) {
+    return (int)(k >> __builtin_ffsll(~k));
+}
+
+static FrozenTree* freeze(Tree* theTree, KeyFunc key) {
+    FrozenTree* frozen = malloc(sizeof(FrozenTree));
+    if (frozen == NULL) {
+        return NULL;
+    }
+
+    int count = theTree->count;
+    size_t bytes = (sizeof(TreeDataPtr) * (count + 1) + 63) / 64 * 64;
+    frozen->data = aligned_alloc(64, bytes);
+    frozen->keys = NULL;
+    if (frozen->data != NULL && key != NULL) {
+        frozen->keys = aligned_alloc(64, (sizeof(long long) * (count + 1) + 63) / 64 * 64);
+    }
+    if (frozen->data == NULL || (key != NULL && frozen->keys == NULL)) {
+        free(frozen->data);
+        free(frozen);
+        return NULL;
+    }
+    frozen->count = count;
+    frozen->compareFunc = theTree->compareFunc;
+
+    //Visiting the implicit positions in order while walking the tree in order places every element
+    int k = 1;
+    while (2 * k <= count) {
+        k = 2 * k;
+    }
+
+    TreeIterator iter = createTreeIterator(theTree);
+    TreeDataPtr elem;
+    while (k != 0 && (elem = nextTreeElement(&iter)) != NULL) {
+        frozen->data[k] = elem;
+        if (key != NULL) {
+            frozen->keys[k] = key(elem);
+        }
+        k = nextEytzinger(k, count);
+    }
+
+    return frozen;
+}
+
+FrozenTree* freezeTree(Tree* theTree) {
+    if (theTree == NULL) {
+        return NULL;
+    }
+
+    return freeze(theTree, NULL);
+}
+
+FrozenTree* freezeTreeWithKeys(Tree* theTree, KeyFunc key) {
+    if (theTree == NULL || key == NULL) {
+        return NULL;
+    }
+
+    return freeze(theTree, key);
+}
+
+void destroyFrozenTree(FrozenTree* toDestroy) {
+    if (toDestroy == NULL) {
+        return;
+    }
+
+    free(toDestroy->data);
+    free(toDestroy->keys);
+    free(toDestroy);
+}
+
+TreeDataPtr frozenLowerBound(FrozenTree* frozen, TreeDataPtr data) {
+    if (frozen == NULL || frozen->count == 0) {
+        return NULL;
+    }
+
+    unsigned long long k = 1;
+    unsigned long long count = frozen->count;
+
+    //The comparison result picks the child, so there is no branch to mispredict
+    while (k <= count) {
+        __builtin_prefetch(&frozen->data[k * FROZEN_PREFETCH_STRIDE]);
+        k = 2 * k + (frozen->compareFunc(frozen->data[k], data) < 0);
+    }
+
+    int position = restoreLowerBound(k);
+    if (position == 0) {
+        return NULL;
+    }
+    return frozen->data[position];
+}
+
+TreeDataPtr findInFrozenTree(FrozenTree* frozen, TreeDataPtr data) {
+    TreeDataPtr found = frozenLowerBound(frozen, data);
+
+    if (found != NULL && frozen->compareFunc(found, data) == 0) {
+        return found;
+    }
+    else {
+        return NULL;
+    }
+}
+
+TreeDataPtr findKeyInFrozenTree(FrozenTree* frozen, long long key) {
+    if (frozen == NULL || frozen->keys == NULL || frozen->count == 0) {
+        return NULL;
+    }
+
+    unsigned long long k = 1;
+    unsigned long long count = frozen->count;
+
+    while (k <= count) {
+        __builtin_prefetch(&frozen->keys[k * FROZEN_PREFETCH_STRIDE]);
+        k = 2 * k + (frozen->keys[k] < key);
+    }
+
+    int position = restoreLowerBound(k);
+    if (position != 0 && frozen->keys[position] == key) {
+        return frozen->data[position];
+    }
+    else {
+        return NULL;
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef FROZENTREE_FROZENTREEAPI_H
+#define FROZENTREE_FROZENTREEAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "BinarySearchTreeAPI.h"
+
+/**
+ * How many elements ahead of the current position to prefetch. The children
+ * of position k four levels down start at 16k and are contiguous.
+ */
+#define FROZEN_PREFETCH_STRIDE 16
+
+/**
+ * Extracts an integer key from a piece of tree data, used to specialize lookups
+ */
+typedef long long (*KeyFunc)(const void* data);
+
+/**
+ * Read-only snapshot of a tree in Eytzinger (BFS) order: the root is at
+ * position 1 and the children of position k are at 2k and 2k + 1, so a
+ * lookup walks an implicit tree with no child pointers. Position 0 is unused.
+ * The snapshot shares the data of the tree it was taken from.
+ */
+typedef struct frozenTree {
+    TreeDataPtr* data;
+    long long* keys; //Integer keys in the same order as data, NULL unless made by freezeTreeWithKeys
+    int count;
+    CompareFunc compareFunc;
+} FrozenTree;
+
+/**
+ * Copies the in-order contents of a tree into a new Eytzinger layout snapshot in O(n)
+ * @param Tree theTree
+ * @return Newly created snapshot, NULL on allocation failure
+ */
+FrozenTree* freezeTree(Tree* theTree);
+
+/**
+ * Like freezeTree, but also stores an integer key per element so that
+ * findKeyInFrozenTree can search without calling the comparator
+ * @param Tree theTree
+ * @param KeyFunc key function giving keys in the same order as the tree's compareFunc
+ * @return Newly created snapshot, NULL on allocation failure
+ */
+FrozenTree* freezeTreeWithKeys(Tree* theTree, KeyFunc key);
+
+/**
+ * Frees a snapshot. The data is owned by the tree and is not deleted.
+ * @param FrozenTree toDestroy
+ * @return void
+ */
+void destroyFrozenTree(FrozenTree* toDestroy);
+
+/**
+ * Finds the first element not less than data, branch free and prefetching ahead
+ * @param FrozenTree frozen
+ * @param TreeDataPtr data
+ * @return NULL if every element is less than data, otherwise the element
+ */
+TreeDataPtr frozenLowerBound(FrozenTree* frozen, TreeDataPtr data);
+
+/**
+ * Searches the snapshot for the target data
+ * @param FrozenTree frozen
+ * @param TreeDataPtr data
+ * @return NULL if fail, otherwise return data
+ */
+TreeDataPtr findInFrozenTree(FrozenTree* frozen, TreeDataPtr data);
+
+/**
+ * Searches a snapshot made by freezeTreeWithKeys by integer key
+ * @param FrozenTree frozen
+ * @param long long key
+ * @return NULL if fail or the snapshot has no keys, otherwise return data
+ */
+TreeDataPtr findKeyInFrozenTree(FrozenTree* frozen, long long key);
+
+#endif //FROZENTREE_FROZENTREEAPI_H
@@ -4,15 +4,26 @@
 #include <ctype.h>
 #include <stdbool.h>
 #include "HashTableAPI.h"
-#define DEBUG false
+#include "InstrumentAPI.h"
 
 HTable* createTable(size_t size, int (*hashFunction)(size_t tableSize, string key), void (*destroyData)(Node* toDelete), void (*printNode)(void *toBePrinted)) {
+    return createTableWithAllocator(size, hashFunction, destroyData, printNode, NULL);
+}
+
+HTable* createTableWithAllocator(size_t size, int (*hashFunction)(size_t tableSize, string key), void (*destroyData)(Node* toDelete), void (*printNode)(void *toBePrinted), Allocator* allocator) {
     //Allocate space for the table and the inner-table
     HTable* newTable = malloc(sizeof(HTable));
-    newTable->table = malloc(sizeof(Node) * size);
+    if (newTable == NULL) {
+        return NULL;
+    }
+    newTable->table = allocatorAllocBulk(allocator, sizeof(Node*) * size);
+    if (newTable->table == NULL && size > 0) {
+        free(newTable);
+        return NULL;
+    }
 
     //Initialize the inner table to NULL
-    for (int i = 0; i < size; i++) {
+    for (size_t i = 0; i < size; i++) {
         newTable->table[i] = NULL;
     }
 
@@ -21,6 +32,9 @@ HTable* createTable(size_t size, int (*hashFunction)(size_t tableSize, string ke
     newTable->hashFunction = hashFunction;
     newTable->destroyData = destroyData;
     newTable->printNode = printNode;
+    newTable->allocator = allocator;
+    newTable->nodeBlock = NULL;
+    newTable->blockSize = 0;
 
     //Return the new table
     return newTable;
@@ -39,21 +53,71 @@ Node* createNode(string key, void* data) {
     return newNode;
 }
 
+/**
+ * Creates a node with the table's allocator
+ * @param hashTable table the node will be inserted into
+ * @param key string that represents the data
+ * @param data is a generic pointer to any data type
+ * @return the new node, NULL on allocation failure
+ */
+static Node* allocateNode(HTable* hashTable, string key, void* data) {
+    Node* newNode = allocatorAlloc(hashTable->allocator, sizeof(Node));
+    if (newNode == NULL) {
+        return NULL;
+    }
+    STAT_RECORD(STATS_HASH_TABLE, STAT_ALLOCS, sizeof(Node));
+
+    newNode->data = data;
+    newNode->key = key;
+    newNode->next = NULL;
+
+    return newNode;
+}
+
+/**
+ * Checks if a node lives in the block made by compactTable
+ * @param hashTable table that owns the node
+ * @param node
+ * @return true if the node must not be released on its own
+ */
+static bool isInBlock(HTable* hashTable, Node* node) {
+    return hashTable->nodeBlock != NULL && node >= hashTable->nodeBlock && node < hashTable->nodeBlock + hashTable->blockSize;
+}
+
+/**
+ * Gives a node back to the table's allocator unless it lives in the compacted block
+ * @param hashTable table that owns the node
+ * @param node
+ * @return void
+ */
+static void releaseNode(HTable* hashTable, Node* node) {
+    if (isInBlock(hashTable, node)) {
+        return;
+    }
+
+    allocatorRelease(hashTable->allocator, node, sizeof(Node));
+    STAT_RECORD(STATS_HASH_TABLE, STAT_FREES, sizeof(Node));
+}
+
 void destroyTable(HTable* hashTable) {
     if (hashTable == NULL) {
         return;
     }
 
-    for (int i = 0; i < hashTable->size; i++) {
-        if (hashTable->table[i] != NULL) {
-            //Free allocated Node
-            free(hashTable->table[i]);
-            hashTable->table[i] = NULL;
+    //Arena nodes all go when the arena is reset, there is nothing to free one by one
+    if (allocatorReleasesEach(hashTable->allocator)) {
+        for (int i = 0; i < hashTable->size; i++) {
+            if (hashTable->table[i] != NULL) {
+                //Free allocated Node
+                releaseNode(hashTable, hashTable->table[i]);
+                hashTable->table[i] = NULL;
+            }
         }
     }
 
-    //Free the array
-    free(hashTable->table);
+    //Free the compacted nodes and the array
+    allocatorReleaseBulk(hashTable->allocator, hashTable->nodeBlock, sizeof(Node) * hashTable->blockSize);
+    allocatorReleaseBulk(hashTable->allocator, hashTable->table, sizeof(Node*) * hashTable->size);
     hashTable->table = NULL;
 
     //Free the table
@@ -68,23 +132,16 @@ void insertData(HTable* hashTable, string key, void* data) {
 
     //Handle collision
     while (hashTable->table[location] != NULL && (i < hashTable->size)) {
-        if(DEBUG)printf("Inside while loop\n");
-        if (hashTable->table[i] == NULL) {
-            if(DEBUG)printf("Inserting %s to hashTable->table[%d]\n", key, i);
-            Node* toAdd = createNode(key, data);
-            hashTable->table[i] = toAdd;
-            return;
-        }
-
         location = (location + 1) % hashTable->size;
         //Advance loop
         i++;
     }
 
+    STAT_RECORD(STATS_HASH_TABLE, STAT_PROBES, i + 1);
+
     //Free slot to insert node
     if (hashTable->table[location] == NULL) {
-        if(DEBUG)printf("Inserting %s to hashTable->table[%d]\n", key, location);
-        Node* toAdd = createNode(key, data);
+        Node* toAdd = allocateNode(hashTable, key, data);
         hashTable->table[location] = toAdd;
     }
 }
@@ -93,6 +150,30 @@ void add(HTable* hashTable, void* data) {
     ;
 }
 
+/**
+ * Empties the slot of a removed node without breaking the probe run it sits in.
+ * Later nodes of the run move back into the hole unless their home slot lies
+ * after the hole, so lookups still reach every key before meeting a NULL slot.
+ * @param hashTable table the node was removed from
+ * @param hole slot of the removed node
+ * @return void
+ */
+static void closeGap(HTable* hashTable, size_t hole) {
+    size_t size = hashTable->size;
+
+    for (size_t next = (hole + 1) % size; hashTable->table[next] != NULL && next != hole; next = (next + 1) % size) {
+        size_t home = hashNode(size, hashTable->table[next]->key);
+
+        //Distance from home to the node against distance from the hole to the node
+        if ((next + size - home) % size >= (next + size - hole) % size) {
+            hashTable->table[hole] = hashTable->table[next];
+            hole = next;
+        }
+    }
+
+    hashTable->table[hole] = NULL;
+}
+
 void removeData(HTable* hashTable, string key) {
     if (hashTable == NULL || key == NULL) {
         return;
@@ -105,6 +186,7 @@ void removeData(HTable* hashTable, string key) {
     Node* temp = hashTable->table[location];
     //No Node found
     if (temp == NULL) {
+        STAT_RECORD(STATS_HASH_TABLE, STAT_PROBES, 1);
         return;
     }
 
@@ -115,8 +197,10 @@ void removeData(HTable* hashTable, string key) {
             //Delete Node
             //destroyNodeData(temp);
             //Delete Node from location
-            free(temp);
+            releaseNode(hashTable, temp);
+            closeGap(hashTable, location);
             temp = NULL;
+            STAT_RECORD(STATS_HASH_TABLE, STAT_PROBES, i + 1);
             return;
         }
 
@@ -125,6 +209,8 @@ void removeData(HTable* hashTable, string key) {
         //Advance loop
         i++;
     }
+
+    STAT_RECORD(STATS_HASH_TABLE, STAT_PROBES, i + 1);
 }
 
 void* lookupData(HTable* hashTable, string key) {
@@ -139,6 +225,7 @@ void* lookupData(HTable* hashTable, string key) {
     Node* temp = hashTable->table[location];
     //No Node found
     if (temp == NULL) {
+        STAT_RECORD(STATS_HASH_TABLE, STAT_PROBES, 1);
         return NULL;
     }
 
@@ -147,6 +234,7 @@ void* lookupData(HTable* hashTable, string key) {
     //Handle collision
     while (temp != NULL && (i < hashTable->size)) {
         if (strcmp(temp->key, key) == 0) {
+            STAT_RECORD(STATS_HASH_TABLE, STAT_PROBES, i + 1);
             return temp;
         }
 
@@ -155,6 +243,126 @@ void* lookupData(HTable* hashTable, string key) {
         //Advance loop
         i++;
     }
+
+    STAT_RECORD(STATS_HASH_TABLE, STAT_PROBES, i + 1);
+    return NULL;
+}
+
+MemoryUsage getTableMemoryUsage(HTable* hashTable) {
+    MemoryUsage usage = {0, 0, 0};
+    if (hashTable == NULL) {
+        return usage;
+    }
+
+    size_t nodeFootprint = allocatorFootprint(hashTable->allocator, sizeof(Node));
+    size_t inBlock = 0;
+
+    usage.metadata += sizeof(HTable);
+    for (size_t i = 0; i < hashTable->size; i++) {
+        Node* node = hashTable->table[i];
+        if (node == NULL) {
+            usage.slack += sizeof(Node*);
+            continue;
+        }
+
+        usage.metadata += sizeof(Node*) + sizeof(node->next);
+        usage.payload += sizeof(node->key) + sizeof(node->data);
+        if (isInBlock(hashTable, node)) {
+            inBlock++;
+        }
+        else {
+            usage.slack += nodeFootprint - sizeof(Node);
+        }
+    }
+
+    size_t slotBytes = sizeof(Node*) * hashTable->size;
+    usage.slack += allocatorBulkFootprint(hashTable->allocator, slotBytes) - slotBytes;
+
+    //Block slots freed by removeData stay allocated until the next compaction
+    if (hashTable->nodeBlock != NULL) {
+        size_t blockBytes = sizeof(Node) * hashTable->blockSize;
+        usage.slack += sizeof(Node) * (hashTable->blockSize - inBlock) + allocatorBulkFootprint(hashTable->allocator, blockBytes) - blockBytes;
+    }
+
+    return usage;
+}
+
+bool compactTable(HTable* hashTable, size_t newSize) {
+    if (hashTable == NULL) {
+        return false;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < hashTable->size; i++) {
+        if (hashTable->table[i] != NULL) {
+            count++;
+        }
+    }
+
+    if (newSize == 0) {
+        newSize = count * 2;
+    }
+    if (newSize < count) {
+        newSize = count;
+    }
+    if (newSize == 0) {
+        newSize = 1;
+    }
+
+    Node** newTable = allocatorAllocBulk(hashTable->allocator, sizeof(Node*) * newSize);
+    Node* newBlock = count > 0 ? allocatorAllocBulk(hashTable->allocator, sizeof(Node) * count) : NULL;
+    if (newTable == NULL || (count > 0 && newBlock == NULL)) {
+        allocatorReleaseBulk(hashTable->allocator, newTable, sizeof(Node*) * newSize);
+        allocatorReleaseBulk(hashTable->allocator, newBlock, sizeof(Node) * count);
+        return false;
+    }
+
+    for (size_t i = 0; i < newSize; i++) {
+        newTable[i] = NULL;
+    }
+
+    //Rehash the old nodes first so the block can follow the new slot order
+    for (size_t i = 0; i < hashTable->size; i++) {
+        Node* node = hashTable->table[i];
+        if (node == NULL) {
+            continue;
+        }
+
+        //Same hash as insertData and lookupData, whatever hashFunction the table was created with
+        size_t location = hashNode(newSize, node->key);
+        while (newTable[location] != NULL) {
+            location = (location + 1) % newSize;
+        }
+        newTable[location] = node;
+    }
+
+    size_t next = 0;
+    for (size_t i = 0; i < newSize; i++) {
+        Node* node = newTable[i];
+        if (node == NULL) {
+            continue;
+        }
+
+        newBlock[next].key = node->key;
+        newBlock[next].data = node->data;
+        newBlock[next].next = NULL;
+        newTable[i] = &newBlock[next];
+        next++;
+
+        //Arena nodes stay in the arena until it is reset
+        releaseNode(hashTable, node);
+    }
+
+    allocatorReleaseBulk(hashTable->allocator, hashTable->nodeBlock, sizeof(Node) * hashTable->blockSize);
+    allocatorReleaseBulk(hashTable->allocator, hashTable->table, sizeof(Node*) * hashTable->size);
+
+    hashTable->table = newTable;
+    hashTable->size = newSize;
+    hashTable->nodeBlock = newBlock;
+    hashTable->blockSize = count;
+    STAT_RECORD(STATS_HASH_TABLE, STAT_RESIZES, newSize);
+
+    return true;
 }
 
 int hashNode(size_t tableSize, string key) {
@@ -3,6 +3,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include "AllocatorAPI.h"
 
 typedef char* string;
 
@@ -21,11 +23,14 @@ typedef struct HTable {
     void (*destroyData)(Node* data);    //Function pointer to a function to delete a single piece of data from a hash table
     int (*hashFunction)(size_t tableSize, string key);    //Function pointer to a function to hash the data
     void (*printNode)(void* toBePrinted);    //Function pointer to a function that prints out a data element of the table
+    Allocator* allocator;    //Where the table's nodes come from, NULL for malloc
+    Node* nodeBlock;    //Nodes repacked by compactTable, NULL if it was never called
+    size_t blockSize;    //Number of nodes in nodeBlock
 } HTable;
 
 /**
  * Function to point the hash table to the appropriate functions. Allocates memory to the struct and table based on the size given.
- * @return pointer to the hash table
+ * @return pointer to the hash table, NULL if memory could not be allocated
  * @param size size of the hash table
  * @param hashFunction function pointer to a function to hash the data
  * @param destroyData function pointer to a function to delete a single piece of data from the hash table
@@ -33,6 +38,20 @@ typedef struct HTable {
  */
 HTable* createTable(size_t size, int (*hashFunction)(size_t tableSize, string key), void (*destroyData)(Node* toDelete), void (*printNode)(void* toBePrinted));
 
+/**
+ * Same as createTable, but the table's nodes are allocated from allocator. With an arena allocator
+ * destroyTable does not free the nodes, they are released when the arena is reset or destroyed.
+ * The slot array and the block made by compactTable come from the allocator's bulk allocation,
+ * so a page allocator backs them with huge pages.
+ * @return pointer to the hash table, NULL if the struct or the slot array could not be allocated
+ * @param size size of the hash table
+ * @param hashFunction function pointer to a function to hash the data
+ * @param destroyData function pointer to a function to delete a single piece of data from the hash table
+ * @param printNode function pointer to a function that prints out a data element of the table
+ * @param allocator allocator for the nodes, NULL for malloc. It must outlive the table
+ */
+HTable* createTableWithAllocator(size_t size, int (*hashFunction)(size_t tableSize, string key), void (*destroyData)(Node* toDelete), void (*printNode)(void* toBePrinted), Allocator* allocator);
+
 /**
  * Function for creating a node for the hash table.
  * @pre Node must be cast to void pointer before being added
@@ -87,6 +106,30 @@ void removeData(HTable* hashTable, string key);
  */
 void* lookupData(HTable* hashTable, string key);
 
+/**
+ * Reports the bytes held by the table. Payload is the key and data pointers of
+ * every node, metadata the table struct, the used slots and the node links,
+ * slack the empty slots, allocator rounding and released nodes of the compacted block.
+ * The keys and data themselves belong to the caller and are not counted.
+ * @pre hashTable must exist
+ * @param hashTable pointer to the hash table
+ * @return the usage, all zero if hashTable is NULL
+ */
+MemoryUsage getTableMemoryUsage(HTable* hashTable);
+
+/**
+ * Resizes the table to newSize slots and rehashes every node into one contiguous
+ * block in slot order, so a table that shrank after heavy churn gives its memory
+ * back and a scan of the table walks memory in order. Node pointers returned by
+ * lookupData before the call are no longer valid. Nodes are placed with
+ * hashNode, the hash insertData, lookupData and removeData probe with.
+ * @pre hashTable must exist
+ * @param hashTable pointer to the hash table
+ * @param newSize number of slots, 0 for twice the number of nodes. Never less than the number of nodes
+ * @return false if memory could not be allocated, the table is then unchanged
+ */
+bool compactTable(HTable* hashTable, size_t newSize);
+
 /**
  * Function to return the hashed value of the Node
  * @param size_t tableSize Size of the hash table
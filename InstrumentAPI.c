@@ -0,0 +1,264 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "InstrumentAPI.h"
+
+/**
+ * Counters of one kind of one structure for a single thread. Only the owning
+ * thread writes them, the atomics only make reads from other threads defined.
+ */
+typedef struct statCounter {
+    atomic_ullong count;
+    atomic_ullong sum;
+    atomic_ullong max;
+    atomic_ullong histogram[STAT_BUCKETS];
+} StatCounter;
+
+/**
+ * Every counter of one thread. Blocks are never freed: when a thread exits
+ * its block keeps its totals and is handed to the next new thread.
+ */
+typedef struct threadStats {
+    StatCounter counters[STATS_NUM_STRUCTURES][STAT_NUM_KINDS];
+    atomic_bool inUse;
+    struct threadStats* next;
+} ThreadStats;
+
+static const char* structureNames[STATS_NUM_STRUCTURES] = {"hashTable", "list", "tree", "priorityQueue"};
+static const char* kindNames[STAT_NUM_KINDS] = {"probes", "compares", "depth", "allocs", "frees", "resizes"};
+
+static _Atomic(ThreadStats*) allThreads = NULL;
+static _Thread_local ThreadStats* threadStats = NULL;
+
+static pthread_key_t releaseKey;
+static pthread_once_t releaseKeyOnce = PTHREAD_ONCE_INIT;
+
+static void releaseThreadStats(void* block) {
+    atomic_store_explicit(&((ThreadStats*)block)->inUse, false, memory_order_release);
+}
+
+static void createReleaseKey(void) {
+    pthread_key_create(&releaseKey, releaseThreadStats);
+}
+
+/**
+ * Finds the calling thread a block, reusing one left by an exited thread if possible
+ * @return the block, NULL on allocation failure
+ */
+static ThreadStats* claimThreadStats(void) {
+    ThreadStats* block = NULL;
+
+    for (ThreadStats* tmp = atomic_load_explicit(&allThreads, memory_order_acquire); tmp != NULL; tmp = tmp->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&tmp->inUse, &expected, true)) {
+            block = tmp;
+            break;
+        }
+    }
+
+    if (block == NULL) {
+        block = calloc(1, sizeof(ThreadStats));
+        if (block == NULL) {
+            return NULL;
+        }
+        atomic_store(&block->inUse, true);
+
+        ThreadStats* head = atomic_load(&allThreads);
+        do {
+            block->next = head;
+        } while (!atomic_compare_exchange_weak(&allThreads, &head, block));
+    }
+
+    pthread_once(&releaseKeyOnce, createReleaseKey);
+    pthread_setspecific(releaseKey, block);
+
+    return block;
+}
+
+/**
+ * Adds to a counter only this thread writes, without a locked instruction
+ */
+static void bump(atomic_ullong* counter, unsigned long long value) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+static int bucketOf(unsigned long long value) {
+    if (value == 0) {
+        return 0;
+    }
+
+    int bucket = 64 - __builtin_clzll(value);
+    return bucket < STAT_BUCKETS ? bucket : STAT_BUCKETS - 1;
+}
+
+void recordStat(StatStructure structure, StatKind kind, unsigned long long value) {
+    if (threadStats == NULL) {
+        threadStats = claimThreadStats();
+        if (threadStats == NULL) {
+            return;
+        }
+    }
+
+    StatCounter* counter = &threadStats->counters[structure][kind];
+    bump(&counter->count, 1);
+    bump(&counter->sum, value);
+    bump(&counter->histogram[bucketOf(value)], 1);
+    if (value > atomic_load_explicit(&counter->max, memory_order_relaxed)) {
+        atomic_store_explicit(&counter->max, value, memory_order_relaxed);
+    }
+}
+
+bool statsEnabled(void) {
+#ifdef DS_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+void getStats(StatStructure structure, StatKind kind, StatSummary* out) {
+    if (out == NULL) {
+        return;
+    }
+
+    out->count = 0;
+    out->sum = 0;
+    out->max = 0;
+    for (int i = 0; i < STAT_BUCKETS; i++) {
+        out->histogram[i] = 0;
+    }
+
+    for (ThreadStats* tmp = atomic_load_explicit(&allThreads, memory_order_acquire); tmp != NULL; tmp = tmp->next) {
+        StatCounter* counter = &tmp->counters[structure][kind];
+        unsigned long long max = atomic_load_explicit(&counter->max, memory_order_relaxed);
+
+        out->count += atomic_load_explicit(&counter->count, memory_order_relaxed);
+        out->sum += atomic_load_explicit(&counter->sum, memory_order_relaxed);
+        out->max = max > out->max ? max : out->max;
+        for (int i = 0; i < STAT_BUCKETS; i++) {
+            out->histogram[i] += atomic_load_explicit(&counter->histogram[i], memory_order_relaxed);
+        }
+    }
+}
+
+void resetStats(void) {
+    for (ThreadStats* tmp = atomic_load_explicit(&allThreads, memory_order_acquire); tmp != NULL; tmp = tmp->next) {
+        for (int s = 0; s < STATS_NUM_STRUCTURES; s++) {
+            for (int k = 0; k < STAT_NUM_KINDS; k++) {
+                StatCounter* counter = &tmp->counters[s][k];
+                atomic_store_explicit(&counter->count, 0, memory_order_relaxed);
+                atomic_store_explicit(&counter->sum, 0, memory_order_relaxed);
+                atomic_store_explicit(&counter->max, 0, memory_order_relaxed);
+                for (int i = 0; i < STAT_BUCKETS; i++) {
+                    atomic_store_explicit(&counter->histogram[i], 0, memory_order_relaxed);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Growing output buffer for statsToJSON
+ */
+typedef struct jsonBuffer {
+    char* text;
+    size_t length;
+    size_t capacity;
+    bool failed;
+} JSONBuffer;
+
+static void appendJSON(JSONBuffer* buffer, const char* format, ...) {
+    if (buffer->failed) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int needed = vsnprintf(buffer->text + buffer->length, buffer->capacity - buffer->length, format, args);
+    va_end(args);
+
+    if (needed < 0) {
+        buffer->failed = true;
+        return;
+    }
+
+    if (buffer->length + needed >= buffer->capacity) {
+        size_t capacity = (buffer->length + needed + 1) * 2;
+        char* text = realloc(buffer->text, capacity);
+        if (text == NULL) {
+            buffer->failed = true;
+            return;
+        }
+        buffer->text = text;
+        buffer->capacity = capacity;
+
+        va_start(args, format);
+        vsnprintf(buffer->text + buffer->length, buffer->capacity - buffer->length, format, args);
+        va_end(args);
+    }
+
+    buffer->length += needed;
+}
+
+char* statsToJSON(void) {
+    JSONBuffer buffer = {malloc(1024), 0, 1024, false};
+    if (buffer.text == NULL) {
+        return NULL;
+    }
+
+    appendJSON(&buffer, "{\"enabled\": %s, \"stats\": {", statsEnabled() ? "true" : "false");
+
+    bool firstStructure = true;
+    for (int s = 0; s < STATS_NUM_STRUCTURES; s++) {
+        bool firstKind = true;
+        for (int k = 0; k < STAT_NUM_KINDS; k++) {
+            StatSummary summary;
+            getStats(s, k, &summary);
+            if (summary.count == 0) {
+                continue;
+            }
+
+            if (firstKind) {
+                appendJSON(&buffer, "%s\"%s\": {", firstStructure ? "" : ", ", structureNames[s]);
+                firstStructure = false;
+            }
+            appendJSON(&buffer, "%s\"%s\": {\"count\": %llu, \"sum\": %llu, \"mean\": %.3f, \"max\": %llu, \"histogram\": {",
+                       firstKind ? "" : ", ", kindNames[k], summary.count, summary.sum,
+                       (double)summary.sum / summary.count, summary.max);
+            firstKind = false;
+
+            //Buckets are labelled with the smallest value they hold
+            bool firstBucket = true;
+            for (int i = 0; i < STAT_BUCKETS; i++) {
+                if (summary.histogram[i] != 0) {
+                    appendJSON(&buffer, "%s\"%llu\": %llu", firstBucket ? "" : ", ", i == 0 ? 0ULL : 1ULL << (i - 1), summary.histogram[i]);
+                    firstBucket = false;
+                }
+            }
+            appendJSON(&buffer, "}}");
+        }
+        if (!firstKind) {
+            appendJSON(&buffer, "}");
+        }
+    }
+    appendJSON(&buffer, "}}");
+
+    if (buffer.failed) {
+        free(buffer.text);
+        return NULL;
+    }
+
+    return buffer.text;
+}
+
+void dumpStats(FILE* stream) {
+    char* json = statsToJSON();
+
+    if (json != NULL) {
+        fprintf(stream, "%s\n", json);
+        free(json);
+    }
+}
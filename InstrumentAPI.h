@@ -0,0 +1,120 @@
+#ifndef INSTRUMENT_INSTRUMENTAPI_H
+#define INSTRUMENT_INSTRUMENTAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+/**
+ * Histograms have one bucket per power of two: bucket 0 counts values of 0,
+ * bucket b values in [2^(b-1), 2^b), the last one everything above
+ */
+#define STAT_BUCKETS 32
+
+/**
+ * Structures that report statistics
+ */
+typedef enum statStructure {
+    STATS_HASH_TABLE,
+    STATS_LIST,
+    STATS_TREE,
+    STATS_PRIORITY_QUEUE,
+    STATS_NUM_STRUCTURES
+} StatStructure;
+
+/**
+ * What is measured. Each recorded value is one operation:
+ * STAT_PROBES: slots visited by one hash table operation
+ * STAT_COMPARES: compare function calls made by one operation
+ * STAT_DEPTH: depth reached in a tree by one operation, the root being 1
+ * STAT_ALLOCS: bytes of one node allocation
+ * STAT_FREES: bytes of one node release
+ * STAT_RESIZES: new capacity after one resize
+ */
+typedef enum statKind {
+    STAT_PROBES,
+    STAT_COMPARES,
+    STAT_DEPTH,
+    STAT_ALLOCS,
+    STAT_FREES,
+    STAT_RESIZES,
+    STAT_NUM_KINDS
+} StatKind;
+
+/**
+ * Values recorded for one kind of one structure, summed over threads
+ */
+typedef struct statSummary {
+    unsigned long long count;    //Number of values recorded
+    unsigned long long sum;
+    unsigned long long max;
+    unsigned long long histogram[STAT_BUCKETS];
+} StatSummary;
+
+/**
+ * Instrumentation is compiled in with -DDS_INSTRUMENT (the CMake option
+ * DATASTRUCTURES_INSTRUMENT). Without it the macros below expand to nothing,
+ * locals declared with STAT_LOCAL do not exist and the hot paths are
+ * unchanged. With it each thread records into its own counters, so recording
+ * takes no lock and no atomic read-modify-write.
+ *
+ * STAT_LOCAL(name) declares a counter starting at 0
+ * STAT_INC(name) adds one to it
+ * STAT_RECORD(structure, kind, value) records one value
+ */
+#ifdef DS_INSTRUMENT
+#define STAT_LOCAL(name) unsigned long long name = 0
+#define STAT_INC(name) ((name)++)
+#define STAT_RECORD(structure, kind, value) recordStat((structure), (kind), (unsigned long long)(value))
+#else
+#define STAT_LOCAL(name)
+#define STAT_INC(name) ((void)0)
+#define STAT_RECORD(structure, kind, value) ((void)0)
+#endif
+
+/**
+ * Records one value in the calling thread's counters. Use STAT_RECORD
+ * rather than calling this directly so it disappears when disabled.
+ * @param StatStructure structure
+ * @param StatKind kind
+ * @param unsigned long long value
+ * @return void
+ */
+void recordStat(StatStructure structure, StatKind kind, unsigned long long value);
+
+/**
+ * Checks if the library was built with instrumentation
+ * @return true if values are being recorded
+ */
+bool statsEnabled(void);
+
+/**
+ * Sums the values recorded by every thread, including threads that have exited
+ * @param StatStructure structure
+ * @param StatKind kind
+ * @param StatSummary* out filled with the totals, all zero when disabled
+ * @return void
+ */
+void getStats(StatStructure structure, StatKind kind, StatSummary* out);
+
+/**
+ * Clears every counter. Values recorded by other threads while this runs may be lost.
+ * @return void
+ */
+void resetStats(void);
+
+/**
+ * Returns every non-empty summary as a JSON object keyed by structure and kind,
+ * with count, sum, mean, max and the non-empty histogram buckets
+ * @return newly allocated string the caller must free, NULL on allocation failure
+ */
+char* statsToJSON(void);
+
+/**
+ * Writes statsToJSON to a stream
+ * @param FILE* stream
+ * @return void
+ */
+void dumpStats(FILE* stream);
+
+#endif //INSTRUMENT_INSTRUMENTAPI_H
@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "MultiQueueAPI.h"
+
+static atomic_uint seedCounter = 1;
+static _Thread_local unsigned int threadSeed = 0;
+
+/**
+ * Per-thread xorshift generator, seeded the first time a thread uses it
+ */
+static unsigned int nextRandom(void) {
+    if (threadSeed == 0) {
+        threadSeed = atomic_fetch_add(&seedCounter, 1) * 2654435761u;
+        if (threadSeed == 0) {
+            threadSeed = 1;
+        }
+    }
+
+    threadSeed ^= threadSeed << 13;
+    threadSeed ^= threadSeed >> 17;
+    threadSeed ^= threadSeed << 5;
+
+    return threadSeed;
+}
+
+static bool heapPush(LockedHeap* heap, long priority, void* data) {
+    if (heap->count == heap->capacity) {
+        int capacity = heap->capacity == 0 ? 64 : heap->capacity * 2;
+        MultiQueueItem* items = realloc(heap->items, sizeof(MultiQueueItem) * capacity);
+        if (items == NULL) {
+            return false;
+        }
+        heap->items = items;
+        heap->capacity = capacity;
+    }
+
+    //Sift the new item up from the bottom
+    int i = heap->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap->items[parent].priority <= priority) {
+            break;
+        }
+        heap->items[i] = heap->items[parent];
+        i = parent;
+    }
+    heap->items[i].priority = priority;
+    heap->items[i].data = data;
+
+    return true;
+}
+
+static MultiQueueItem heapPop(LockedHeap* heap) {
+    MultiQueueItem top = heap->items[0];
+    MultiQueueItem last = heap->items[--heap->count];
+
+    //Sift the last item down from the root
+    int i = 0;
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= heap->count) {
+            break;
+        }
+        if (child + 1 < heap->count && heap->items[child + 1].priority < heap->items[child].priority) {
+            child++;
+        }
+        if (last.priority <= heap->items[child].priority) {
+            break;
+        }
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    if (heap->count > 0) {
+        heap->items[i] = last;
+    }
+
+    return top;
+}
+
+static void publishTop(LockedHeap* heap) {
+    long top = heap->count > 0 ? heap->items[0].priority : LONG_MAX;
+    atomic_store_explicit(&heap->top, top, memory_order_relaxed);
+}
+
+MultiQueue* createMultiQueue(int numThreads, int factor, void (*deleteFunction)(void* toBeDeleted)) {
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    if (factor < 1) {
+        factor = MULTIQUEUE_DEFAULT_FACTOR;
+    }
+
+    MultiQueue* queue = malloc(sizeof(MultiQueue));
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    //Two-choice pops need at least two heaps
+    queue->numHeaps = numThreads * factor < 2 ? 2 : numThreads * factor;
+    queue->heaps = aligned_alloc(_Alignof(LockedHeap), sizeof(LockedHeap) * queue->numHeaps);
+    if (queue->heaps == NULL) {
+        free(queue);
+        return NULL;
+    }
+
+    for (int i = 0; i < queue->numHeaps; i++) {
+        queue->heaps[i].items = NULL;
+        queue->heaps[i].count = 0;
+        queue->heaps[i].capacity = 0;
+        pthread_mutex_init(&queue->heaps[i].lock, NULL);
+        atomic_init(&queue->heaps[i].top, LONG_MAX);
+    }
+    atomic_init(&queue->count, 0);
+    queue->deleteData = deleteFunction;
+
+    return queue;
+}
+
+void destroyMultiQueue(MultiQueue* queue) {
+    if (queue == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < queue->numHeaps; i++) {
+        LockedHeap* heap = &queue->heaps[i];
+        for (int j = 0; queue->deleteData != NULL && j < heap->count; j++) {
+            queue->deleteData(heap->items[j].data);
+        }
+        free(heap->items);
+        pthread_mutex_destroy(&heap->lock);
+    }
+
+    free(queue->heaps);
+    free(queue);
+}
+
+bool multiQueueInsert(MultiQueue* queue, long priority, void* data) {
+    if (queue == NULL) {
+        return false;
+    }
+
+    //Keep trying random heaps until one is not locked by another thread
+    LockedHeap* heap;
+    do {
+        heap = &queue->heaps[nextRandom() % queue->numHeaps];
+    } while (pthread_mutex_trylock(&heap->lock) != 0);
+
+    bool pushed = heapPush(heap, priority, data);
+    if (pushed) {
+        atomic_fetch_add_explicit(&queue->count, 1, memory_order_relaxed);
+    }
+    publishTop(heap);
+    pthread_mutex_unlock(&heap->lock);
+
+    return pushed;
+}
+
+void* multiQueuePop(MultiQueue* queue, long* priority) {
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    int misses = 0;
+
+    while (atomic_load_explicit(&queue->count, memory_order_relaxed) > 0) {
+        //Pick the better of two random heaps using the published tops
+        LockedHeap* first = &queue->heaps[nextRandom() % queue->numHeaps];
+        LockedHeap* second = &queue->heaps[nextRandom() % queue->numHeaps];
+        long firstTop = atomic_load_explicit(&first->top, memory_order_relaxed);
+        long secondTop = atomic_load_explicit(&second->top, memory_order_relaxed);
+        LockedHeap* heap = secondTop < firstTop ? second : first;
+
+        if (firstTop == LONG_MAX && secondTop == LONG_MAX) {
+            //With few items left random probes mostly miss, so sweep every heap
+            if (++misses < queue->numHeaps) {
+                continue;
+            }
+            misses = 0;
+            heap = NULL;
+            for (int i = 0; i < queue->numHeaps && heap == NULL; i++) {
+                pthread_mutex_lock(&queue->heaps[i].lock);
+                if (queue->heaps[i].count > 0) {
+                    heap = &queue->heaps[i];
+                }
+                else {
+                    pthread_mutex_unlock(&queue->heaps[i].lock);
+                }
+            }
+            if (heap == NULL) {
+                continue;
+            }
+        }
+        else if (pthread_mutex_trylock(&heap->lock) != 0) {
+            continue;
+        }
+
+        //The heap may have been emptied between reading its top and locking it
+        if (heap->count == 0) {
+            pthread_mutex_unlock(&heap->lock);
+            continue;
+        }
+
+        MultiQueueItem item = heapPop(heap);
+        atomic_fetch_sub_explicit(&queue->count, 1, memory_order_relaxed);
+        publishTop(heap);
+        pthread_mutex_unlock(&heap->lock);
+
+        if (priority != NULL) {
+            *priority = item.priority;
+        }
+        return item.data;
+    }
+
+    return NULL;
+}
+
+int getMultiQueueCount(MultiQueue* queue) {
+    if (queue == NULL) {
+        return 0;
+    }
+
+    return atomic_load(&queue->count);
+}
@@ -0,0 +1,93 @@
+#ifndef MULTIQUEUE_MULTIQUEUEAPI_H
+#define MULTIQUEUE_MULTIQUEUEAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/**
+ * Number of heaps created per thread. More heaps lower contention, fewer
+ * heaps lower the rank error of pops.
+ */
+#define MULTIQUEUE_DEFAULT_FACTOR 2
+
+/**
+ * A (priority, data) pair stored in the heaps
+ */
+typedef struct multiQueueItem {
+    long priority;
+    void* data;
+} MultiQueueItem;
+
+/**
+ * One sequential binary min-heap guarded by its own lock. The priority of
+ * its top is mirrored in an atomic so that pop can pick between two heaps
+ * without taking either lock. Aligned to keep heaps on separate cache lines.
+ */
+typedef struct lockedHeap {
+    _Alignas(64) pthread_mutex_t lock;
+    MultiQueueItem* items;
+    int count;
+    int capacity;
+    atomic_long top;    //Priority of items[0], LONG_MAX when empty
+} LockedHeap;
+
+/**
+ * Relaxed concurrent priority queue made of c*p locked heaps. Insert pushes
+ * into a random heap and pop removes the top of the better of two random
+ * heaps, so popped items are close to, but not always, the global minimum.
+ * The expected rank error grows linearly with the number of heaps.
+ */
+typedef struct multiQueue {
+    LockedHeap* heaps;
+    int numHeaps;
+    atomic_int count;
+    void (*deleteData)(void* toBeDeleted);
+} MultiQueue;
+
+/**
+ * createMultiQueue: Creates a multiqueue sized for numThreads workers
+ * @param numThreads number of threads that will use the queue
+ * @param factor number of heaps per thread, MULTIQUEUE_DEFAULT_FACTOR if 0 or less
+ * @param deleteFunction function pointer to delete a single piece of data from the queue, may be NULL
+ * @return the new multiqueue, NULL on failure
+ */
+MultiQueue* createMultiQueue(int numThreads, int factor, void (*deleteFunction)(void* toBeDeleted));
+
+/**
+ * destroyMultiQueue: Deletes all remaining data, if the queue has a delete function, and frees the queue.
+ * No other thread may be using the queue.
+ * @param MultiQueue* queue
+ * @return void
+ */
+void destroyMultiQueue(MultiQueue* queue);
+
+/**
+ * multiQueueInsert: Inserts data with the given priority. Thread safe.
+ * Lower priority values are popped first.
+ * @param MultiQueue* queue
+ * @param long priority
+ * @param void* data
+ * @return true on success, false on allocation failure
+ */
+bool multiQueueInsert(MultiQueue* queue, long priority, void* data);
+
+/**
+ * multiQueuePop: Removes an item with a small priority. Thread safe.
+ * @param MultiQueue* queue
+ * @param long* priority set to the priority of the removed item, may be NULL
+ * @return the data of the removed item, NULL if the queue is empty
+ */
+void* multiQueuePop(MultiQueue* queue, long* priority);
+
+/**
+ * getMultiQueueCount: Number of items in the queue. Only exact while no
+ * other thread is inserting or popping.
+ * @param MultiQueue* queue
+ * @return int
+ */
+int getMultiQueueCount(MultiQueue* queue);
+
+#endif //MULTIQUEUE_MULTIQUEUEAPI_H
@@ -0,0 +1,319 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "PersistentTreeAPI.h"
+
+#define PERSISTENT_MAX_HEIGHT 64
+
+/**
+ * Reference conventions: functions taking a node to search from only borrow
+ * it, functions returning a node hand the caller one reference to it, and
+ * makeNode takes over the references passed to it.
+ */
+static PersistentNode* retainNode(PersistentNode* node) {
+    if (node != NULL) {
+        atomic_fetch_add_explicit(&node->refs, 1, memory_order_relaxed);
+    }
+    return node;
+}
+
+static PersistentEntry* retainEntry(PersistentEntry* entry) {
+    atomic_fetch_add_explicit(&entry->refs, 1, memory_order_relaxed);
+    return entry;
+}
+
+static void releaseEntry(PersistentEntry* entry, DeleteFunc del) {
+    if (atomic_fetch_sub_explicit(&entry->refs, 1, memory_order_acq_rel) == 1) {
+        if (del != NULL) {
+            del(entry->data);
+        }
+        free(entry);
+    }
+}
+
+static void releaseNode(PersistentNode* node, DeleteFunc del) {
+    //Recursion only follows nodes that were freed, so it is bounded by the height
+    if (node != NULL && atomic_fetch_sub_explicit(&node->refs, 1, memory_order_acq_rel) == 1) {
+        releaseEntry(node->entry, del);
+        releaseNode(node->left, del);
+        releaseNode(node->right, del);
+        free(node);
+    }
+}
+
+static int nodeHeight(PersistentNode* node) {
+    return node == NULL ? 0 : node->height;
+}
+
+/**
+ * Creates a node over the given references. After an allocation failure,
+ * here or earlier on, the references are released and NULL is returned.
+ */
+static PersistentNode* makeNode(PersistentEntry* entry, PersistentNode* left, PersistentNode* right, DeleteFunc del, bool* failed) {
+    PersistentNode* node = *failed ? NULL : malloc(sizeof(PersistentNode));
+    if (node == NULL) {
+        *failed = true;
+        if (entry != NULL) {
+            releaseEntry(entry, del);
+        }
+        releaseNode(left, del);
+        releaseNode(right, del);
+        return NULL;
+    }
+
+    node->entry = entry;
+    node->left = left;
+    node->right = right;
+    node->height = 1 + (nodeHeight(left) > nodeHeight(right) ? nodeHeight(left) : nodeHeight(right));
+    atomic_init(&node->refs, 1);
+
+    return node;
+}
+
+/**
+ * makeNode that restores the AVL condition with fresh copies instead of rotating in place
+ */
+static PersistentNode* balanceNode(PersistentEntry* entry, PersistentNode* left, PersistentNode* right, DeleteFunc del, bool* failed) {
+    int balance = nodeHeight(left) - nodeHeight(right);
+
+    if (*failed || (balance >= -1 && balance <= 1)) {
+        return makeNode(entry, left, right, del, failed);
+    }
+
+    PersistentNode* result;
+    if (balance > 1) {
+        if (nodeHeight(left->left) >= nodeHeight(left->right)) {
+            PersistentNode* lower = makeNode(entry, retainNode(left->right), right, del, failed);
+            result = makeNode(retainEntry(left->entry), retainNode(left->left), lower, del, failed);
+        }
+        else {
+            PersistentNode* middle = left->right;
+            PersistentNode* lower = makeNode(retainEntry(left->entry), retainNode(left->left), retainNode(middle->left), del, failed);
+            PersistentNode* upper = makeNode(entry, retainNode(middle->right), right, del, failed);
+            result = makeNode(retainEntry(middle->entry), lower, upper, del, failed);
+        }
+        releaseNode(left, del);
+    }
+    else {
+        if (nodeHeight(right->right) >= nodeHeight(right->left)) {
+            PersistentNode* lower = makeNode(entry, left, retainNode(right->left), del, failed);
+            result = makeNode(retainEntry(right->entry), lower, retainNode(right->right), del, failed);
+        }
+        else {
+            PersistentNode* middle = right->left;
+            PersistentNode* lower = makeNode(entry, left, retainNode(middle->left), del, failed);
+            PersistentNode* upper = makeNode(retainEntry(right->entry), retainNode(middle->right), retainNode(right->right), del, failed);
+            result = makeNode(retainEntry(middle->entry), lower, upper, del, failed);
+        }
+        releaseNode(right, del);
+    }
+
+    return result;
+}
+
+static PersistentNode* insertNode(PersistentTree* version, PersistentNode* node, TreeDataPtr data, bool* failed) {
+    if (node == NULL) {
+        PersistentEntry* entry = malloc(sizeof(PersistentEntry));
+        if (entry == NULL) {
+            *failed = true;
+            return NULL;
+        }
+        entry->data = data;
+        atomic_init(&entry->refs, 1);
+        return makeNode(entry, NULL, NULL, version->deleteFunc, failed);
+    }
+
+    PersistentNode* left = node->left;
+    PersistentNode* right = node->right;
+    if (version->compareFunc(data, node->entry->data) < 0) {
+        left = insertNode(version, left, data, failed);
+        right = retainNode(right);
+    }
+    else {
+        left = retainNode(left);
+        right = insertNode(version, right, data, failed);
+    }
+
+    return balanceNode(retainEntry(node->entry), left, right, version->deleteFunc, failed);
+}
+
+/**
+ * Copies the path to the smallest node of a subtree without it, handing its entry to min
+ */
+static PersistentNode* removeMinNode(PersistentTree* version, PersistentNode* node, PersistentEntry** min, bool* failed) {
+    if (node->left == NULL) {
+        *min = retainEntry(node->entry);
+        return retainNode(node->right);
+    }
+
+    PersistentNode* left = removeMinNode(version, node->left, min, failed);
+    return balanceNode(retainEntry(node->entry), left, retainNode(node->right), version->deleteFunc, failed);
+}
+
+static PersistentNode* removeNode(PersistentTree* version, PersistentNode* node, TreeDataPtr data, bool* failed) {
+    int result = version->compareFunc(data, node->entry->data);
+
+    if (result < 0) {
+        PersistentNode* left = removeNode(version, node->left, data, failed);
+        return balanceNode(retainEntry(node->entry), left, retainNode(node->right), version->deleteFunc, failed);
+    }
+    else if (result > 0) {
+        PersistentNode* right = removeNode(version, node->right, data, failed);
+        return balanceNode(retainEntry(node->entry), retainNode(node->left), right, version->deleteFunc, failed);
+    }
+
+    //The removed entry is not carried into the new version
+    if (node->left == NULL) {
+        return retainNode(node->right);
+    }
+    if (node->right == NULL) {
+        return retainNode(node->left);
+    }
+
+    PersistentEntry* min;
+    PersistentNode* right = removeMinNode(version, node->right, &min, failed);
+    return balanceNode(min, retainNode(node->left), right, version->deleteFunc, failed);
+}
+
+static PersistentNode* findNode(PersistentTree* version, TreeDataPtr data) {
+    PersistentNode* node = version->root;
+
+    while (node != NULL) {
+        int result = version->compareFunc(data, node->entry->data);
+        if (result == 0) {
+            return node;
+        }
+        node = result < 0 ? node->left : node->right;
+    }
+
+    return NULL;
+}
+
+/**
+ * Wraps a root reference in a version handle with the same function pointers as base
+ */
+static PersistentTree* createVersion(PersistentTree* base, PersistentNode* root, int count) {
+    PersistentTree* toReturn = malloc(sizeof(PersistentTree));
+    if (toReturn == NULL) {
+        releaseNode(root, base->deleteFunc);
+        return NULL;
+    }
+
+    toReturn->root = root;
+    toReturn->count = count;
+    toReturn->compareFunc = base->compareFunc;
+    toReturn->deleteFunc = base->deleteFunc;
+    toReturn->printFunc = base->printFunc;
+
+    return toReturn;
+}
+
+PersistentTree* createPersistentTree(CompareFunc compare, DeleteFunc del, PrintFunc print) {
+    PersistentTree base = {NULL, 0, compare, del, print};
+
+    return createVersion(&base, NULL, 0);
+}
+
+void releasePersistentTree(PersistentTree* version) {
+    if (version == NULL) {
+        return;
+    }
+
+    releaseNode(version->root, version->deleteFunc);
+    free(version);
+}
+
+PersistentTree* snapshotPersistentTree(PersistentTree* version) {
+    if (version == NULL) {
+        return NULL;
+    }
+
+    return createVersion(version, retainNode(version->root), version->count);
+}
+
+PersistentTree* addToPersistentTree(PersistentTree* version, TreeDataPtr data) {
+    if (version == NULL) {
+        return NULL;
+    }
+
+    if (findNode(version, data) != NULL) {
+        return snapshotPersistentTree(version);
+    }
+
+    bool failed = false;
+    PersistentNode* root = insertNode(version, version->root, data, &failed);
+    if (failed) {
+        return NULL;
+    }
+
+    return createVersion(version, root, version->count + 1);
+}
+
+PersistentTree* removeFromPersistentTree(PersistentTree* version, TreeDataPtr data) {
+    if (version == NULL) {
+        return NULL;
+    }
+
+    if (findNode(version, data) == NULL) {
+        return snapshotPersistentTree(version);
+    }
+
+    bool failed = false;
+    PersistentNode* root = removeNode(version, version->root, data, &failed);
+    if (failed) {
+        return NULL;
+    }
+
+    return createVersion(version, root, version->count - 1);
+}
+
+TreeDataPtr findInPersistentTree(PersistentTree* version, TreeDataPtr data) {
+    if (version == NULL) {
+        return NULL;
+    }
+
+    PersistentNode* node = findNode(version, data);
+    return node == NULL ? NULL : node->entry->data;
+}
+
+int persistentTreeToArray(PersistentTree* version, TreeDataPtr out[], int max) {
+    if (version == NULL || out == NULL) {
+        return 0;
+    }
+
+    //Nodes have no parent pointers, they are shared between versions, so walk with a stack
+    PersistentNode* stack[PERSISTENT_MAX_HEIGHT];
+    int depth = 0;
+    int found = 0;
+    PersistentNode* node = version->root;
+
+    while (found < max && (node != NULL || depth > 0)) {
+        if (node != NULL) {
+            stack[depth++] = node;
+            node = node->left;
+        }
+        else {
+            node = stack[--depth];
+            out[found++] = node->entry->data;
+            node = node->right;
+        }
+    }
+
+    return found;
+}
+
+int getPersistentTreeSize(PersistentTree* version) {
+    if (version == NULL) {
+        return 0;
+    }
+
+    return version->count;
+}
+
+int getPersistentTreeHeight(PersistentTree* version) {
+    if (version == NULL) {
+        return 0;
+    }
+
+    return nodeHeight(version->root);
+}
@@ -0,0 +1,120 @@
+#ifndef PERSISTENTTREE_PERSISTENTTREEAPI_H
+#define PERSISTENTTREE_PERSISTENTTREEAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "BinarySearchTreeAPI.h"
+
+/**
+ * Reference counted cell holding one piece of data. Every node copied from
+ * another shares its entry, and the data is deleted when the last node that
+ * refers to it is freed.
+ */
+typedef struct persistentEntry {
+    TreeDataPtr data;
+    atomic_int refs;
+} PersistentEntry;
+
+/**
+ * Immutable AVL tree node. A node is never changed after it is created, so
+ * it can be shared by any number of versions; refs counts the versions and
+ * parent nodes that point to it.
+ */
+typedef struct persistentNode {
+    PersistentEntry* entry;
+    struct persistentNode* left;
+    struct persistentNode* right;
+    int height;
+    atomic_int refs;
+} PersistentNode;
+
+/**
+ * One version of a persistent tree. Adding or removing data copies only the
+ * O(log n) nodes on the search path and returns a new version, every other
+ * node is shared with the version it was made from. Versions stay readable
+ * until they are released, from any thread.
+ */
+typedef struct persistentTree {
+    PersistentNode* root;
+    int count;
+    CompareFunc compareFunc;
+    DeleteFunc deleteFunc;
+    PrintFunc printFunc;
+} PersistentTree;
+
+/**
+ * Allocates an empty version and assigns function pointers
+ * @param compare Function pointer to compare data in tree Nodes
+ * @param del Function pointer to delete data from tree Nodes, may be NULL
+ * @param print Function pointer to print data from tree Nodes
+ * @return Newly created version, NULL on allocation failure
+ */
+PersistentTree* createPersistentTree(CompareFunc compare, DeleteFunc del, PrintFunc print);
+
+/**
+ * Releases a version. Nodes and data no other version shares are freed.
+ * @param PersistentTree version
+ * @return void
+ */
+void releasePersistentTree(PersistentTree* version);
+
+/**
+ * Makes another handle to the same version in O(1), released separately
+ * @param PersistentTree version
+ * @return Newly created handle, NULL on allocation failure
+ */
+PersistentTree* snapshotPersistentTree(PersistentTree* version);
+
+/**
+ * Creates a new version with data added, version itself is unchanged.
+ * If equal data is already stored the new version has the same contents.
+ * @param PersistentTree version
+ * @param TreeDataPtr data
+ * @return Newly created version, NULL on allocation failure
+ */
+PersistentTree* addToPersistentTree(PersistentTree* version, TreeDataPtr data);
+
+/**
+ * Creates a new version without data, version itself is unchanged. The
+ * stored data is deleted once no version holds it any more.
+ * @param PersistentTree version
+ * @param TreeDataPtr data
+ * @return Newly created version, NULL on allocation failure
+ */
+PersistentTree* removeFromPersistentTree(PersistentTree* version, TreeDataPtr data);
+
+/**
+ * Searches a version for the target data
+ * @param PersistentTree version
+ * @param TreeDataPtr data
+ * @return NULL if fail, otherwise return data
+ */
+TreeDataPtr findInPersistentTree(PersistentTree* version, TreeDataPtr data);
+
+/**
+ * Copies the data of a version into out in order, a consistent scan no
+ * later version can change
+ * @param PersistentTree version
+ * @param TreeDataPtr out[] array of at least max elements
+ * @param int max
+ * @return number of elements written to out
+ */
+int persistentTreeToArray(PersistentTree* version, TreeDataPtr out[], int max);
+
+/**
+ * Number of items in a version
+ * @param PersistentTree version
+ * @return int
+ */
+int getPersistentTreeSize(PersistentTree* version);
+
+/**
+ * Height of a version, 0 when empty
+ * @param PersistentTree version
+ * @return int
+ */
+int getPersistentTreeHeight(PersistentTree* version);
+
+#endif //PERSISTENTTREE_PERSISTENTTREEAPI_H
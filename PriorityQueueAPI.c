@@ -2,14 +2,129 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include "PriorityQueueAPI.h"
-#include "LinkedListAPI.h"
-#define DEBUG false
+#include "InstrumentAPI.h"
+
+/**
+ * Checks if heap item a belongs above heap item b in the current heap order
+ */
+static bool heapBefore(Queue* queue, void* a, void* b) {
+    return queue->order * queue->list.compare(a, b) < 0;
+}
+
+static void siftUp(Queue* queue, int i) {
+    void* item = queue->heap[i];
+    STAT_LOCAL(compares);
+
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        STAT_INC(compares);
+        if (!heapBefore(queue, item, queue->heap[parent])) {
+            break;
+        }
+        queue->heap[i] = queue->heap[parent];
+        i = parent;
+    }
+    queue->heap[i] = item;
+    STAT_RECORD(STATS_PRIORITY_QUEUE, STAT_COMPARES, compares);
+}
+
+static void siftDown(Queue* queue, int i) {
+    void* item = queue->heap[i];
+    STAT_LOCAL(compares);
+
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= queue->count) {
+            break;
+        }
+        if (child + 1 < queue->count) {
+            STAT_INC(compares);
+            if (heapBefore(queue, queue->heap[child + 1], queue->heap[child])) {
+                child++;
+            }
+        }
+        STAT_INC(compares);
+        if (!heapBefore(queue, queue->heap[child], item)) {
+            break;
+        }
+        queue->heap[i] = queue->heap[child];
+        i = child;
+    }
+    queue->heap[i] = item;
+    STAT_RECORD(STATS_PRIORITY_QUEUE, STAT_COMPARES, compares);
+}
+
+/**
+ * Bottom-up heap construction, O(n) for the whole array
+ */
+static void heapify(Queue* queue, int order) {
+    queue->order = order;
+    for (int i = queue->count / 2 - 1; i >= 0; i--) {
+        siftDown(queue, i);
+    }
+}
 
 Queue* createQueue(char* (*printFunction)(void* toBePrinted), void (*deleteFunction)(void* toBeDeleted), int (*compareFunction)(const void* first, const void* second)) {
     Queue* queue = malloc(sizeof(Queue));
+    if (queue == NULL) {
+        return NULL;
+    }
+
     List list = initializeList(printFunction, deleteFunction, compareFunction);
     queue->list = list;
     queue->count = 0;
+    queue->heap = NULL;
+    queue->capacity = 0;
+    queue->bound = 0;
+    queue->order = 1;
+
+    return queue;
+}
+
+static Queue* createHeapQueue(char* (*printFunction)(void* toBePrinted), void (*deleteFunction)(void* toBeDeleted), int (*compareFunction)(const void* first, const void* second), int capacity) {
+    Queue* queue = createQueue(printFunction, deleteFunction, compareFunction);
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    queue->capacity = capacity < 1 ? 1 : capacity;
+    queue->heap = malloc(sizeof(void*) * queue->capacity);
+    if (queue->heap == NULL) {
+        free(queue);
+        return NULL;
+    }
+
+    return queue;
+}
+
+Queue* createQueueFromArray(char* (*printFunction)(void* toBePrinted), void (*deleteFunction)(void* toBeDeleted), int (*compareFunction)(const void* first, const void* second), void* data[], int n) {
+    Queue* queue = createHeapQueue(printFunction, deleteFunction, compareFunction, n);
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < n; i++) {
+        queue->heap[i] = data[i];
+    }
+    queue->count = n;
+    heapify(queue, 1);
+
+    return queue;
+}
+
+Queue* createBoundedQueue(char* (*printFunction)(void* toBePrinted), void (*deleteFunction)(void* toBeDeleted), int (*compareFunction)(const void* first, const void* second), int k) {
+    if (k <= 0) {
+        return NULL;
+    }
+
+    Queue* queue = createHeapQueue(printFunction, deleteFunction, compareFunction, k);
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    //Keep the worst item on top so it can be checked and replaced cheaply
+    queue->bound = queue->capacity;
+    queue->order = -1;
 
     return queue;
 }
@@ -19,17 +134,91 @@ void destroy(Queue* queue) {
         return;
     }
 
-    while (queue->count != 0) {
-        pop(queue);
-	    queue->count--;
+    if (queue->heap != NULL) {
+        for (int i = 0; i < queue->count; i++) {
+            queue->list.deleteData(queue->heap[i]);
+        }
+        free(queue->heap);
+    }
+    else {
+        clearList(&queue->list);
     }
 
     free(queue);
 }
 
-void insert(Queue* queue, void* toBeAdded) {
-    insertSorted(&queue->list, toBeAdded);
+bool insert(Queue* queue, void* toBeAdded) {
+    if (queue == NULL) {
+        return false;
+    }
+
+    if (queue->heap == NULL) {
+        int length = queue->list.length;
+        insertSorted(&queue->list, toBeAdded);
+        if (queue->list.length == length) {
+            return false;
+        }
+        queue->count++;
+        return true;
+    }
+
+    if (queue->bound > 0) {
+        //Inserting after a pop needs the worst item back on top
+        if (queue->order != -1) {
+            heapify(queue, -1);
+        }
+
+        if (queue->count == queue->bound) {
+            //Not better than the worst kept item: reject without touching the heap
+            if (queue->list.compare(toBeAdded, queue->heap[0]) >= 0) {
+                queue->list.deleteData(toBeAdded);
+                return true;
+            }
+            queue->list.deleteData(queue->heap[0]);
+            queue->heap[0] = toBeAdded;
+            siftDown(queue, 0);
+            return true;
+        }
+    }
+    else if (queue->count == queue->capacity) {
+        void** heap = realloc(queue->heap, sizeof(void*) * queue->capacity * 2);
+        if (heap == NULL) {
+            return false;
+        }
+        queue->heap = heap;
+        queue->capacity *= 2;
+        STAT_RECORD(STATS_PRIORITY_QUEUE, STAT_RESIZES, queue->capacity);
+    }
+
+    queue->heap[queue->count] = toBeAdded;
     queue->count++;
+    siftUp(queue, queue->count - 1);
+
+    return true;
+}
+
+/**
+ * Puts the best item on top of a heap queue, bounded queues keep the worst there while filling
+ */
+static void orderBestFirst(Queue* queue) {
+    if (queue->order != 1) {
+        heapify(queue, 1);
+    }
+}
+
+/**
+ * Removes and returns the top of a heap queue
+ */
+static void* heapPop(Queue* queue) {
+    void* top = queue->heap[0];
+
+    queue->count--;
+    if (queue->count > 0) {
+        queue->heap[0] = queue->heap[queue->count];
+        siftDown(queue, 0);
+    }
+
+    return top;
 }
 
 void pop(Queue* queue) {
@@ -38,18 +227,63 @@ void pop(Queue* queue) {
     }
 
     if (isEmpty(queue) == 1) {
-        deleteDataFromList(&queue->list, queue->list.head);
-        queue->count--;
+        if (queue->heap != NULL) {
+            orderBestFirst(queue);
+            heapPop(queue);
+        }
+        else {
+            deleteDataFromList(&queue->list, queue->list.head->data);
+            queue->count--;
+        }
     }
 }
 
+int popBatch(Queue* queue, int k, void* out[]) {
+    if (queue == NULL || out == NULL) {
+        return 0;
+    }
+
+    int popped = 0;
+
+    if (queue->heap != NULL) {
+        orderBestFirst(queue);
+        while (popped < k && queue->count > 0) {
+            out[popped++] = heapPop(queue);
+        }
+        return popped;
+    }
+
+    //Unlink straight from the head of the sorted list without searching
+    while (popped < k && queue->list.head != NULL) {
+        out[popped++] = removeFromFront(&queue->list);
+    }
+    queue->count -= popped;
+
+    return popped;
+}
+
 void* peek(Queue* queue) {
     if (queue == NULL) {
         return NULL;
     }
 
     if (isEmpty(queue) == 1) {
-        return getFromFront(queue->list);
+        if (queue->heap == NULL) {
+            return getFromFront(queue->list);
+        }
+        if (queue->order == 1) {
+            return queue->heap[0];
+        }
+
+        //With the worst item on top the best is one of the leaves, scan them
+        //rather than reorder a heap the next insert would have to flip back
+        void* best = queue->heap[queue->count / 2];
+        for (int i = queue->count / 2 + 1; i < queue->count; i++) {
+            if (queue->list.compare(queue->heap[i], best) < 0) {
+                best = queue->heap[i];
+            }
+        }
+        return best;
     }
 
     return NULL;
@@ -61,8 +295,25 @@ void deleteNode(Queue* queue, void* toBeDeleted) {
     }
 
     if (isEmpty(queue) == 1) {
-        deleteDataFromList(&queue->list, toBeDeleted);
-        queue->count--;
+        if (queue->heap == NULL) {
+            if (deleteDataFromList(&queue->list, toBeDeleted) != NULL) {
+                queue->count--;
+            }
+            return;
+        }
+
+        for (int i = 0; i < queue->count; i++) {
+            if (queue->list.compare(queue->heap[i], toBeDeleted) == 0) {
+                //Fill the hole with the last item and restore the heap around it
+                queue->count--;
+                if (i < queue->count) {
+                    queue->heap[i] = queue->heap[queue->count];
+                    siftDown(queue, i);
+                    siftUp(queue, i);
+                }
+                return;
+            }
+        }
     }
 }
 
@@ -74,3 +325,48 @@ int isEmpty(Queue* queue) {
         return 1;
     }
 }
+
+MemoryUsage getQueueMemoryUsage(Queue* queue) {
+    MemoryUsage usage = {0, 0, 0};
+    if (queue == NULL) {
+        return usage;
+    }
+
+    if (queue->heap != NULL) {
+        size_t heapBytes = sizeof(void*) * queue->capacity;
+        usage.payload = sizeof(void*) * queue->count;
+        usage.slack = sizeof(void*) * (queue->capacity - queue->count) + allocatorFootprint(NULL, heapBytes) - heapBytes;
+    }
+    else {
+        usage = getListMemoryUsage(queue->list);
+    }
+    usage.metadata += sizeof(Queue);
+
+    return usage;
+}
+
+bool compactQueue(Queue* queue) {
+    if (queue == NULL) {
+        return false;
+    }
+
+    if (queue->heap == NULL) {
+        return compactList(&queue->list);
+    }
+
+    //A bounded queue fills its k slots in place and never grows
+    if (queue->bound > 0 || queue->capacity == queue->count || queue->capacity == 1) {
+        return true;
+    }
+
+    int capacity = queue->count < 1 ? 1 : queue->count;
+    void** heap = realloc(queue->heap, sizeof(void*) * capacity);
+    if (heap == NULL) {
+        return false;
+    }
+    queue->heap = heap;
+    queue->capacity = capacity;
+    STAT_RECORD(STATS_PRIORITY_QUEUE, STAT_RESIZES, queue->capacity);
+
+    return true;
+}
@@ -4,14 +4,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
-#include "LinkedListAPI.h"
+#include "DoublyLinkedListAPI.h"
 
 /**
- * Stores basic queue information
+ * Stores basic queue information. Queues made by createQueue keep their items
+ * in the sorted list, queues made by createQueueFromArray or createBoundedQueue
+ * keep them in an array binary heap and only use the list for its function pointers.
  */
 typedef struct queue {
     List list;
     int count;
+    void** heap;    //Binary heap of items, NULL when the sorted list is used
+    int capacity;
+    int bound;    //Maximum number of items kept in bounded mode, 0 if unbounded
+    int order;    //1 when the best item is on top of the heap, -1 when the worst is
 } Queue;
 
 /**
@@ -23,6 +29,30 @@ typedef struct queue {
  */
 Queue* createQueue(char* (*printFunction)(void* toBePrinted), void (*deleteFunction)(void* toBeDeleted), int (compareFunction)(const void* first, const void* second));
 
+/**
+ * createQueueFromArray: Creates a heap based queue holding the n items of data in O(n)
+ * @param printFunction function pointer to print a single node from the queue
+ * @param deleteFunction function pointer to delete a single piece of data from the queue
+ * @param compareFunction function pointer to compare two nodes of the queue
+ * @param data array of items to load, copied into the queue
+ * @param n number of items in data
+ * @return the queue struct, NULL on allocation failure
+ */
+Queue* createQueueFromArray(char* (*printFunction)(void* toBePrinted), void (*deleteFunction)(void* toBeDeleted), int (*compareFunction)(const void* first, const void* second), void* data[], int n);
+
+/**
+ * createBoundedQueue: Creates a heap based queue that keeps only the best k items inserted.
+ * Once full, an item that is not better than the worst kept item is rejected in O(1),
+ * otherwise it replaces the worst item in O(log k). Rejected and replaced items are
+ * passed to deleteFunction.
+ * @param printFunction function pointer to print a single node from the queue
+ * @param deleteFunction function pointer to delete a single piece of data from the queue
+ * @param compareFunction function pointer to compare two nodes of the queue
+ * @param k number of items to keep
+ * @return the queue struct, NULL if k is 0 or less or on allocation failure
+ */
+Queue* createBoundedQueue(char* (*printFunction)(void* toBePrinted), void (*deleteFunction)(void* toBeDeleted), int (*compareFunction)(const void* first, const void* second), int k);
+
 /**
  * destroy: Destroys a queue
  * @param Queue* queue
@@ -31,12 +61,14 @@ Queue* createQueue(char* (*printFunction)(void* toBePrinted), void (*deleteFunct
 void destroy(Queue* queue);
 
 /**
- * insert: Inserts into a queue
+ * insert: Inserts into a queue. An item a full bounded queue rejects counts as
+ * inserted, it has been passed to deleteFunction.
  * @param Queue* queue
  * @param void* toBeAdded
- * @return void
+ * @return true on success, false if memory could not be allocated, the item is then
+ * not in the queue and still belongs to the caller
  */
-void insert(Queue* queue, void* toBeAdded);
+bool insert(Queue* queue, void* toBeAdded);
 
 /**
  * pop: Removes the first element of a queue
@@ -46,7 +78,20 @@ void insert(Queue* queue, void* toBeAdded);
 void pop(Queue* queue);
 
 /**
- * peek: Looks at the head of a queue and returns the data
+ * popBatch: Removes up to k of the best elements of a queue, best first. The data
+ * is handed to the caller and not deleted. On a bounded queue the first call after
+ * inserting reorders the heap in O(k).
+ * @param Queue* queue
+ * @param int k
+ * @param void* out[] array of at least k elements
+ * @return number of elements written to out
+ */
+int popBatch(Queue* queue, int k, void* out[]);
+
+/**
+ * peek: Looks at the head of a queue and returns the data. On a bounded queue
+ * that has been inserted into since the last pop this scans the k/2 leaves of the
+ * heap, O(k), and leaves the heap as it is.
  * @param Queue* queue
  * @return void* data of the head of the queue
  */
@@ -67,4 +112,22 @@ void deleteNode(Queue* queue, void* toBeDeleted);
  */
 int isEmpty(Queue* queue);
 
+/**
+ * getQueueMemoryUsage: Reports the bytes held by a queue. Payload is one pointer per item,
+ * metadata the queue struct and the list links, slack the unused heap capacity, the
+ * allocator rounding and the released nodes of a compacted list
+ * @param Queue* queue
+ * @return MemoryUsage usage, all zero if queue is NULL
+ */
+MemoryUsage getQueueMemoryUsage(Queue* queue);
+
+/**
+ * compactQueue: Shrinks the heap array of an unbounded heap queue to its item count, or
+ * repacks the sorted list of a list queue into one block with compactList. Bounded
+ * queues keep their k slots.
+ * @param Queue* queue
+ * @return bool false if memory could not be allocated, the queue is then unchanged
+ */
+bool compactQueue(Queue* queue);
+
 #endif //QUEUEAPI_H
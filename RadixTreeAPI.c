@@ -0,0 +1,942 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "RadixTreeAPI.h"
+
+/**
+ * Child pointers with the lowest bit set point to leaves
+ */
+static bool isLeafPointer(RadixNode* node) {
+    return ((uintptr_t)node & 1) != 0;
+}
+
+static RadixLeaf* asLeaf(RadixNode* node) {
+    return (RadixLeaf*)((uintptr_t)node & ~(uintptr_t)1);
+}
+
+static RadixNode* tagLeaf(RadixLeaf* leaf) {
+    return (RadixNode*)((uintptr_t)leaf | 1);
+}
+
+static size_t nodeBytes(int type) {
+    switch (type) {
+        case RADIX_NODE4:
+            return sizeof(RadixNode4);
+        case RADIX_NODE16:
+            return sizeof(RadixNode16);
+        case RADIX_NODE48:
+            return sizeof(RadixNode48);
+        default:
+            return sizeof(RadixNode256);
+    }
+}
+
+static RadixNode* createNode(RadixTree* theTree, int type) {
+    size_t size = nodeBytes(type);
+    RadixNode* node = allocatorAlloc(theTree->allocator, size);
+    if (node == NULL) {
+        return NULL;
+    }
+
+    memset(node, 0, size);
+    node->type = type;
+
+    return node;
+}
+
+static void releaseNode(RadixTree* theTree, RadixNode* node) {
+    allocatorRelease(theTree->allocator, node, nodeBytes(node->type));
+}
+
+/**
+ * Copies the child count and compressed path of one node into a node of another size
+ */
+static void copyHeader(RadixNode* dest, RadixNode* src) {
+    dest->numChildren = src->numChildren;
+    dest->prefixLength = src->prefixLength;
+    memcpy(dest->prefix, src->prefix, RADIX_MAX_PREFIX);
+}
+
+static bool leafMatches(RadixLeaf* leaf, const char* key, size_t length) {
+    return leaf->length == length && memcmp(leaf->key, key, length) == 0;
+}
+
+RadixTree* createRadixTree(void (*deleteFunction)(void* toBeDeleted)) {
+    return createRadixTreeWithAllocator(deleteFunction, NULL);
+}
+
+RadixTree* createRadixTreeWithAllocator(void (*deleteFunction)(void* toBeDeleted), Allocator* allocator) {
+    RadixTree* toReturn = malloc(sizeof(RadixTree));
+    if (toReturn == NULL) {
+        return NULL;
+    }
+
+    toReturn->root = NULL;
+    toReturn->count = 0;
+    toReturn->deleteData = deleteFunction;
+    toReturn->allocator = allocator;
+
+    return toReturn;
+}
+
+/**
+ * Finds the slot holding the child for byte
+ * @return the slot, NULL if node has no such child
+ */
+static RadixNode** findChild(RadixNode* node, unsigned char byte) {
+    switch (node->type) {
+        case RADIX_NODE4: {
+            RadixNode4* node4 = (RadixNode4*)node;
+            for (int i = 0; i < node->numChildren; i++) {
+                if (node4->keys[i] == byte) {
+                    return &node4->children[i];
+                }
+            }
+            return NULL;
+        }
+        case RADIX_NODE16: {
+            RadixNode16* node16 = (RadixNode16*)node;
+#ifdef __SSE2__
+            //Compare the byte against all 16 keys at once and keep the slots in use
+            __m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8((char)byte), _mm_loadu_si128((const __m128i*)node16->keys));
+            unsigned mask = (unsigned)_mm_movemask_epi8(matches) & ((1U << node->numChildren) - 1);
+            return mask != 0 ? &node16->children[__builtin_ctz(mask)] : NULL;
+#else
+            for (int i = 0; i < node->numChildren; i++) {
+                if (node16->keys[i] == byte) {
+                    return &node16->children[i];
+                }
+            }
+            return NULL;
+#endif
+        }
+        case RADIX_NODE48: {
+            RadixNode48* node48 = (RadixNode48*)node;
+            int index = node48->childIndex[byte];
+            return index != 0 ? &node48->children[index - 1] : NULL;
+        }
+        default: {
+            RadixNode256* node256 = (RadixNode256*)node;
+            return node256->children[byte] != NULL ? &node256->children[byte] : NULL;
+        }
+    }
+}
+
+/**
+ * Follows the first child of every node down to the smallest leaf
+ */
+static RadixLeaf* minimumLeaf(RadixNode* node) {
+    while (node != NULL && !isLeafPointer(node)) {
+        switch (node->type) {
+            case RADIX_NODE4:
+                node = ((RadixNode4*)node)->children[0];
+                break;
+            case RADIX_NODE16:
+                node = ((RadixNode16*)node)->children[0];
+                break;
+            case RADIX_NODE48: {
+                RadixNode48* node48 = (RadixNode48*)node;
+                int i = 0;
+                while (node48->childIndex[i] == 0) {
+                    i++;
+                }
+                node = node48->children[node48->childIndex[i] - 1];
+                break;
+            }
+            default: {
+                RadixNode256* node256 = (RadixNode256*)node;
+                int i = 0;
+                while (node256->children[i] == NULL) {
+                    i++;
+                }
+                node = node256->children[i];
+                break;
+            }
+        }
+    }
+
+    return node == NULL ? NULL : asLeaf(node);
+}
+
+/**
+ * Counts the bytes of the prefix kept in the node that match key at depth
+ */
+static uint32_t matchStoredPrefix(RadixNode* node, const char* key, size_t length, size_t depth) {
+    uint32_t stored = node->prefixLength < RADIX_MAX_PREFIX ? node->prefixLength : RADIX_MAX_PREFIX;
+    uint32_t i = 0;
+
+    while (i < stored && depth + i < length && node->prefix[i] == (unsigned char)key[depth + i]) {
+        i++;
+    }
+
+    return i;
+}
+
+/**
+ * Counts the bytes of the whole compressed path of node that match key at
+ * depth, reading the part not kept in the node from its smallest leaf
+ * @return prefixLength or more when everything matches
+ */
+static uint32_t matchFullPrefix(RadixNode* node, const char* key, size_t length, size_t depth) {
+    uint32_t i = matchStoredPrefix(node, key, length, depth);
+
+    if (i < RADIX_MAX_PREFIX || node->prefixLength <= RADIX_MAX_PREFIX) {
+        return i;
+    }
+
+    RadixLeaf* leaf = minimumLeaf(node);
+    size_t limit = (leaf->length < length ? leaf->length : length) - depth;
+    while (i < limit && leaf->key[depth + i] == key[depth + i]) {
+        i++;
+    }
+
+    return i;
+}
+
+/**
+ * Adds child under byte to a node that has room for it
+ */
+static void addChildInPlace(RadixNode* node, unsigned char byte, RadixNode* child) {
+    switch (node->type) {
+        case RADIX_NODE4:
+        case RADIX_NODE16: {
+            //Node4 and Node16 share their layout up to the array sizes
+            unsigned char* keys = node->type == RADIX_NODE4 ? ((RadixNode4*)node)->keys : ((RadixNode16*)node)->keys;
+            RadixNode** children = node->type == RADIX_NODE4 ? ((RadixNode4*)node)->children : ((RadixNode16*)node)->children;
+            int position = 0;
+            while (position < node->numChildren && keys[position] < byte) {
+                position++;
+            }
+            memmove(keys + position + 1, keys + position, node->numChildren - position);
+            memmove(children + position + 1, children + position, sizeof(RadixNode*) * (node->numChildren - position));
+            keys[position] = byte;
+            children[position] = child;
+            break;
+        }
+        case RADIX_NODE48: {
+            RadixNode48* node48 = (RadixNode48*)node;
+            int position = 0;
+            while (node48->children[position] != NULL) {
+                position++;
+            }
+            node48->children[position] = child;
+            node48->childIndex[byte] = position + 1;
+            break;
+        }
+        default:
+            ((RadixNode256*)node)->children[byte] = child;
+            break;
+    }
+
+    node->numChildren++;
+}
+
+/**
+ * Copies a full node into the next larger type
+ * @return the new node, NULL on allocation failure
+ */
+static RadixNode* growNode(RadixTree* theTree, RadixNode* node) {
+    RadixNode* bigger = createNode(theTree, node->type + 1);
+    if (bigger == NULL) {
+        return NULL;
+    }
+    copyHeader(bigger, node);
+
+    switch (node->type) {
+        case RADIX_NODE4: {
+            RadixNode4* node4 = (RadixNode4*)node;
+            RadixNode16* node16 = (RadixNode16*)bigger;
+            memcpy(node16->keys, node4->keys, sizeof(node4->keys));
+            memcpy(node16->children, node4->children, sizeof(node4->children));
+            break;
+        }
+        case RADIX_NODE16: {
+            RadixNode16* node16 = (RadixNode16*)node;
+            RadixNode48* node48 = (RadixNode48*)bigger;
+            for (int i = 0; i < node->numChildren; i++) {
+                node48->childIndex[node16->keys[i]] = i + 1;
+                node48->children[i] = node16->children[i];
+            }
+            break;
+        }
+        default: {
+            RadixNode48* node48 = (RadixNode48*)node;
+            RadixNode256* node256 = (RadixNode256*)bigger;
+            for (int i = 0; i < 256; i++) {
+                if (node48->childIndex[i] != 0) {
+                    node256->children[i] = node48->children[node48->childIndex[i] - 1];
+                }
+            }
+            break;
+        }
+    }
+
+    releaseNode(theTree, node);
+    return bigger;
+}
+
+static bool isFull(RadixNode* node) {
+    static const int capacity[] = {4, 16, 48, 256};
+    return node->numChildren == capacity[node->type];
+}
+
+/**
+ * Adds child under byte to the node in *ref, growing it first if it is full
+ * @return false on allocation failure
+ */
+static bool addChild(RadixTree* theTree, RadixNode** ref, unsigned char byte, RadixNode* child) {
+    if (isFull(*ref)) {
+        RadixNode* bigger = growNode(theTree, *ref);
+        if (bigger == NULL) {
+            return false;
+        }
+        *ref = bigger;
+    }
+
+    addChildInPlace(*ref, byte, child);
+    return true;
+}
+
+void addToRadixTree(RadixTree* theTree, char* key, void* data) {
+    if (theTree == NULL || key == NULL) {
+        return;
+    }
+
+    size_t length = strlen(key) + 1;
+    RadixLeaf* newLeaf = allocatorAlloc(theTree->allocator, sizeof(RadixLeaf));
+    if (newLeaf == NULL) {
+        return;
+    }
+    newLeaf->key = key;
+    newLeaf->data = data;
+    newLeaf->length = length;
+
+    RadixNode** ref = &theTree->root;
+    size_t depth = 0;
+
+    while (true) {
+        RadixNode* node = *ref;
+
+        if (node == NULL) {
+            *ref = tagLeaf(newLeaf);
+            break;
+        }
+
+        if (isLeafPointer(node)) {
+            RadixLeaf* leaf = asLeaf(node);
+            if (leafMatches(leaf, key, length)) {
+                allocatorRelease(theTree->allocator, newLeaf, sizeof(RadixLeaf));
+                return;
+            }
+
+            //Split the leaf: a Node4 holding the shared bytes and both leaves.
+            //The keys differ before either terminator, so both bytes exist.
+            RadixNode* split = createNode(theTree, RADIX_NODE4);
+            if (split == NULL) {
+                allocatorRelease(theTree->allocator, newLeaf, sizeof(RadixLeaf));
+                return;
+            }
+            size_t common = 0;
+            while (leaf->key[depth + common] == key[depth + common]) {
+                common++;
+            }
+            split->prefixLength = common;
+            memcpy(split->prefix, key + depth, common < RADIX_MAX_PREFIX ? common : RADIX_MAX_PREFIX);
+            addChildInPlace(split, (unsigned char)leaf->key[depth + common], node);
+            addChildInPlace(split, (unsigned char)key[depth + common], tagLeaf(newLeaf));
+            *ref = split;
+            break;
+        }
+
+        if (node->prefixLength > 0) {
+            uint32_t matched = matchFullPrefix(node, key, length, depth);
+            if (matched < node->prefixLength) {
+                //The key leaves the compressed path: put a Node4 above the node
+                //holding the shared part, the node keeps what comes after its branch byte
+                RadixNode* split = createNode(theTree, RADIX_NODE4);
+                if (split == NULL) {
+                    allocatorRelease(theTree->allocator, newLeaf, sizeof(RadixLeaf));
+                    return;
+                }
+                split->prefixLength = matched;
+                memcpy(split->prefix, node->prefix, matched < RADIX_MAX_PREFIX ? matched : RADIX_MAX_PREFIX);
+
+                unsigned char branch;
+                uint32_t remaining = node->prefixLength - (matched + 1);
+                if (node->prefixLength <= RADIX_MAX_PREFIX) {
+                    branch = node->prefix[matched];
+                    memmove(node->prefix, node->prefix + matched + 1, remaining);
+                }
+                else {
+                    RadixLeaf* leaf = minimumLeaf(node);
+                    branch = (unsigned char)leaf->key[depth + matched];
+                    memcpy(node->prefix, leaf->key + depth + matched + 1, remaining < RADIX_MAX_PREFIX ? remaining : RADIX_MAX_PREFIX);
+                }
+                node->prefixLength = remaining;
+
+                addChildInPlace(split, branch, node);
+                addChildInPlace(split, (unsigned char)key[depth + matched], tagLeaf(newLeaf));
+                *ref = split;
+                break;
+            }
+            depth += node->prefixLength;
+        }
+
+        RadixNode** child = findChild(node, (unsigned char)key[depth]);
+        if (child == NULL) {
+            if (!addChild(theTree, ref, (unsigned char)key[depth], tagLeaf(newLeaf))) {
+                allocatorRelease(theTree->allocator, newLeaf, sizeof(RadixLeaf));
+                return;
+            }
+            break;
+        }
+
+        ref = child;
+        depth++;
+    }
+
+    theTree->count++;
+}
+
+/**
+ * Copies a mostly empty node into the next smaller type
+ */
+static RadixNode* shrinkNode(RadixTree* theTree, RadixNode* node) {
+    RadixNode* smaller = createNode(theTree, node->type - 1);
+    if (smaller == NULL) {
+        //Keep the larger node, it is still valid
+        return node;
+    }
+    copyHeader(smaller, node);
+
+    switch (node->type) {
+        case RADIX_NODE16: {
+            RadixNode16* node16 = (RadixNode16*)node;
+            RadixNode4* node4 = (RadixNode4*)smaller;
+            memcpy(node4->keys, node16->keys, node->numChildren);
+            memcpy(node4->children, node16->children, sizeof(RadixNode*) * node->numChildren);
+            break;
+        }
+        case RADIX_NODE48: {
+            RadixNode48* node48 = (RadixNode48*)node;
+            RadixNode16* node16 = (RadixNode16*)smaller;
+            int next = 0;
+            for (int i = 0; i < 256; i++) {
+                if (node48->childIndex[i] != 0) {
+                    node16->keys[next] = i;
+                    node16->children[next] = node48->children[node48->childIndex[i] - 1];
+                    next++;
+                }
+            }
+            break;
+        }
+        default: {
+            RadixNode256* node256 = (RadixNode256*)node;
+            RadixNode48* node48 = (RadixNode48*)smaller;
+            int next = 0;
+            for (int i = 0; i < 256; i++) {
+                if (node256->children[i] != NULL) {
+                    node48->childIndex[i] = next + 1;
+                    node48->children[next] = node256->children[i];
+                    next++;
+                }
+            }
+            break;
+        }
+    }
+
+    releaseNode(theTree, node);
+    return smaller;
+}
+
+/**
+ * Removes the child under byte from the node in *ref, shrinking the node or
+ * merging it into its last child when few children are left
+ */
+static void removeChild(RadixTree* theTree, RadixNode** ref, unsigned char byte, RadixNode** slot) {
+    RadixNode* node = *ref;
+
+    switch (node->type) {
+        case RADIX_NODE4:
+        case RADIX_NODE16: {
+            unsigned char* keys = node->type == RADIX_NODE4 ? ((RadixNode4*)node)->keys : ((RadixNode16*)node)->keys;
+            RadixNode** children = node->type == RADIX_NODE4 ? ((RadixNode4*)node)->children : ((RadixNode16*)node)->children;
+            int position = slot - children;
+            memmove(keys + position, keys + position + 1, node->numChildren - position - 1);
+            memmove(children + position, children + position + 1, sizeof(RadixNode*) * (node->numChildren - position - 1));
+            break;
+        }
+        case RADIX_NODE48: {
+            RadixNode48* node48 = (RadixNode48*)node;
+            node48->children[node48->childIndex[byte] - 1] = NULL;
+            node48->childIndex[byte] = 0;
+            break;
+        }
+        default:
+            ((RadixNode256*)node)->children[byte] = NULL;
+            break;
+    }
+    node->numChildren--;
+
+    //Shrink with some room to spare so a node at the boundary does not flip back and forth
+    if ((node->type == RADIX_NODE256 && node->numChildren <= 37) || (node->type == RADIX_NODE48 && node->numChildren <= 12) ||
+        (node->type == RADIX_NODE16 && node->numChildren <= 3)) {
+        *ref = shrinkNode(theTree, node);
+        return;
+    }
+
+    if (node->type != RADIX_NODE4 || node->numChildren != 1) {
+        return;
+    }
+
+    //One child left: it takes over the node's path, the branch byte and its own path
+    RadixNode4* node4 = (RadixNode4*)node;
+    RadixNode* child = node4->children[0];
+    if (!isLeafPointer(child)) {
+        unsigned char prefix[RADIX_MAX_PREFIX];
+        uint32_t length = node->prefixLength < RADIX_MAX_PREFIX ? node->prefixLength : RADIX_MAX_PREFIX;
+
+        memcpy(prefix, node->prefix, length);
+        if (length < RADIX_MAX_PREFIX) {
+            prefix[length++] = node4->keys[0];
+        }
+        if (length < RADIX_MAX_PREFIX) {
+            uint32_t fromChild = child->prefixLength < RADIX_MAX_PREFIX - length ? child->prefixLength : RADIX_MAX_PREFIX - length;
+            memcpy(prefix + length, child->prefix, fromChild);
+            length += fromChild;
+        }
+        memcpy(child->prefix, prefix, length);
+        child->prefixLength += node->prefixLength + 1;
+    }
+
+    *ref = child;
+    releaseNode(theTree, node);
+}
+
+void removeFromRadixTree(RadixTree* theTree, const char* key) {
+    if (theTree == NULL || key == NULL || theTree->root == NULL) {
+        return;
+    }
+
+    size_t length = strlen(key) + 1;
+    RadixLeaf* found = NULL;
+
+    if (isLeafPointer(theTree->root)) {
+        if (leafMatches(asLeaf(theTree->root), key, length)) {
+            found = asLeaf(theTree->root);
+            theTree->root = NULL;
+        }
+    }
+    else {
+        RadixNode** ref = &theTree->root;
+        size_t depth = 0;
+
+        while (true) {
+            RadixNode* node = *ref;
+            if (node->prefixLength > 0) {
+                uint32_t stored = node->prefixLength < RADIX_MAX_PREFIX ? node->prefixLength : RADIX_MAX_PREFIX;
+                if (matchStoredPrefix(node, key, length, depth) != stored) {
+                    break;
+                }
+                depth += node->prefixLength;
+            }
+            if (depth >= length) {
+                break;
+            }
+
+            unsigned char byte = (unsigned char)key[depth];
+            RadixNode** child = findChild(node, byte);
+            if (child == NULL) {
+                break;
+            }
+
+            if (isLeafPointer(*child)) {
+                if (leafMatches(asLeaf(*child), key, length)) {
+                    found = asLeaf(*child);
+                    removeChild(theTree, ref, byte, child);
+                }
+                break;
+            }
+
+            ref = child;
+            depth++;
+        }
+    }
+
+    if (found == NULL) {
+        return;
+    }
+
+    if (theTree->deleteData != NULL) {
+        theTree->deleteData(found->data);
+    }
+    allocatorRelease(theTree->allocator, found, sizeof(RadixLeaf));
+    theTree->count--;
+}
+
+void* findInRadixTree(RadixTree* theTree, const char* key) {
+    if (theTree == NULL || key == NULL) {
+        return NULL;
+    }
+
+    size_t length = strlen(key) + 1;
+    RadixNode* node = theTree->root;
+    size_t depth = 0;
+
+    while (node != NULL) {
+        if (isLeafPointer(node)) {
+            RadixLeaf* leaf = asLeaf(node);
+            return leafMatches(leaf, key, length) ? leaf->data : NULL;
+        }
+
+        //Bytes past RADIX_MAX_PREFIX are skipped here and checked at the leaf
+        if (node->prefixLength > 0) {
+            uint32_t stored = node->prefixLength < RADIX_MAX_PREFIX ? node->prefixLength : RADIX_MAX_PREFIX;
+            if (matchStoredPrefix(node, key, length, depth) != stored) {
+                return NULL;
+            }
+            depth += node->prefixLength;
+        }
+        if (depth >= length) {
+            return NULL;
+        }
+
+        RadixNode** child = findChild(node, (unsigned char)key[depth]);
+        node = child != NULL ? *child : NULL;
+        depth++;
+    }
+
+    return NULL;
+}
+
+void* findLongestPrefixInRadixTree(RadixTree* theTree, const char* key, char** matched) {
+    if (matched != NULL) {
+        *matched = NULL;
+    }
+    if (theTree == NULL || key == NULL) {
+        return NULL;
+    }
+
+    size_t length = strlen(key) + 1;
+    RadixLeaf* best = NULL;
+    RadixNode* node = theTree->root;
+    size_t depth = 0;
+
+    while (node != NULL) {
+        if (isLeafPointer(node)) {
+            RadixLeaf* leaf = asLeaf(node);
+            if (leaf->length <= length && memcmp(leaf->key, key, leaf->length - 1) == 0) {
+                best = leaf;
+            }
+            break;
+        }
+
+        //The whole path has to match, every key ending below is then a prefix
+        if (node->prefixLength > 0) {
+            if (matchFullPrefix(node, key, length, depth) < node->prefixLength) {
+                break;
+            }
+            depth += node->prefixLength;
+        }
+        if (depth >= length) {
+            break;
+        }
+
+        //A key ending at this depth hangs off the terminator byte
+        RadixNode** ending = findChild(node, '\0');
+        if (ending != NULL) {
+            best = asLeaf(*ending);
+        }
+
+        RadixNode** child = findChild(node, (unsigned char)key[depth]);
+        node = child != NULL ? *child : NULL;
+        depth++;
+    }
+
+    if (best == NULL) {
+        return NULL;
+    }
+    if (matched != NULL) {
+        *matched = best->key;
+    }
+
+    return best->data;
+}
+
+/**
+ * State of an ordered walk. Keys below lo are skipped and the walk ends at
+ * the first key above hi, either may be NULL.
+ */
+typedef struct radixWalk {
+    const char* lo;
+    size_t loLength;
+    const char* hi;
+    RadixVisitFunc visit;
+    void* context;
+    bool done;    //Set once a key above hi is reached
+} RadixWalk;
+
+static int walkNode(RadixNode* node, size_t depth, bool bounded, RadixWalk* walk);
+
+/**
+ * Walks one child. While bounded the path so far equals the first bytes of lo,
+ * children below the next byte of lo are skipped and larger ones are unbounded.
+ */
+static int walkChild(RadixNode* child, unsigned char byte, size_t depth, bool bounded, RadixWalk* walk) {
+    if (bounded) {
+        unsigned char loByte = depth < walk->loLength ? (unsigned char)walk->lo[depth] : 0;
+        if (byte < loByte) {
+            return 0;
+        }
+        bounded = byte == loByte;
+    }
+
+    return walkNode(child, depth + 1, bounded, walk);
+}
+
+static int walkNode(RadixNode* node, size_t depth, bool bounded, RadixWalk* walk) {
+    if (isLeafPointer(node)) {
+        RadixLeaf* leaf = asLeaf(node);
+        if (bounded && strcmp(leaf->key, walk->lo) < 0) {
+            return 0;
+        }
+        if (walk->hi != NULL && strcmp(leaf->key, walk->hi) > 0) {
+            walk->done = true;
+            return 0;
+        }
+        return walk->visit(leaf->key, leaf->data, walk->context);
+    }
+
+    if (bounded && node->prefixLength > 0) {
+        RadixLeaf* leaf = node->prefixLength > RADIX_MAX_PREFIX ? minimumLeaf(node) : NULL;
+        for (uint32_t i = 0; i < node->prefixLength; i++) {
+            unsigned char byte = i < RADIX_MAX_PREFIX ? node->prefix[i] : (unsigned char)leaf->key[depth + i];
+            unsigned char loByte = depth + i < walk->loLength ? (unsigned char)walk->lo[depth + i] : 0;
+            if (byte < loByte) {
+                return 0;
+            }
+            if (byte > loByte) {
+                bounded = false;
+                break;
+            }
+        }
+    }
+    depth += node->prefixLength;
+
+    int result = 0;
+    switch (node->type) {
+        case RADIX_NODE4:
+        case RADIX_NODE16: {
+            unsigned char* keys = node->type == RADIX_NODE4 ? ((RadixNode4*)node)->keys : ((RadixNode16*)node)->keys;
+            RadixNode** children = node->type == RADIX_NODE4 ? ((RadixNode4*)node)->children : ((RadixNode16*)node)->children;
+            for (int i = 0; i < node->numChildren && result == 0 && !walk->done; i++) {
+                result = walkChild(children[i], keys[i], depth, bounded, walk);
+            }
+            break;
+        }
+        case RADIX_NODE48: {
+            RadixNode48* node48 = (RadixNode48*)node;
+            for (int i = 0; i < 256 && result == 0 && !walk->done; i++) {
+                if (node48->childIndex[i] != 0) {
+                    result = walkChild(node48->children[node48->childIndex[i] - 1], i, depth, bounded, walk);
+                }
+            }
+            break;
+        }
+        default: {
+            RadixNode256* node256 = (RadixNode256*)node;
+            for (int i = 0; i < 256 && result == 0 && !walk->done; i++) {
+                if (node256->children[i] != NULL) {
+                    result = walkChild(node256->children[i], i, depth, bounded, walk);
+                }
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+int visitRadixRange(RadixTree* theTree, const char* lo, const char* hi, RadixVisitFunc visit, void* context) {
+    if (theTree == NULL || visit == NULL || theTree->root == NULL) {
+        return 0;
+    }
+
+    RadixWalk walk = {lo, lo != NULL ? strlen(lo) + 1 : 0, hi, visit, context, false};
+
+    return walkNode(theTree->root, 0, lo != NULL, &walk);
+}
+
+int visitRadixTree(RadixTree* theTree, RadixVisitFunc visit, void* context) {
+    return visitRadixRange(theTree, NULL, NULL, visit, context);
+}
+
+int visitRadixPrefix(RadixTree* theTree, const char* prefix, RadixVisitFunc visit, void* context) {
+    if (theTree == NULL || prefix == NULL || visit == NULL) {
+        return 0;
+    }
+
+    //Descend along the prefix, without its terminator, to the subtree holding every match
+    size_t length = strlen(prefix);
+    RadixNode* node = theTree->root;
+    size_t depth = 0;
+
+    while (node != NULL && depth < length) {
+        if (isLeafPointer(node)) {
+            RadixLeaf* leaf = asLeaf(node);
+            if (strncmp(leaf->key, prefix, length) == 0) {
+                return visit(leaf->key, leaf->data, context);
+            }
+            return 0;
+        }
+
+        if (node->prefixLength > 0) {
+            //Bytes matched past the compressed path belong to a child, not to this node
+            uint32_t matched = matchFullPrefix(node, prefix, length, depth);
+            if (matched > node->prefixLength) {
+                matched = node->prefixLength;
+            }
+            if (depth + matched >= length) {
+                //The prefix ends inside this node's path
+                break;
+            }
+            if (matched < node->prefixLength) {
+                return 0;
+            }
+            depth += node->prefixLength;
+        }
+
+        RadixNode** child = findChild(node, (unsigned char)prefix[depth]);
+        node = child != NULL ? *child : NULL;
+        depth++;
+    }
+
+    if (node == NULL) {
+        return 0;
+    }
+
+    RadixWalk walk = {NULL, 0, NULL, visit, context, false};
+    return walkNode(node, depth, false, &walk);
+}
+
+/**
+ * Frees every node below node, deleting the data of the leaves
+ */
+static void destroyNodes(RadixTree* theTree, RadixNode* node) {
+    if (isLeafPointer(node)) {
+        RadixLeaf* leaf = asLeaf(node);
+        if (theTree->deleteData != NULL) {
+            theTree->deleteData(leaf->data);
+        }
+        allocatorRelease(theTree->allocator, leaf, sizeof(RadixLeaf));
+        return;
+    }
+
+    switch (node->type) {
+        case RADIX_NODE4:
+            for (int i = 0; i < node->numChildren; i++) {
+                destroyNodes(theTree, ((RadixNode4*)node)->children[i]);
+            }
+            break;
+        case RADIX_NODE16:
+            for (int i = 0; i < node->numChildren; i++) {
+                destroyNodes(theTree, ((RadixNode16*)node)->children[i]);
+            }
+            break;
+        case RADIX_NODE48:
+            for (int i = 0; i < 48; i++) {
+                if (((RadixNode48*)node)->children[i] != NULL) {
+                    destroyNodes(theTree, ((RadixNode48*)node)->children[i]);
+                }
+            }
+            break;
+        default:
+            for (int i = 0; i < 256; i++) {
+                if (((RadixNode256*)node)->children[i] != NULL) {
+                    destroyNodes(theTree, ((RadixNode256*)node)->children[i]);
+                }
+            }
+            break;
+    }
+
+    releaseNode(theTree, node);
+}
+
+void destroyRadixTree(RadixTree* toDestroy) {
+    if (toDestroy == NULL) {
+        return;
+    }
+
+    if (toDestroy->root != NULL) {
+        destroyNodes(toDestroy, toDestroy->root);
+    }
+
+    free(toDestroy);
+}
+
+/**
+ * Adds the bytes held by node and everything below it to usage
+ */
+static void addNodeUsage(RadixTree* theTree, RadixNode* node, MemoryUsage* usage) {
+    if (isLeafPointer(node)) {
+        RadixLeaf* leaf = asLeaf(node);
+        usage->payload += sizeof(leaf->key) + sizeof(leaf->data);
+        usage->metadata += sizeof(leaf->length);
+        usage->slack += allocatorFootprint(theTree->allocator, sizeof(RadixLeaf)) - sizeof(RadixLeaf);
+        return;
+    }
+
+    static const int capacity[] = {4, 16, 48, 256};
+    size_t bytes = nodeBytes(node->type);
+    size_t slotBytes = node->type <= RADIX_NODE16 ? sizeof(RadixNode*) + 1 : sizeof(RadixNode*);
+    size_t unused = slotBytes * (capacity[node->type] - node->numChildren);
+
+    usage->metadata += bytes - unused;
+    usage->slack += unused + allocatorFootprint(theTree->allocator, bytes) - bytes;
+
+    switch (node->type) {
+        case RADIX_NODE4:
+            for (int i = 0; i < node->numChildren; i++) {
+                addNodeUsage(theTree, ((RadixNode4*)node)->children[i], usage);
+            }
+            break;
+        case RADIX_NODE16:
+            for (int i = 0; i < node->numChildren; i++) {
+                addNodeUsage(theTree, ((RadixNode16*)node)->children[i], usage);
+            }
+            break;
+        case RADIX_NODE48:
+            for (int i = 0; i < 48; i++) {
+                if (((RadixNode48*)node)->children[i] != NULL) {
+                    addNodeUsage(theTree, ((RadixNode48*)node)->children[i], usage);
+                }
+            }
+            break;
+        default:
+            for (int i = 0; i < 256; i++) {
+                if (((RadixNode256*)node)->children[i] != NULL) {
+                    addNodeUsage(theTree, ((RadixNode256*)node)->children[i], usage);
+                }
+            }
+            break;
+    }
+}
+
+MemoryUsage getRadixTreeMemoryUsage(RadixTree* theTree) {
+    MemoryUsage usage = {0, 0, 0};
+    if (theTree == NULL) {
+        return usage;
+    }
+
+    usage.metadata = sizeof(RadixTree);
+    if (theTree->root != NULL) {
+        addNodeUsage(theTree, theTree->root, &usage);
+    }
+
+    return usage;
+}
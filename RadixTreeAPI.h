@@ -0,0 +1,189 @@
+#ifndef RADIXTREE_RADIXTREEAPI_H
+#define RADIXTREE_RADIXTREEAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "AllocatorAPI.h"
+
+/**
+ * Bytes of a compressed path kept in the node itself. Longer paths keep
+ * their length and the rest is read from a leaf below the node.
+ */
+#define RADIX_MAX_PREFIX 10
+
+/**
+ * Inner node sizes, each grows into the next when full and shrinks back
+ * when mostly empty
+ */
+typedef enum radixNodeType {
+    RADIX_NODE4,    //Up to 4 children, sorted keys searched linearly
+    RADIX_NODE16,    //Up to 16 children, sorted keys searched with one SSE2 compare
+    RADIX_NODE48,    //Up to 48 children, a 256 byte index into the child array
+    RADIX_NODE256    //One child slot per byte
+} RadixNodeType;
+
+/**
+ * Header shared by every inner node. prefix holds the first bytes of the
+ * path compressed into this node, prefixLength its full length.
+ */
+typedef struct radixNode {
+    uint8_t type;
+    uint16_t numChildren;
+    uint32_t prefixLength;
+    unsigned char prefix[RADIX_MAX_PREFIX];
+} RadixNode;
+
+typedef struct radixNode4 {
+    RadixNode header;
+    unsigned char keys[4];
+    RadixNode* children[4];
+} RadixNode4;
+
+typedef struct radixNode16 {
+    RadixNode header;
+    unsigned char keys[16];
+    RadixNode* children[16];
+} RadixNode16;
+
+typedef struct radixNode48 {
+    RadixNode header;
+    unsigned char childIndex[256];    //Position of the child for each byte plus one, 0 if there is none
+    RadixNode* children[48];
+} RadixNode48;
+
+typedef struct radixNode256 {
+    RadixNode header;
+    RadixNode* children[256];
+} RadixNode256;
+
+/**
+ * Leaf holding one key and its data. Child pointers to leaves have their
+ * lowest bit set to tell them from inner nodes.
+ */
+typedef struct radixLeaf {
+    char* key;    //Not copied, like the keys of a hash table
+    void* data;
+    size_t length;    //Length of key including its terminating '\0'
+} RadixLeaf;
+
+/**
+ * Definition of the adaptive radix tree. Keys are '\0' terminated strings
+ * compared byte by byte as unsigned chars, so ordered traversals follow strcmp.
+ */
+typedef struct radixTree {
+    RadixNode* root;
+    size_t count;
+    void (*deleteData)(void* toBeDeleted);
+    Allocator* allocator;    //Where nodes and leaves come from, NULL for malloc
+} RadixTree;
+
+/**
+ * Called with each key and its data, return 0 to continue, anything else stops the traversal
+ */
+typedef int (*RadixVisitFunc)(const char* key, void* data, void* context);
+
+/**
+ * Allocates memory for an empty radix tree
+ * @param deleteFunction function pointer to delete a single piece of data from the tree, may be NULL
+ * @return Newly created tree, NULL on allocation failure
+ */
+RadixTree* createRadixTree(void (*deleteFunction)(void* toBeDeleted));
+
+/**
+ * Same as createRadixTree, but nodes and leaves come from allocator
+ * @param deleteFunction function pointer to delete a single piece of data from the tree, may be NULL
+ * @param allocator allocator for the nodes, NULL for malloc. It must outlive the tree
+ * @return Newly created tree, NULL on allocation failure
+ */
+RadixTree* createRadixTreeWithAllocator(void (*deleteFunction)(void* toBeDeleted), Allocator* allocator);
+
+/**
+ * Remove all items and free memory, deleting the data with deleteData
+ * @param RadixTree toDestroy
+ * @return void
+ */
+void destroyRadixTree(RadixTree* toDestroy);
+
+/**
+ * Add data under key. The key is stored as a pointer and must outlive the
+ * entry. Duplicate keys are not added, like addToTree.
+ * @param RadixTree theTree
+ * @param char* key
+ * @param void* data
+ * @return void
+ */
+void addToRadixTree(RadixTree* theTree, char* key, void* data);
+
+/**
+ * Remove the key and delete its data. Nodes shrink to a smaller type and
+ * single child nodes merge into their child.
+ * @param RadixTree theTree
+ * @param const char* key
+ * @return void
+ */
+void removeFromRadixTree(RadixTree* theTree, const char* key);
+
+/**
+ * Searches the tree for the key. Only the bytes kept in each node are
+ * compared on the way down, the whole key once at the leaf.
+ * @param RadixTree theTree
+ * @param const char* key
+ * @return NULL if fail, otherwise return data
+ */
+void* findInRadixTree(RadixTree* theTree, const char* key);
+
+/**
+ * Finds the longest key in the tree that is a prefix of key, key itself
+ * included. Prefixes are byte wise: "/a/b" is a prefix of "/a/bc".
+ * @param RadixTree theTree
+ * @param const char* key
+ * @param char** matched set to the key that matched, may be NULL
+ * @return NULL if no key in the tree is a prefix of key, otherwise its data
+ */
+void* findLongestPrefixInRadixTree(RadixTree* theTree, const char* key, char** matched);
+
+/**
+ * Calls visit on every key in order
+ * @param RadixTree theTree
+ * @param RadixVisitFunc visit
+ * @param void* context passed to every call of visit
+ * @return 0 if every key was visited, otherwise the value that stopped the traversal
+ */
+int visitRadixTree(RadixTree* theTree, RadixVisitFunc visit, void* context);
+
+/**
+ * Calls visit on every key starting with prefix, in order. Only the
+ * subtree under the prefix is walked.
+ * @param RadixTree theTree
+ * @param const char* prefix
+ * @param RadixVisitFunc visit
+ * @param void* context passed to every call of visit
+ * @return 0 if every key was visited, otherwise the value that stopped the traversal
+ */
+int visitRadixPrefix(RadixTree* theTree, const char* prefix, RadixVisitFunc visit, void* context);
+
+/**
+ * Calls visit on every key k with lo <= k <= hi in strcmp order. Subtrees
+ * entirely below lo are skipped and the walk stops at the first key above hi.
+ * @param RadixTree theTree
+ * @param const char* lo smallest key, NULL for no lower bound
+ * @param const char* hi largest key, NULL for no upper bound
+ * @param RadixVisitFunc visit
+ * @param void* context passed to every call of visit
+ * @return 0 if every key was visited, otherwise the value that stopped the traversal
+ */
+int visitRadixRange(RadixTree* theTree, const char* lo, const char* hi, RadixVisitFunc visit, void* context);
+
+/**
+ * Reports the bytes held by the tree. Payload is the key and data pointers
+ * of every leaf, metadata the inner nodes, the leaf lengths and the tree
+ * struct, slack the unused child slots and allocator rounding. The keys and
+ * data themselves belong to the caller and are not counted.
+ * @param RadixTree theTree
+ * @return MemoryUsage usage, all zero if theTree is NULL
+ */
+MemoryUsage getRadixTreeMemoryUsage(RadixTree* theTree);
+
+#endif //RADIXTREE_RADIXTREEAPI_H
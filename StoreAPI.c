@@ -0,0 +1,1372 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "StoreAPI.h"
+
+//Top bit of a record's value length, set for deleted keys
+#define STORE_DELETED_FLAG 0x80000000u
+
+/**
+ * Last bytes of every run file
+ */
+typedef struct runFooter {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t bloomHashes;
+    uint64_t indexOffset;
+    uint64_t numBlocks;
+    uint64_t bloomOffset;
+    uint64_t bloomBits;
+    uint64_t count;
+} RunFooter;
+
+/**
+ * One record as read from a memtable or a run. The pointers stay valid while
+ * the run is referenced or, for memtables, while the store is locked.
+ */
+typedef struct storeRecord {
+    const char* key;
+    const void* value;
+    size_t length;
+    bool deleted;
+} StoreRecord;
+
+/**
+ * Writes a run one record at a time, in key order
+ */
+typedef struct runWriter {
+    FILE* file;
+    char* path;
+    char* tmpPath;
+    unsigned char* block;    //Records of the block being filled
+    size_t blockUsed;
+    size_t blockCapacity;
+    char** firstKeys;    //Index, one entry per block written
+    uint64_t* offsets;
+    uint32_t* lengths;
+    size_t numBlocks;
+    size_t maxBlocks;
+    unsigned char* bloom;
+    uint64_t bloomBits;
+    uint64_t offset;    //Bytes written so far
+    uint64_t count;
+    bool failed;
+} RunWriter;
+
+/**
+ * Position in one source of a merge: a memtable or a run
+ */
+typedef struct storeCursor {
+    StoreRecord record;
+    bool valid;
+    int source;    //Lower is newer, newer sources hide older values of a key
+    Tree* tree;    //NULL for runs
+    TreeIterator iter;
+    StoreRun* run;
+    size_t block;
+    uint64_t offset;    //Of the next record in the run
+} StoreCursor;
+
+/**
+ * K-way merge of cursors, a binary heap ordered by key and then by source
+ */
+typedef struct storeMerge {
+    StoreCursor** heap;
+    int size;
+} StoreMerge;
+
+static int compareEntries(const void* a, const void* b) {
+    return strcmp(((const StoreEntry*)a)->key, ((const StoreEntry*)b)->key);
+}
+
+static void deleteEntry(void* data) {
+    StoreEntry* entry = data;
+    free(entry->value);
+    free(entry);
+}
+
+/**
+ * Creates a memtable entry, the key is copied behind the entry and the value into its own block
+ * @return the entry, NULL on allocation failure
+ */
+static StoreEntry* createEntry(const char* key, const void* value, size_t length, bool deleted) {
+    size_t keyLength = strlen(key) + 1;
+    StoreEntry* entry = malloc(sizeof(StoreEntry) + keyLength);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    entry->value = NULL;
+    if (!deleted && length > 0) {
+        entry->value = malloc(length);
+        if (entry->value == NULL) {
+            free(entry);
+            return NULL;
+        }
+        memcpy(entry->value, value, length);
+    }
+
+    memcpy(entry + 1, key, keyLength);
+    entry->key = (const char*)(entry + 1);
+    entry->length = deleted ? 0 : length;
+    entry->deleted = deleted;
+
+    return entry;
+}
+
+static size_t entryBytes(const StoreEntry* entry) {
+    return sizeof(StoreEntry) + sizeof(TreeNode) + strlen(entry->key) + 1 + entry->length;
+}
+
+static Tree* createMemtable(void) {
+    return createBinTreeWithMode(compareEntries, deleteEntry, NULL, TREE_AVL);
+}
+
+/**
+ * 64 bit FNV-1a of a key, split in two for the double hashing of the Bloom filters
+ */
+static uint64_t hashKey(const char* key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char* c = (const unsigned char*)key; *c != '\0'; c++) {
+        hash ^= *c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t bloomBit(uint64_t hash, uint32_t i, uint64_t bits) {
+    uint64_t step = ((hash >> 32) | (hash << 32)) | 1;
+    return (hash + i * step) % bits;
+}
+
+static bool mayContain(StoreRun* run, uint64_t hash) {
+    for (uint32_t i = 0; i < run->bloomHashes; i++) {
+        uint64_t bit = bloomBit(hash, i, run->bloomBits);
+        if ((run->bloom[bit / 8] & (1u << (bit % 8))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Decodes the record at p
+ * @return bytes the record takes
+ */
+static size_t readRecord(const unsigned char* p, StoreRecord* record) {
+    uint32_t keyLength;
+    uint32_t valueLength;
+    memcpy(&keyLength, p, sizeof(keyLength));
+    memcpy(&valueLength, p + sizeof(keyLength), sizeof(valueLength));
+
+    record->key = (const char*)p + 2 * sizeof(uint32_t);
+    record->deleted = (valueLength & STORE_DELETED_FLAG) != 0;
+    record->length = valueLength & ~STORE_DELETED_FLAG;
+    record->value = p + 2 * sizeof(uint32_t) + keyLength;
+
+    return 2 * sizeof(uint32_t) + keyLength + record->length;
+}
+
+static char* runPath(const char* directory, uint64_t id, const char* suffix) {
+    size_t length = strlen(directory) + 48;
+    char* path = malloc(length);
+    if (path != NULL) {
+        snprintf(path, length, "%s/%llu.run%s", directory, (unsigned long long)id, suffix);
+    }
+    return path;
+}
+
+/**
+ * Flushes a file to disk and makes its directory entry durable
+ * @return false on failure
+ */
+static bool syncDirectory(const char* directory) {
+    int fd = open(directory, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+/**
+ * Starts writing run id of the store, expecting at most expected records
+ * @return false if the file could not be created
+ */
+static bool beginRun(RunWriter* writer, const char* directory, uint64_t id, uint64_t expected) {
+    memset(writer, 0, sizeof(RunWriter));
+    writer->path = runPath(directory, id, "");
+    writer->tmpPath = runPath(directory, id, ".tmp");
+    writer->bloomBits = (expected > 0 ? expected : 1) * STORE_BLOOM_BITS_PER_KEY;
+    writer->bloomBits = (writer->bloomBits + 7) / 8 * 8;
+    writer->bloom = calloc(writer->bloomBits / 8, 1);
+    writer->blockCapacity = STORE_BLOCK_BYTES;
+    writer->block = malloc(writer->blockCapacity);
+    if (writer->path == NULL || writer->tmpPath == NULL || writer->bloom == NULL || writer->block == NULL) {
+        writer->failed = true;
+        return false;
+    }
+
+    writer->file = fopen(writer->tmpPath, "wb");
+    if (writer->file == NULL) {
+        writer->failed = true;
+        return false;
+    }
+    setvbuf(writer->file, NULL, _IOFBF, 1 << 20);
+
+    return true;
+}
+
+static void writeBytes(RunWriter* writer, const void* bytes, size_t length) {
+    if (!writer->failed && fwrite(bytes, 1, length, writer->file) != length) {
+        writer->failed = true;
+    }
+    writer->offset += length;
+}
+
+static void writeBlock(RunWriter* writer) {
+    if (writer->blockUsed == 0) {
+        return;
+    }
+
+    writer->offsets[writer->numBlocks - 1] = writer->offset;
+    writer->lengths[writer->numBlocks - 1] = (uint32_t)writer->blockUsed;
+    writeBytes(writer, writer->block, writer->blockUsed);
+    writer->blockUsed = 0;
+}
+
+/**
+ * Appends a record, keys must come in strictly increasing order
+ */
+static void addToRun(RunWriter* writer, const StoreRecord* record) {
+    if (writer->failed) {
+        return;
+    }
+
+    uint32_t keyLength = (uint32_t)strlen(record->key) + 1;
+    uint32_t valueLength = (uint32_t)record->length | (record->deleted ? STORE_DELETED_FLAG : 0);
+    size_t recordLength = 2 * sizeof(uint32_t) + keyLength + record->length;
+
+    if (writer->blockUsed > 0 && writer->blockUsed + recordLength > STORE_BLOCK_BYTES) {
+        writeBlock(writer);
+    }
+
+    //A new block starts with this record, its key goes into the index
+    if (writer->blockUsed == 0) {
+        if (writer->numBlocks == writer->maxBlocks) {
+            size_t maxBlocks = writer->maxBlocks == 0 ? 64 : writer->maxBlocks * 2;
+            char** firstKeys = realloc(writer->firstKeys, sizeof(char*) * maxBlocks);
+            if (firstKeys != NULL) {
+                writer->firstKeys = firstKeys;
+            }
+            uint64_t* offsets = realloc(writer->offsets, sizeof(uint64_t) * maxBlocks);
+            if (offsets != NULL) {
+                writer->offsets = offsets;
+            }
+            uint32_t* lengths = realloc(writer->lengths, sizeof(uint32_t) * maxBlocks);
+            if (lengths != NULL) {
+                writer->lengths = lengths;
+            }
+            if (firstKeys == NULL || offsets == NULL || lengths == NULL) {
+                writer->failed = true;
+                return;
+            }
+            writer->maxBlocks = maxBlocks;
+        }
+        writer->firstKeys[writer->numBlocks] = strdup(record->key);
+        if (writer->firstKeys[writer->numBlocks] == NULL) {
+            writer->failed = true;
+            return;
+        }
+        writer->numBlocks++;
+    }
+
+    //Records larger than a block get a block of their own
+    if (writer->blockUsed + recordLength > writer->blockCapacity) {
+        unsigned char* block = realloc(writer->block, writer->blockUsed + recordLength);
+        if (block == NULL) {
+            writer->failed = true;
+            return;
+        }
+        writer->block = block;
+        writer->blockCapacity = writer->blockUsed + recordLength;
+    }
+
+    unsigned char* p = writer->block + writer->blockUsed;
+    memcpy(p, &keyLength, sizeof(keyLength));
+    memcpy(p + sizeof(keyLength), &valueLength, sizeof(valueLength));
+    memcpy(p + 2 * sizeof(uint32_t), record->key, keyLength);
+    if (record->length > 0) {
+        memcpy(p + 2 * sizeof(uint32_t) + keyLength, record->value, record->length);
+    }
+    writer->blockUsed += recordLength;
+
+    uint64_t hash = hashKey(record->key);
+    for (uint32_t i = 0; i < STORE_BLOOM_HASHES; i++) {
+        uint64_t bit = bloomBit(hash, i, writer->bloomBits);
+        writer->bloom[bit / 8] |= (unsigned char)(1u << (bit % 8));
+    }
+    writer->count++;
+}
+
+static void freeWriter(RunWriter* writer) {
+    for (size_t i = 0; i < writer->numBlocks; i++) {
+        free(writer->firstKeys[i]);
+    }
+    free(writer->firstKeys);
+    free(writer->offsets);
+    free(writer->lengths);
+    free(writer->bloom);
+    free(writer->block);
+    free(writer->path);
+    free(writer->tmpPath);
+}
+
+/**
+ * Writes the index, Bloom filter and footer, syncs the file and gives it its final name
+ * @param size_t* written set to the bytes of the run
+ * @return false on failure, the partial file is then deleted
+ */
+static bool finishRun(RunWriter* writer, size_t* written) {
+    writeBlock(writer);
+
+    RunFooter footer;
+    memset(&footer, 0, sizeof(footer));
+    footer.magic = STORE_MAGIC;
+    footer.version = STORE_VERSION;
+    footer.bloomHashes = STORE_BLOOM_HASHES;
+    footer.indexOffset = writer->offset;
+    footer.numBlocks = writer->numBlocks;
+    for (size_t i = 0; i < writer->numBlocks; i++) {
+        uint32_t keyLength = (uint32_t)strlen(writer->firstKeys[i]) + 1;
+        writeBytes(writer, &keyLength, sizeof(keyLength));
+        writeBytes(writer, writer->firstKeys[i], keyLength);
+        writeBytes(writer, &writer->offsets[i], sizeof(uint64_t));
+        writeBytes(writer, &writer->lengths[i], sizeof(uint32_t));
+    }
+    footer.bloomOffset = writer->offset;
+    footer.bloomBits = writer->bloomBits;
+    footer.count = writer->count;
+    writeBytes(writer, writer->bloom, writer->bloomBits / 8);
+    writeBytes(writer, &footer, sizeof(footer));
+    *written = writer->offset;
+
+    if (writer->file != NULL) {
+        if (fflush(writer->file) != 0 || fsync(fileno(writer->file)) != 0) {
+            writer->failed = true;
+        }
+        if (fclose(writer->file) != 0) {
+            writer->failed = true;
+        }
+        writer->file = NULL;
+    }
+    if (!writer->failed && rename(writer->tmpPath, writer->path) != 0) {
+        writer->failed = true;
+    }
+    if (writer->failed && writer->tmpPath != NULL) {
+        unlink(writer->tmpPath);
+    }
+
+    return !writer->failed;
+}
+
+/**
+ * Abandons a run without writing it
+ */
+static void abortRun(RunWriter* writer) {
+    if (writer->file != NULL) {
+        fclose(writer->file);
+        unlink(writer->tmpPath);
+    }
+    freeWriter(writer);
+}
+
+static void releaseRun(StoreRun* run) {
+    if (run == NULL || atomic_fetch_sub(&run->refs, 1) != 1) {
+        return;
+    }
+
+    munmap(run->mapping, run->mappedBytes);
+    if (atomic_load(&run->obsolete)) {
+        unlink(run->path);
+    }
+    free(run->blocks);
+    free(run->path);
+    free(run);
+}
+
+/**
+ * Maps a run file and reads its index
+ * @return the run with one reference, NULL if the file cannot be read or is damaged
+ */
+static StoreRun* openRun(const char* directory, uint64_t id) {
+    StoreRun* run = calloc(1, sizeof(StoreRun));
+    if (run == NULL) {
+        return NULL;
+    }
+    run->id = id;
+    run->path = runPath(directory, id, "");
+    atomic_init(&run->refs, 1);
+    atomic_init(&run->obsolete, false);
+
+    int fd = run->path == NULL ? -1 : open(run->path, O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(RunFooter)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        free(run->path);
+        free(run);
+        return NULL;
+    }
+
+    run->mappedBytes = status.st_size;
+    run->mapping = mmap(NULL, run->mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (run->mapping == MAP_FAILED) {
+        free(run->path);
+        free(run);
+        return NULL;
+    }
+
+    RunFooter footer;
+    size_t end = run->mappedBytes - sizeof(RunFooter);
+    memcpy(&footer, run->mapping + end, sizeof(footer));
+    bool valid = footer.magic == STORE_MAGIC && footer.version == STORE_VERSION && footer.bloomBits > 0
+                 && footer.indexOffset <= footer.bloomOffset && footer.bloomOffset <= end
+                 && footer.bloomBits / 8 <= end - footer.bloomOffset;
+
+    run->numBlocks = valid ? footer.numBlocks : 0;
+    run->blocks = valid && footer.numBlocks > 0 ? malloc(sizeof(StoreBlockIndex) * footer.numBlocks) : NULL;
+    if (valid && footer.numBlocks > 0 && run->blocks == NULL) {
+        valid = false;
+    }
+
+    //Every index entry and the block it points to must lie inside the file
+    uint64_t p = footer.indexOffset;
+    for (size_t i = 0; valid && i < run->numBlocks; i++) {
+        uint32_t keyLength;
+        if (footer.bloomOffset - p < sizeof(uint32_t)) {
+            valid = false;
+            break;
+        }
+        memcpy(&keyLength, run->mapping + p, sizeof(keyLength));
+        p += sizeof(keyLength);
+        if (keyLength == 0 || footer.bloomOffset - p < keyLength + sizeof(uint64_t) + sizeof(uint32_t)
+            || run->mapping[p + keyLength - 1] != '\0') {
+            valid = false;
+            break;
+        }
+        run->blocks[i].firstKey = (const char*)run->mapping + p;
+        p += keyLength;
+        memcpy(&run->blocks[i].offset, run->mapping + p, sizeof(uint64_t));
+        p += sizeof(uint64_t);
+        memcpy(&run->blocks[i].length, run->mapping + p, sizeof(uint32_t));
+        p += sizeof(uint32_t);
+        if (run->blocks[i].offset > footer.indexOffset || run->blocks[i].length > footer.indexOffset - run->blocks[i].offset) {
+            valid = false;
+        }
+    }
+
+    if (!valid) {
+        munmap(run->mapping, run->mappedBytes);
+        free(run->blocks);
+        free(run->path);
+        free(run);
+        return NULL;
+    }
+
+    run->bloom = run->mapping + footer.bloomOffset;
+    run->bloomBits = footer.bloomBits;
+    run->bloomHashes = footer.bloomHashes;
+    run->count = footer.count;
+
+    return run;
+}
+
+/**
+ * Finds the block of a run that would hold key
+ * @return index of the last block whose first key is not greater than key, numBlocks if key is before every block
+ */
+static size_t findBlock(StoreRun* run, const char* key) {
+    size_t lo = 0;
+    size_t hi = run->numBlocks;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (strcmp(run->blocks[mid].firstKey, key) <= 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo == 0 ? run->numBlocks : lo - 1;
+}
+
+/**
+ * Searches one run for key
+ * @return true if the run has a record of key, deleted or not
+ */
+static bool findInRun(StoreRun* run, const char* key, StoreRecord* record) {
+    size_t block = findBlock(run, key);
+    if (block == run->numBlocks) {
+        return false;
+    }
+
+    const unsigned char* p = run->mapping + run->blocks[block].offset;
+    const unsigned char* end = p + run->blocks[block].length;
+    while (p < end) {
+        p += readRecord(p, record);
+        int comparison = strcmp(record->key, key);
+        if (comparison == 0) {
+            return true;
+        }
+        if (comparison > 0) {
+            break;
+        }
+    }
+
+    return false;
+}
+
+static void advanceCursor(StoreCursor* cursor) {
+    if (cursor->tree != NULL) {
+        StoreEntry* entry = nextTreeElement(&cursor->iter);
+        cursor->valid = entry != NULL;
+        if (cursor->valid) {
+            cursor->record.key = entry->key;
+            cursor->record.value = entry->value;
+            cursor->record.length = entry->length;
+            cursor->record.deleted = entry->deleted;
+        }
+        return;
+    }
+
+    StoreRun* run = cursor->run;
+    while (cursor->block < run->numBlocks && cursor->offset >= run->blocks[cursor->block].offset + run->blocks[cursor->block].length) {
+        cursor->block++;
+        if (cursor->block < run->numBlocks) {
+            cursor->offset = run->blocks[cursor->block].offset;
+        }
+    }
+    cursor->valid = cursor->block < run->numBlocks;
+    if (cursor->valid) {
+        cursor->offset += readRecord(run->mapping + cursor->offset, &cursor->record);
+    }
+}
+
+/**
+ * Positions a cursor on the first record of a memtable or run not less than lo
+ * @param const char* lo NULL for the first record
+ */
+static void seekCursor(StoreCursor* cursor, const char* lo) {
+    if (cursor->tree != NULL) {
+        if (lo == NULL) {
+            cursor->iter = createTreeIterator(cursor->tree);
+        }
+        else {
+            StoreEntry probe = {lo, NULL, 0, false};
+            cursor->iter = treeLowerBound(cursor->tree, &probe);
+        }
+        advanceCursor(cursor);
+        return;
+    }
+
+    StoreRun* run = cursor->run;
+    cursor->block = lo == NULL ? 0 : findBlock(run, lo);
+    if (cursor->block == run->numBlocks) {
+        cursor->block = 0;
+    }
+    cursor->offset = run->numBlocks > 0 ? run->blocks[cursor->block].offset : 0;
+    advanceCursor(cursor);
+    while (lo != NULL && cursor->valid && strcmp(cursor->record.key, lo) < 0) {
+        advanceCursor(cursor);
+    }
+}
+
+static bool cursorBefore(const StoreCursor* a, const StoreCursor* b) {
+    int comparison = strcmp(a->record.key, b->record.key);
+    return comparison < 0 || (comparison == 0 && a->source < b->source);
+}
+
+static void siftDownCursor(StoreMerge* merge, int i) {
+    StoreCursor* cursor = merge->heap[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= merge->size) {
+            break;
+        }
+        if (child + 1 < merge->size && cursorBefore(merge->heap[child + 1], merge->heap[child])) {
+            child++;
+        }
+        if (!cursorBefore(merge->heap[child], cursor)) {
+            break;
+        }
+        merge->heap[i] = merge->heap[child];
+        i = child;
+    }
+    merge->heap[i] = cursor;
+}
+
+/**
+ * Builds the heap from positioned cursors, dropping those already at their end
+ */
+static void startMerge(StoreMerge* merge, StoreCursor* cursors, StoreCursor** heap, int numCursors) {
+    merge->heap = heap;
+    merge->size = 0;
+    for (int i = 0; i < numCursors; i++) {
+        if (cursors[i].valid) {
+            heap[merge->size++] = &cursors[i];
+        }
+    }
+    for (int i = merge->size / 2 - 1; i >= 0; i--) {
+        siftDownCursor(merge, i);
+    }
+}
+
+/**
+ * Takes the smallest key of the merge with its newest record and moves every source past that key
+ * @return false once every source is exhausted
+ */
+static bool nextMerged(StoreMerge* merge, StoreRecord* record) {
+    if (merge->size == 0) {
+        return false;
+    }
+
+    *record = merge->heap[0]->record;
+    while (merge->size > 0 && strcmp(merge->heap[0]->record.key, record->key) == 0) {
+        advanceCursor(merge->heap[0]);
+        if (!merge->heap[0]->valid) {
+            merge->heap[0] = merge->heap[--merge->size];
+        }
+        if (merge->size > 0) {
+            siftDownCursor(merge, 0);
+        }
+    }
+
+    return true;
+}
+
+static int flushEntry(void* data, void* context) {
+    StoreEntry* entry = data;
+    StoreRecord record = {entry->key, entry->value, entry->length, entry->deleted};
+    addToRun(context, &record);
+    return 0;
+}
+
+/**
+ * Writes a frozen memtable out as run id with an in-order traversal
+ * @return the run, NULL on failure
+ */
+static StoreRun* writeMemtable(Store* store, Tree* memtable, uint64_t id, size_t* written) {
+    RunWriter writer;
+    if (!beginRun(&writer, store->directory, id, memtable->count)) {
+        abortRun(&writer);
+        return NULL;
+    }
+
+    visitInOrder(memtable, flushEntry, &writer);
+    bool finished = finishRun(&writer, written);
+    freeWriter(&writer);
+
+    return finished ? openRun(store->directory, id) : NULL;
+}
+
+/**
+ * Merges runs, newest first, into run id
+ * @param bool dropDeleted true when the oldest run is merged, so deleted keys have nothing left to hide
+ * @param bool* failed set on failure
+ * @return the run, NULL on failure or if nothing was left
+ */
+static StoreRun* mergeRuns(Store* store, StoreRun** inputs, int numInputs, bool dropDeleted, uint64_t id, size_t* written, bool* failed) {
+    StoreCursor* cursors = calloc(numInputs, sizeof(StoreCursor));
+    StoreCursor** heap = malloc(sizeof(StoreCursor*) * numInputs);
+    uint64_t expected = 0;
+    RunWriter writer;
+
+    *failed = true;
+    if (cursors == NULL || heap == NULL) {
+        free(cursors);
+        free(heap);
+        return NULL;
+    }
+
+    for (int i = 0; i < numInputs; i++) {
+        cursors[i].source = i;
+        cursors[i].run = inputs[i];
+        seekCursor(&cursors[i], NULL);
+        expected += inputs[i]->count;
+    }
+
+    StoreRun* run = NULL;
+    if (beginRun(&writer, store->directory, id, expected)) {
+        StoreMerge merge;
+        StoreRecord record;
+        startMerge(&merge, cursors, heap, numInputs);
+        while (nextMerged(&merge, &record)) {
+            if (!(dropDeleted && record.deleted)) {
+                addToRun(&writer, &record);
+            }
+        }
+
+        if (writer.count == 0) {
+            abortRun(&writer);
+            *failed = false;
+        }
+        else {
+            bool finished = finishRun(&writer, written);
+            freeWriter(&writer);
+            run = finished ? openRun(store->directory, id) : NULL;
+            *failed = run == NULL;
+        }
+    }
+    else {
+        abortRun(&writer);
+    }
+
+    free(cursors);
+    free(heap);
+    return run;
+}
+
+/**
+ * Replaces the manifest with the ids of runs, newest first
+ * @return false on failure, the old manifest is then unchanged
+ */
+static bool writeManifest(Store* store, StoreRun** runs, int numRuns) {
+    size_t length = strlen(store->directory) + 32;
+    char* path = malloc(length);
+    char* tmpPath = malloc(length);
+    if (path == NULL || tmpPath == NULL) {
+        free(path);
+        free(tmpPath);
+        return false;
+    }
+    snprintf(path, length, "%s/MANIFEST", store->directory);
+    snprintf(tmpPath, length, "%s/MANIFEST.tmp", store->directory);
+
+    bool written = false;
+    FILE* file = fopen(tmpPath, "w");
+    if (file != NULL) {
+        written = true;
+        for (int i = 0; i < numRuns; i++) {
+            if (fprintf(file, "%llu\n", (unsigned long long)runs[i]->id) < 0) {
+                written = false;
+            }
+        }
+        written = fflush(file) == 0 && fsync(fileno(file)) == 0 && written;
+        written = fclose(file) == 0 && written;
+        written = written && rename(tmpPath, path) == 0 && syncDirectory(store->directory);
+        if (!written) {
+            unlink(tmpPath);
+        }
+    }
+
+    free(path);
+    free(tmpPath);
+    return written;
+}
+
+/**
+ * Picks the newest runs to merge: the two newest, then each older one while
+ * it is at most STORE_SIZE_RATIO times the size merged so far
+ * @return number of runs from the front of the list
+ */
+static int chooseCompaction(Store* store) {
+    size_t merged = store->runs[0]->mappedBytes + store->runs[1]->mappedBytes;
+    int n = 2;
+
+    while (n < store->numRuns && store->runs[n]->mappedBytes <= STORE_SIZE_RATIO * merged) {
+        merged += store->runs[n]->mappedBytes;
+        n++;
+    }
+
+    return n;
+}
+
+/**
+ * Writes out the frozen memtable, called by the worker with the lock held
+ */
+static void flushImmutable(Store* store) {
+    Tree* frozen = store->immutable;
+    uint64_t id = store->nextId++;
+    size_t written = 0;
+
+    pthread_mutex_unlock(&store->lock);
+    StoreRun* run = frozen->count > 0 ? writeMemtable(store, frozen, id, &written) : NULL;
+    pthread_mutex_lock(&store->lock);
+
+    if (frozen->count > 0 && run == NULL) {
+        store->error = errno != 0 ? errno : EIO;
+        return;
+    }
+
+    if (run != NULL) {
+        StoreRun** runs = malloc(sizeof(StoreRun*) * (store->numRuns + 1));
+        if (runs != NULL) {
+            runs[0] = run;
+            if (store->numRuns > 0) {
+                memcpy(runs + 1, store->runs, sizeof(StoreRun*) * store->numRuns);
+            }
+        }
+        if (runs == NULL || !writeManifest(store, runs, store->numRuns + 1)) {
+            store->error = errno != 0 ? errno : EIO;
+            atomic_store(&run->obsolete, true);
+            releaseRun(run);
+            free(runs);
+            return;
+        }
+        free(store->runs);
+        store->runs = runs;
+        store->numRuns++;
+        store->bytesWritten += written;
+    }
+
+    //Readers only look at the frozen memtable with the lock held
+    destroyBinTree(frozen);
+    store->immutable = NULL;
+    store->flushes++;
+}
+
+/**
+ * Merges the newest runs in the background, called by the worker with the lock held
+ */
+static void compactRuns(Store* store) {
+    int numInputs = chooseCompaction(store);
+    bool dropDeleted = numInputs == store->numRuns;
+    uint64_t id = store->nextId++;
+    StoreRun** inputs = malloc(sizeof(StoreRun*) * numInputs);
+    if (inputs == NULL) {
+        store->error = ENOMEM;
+        return;
+    }
+    for (int i = 0; i < numInputs; i++) {
+        inputs[i] = store->runs[i];
+        atomic_fetch_add(&inputs[i]->refs, 1);
+    }
+
+    size_t written = 0;
+    bool failed;
+    pthread_mutex_unlock(&store->lock);
+    StoreRun* output = mergeRuns(store, inputs, numInputs, dropDeleted, id, &written, &failed);
+    pthread_mutex_lock(&store->lock);
+
+    //Runs flushed meanwhile went in front, the inputs are still next to each other
+    int start = 0;
+    while (!failed && store->runs[start] != inputs[0]) {
+        start++;
+    }
+
+    int numRuns = store->numRuns - numInputs + (output != NULL);
+    StoreRun** runs = failed ? NULL : malloc(sizeof(StoreRun*) * (numRuns > 0 ? numRuns : 1));
+    if (runs != NULL) {
+        memcpy(runs, store->runs, sizeof(StoreRun*) * start);
+        if (output != NULL) {
+            runs[start] = output;
+        }
+        memcpy(runs + start + (output != NULL), store->runs + start + numInputs, sizeof(StoreRun*) * (store->numRuns - start - numInputs));
+    }
+
+    if (runs == NULL || !writeManifest(store, runs, numRuns)) {
+        store->error = errno != 0 ? errno : EIO;
+        if (output != NULL) {
+            atomic_store(&output->obsolete, true);
+            releaseRun(output);
+        }
+        free(runs);
+    }
+    else {
+        //The store's references go, the files follow once no reader holds them
+        for (int i = 0; i < numInputs; i++) {
+            atomic_store(&inputs[i]->obsolete, true);
+            releaseRun(inputs[i]);
+        }
+        free(store->runs);
+        store->runs = runs;
+        store->numRuns = numRuns;
+        store->bytesWritten += written;
+        store->compactions++;
+    }
+
+    for (int i = 0; i < numInputs; i++) {
+        releaseRun(inputs[i]);
+    }
+    free(inputs);
+}
+
+/**
+ * Background thread: writes out frozen memtables first, then compacts
+ */
+static void* storeWorker(void* argument) {
+    Store* store = argument;
+
+    pthread_mutex_lock(&store->lock);
+    for (;;) {
+        if (store->immutable != NULL && store->error == 0) {
+            store->busy = true;
+            flushImmutable(store);
+            pthread_cond_broadcast(&store->changed);
+        }
+        else if (store->closing) {
+            break;
+        }
+        else if (store->numRuns >= STORE_COMPACT_RUNS && store->error == 0) {
+            store->busy = true;
+            compactRuns(store);
+            pthread_cond_broadcast(&store->changed);
+        }
+        else {
+            store->busy = false;
+            pthread_cond_broadcast(&store->changed);
+            pthread_cond_wait(&store->changed, &store->lock);
+        }
+    }
+    store->busy = false;
+    pthread_mutex_unlock(&store->lock);
+
+    return NULL;
+}
+
+/**
+ * Reads the manifest and opens every run it lists, newest first
+ * @return false if a listed run cannot be opened
+ */
+static bool readManifest(Store* store) {
+    size_t length = strlen(store->directory) + 32;
+    char* path = malloc(length);
+    if (path == NULL) {
+        return false;
+    }
+    snprintf(path, length, "%s/MANIFEST", store->directory);
+    FILE* file = fopen(path, "r");
+    free(path);
+    if (file == NULL) {
+        return errno == ENOENT;
+    }
+
+    bool opened = true;
+    unsigned long long id;
+    int maxRuns = 0;
+    while (opened && fscanf(file, "%llu", &id) == 1) {
+        if (store->numRuns == maxRuns) {
+            maxRuns = maxRuns == 0 ? 8 : maxRuns * 2;
+            StoreRun** runs = realloc(store->runs, sizeof(StoreRun*) * maxRuns);
+            if (runs == NULL) {
+                opened = false;
+                break;
+            }
+            store->runs = runs;
+        }
+        StoreRun* run = openRun(store->directory, id);
+        if (run == NULL) {
+            opened = false;
+            break;
+        }
+        store->runs[store->numRuns++] = run;
+        if (id >= store->nextId) {
+            store->nextId = id + 1;
+        }
+    }
+
+    fclose(file);
+    return opened;
+}
+
+/**
+ * Deletes run files the manifest does not list, left by an interrupted flush or compaction
+ */
+static void removeStrayRuns(Store* store) {
+    DIR* directory = opendir(store->directory);
+    if (directory == NULL) {
+        return;
+    }
+
+    struct dirent* file;
+    while ((file = readdir(directory)) != NULL) {
+        unsigned long long id;
+        int consumed = 0;
+        if (sscanf(file->d_name, "%llu.run%n", &id, &consumed) != 1 || consumed == 0) {
+            continue;
+        }
+
+        bool listed = false;
+        for (int i = 0; i < store->numRuns && !listed; i++) {
+            listed = store->runs[i]->id == id && file->d_name[consumed] == '\0';
+        }
+        if (!listed) {
+            size_t length = strlen(store->directory) + strlen(file->d_name) + 2;
+            char* path = malloc(length);
+            if (path != NULL) {
+                snprintf(path, length, "%s/%s", store->directory, file->d_name);
+                unlink(path);
+                free(path);
+            }
+        }
+        if (id >= store->nextId) {
+            store->nextId = id + 1;
+        }
+    }
+
+    closedir(directory);
+}
+
+Store* openStore(const char* directory, size_t memtableLimit) {
+    if (directory == NULL || (mkdir(directory, 0755) != 0 && errno != EEXIST)) {
+        return NULL;
+    }
+
+    Store* store = calloc(1, sizeof(Store));
+    if (store == NULL) {
+        return NULL;
+    }
+    store->directory = strdup(directory);
+    store->memtableLimit = memtableLimit == 0 ? STORE_DEFAULT_MEMTABLE_BYTES : memtableLimit;
+    store->memtable = createMemtable();
+    store->nextId = 1;
+    atomic_init(&store->gets, 0);
+    atomic_init(&store->runsProbed, 0);
+    atomic_init(&store->bloomSkips, 0);
+
+    if (store->directory == NULL || store->memtable == NULL || !readManifest(store)) {
+        for (int i = 0; i < store->numRuns; i++) {
+            releaseRun(store->runs[i]);
+        }
+        free(store->runs);
+        destroyBinTree(store->memtable);
+        free(store->directory);
+        free(store);
+        return NULL;
+    }
+    removeStrayRuns(store);
+
+    pthread_mutex_init(&store->lock, NULL);
+    pthread_cond_init(&store->changed, NULL);
+    if (pthread_create(&store->worker, NULL, storeWorker, store) != 0) {
+        store->closing = true;
+        for (int i = 0; i < store->numRuns; i++) {
+            releaseRun(store->runs[i]);
+        }
+        free(store->runs);
+        destroyBinTree(store->memtable);
+        pthread_mutex_destroy(&store->lock);
+        pthread_cond_destroy(&store->changed);
+        free(store->directory);
+        free(store);
+        return NULL;
+    }
+
+    return store;
+}
+
+/**
+ * Hands the memtable to the worker, waiting first for the previous one to be written out.
+ * Called with the lock held.
+ * @return false if a background write failed
+ */
+static bool freezeMemtable(Store* store) {
+    while (store->immutable != NULL && store->error == 0) {
+        pthread_cond_wait(&store->changed, &store->lock);
+    }
+    if (store->error != 0) {
+        return false;
+    }
+
+    Tree* memtable = createMemtable();
+    if (memtable == NULL) {
+        return false;
+    }
+    store->immutable = store->memtable;
+    store->memtable = memtable;
+    store->memtableBytes = 0;
+    pthread_cond_broadcast(&store->changed);
+
+    return true;
+}
+
+bool closeStore(Store* store) {
+    if (store == NULL) {
+        return false;
+    }
+
+    pthread_mutex_lock(&store->lock);
+    if (store->memtable->count > 0) {
+        freezeMemtable(store);
+    }
+    while (store->immutable != NULL && store->error == 0) {
+        pthread_cond_wait(&store->changed, &store->lock);
+    }
+    store->closing = true;
+    pthread_cond_broadcast(&store->changed);
+    pthread_mutex_unlock(&store->lock);
+    pthread_join(store->worker, NULL);
+
+    bool closed = store->error == 0;
+    for (int i = 0; i < store->numRuns; i++) {
+        releaseRun(store->runs[i]);
+    }
+    free(store->runs);
+    destroyBinTree(store->memtable);
+    destroyBinTree(store->immutable);
+    pthread_mutex_destroy(&store->lock);
+    pthread_cond_destroy(&store->changed);
+    free(store->directory);
+    free(store);
+
+    return closed;
+}
+
+/**
+ * Adds an entry to the memtable, replacing the entry of the same key
+ */
+static bool addEntry(Store* store, const char* key, const void* value, size_t length, bool deleted) {
+    if (store == NULL || key == NULL || length >= STORE_DELETED_FLAG || (value == NULL && length > 0)) {
+        return false;
+    }
+
+    StoreEntry* entry = createEntry(key, value, length, deleted);
+    if (entry == NULL) {
+        return false;
+    }
+
+    pthread_mutex_lock(&store->lock);
+    if (store->memtableBytes >= store->memtableLimit && !freezeMemtable(store)) {
+        pthread_mutex_unlock(&store->lock);
+        deleteEntry(entry);
+        return false;
+    }
+
+    StoreEntry* old = findInTree(store->memtable, entry);
+    if (old != NULL) {
+        //Swap the value into the entry already in the tree
+        store->memtableBytes -= entryBytes(old);
+        void* oldValue = old->value;
+        old->value = entry->value;
+        old->length = entry->length;
+        old->deleted = entry->deleted;
+        entry->value = oldValue;
+        deleteEntry(entry);
+        store->memtableBytes += entryBytes(old);
+    }
+    else {
+        addToTree(store->memtable, entry);
+        store->memtableBytes += entryBytes(entry);
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    return true;
+}
+
+bool putInStore(Store* store, const char* key, const void* value, size_t length) {
+    return addEntry(store, key, value, length, false);
+}
+
+bool removeFromStore(Store* store, const char* key) {
+    return addEntry(store, key, NULL, 0, true);
+}
+
+/**
+ * Copies the value of a record for the caller
+ * @return the copy, NULL if the record is deleted or memory ran out
+ */
+static void* copyValue(const StoreRecord* record, size_t* length) {
+    if (record->deleted) {
+        return NULL;
+    }
+
+    //Empty values still get a block so they differ from missing keys
+    void* copy = malloc(record->length > 0 ? record->length : 1);
+    if (copy != NULL) {
+        if (record->length > 0) {
+            memcpy(copy, record->value, record->length);
+        }
+        if (length != NULL) {
+            *length = record->length;
+        }
+    }
+    return copy;
+}
+
+void* getFromStore(Store* store, const char* key, size_t* length) {
+    if (store == NULL || key == NULL) {
+        return NULL;
+    }
+    atomic_fetch_add_explicit(&store->gets, 1, memory_order_relaxed);
+
+    StoreEntry probe = {key, NULL, 0, false};
+    StoreRecord record;
+    void* value = NULL;
+
+    pthread_mutex_lock(&store->lock);
+    StoreEntry* entry = findInTree(store->memtable, &probe);
+    if (entry == NULL && store->immutable != NULL) {
+        entry = findInTree(store->immutable, &probe);
+    }
+    if (entry != NULL) {
+        record.value = entry->value;
+        record.length = entry->length;
+        record.deleted = entry->deleted;
+        value = copyValue(&record, length);
+        pthread_mutex_unlock(&store->lock);
+        return value;
+    }
+
+    //Search the runs without the lock, holding a reference so compaction cannot unmap them
+    int numRuns = store->numRuns;
+    StoreRun* stackRuns[16];
+    StoreRun** runs = numRuns <= 16 ? stackRuns : malloc(sizeof(StoreRun*) * numRuns);
+    if (runs == NULL) {
+        pthread_mutex_unlock(&store->lock);
+        return NULL;
+    }
+    for (int i = 0; i < numRuns; i++) {
+        runs[i] = store->runs[i];
+        atomic_fetch_add(&runs[i]->refs, 1);
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    uint64_t hash = hashKey(key);
+    size_t probed = 0;
+    size_t skipped = 0;
+    int i = 0;
+    for (; i < numRuns; i++) {
+        if (!mayContain(runs[i], hash)) {
+            skipped++;
+            continue;
+        }
+        probed++;
+        if (findInRun(runs[i], key, &record)) {
+            value = copyValue(&record, length);
+            break;
+        }
+    }
+    atomic_fetch_add_explicit(&store->runsProbed, probed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&store->bloomSkips, skipped, memory_order_relaxed);
+
+    for (i = 0; i < numRuns; i++) {
+        releaseRun(runs[i]);
+    }
+    if (runs != stackRuns) {
+        free(runs);
+    }
+
+    return value;
+}
+
+int visitStoreRange(Store* store, const char* lo, const char* hi, StoreVisitFunc visit, void* context) {
+    if (store == NULL || visit == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&store->lock);
+    int numCursors = store->numRuns + 2;
+    StoreCursor* cursors = calloc(numCursors, sizeof(StoreCursor));
+    StoreCursor** heap = malloc(sizeof(StoreCursor*) * numCursors);
+    if (cursors == NULL || heap == NULL) {
+        pthread_mutex_unlock(&store->lock);
+        free(cursors);
+        free(heap);
+        return 0;
+    }
+
+    //Sources from newest to oldest: the memtable, the frozen one and the runs
+    int used = 0;
+    Tree* trees[2] = {store->memtable, store->immutable};
+    for (int i = 0; i < 2; i++) {
+        if (trees[i] != NULL) {
+            cursors[used].source = used;
+            cursors[used].tree = trees[i];
+            seekCursor(&cursors[used], lo);
+            used++;
+        }
+    }
+    for (int i = 0; i < store->numRuns; i++) {
+        cursors[used].source = used;
+        cursors[used].run = store->runs[i];
+        seekCursor(&cursors[used], lo);
+        used++;
+    }
+
+    StoreMerge merge;
+    StoreRecord record;
+    int result = 0;
+    startMerge(&merge, cursors, heap, used);
+    while (result == 0 && nextMerged(&merge, &record)) {
+        if (hi != NULL && strcmp(record.key, hi) > 0) {
+            break;
+        }
+        if (!record.deleted) {
+            result = visit(record.key, record.value, record.length, context);
+        }
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    free(cursors);
+    free(heap);
+    return result;
+}
+
+bool flushStore(Store* store) {
+    if (store == NULL) {
+        return false;
+    }
+
+    pthread_mutex_lock(&store->lock);
+    bool flushed = store->memtable->count == 0 || freezeMemtable(store);
+    while (flushed && store->immutable != NULL && store->error == 0) {
+        pthread_cond_wait(&store->changed, &store->lock);
+    }
+    flushed = flushed && store->error == 0;
+    pthread_mutex_unlock(&store->lock);
+
+    return flushed;
+}
+
+bool waitForStore(Store* store) {
+    if (store == NULL) {
+        return false;
+    }
+
+    pthread_mutex_lock(&store->lock);
+    while (store->error == 0 && (store->busy || store->immutable != NULL || store->numRuns >= STORE_COMPACT_RUNS)) {
+        pthread_cond_wait(&store->changed, &store->lock);
+    }
+    bool idle = store->error == 0;
+    pthread_mutex_unlock(&store->lock);
+
+    return idle;
+}
+
+StoreStats getStoreStats(Store* store) {
+    StoreStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (store == NULL) {
+        return stats;
+    }
+
+    pthread_mutex_lock(&store->lock);
+    stats.runs = store->numRuns;
+    for (int i = 0; i < store->numRuns; i++) {
+        stats.runBytes += store->runs[i]->mappedBytes;
+    }
+    stats.memtableBytes = store->memtableBytes;
+    stats.flushes = store->flushes;
+    stats.compactions = store->compactions;
+    stats.bytesWritten = store->bytesWritten;
+    pthread_mutex_unlock(&store->lock);
+
+    stats.gets = atomic_load(&store->gets);
+    stats.runsProbed = atomic_load(&store->runsProbed);
+    stats.bloomSkips = atomic_load(&store->bloomSkips);
+
+    return stats;
+}
@@ -0,0 +1,217 @@
+#ifndef STORE_STOREAPI_H
+#define STORE_STOREAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "BinarySearchTreeAPI.h"
+
+/**
+ * Bytes of keys and values the memtable takes before it is frozen and written out
+ */
+#define STORE_DEFAULT_MEMTABLE_BYTES (8 * 1024 * 1024)
+
+/**
+ * Records of a run are grouped into blocks of about this size, each found through the index
+ */
+#define STORE_BLOCK_BYTES 4096
+
+/**
+ * Bloom filter bits per key of a run, about 1% false positives with STORE_BLOOM_HASHES
+ */
+#define STORE_BLOOM_BITS_PER_KEY 10
+#define STORE_BLOOM_HASHES 7
+
+/**
+ * Number of runs that starts a background compaction
+ */
+#define STORE_COMPACT_RUNS 4
+
+/**
+ * A compaction merges the two newest runs and keeps adding the next older
+ * one while it is at most this many times the size merged so far, so small
+ * runs are merged together before they are merged into large ones
+ */
+#define STORE_SIZE_RATIO 2
+
+/**
+ * Marks a run file, followed by the format version
+ */
+#define STORE_MAGIC 0x314e55524d53534cULL
+#define STORE_VERSION 1
+
+/**
+ * Key and value in a memtable. Removing a key stores an entry marked deleted,
+ * which hides older values of the key in the runs until compaction drops it.
+ */
+typedef struct storeEntry {
+    const char* key;    //Copy of the key, allocated with the entry
+    void* value;
+    size_t length;
+    bool deleted;
+} StoreEntry;
+
+/**
+ * Index entry of one block of a run, firstKey points into the mapped file
+ */
+typedef struct storeBlockIndex {
+    const char* firstKey;
+    uint64_t offset;
+    uint32_t length;
+} StoreBlockIndex;
+
+/**
+ * Immutable sorted run on disk, read through mmap. Layout: data blocks of
+ * records (key length with its '\0', value length with the top bit set for
+ * deleted keys, key, value), then the block index, then the Bloom filter,
+ * then a fixed size footer. Numbers are in native byte order.
+ */
+typedef struct storeRun {
+    uint64_t id;    //Runs are named <id>.run in the store directory
+    unsigned char* mapping;
+    size_t mappedBytes;
+    StoreBlockIndex* blocks;
+    size_t numBlocks;
+    const unsigned char* bloom;
+    uint64_t bloomBits;
+    uint32_t bloomHashes;
+    uint64_t count;    //Records, deleted keys included
+    atomic_int refs;    //The store holds one, every reader and compaction one more
+    atomic_bool obsolete;    //Replaced by a compaction, the file is deleted with the last reference
+    char* path;
+} StoreRun;
+
+/**
+ * Counters of a store since it was opened
+ */
+typedef struct storeStats {
+    int runs;
+    size_t runBytes;
+    size_t memtableBytes;
+    size_t flushes;
+    size_t compactions;
+    size_t bytesWritten;    //By flushes and compactions together
+    size_t gets;
+    size_t runsProbed;    //Runs whose Bloom filter let a get through
+    size_t bloomSkips;    //Runs a get skipped on its Bloom filter
+} StoreStats;
+
+/**
+ * Log structured ordered key-value store. Writes go to an AVL tree in memory;
+ * a full tree is frozen and a background thread writes it out as a sorted
+ * run, then merges runs once STORE_COMPACT_RUNS of them pile up. Every
+ * function is thread safe. The memtable is not logged: writes since the
+ * last flush are lost if the process dies without closeStore.
+ */
+typedef struct store {
+    char* directory;
+    size_t memtableLimit;
+    Tree* memtable;    //StoreEntry ordered by key
+    size_t memtableBytes;
+    Tree* immutable;    //Frozen memtable being written out, NULL if none
+    StoreRun** runs;    //Newest first
+    int numRuns;
+    uint64_t nextId;
+    int error;    //errno of the first failed background write, 0 if none
+    bool busy;    //The worker is flushing or compacting
+    bool closing;
+    size_t flushes;
+    size_t compactions;
+    size_t bytesWritten;
+    atomic_size_t gets;    //Read counters are updated by gets outside the lock
+    atomic_size_t runsProbed;
+    atomic_size_t bloomSkips;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;    //Signalled when there is work for the worker or a flush finished
+    pthread_t worker;
+} Store;
+
+/**
+ * Called with each key in order and its value, return 0 to continue, anything else stops the traversal
+ */
+typedef int (*StoreVisitFunc)(const char* key, const void* value, size_t length, void* context);
+
+/**
+ * Opens the store in directory, creating both if needed, and starts its
+ * background thread. Run files the manifest does not list are left over
+ * from an interrupted flush or compaction and are deleted.
+ * @param const char* directory
+ * @param size_t memtableLimit bytes the memtable takes before it is written out, 0 for STORE_DEFAULT_MEMTABLE_BYTES
+ * @return Newly opened store, NULL if the directory or a run could not be read
+ */
+Store* openStore(const char* directory, size_t memtableLimit);
+
+/**
+ * Writes out the memtable, waits for the background thread and frees memory
+ * @param Store store
+ * @return false if some data could not be written
+ */
+bool closeStore(Store* store);
+
+/**
+ * Adds value under key, replacing any older value. Both are copied. Blocks
+ * while the memtable is full and the previous one is still being written out.
+ * @param Store store
+ * @param const char* key
+ * @param const void* value
+ * @param size_t length bytes of value
+ * @return false if memory ran out or a background write failed
+ */
+bool putInStore(Store* store, const char* key, const void* value, size_t length);
+
+/**
+ * Removes key. Older values are hidden at once and dropped by compaction.
+ * @param Store store
+ * @param const char* key
+ * @return false if memory ran out or a background write failed
+ */
+bool removeFromStore(Store* store, const char* key);
+
+/**
+ * Looks up key in the memtables, then in the runs newest first, skipping
+ * runs whose Bloom filter rules the key out
+ * @param Store store
+ * @param const char* key
+ * @param size_t* length set to the length of the value, may be NULL
+ * @return NULL if the key is not stored, otherwise a copy of its value the caller frees
+ */
+void* getFromStore(Store* store, const char* key, size_t* length);
+
+/**
+ * Calls visit on every key k with lo <= k <= hi in strcmp order, merging the
+ * memtables and every run so each key shows its newest value. The store is
+ * locked for writers during the traversal, visit must not call into it.
+ * @param Store store
+ * @param const char* lo smallest key, NULL for no lower bound
+ * @param const char* hi largest key, NULL for no upper bound
+ * @param StoreVisitFunc visit
+ * @param void* context passed to every call of visit
+ * @return 0 if every key was visited, otherwise the value that stopped the traversal
+ */
+int visitStoreRange(Store* store, const char* lo, const char* hi, StoreVisitFunc visit, void* context);
+
+/**
+ * Writes out the memtable and waits until it is on disk
+ * @param Store store
+ * @return false if the write failed
+ */
+bool flushStore(Store* store);
+
+/**
+ * Waits until the background thread has no flush or compaction left to do
+ * @param Store store
+ * @return false if a background write failed
+ */
+bool waitForStore(Store* store);
+
+/**
+ * Reads the counters of a store
+ * @param Store store
+ * @return StoreStats stats, all zero if store is NULL
+ */
+StoreStats getStoreStats(Store* store);
+
+#endif //STORE_STOREAPI_H
@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "TimingWheelAPI.h"
+
+/**
+ * Finds the slot a timer belongs in relative to the current time, -1 if it is due
+ */
+static int findSlot(TimerTick now, TimerTick deadline) {
+    if (deadline <= now) {
+        return -1;
+    }
+
+    //The level is the 6-bit digit holding the highest bit that differs from now
+    int highBit = 63 - __builtin_clzll(deadline ^ now);
+    int level = highBit / WHEEL_BITS;
+    int slot = (int)((deadline >> (level * WHEEL_BITS)) & (WHEEL_SLOTS - 1));
+
+    return level * WHEEL_SLOTS + slot;
+}
+
+static void appendExpired(TimingWheel* wheel, Timer* timer) {
+    timer->slot = -1;
+    timer->next = NULL;
+    wheel->expiredCount++;
+    timer->previous = wheel->expiredTail;
+
+    if (wheel->expiredTail == NULL) {
+        wheel->expiredHead = timer;
+    }
+    else {
+        wheel->expiredTail->next = timer;
+    }
+    wheel->expiredTail = timer;
+}
+
+static void placeTimer(TimingWheel* wheel, Timer* timer) {
+    int slot = findSlot(wheel->now, timer->deadline);
+
+    if (slot < 0) {
+        appendExpired(wheel, timer);
+        return;
+    }
+
+    //Push onto the front of the slot list
+    timer->slot = slot;
+    timer->previous = NULL;
+    timer->next = wheel->slots[slot];
+    if (timer->next != NULL) {
+        timer->next->previous = timer;
+    }
+    wheel->slots[slot] = timer;
+    wheel->occupied[slot / WHEEL_SLOTS] |= 1ULL << (slot % WHEEL_SLOTS);
+}
+
+static void unlinkTimer(TimingWheel* wheel, Timer* timer) {
+    if (timer->slot < 0) {
+        if (timer->previous != NULL) {
+            timer->previous->next = timer->next;
+        }
+        else {
+            wheel->expiredHead = timer->next;
+        }
+
+        if (timer->next != NULL) {
+            timer->next->previous = timer->previous;
+        }
+        else {
+            wheel->expiredTail = timer->previous;
+        }
+        wheel->expiredCount--;
+        return;
+    }
+
+    if (timer->previous != NULL) {
+        timer->previous->next = timer->next;
+    }
+    else {
+        wheel->slots[timer->slot] = timer->next;
+        if (timer->next == NULL) {
+            wheel->occupied[timer->slot / WHEEL_SLOTS] &= ~(1ULL << (timer->slot % WHEEL_SLOTS));
+        }
+    }
+
+    if (timer->next != NULL) {
+        timer->next->previous = timer->previous;
+    }
+}
+
+TimingWheel* createTimingWheel(void (*deleteFunction)(void* toBeDeleted), TimerTick startTime) {
+    TimingWheel* wheel = calloc(1, sizeof(TimingWheel));
+
+    if (wheel == NULL) {
+        return NULL;
+    }
+
+    wheel->now = startTime;
+    wheel->deleteData = deleteFunction;
+
+    return wheel;
+}
+
+void destroyTimingWheel(TimingWheel* wheel) {
+    if (wheel == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++) {
+        Timer* timer = wheel->slots[i];
+        while (timer != NULL) {
+            Timer* next = timer->next;
+            if (wheel->deleteData != NULL) {
+                wheel->deleteData(timer->data);
+            }
+            free(timer);
+            timer = next;
+        }
+    }
+
+    Timer* timer = wheel->expiredHead;
+    while (timer != NULL) {
+        Timer* next = timer->next;
+        if (wheel->deleteData != NULL) {
+            wheel->deleteData(timer->data);
+        }
+        free(timer);
+        timer = next;
+    }
+
+    free(wheel);
+}
+
+Timer* scheduleTimer(TimingWheel* wheel, TimerTick deadline, void* data) {
+    if (wheel == NULL) {
+        return NULL;
+    }
+
+    Timer* timer = malloc(sizeof(Timer));
+    if (timer == NULL) {
+        return NULL;
+    }
+
+    timer->deadline = deadline;
+    timer->data = data;
+    placeTimer(wheel, timer);
+    wheel->count++;
+
+    return timer;
+}
+
+void* cancelTimer(TimingWheel* wheel, Timer* timer) {
+    if (wheel == NULL || timer == NULL) {
+        return NULL;
+    }
+
+    void* data = timer->data;
+    unlinkTimer(wheel, timer);
+    free(timer);
+    wheel->count--;
+
+    return data;
+}
+
+int advanceTimingWheel(TimingWheel* wheel, TimerTick time) {
+    if (wheel == NULL) {
+        return 0;
+    }
+
+    Timer* cascade = NULL;
+
+    if (time > wheel->now) {
+        for (int level = 0; level < WHEEL_LEVELS; level++) {
+            int shift = level * WHEEL_BITS;
+            TimerTick elapsed = (time >> shift) - (wheel->now >> shift);
+
+            //Higher levels only move when this one wraps
+            if (elapsed == 0) {
+                break;
+            }
+
+            //Every slot between the old and new digit of this level has been passed
+            unsigned long long passed;
+            if (elapsed >= WHEEL_SLOTS) {
+                passed = ~0ULL;
+            }
+            else {
+                int first = (int)(((wheel->now >> shift) + 1) & (WHEEL_SLOTS - 1));
+                unsigned long long run = (1ULL << elapsed) - 1;
+                passed = (run << first) | (first == 0 ? 0 : run >> (WHEEL_SLOTS - first));
+            }
+
+            unsigned long long pending = wheel->occupied[level] & passed;
+            while (pending != 0) {
+                int slot = level * WHEEL_SLOTS + __builtin_ctzll(pending);
+                pending &= pending - 1;
+
+                //Splice the whole slot onto the cascade list
+                Timer* timer = wheel->slots[slot];
+                while (timer != NULL) {
+                    Timer* next = timer->next;
+                    timer->next = cascade;
+                    cascade = timer;
+                    timer = next;
+                }
+                wheel->slots[slot] = NULL;
+            }
+            wheel->occupied[level] &= ~passed;
+        }
+
+        wheel->now = time;
+    }
+
+    //Timers that were passed either fire or drop to a lower level
+    while (cascade != NULL) {
+        Timer* next = cascade->next;
+        placeTimer(wheel, cascade);
+        cascade = next;
+    }
+
+    return wheel->expiredCount;
+}
+
+int collectExpired(TimingWheel* wheel, void* out[], int max) {
+    if (wheel == NULL || out == NULL) {
+        return 0;
+    }
+
+    int collected = 0;
+    while (collected < max && wheel->expiredHead != NULL) {
+        Timer* timer = wheel->expiredHead;
+        wheel->expiredHead = timer->next;
+        out[collected++] = timer->data;
+        free(timer);
+    }
+
+    if (wheel->expiredHead == NULL) {
+        wheel->expiredTail = NULL;
+    }
+    else {
+        wheel->expiredHead->previous = NULL;
+    }
+    wheel->count -= collected;
+    wheel->expiredCount -= collected;
+
+    return collected;
+}
+
+int expireTimers(TimingWheel* wheel, TimerTick time, void* out[], int max) {
+    advanceTimingWheel(wheel, time);
+
+    return collectExpired(wheel, out, max);
+}
+
+TimerTick nextTimerDeadline(TimingWheel* wheel) {
+    if (wheel == NULL || wheel->count == 0) {
+        return ULLONG_MAX;
+    }
+
+    if (wheel->expiredHead != NULL) {
+        return wheel->now;
+    }
+
+    //Every timer on a level is later than every timer on the levels below it
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        if (wheel->occupied[level] != 0) {
+            int shift = level * WHEEL_BITS;
+            TimerTick slot = (TimerTick)__builtin_ctzll(wheel->occupied[level]);
+            TimerTick prefix = shift + WHEEL_BITS >= 64 ? 0 : (wheel->now >> (shift + WHEEL_BITS)) << (shift + WHEEL_BITS);
+
+            return prefix | (slot << shift);
+        }
+    }
+
+    return ULLONG_MAX;
+}
+
+int getTimerCount(TimingWheel* wheel) {
+    if (wheel == NULL) {
+        return 0;
+    }
+
+    return wheel->count;
+}
@@ -0,0 +1,129 @@
+#ifndef TIMINGWHEEL_TIMINGWHEELAPI_H
+#define TIMINGWHEEL_TIMINGWHEELAPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+/**
+ * Number of bits of the deadline resolved by each level of the wheel
+ */
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS ((64 + WHEEL_BITS - 1) / WHEEL_BITS)
+
+/**
+ * Integer deadlines/priorities used by the wheel. Time only moves forward.
+ */
+typedef unsigned long long TimerTick;
+
+/**
+ * A single scheduled timer. The struct is also the handle returned to the
+ * caller so that cancellation does not need a search.
+ */
+typedef struct timer {
+    TimerTick deadline;    //Tick at which the timer becomes due
+    void* data;    //Pointer to generic data carried by the timer
+    struct timer* previous;
+    struct timer* next;
+    int slot;    //Index into the wheel slots, or -1 once the timer is due
+} Timer;
+
+/**
+ * Hierarchical timing wheel. Every level has WHEEL_SLOTS slots that each hold a
+ * doubly linked list of timers, and a bitmap of the slots that are not empty.
+ * A timer is stored on the level of the highest bit where its deadline differs
+ * from the current time, so it cascades down at most WHEEL_LEVELS times.
+ */
+typedef struct timingWheel {
+    Timer* slots[WHEEL_LEVELS * WHEEL_SLOTS];
+    unsigned long long occupied[WHEEL_LEVELS];
+    Timer* expiredHead;    //Due timers that have not been collected yet, oldest first
+    Timer* expiredTail;
+    int expiredCount;
+    TimerTick now;
+    int count;
+    void (*deleteData)(void* toBeDeleted);
+} TimingWheel;
+
+/**
+ * createTimingWheel: Creates an empty timing wheel
+ * @param deleteFunction function pointer to delete a single piece of data from the wheel, may be NULL
+ * @param startTime tick the wheel starts at
+ * @return the newly created wheel, NULL on allocation failure
+ */
+TimingWheel* createTimingWheel(void (*deleteFunction)(void* toBeDeleted), TimerTick startTime);
+
+/**
+ * destroyTimingWheel: Frees every pending and due timer, and their data when the wheel has a delete function
+ * @param TimingWheel* wheel
+ * @return void
+ */
+void destroyTimingWheel(TimingWheel* wheel);
+
+/**
+ * scheduleTimer: Schedules data to become due at deadline in O(1).
+ * Deadlines at or before the current time are due immediately.
+ * @param TimingWheel* wheel
+ * @param TimerTick deadline
+ * @param void* data
+ * @return handle that can be passed to cancelTimer, NULL on failure
+ */
+Timer* scheduleTimer(TimingWheel* wheel, TimerTick deadline, void* data);
+
+/**
+ * cancelTimer: Removes a pending or due timer in O(1) and frees the handle.
+ * The data is not deleted.
+ * @param TimingWheel* wheel
+ * @param Timer* timer
+ * @return the data that was carried by the timer
+ */
+void* cancelTimer(TimingWheel* wheel, Timer* timer);
+
+/**
+ * advanceTimingWheel: Moves the current time forward to time. Timers whose
+ * deadline has been reached are moved to the due list, and cascading costs
+ * amortized O(1) per timer. Timers that become due in the same call are not
+ * ordered by deadline.
+ * @param TimingWheel* wheel
+ * @param TimerTick time
+ * @return number of timers that are due after advancing
+ */
+int advanceTimingWheel(TimingWheel* wheel, TimerTick time);
+
+/**
+ * collectExpired: Removes up to max due timers and stores their data in out.
+ * The timer handles are freed.
+ * @param TimingWheel* wheel
+ * @param void* out[] array of at least max elements
+ * @param int max
+ * @return number of elements written to out
+ */
+int collectExpired(TimingWheel* wheel, void* out[], int max);
+
+/**
+ * expireTimers: Advances the wheel to time and collects the due data in one call
+ * @param TimingWheel* wheel
+ * @param TimerTick time
+ * @param void* out[] array of at least max elements
+ * @param int max
+ * @return number of elements written to out
+ */
+int expireTimers(TimingWheel* wheel, TimerTick time, void* out[], int max);
+
+/**
+ * nextTimerDeadline: Gives a lower bound on the earliest pending deadline
+ * so that callers know how long they can sleep
+ * @param TimingWheel* wheel
+ * @return current time if timers are due, ULLONG_MAX if the wheel is empty
+ */
+TimerTick nextTimerDeadline(TimingWheel* wheel);
+
+/**
+ * getTimerCount: Number of pending and due timers in the wheel
+ * @param TimingWheel* wheel
+ * @return int
+ */
+int getTimerCount(TimingWheel* wheel);
+
+#endif //TIMINGWHEEL_TIMINGWHEELAPI_H
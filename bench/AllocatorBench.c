@@ -0,0 +1,95 @@
+/**
+ * Benchmark for node allocators: builds an AVL tree of random keys, looks
+ * every key up and destroys it, with nodes from malloc, the slab allocator
+ * and an arena.
+ * Usage: AllocatorBench [keys] [rounds]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../BinarySearchTreeAPI.h"
+
+static int compareKeys(const void* a, const void* b) {
+    long first = *(const long*)a;
+    long second = *(const long*)b;
+
+    return (first > second) - (first < second);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long randomBelow(long n) {
+    return ((long)rand() * RAND_MAX + rand()) % n;
+}
+
+/**
+ * Times one round of building, searching and destroying a tree
+ */
+static void runRound(const char* name, Allocator* allocator, long* keys, long numKeys, double* build, double* lookup, double* destroy) {
+    double start = now();
+    //No delete function, the keys are not owned by the tree
+    Tree* tree = createBinTreeWithAllocator(compareKeys, NULL, NULL, TREE_AVL, allocator);
+    for (long i = 0; i < numKeys; i++) {
+        addToTree(tree, &keys[i]);
+    }
+    *build += now() - start;
+
+    start = now();
+    long found = 0;
+    for (long i = 0; i < numKeys; i++) {
+        found += findInTree(tree, &keys[i]) != NULL;
+    }
+    *lookup += now() - start;
+    if (found != numKeys) {
+        fprintf(stderr, "%s: found %ld of %ld keys\n", name, found, numKeys);
+    }
+
+    start = now();
+    destroyBinTree(tree);
+    if (allocator != NULL && !allocatorReleasesEach(allocator)) {
+        resetArenaAllocator(allocator);
+    }
+    *destroy += now() - start;
+}
+
+int main(int argc, char** argv) {
+    long numKeys = argc > 1 ? atol(argv[1]) : 1000000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+
+    srand(42);
+
+    long* keys = malloc(sizeof(long) * numKeys);
+    for (long i = 0; i < numKeys; i++) {
+        keys[i] = i;
+    }
+    for (long i = numKeys - 1; i > 0; i--) {
+        long j = randomBelow(i + 1);
+        long tmp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = tmp;
+    }
+
+    Allocator* arena = createArenaAllocator(0);
+    const char* names[] = {"malloc", "slab", "arena"};
+    Allocator* allocators[] = {NULL, getSlabAllocator(), arena};
+
+    printf("{\"benchmark\": \"Allocator\", \"keys\": %ld, \"rounds\": %d, \"results\": [\n", numKeys, rounds);
+    for (int a = 0; a < 3; a++) {
+        double build = 0, lookup = 0, destroy = 0;
+        for (int r = 0; r < rounds; r++) {
+            runRound(names[a], allocators[a], keys, numKeys, &build, &lookup, &destroy);
+        }
+        printf("  {\"allocator\": \"%s\", \"buildSeconds\": %.4f, \"lookupSeconds\": %.4f, \"destroySeconds\": %.4f}%s\n",
+               names[a], build / rounds, lookup / rounds, destroy / rounds, a < 2 ? "," : "");
+    }
+    printf("]}\n");
+
+    destroyArenaAllocator(arena);
+    free(keys);
+
+    return 0;
+}
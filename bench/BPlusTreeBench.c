@@ -0,0 +1,98 @@
+/**
+ * Benchmark for BPlusTreeAPI: random point lookups against findInTree on a
+ * balanced Tree holding the same keys.
+ * Usage: BPlusTreeBench [keys] [lookups]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../BPlusTreeAPI.h"
+#include "../BinarySearchTreeAPI.h"
+
+static void noDelete(void* data) {
+    (void)data;
+}
+
+static int compareKeys(const void* a, const void* b) {
+    long long first = *(const long long*)a;
+    long long second = *(const long long*)b;
+
+    return (first > second) - (first < second);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long nextRandom(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+int main(int argc, char** argv) {
+    long n = argc > 1 ? atol(argv[1]) : 10000000;
+    long lookups = argc > 2 ? atol(argv[2]) : 10000000;
+
+    //Random distinct keys: even numbers so that odd probes miss
+    long long* keys = malloc(sizeof(long long) * n);
+    long long* probes = malloc(sizeof(long long) * lookups);
+    unsigned long long state = 88172645463325252ULL;
+    for (long i = 0; i < n; i++) {
+        keys[i] = 2 * i;
+    }
+    for (long i = n - 1; i > 0; i--) {
+        long j = nextRandom(&state) % (i + 1);
+        long long tmp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = tmp;
+    }
+    for (long i = 0; i < lookups; i++) {
+        probes[i] = nextRandom(&state) % (2 * n);
+    }
+
+    double start = now();
+    Tree* tree = createBinTreeWithMode(compareKeys, noDelete, NULL, TREE_AVL);
+    for (long i = 0; i < n; i++) {
+        addToTree(tree, &keys[i]);
+    }
+    double treeBuild = now() - start;
+
+    start = now();
+    BPlusTree* bPlusTree = createBPlusTree(noDelete);
+    for (long i = 0; i < n; i++) {
+        addToBPlusTree(bPlusTree, keys[i], &keys[i]);
+    }
+    double bPlusBuild = now() - start;
+
+    long treeHits = 0;
+    start = now();
+    for (long i = 0; i < lookups; i++) {
+        treeHits += findInTree(tree, &probes[i]) != NULL;
+    }
+    double treeFind = now() - start;
+
+    long bPlusHits = 0;
+    start = now();
+    for (long i = 0; i < lookups; i++) {
+        bPlusHits += findInBPlusTree(bPlusTree, probes[i]) != NULL;
+    }
+    double bPlusFind = now() - start;
+
+    printf("{\"benchmark\": \"BPlusTree\", \"keys\": %ld, \"lookups\": %ld, \"nodeBytes\": %d, \"results\": [\n", n, lookups, BPLUS_NODE_BYTES);
+    printf("  {\"structure\": \"Tree (AVL)\", \"height\": %d, \"buildSeconds\": %.3f, \"nsPerLookup\": %.1f, \"hits\": %ld},\n",
+           getHeight(tree->root), treeBuild, treeFind * 1e9 / lookups, treeHits);
+    printf("  {\"structure\": \"BPlusTree\", \"height\": %d, \"buildSeconds\": %.3f, \"nsPerLookup\": %.1f, \"hits\": %ld}\n",
+           bPlusTree->height, bPlusBuild, bPlusFind * 1e9 / lookups, bPlusHits);
+    printf("]}\n");
+
+    destroyBPlusTree(bPlusTree);
+    destroyBinTree(tree);
+    free(keys);
+    free(probes);
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+/**
+ * Insert, lookup, delete and scan workloads for BPlusTreeAPI.
+ * Usage: BPlusTreeWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "../BPlusTreeAPI.h"
+#include "BenchHarness.h"
+
+static void* createBPlus(long* keys, long numKeys) {
+    (void)keys;
+    (void)numKeys;
+    return createBPlusTree(benchNoDelete);
+}
+
+static void insertBPlus(void* structure, long* key) {
+    addToBPlusTree(structure, *key, key);
+}
+
+static void* lookupBPlus(void* structure, long* key) {
+    return findInBPlusTree(structure, *key);
+}
+
+static void removeBPlus(void* structure, long* key) {
+    removeFromBPlusTree(structure, *key);
+}
+
+static long scanBPlus(void* structure) {
+    BPlusIterator iter = createBPlusIterator(structure, LLONG_MIN);
+    BPlusKey key;
+    long count = 0;
+
+    while (nextBPlusElement(&iter, &key) != NULL) {
+        count++;
+    }
+
+    return count;
+}
+
+static void destroyBPlus(void* structure) {
+    destroyBPlusTree(structure);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"BPlusTree", 0, createBPlus, insertBPlus, lookupBPlus, removeBPlus, scanBPlus, destroyBPlus}
+    };
+
+    return runBenchmarks("BPlusTree", targets, 1, argc, argv);
+}
@@ -0,0 +1,91 @@
+/**
+ * Benchmark for findManyInTree: random lookups on an AVL tree larger than
+ * the cache, one findInTree call per key against interleaved batches.
+ * Usage: BatchLookupBench [keys] [lookups] [batchSize]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../BinarySearchTreeAPI.h"
+
+static void noDelete(void* data) {
+    (void)data;
+}
+
+static int compareKeys(const void* a, const void* b) {
+    long first = *(const long*)a;
+    long second = *(const long*)b;
+
+    return (first > second) - (first < second);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long randomBelow(long n) {
+    return ((long)rand() * RAND_MAX + rand()) % n;
+}
+
+int main(int argc, char** argv) {
+    long numKeys = argc > 1 ? atol(argv[1]) : 4000000;
+    long lookups = argc > 2 ? atol(argv[2]) : 4000000;
+    int batchSize = argc > 3 ? atoi(argv[3]) : 1024;
+
+    srand(42);
+
+    //Insert in random order so neighbouring nodes are far apart in memory
+    long* keys = malloc(sizeof(long) * numKeys);
+    for (long i = 0; i < numKeys; i++) {
+        keys[i] = i;
+    }
+    for (long i = numKeys - 1; i > 0; i--) {
+        long j = randomBelow(i + 1);
+        long tmp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = tmp;
+    }
+    Tree* tree = createBinTreeWithMode(compareKeys, noDelete, NULL, TREE_AVL);
+    for (long i = 0; i < numKeys; i++) {
+        addToTree(tree, &keys[i]);
+    }
+
+    //Half of the lookups miss
+    long* queries = malloc(sizeof(long) * lookups);
+    TreeDataPtr* queryPtrs = malloc(sizeof(TreeDataPtr) * lookups);
+    TreeDataPtr* out = malloc(sizeof(TreeDataPtr) * lookups);
+    for (long i = 0; i < lookups; i++) {
+        queries[i] = randomBelow(numKeys * 2);
+        queryPtrs[i] = &queries[i];
+    }
+
+    long singleFound = 0;
+    double start = now();
+    for (long i = 0; i < lookups; i++) {
+        singleFound += findInTree(tree, queryPtrs[i]) != NULL;
+    }
+    double singleElapsed = now() - start;
+
+    long batchFound = 0;
+    start = now();
+    for (long i = 0; i < lookups; i += batchSize) {
+        int n = lookups - i < batchSize ? (int)(lookups - i) : batchSize;
+        batchFound += findManyInTree(tree, &queryPtrs[i], n, &out[i]);
+    }
+    double batchElapsed = now() - start;
+
+    printf("{\"benchmark\": \"BatchLookup\", \"keys\": %ld, \"lookups\": %ld, \"batchSize\": %d, \"inFlight\": %d, "
+           "\"singleLookupsPerSecond\": %.0f, \"batchLookupsPerSecond\": %.0f, \"speedup\": %.2f, \"resultsMatch\": %s}\n",
+           numKeys, lookups, batchSize, TREE_BATCH_LOOKUPS, lookups / singleElapsed, lookups / batchElapsed,
+           singleElapsed / batchElapsed, singleFound == batchFound ? "true" : "false");
+
+    destroyBinTree(tree);
+    free(keys);
+    free(queries);
+    free(queryPtrs);
+    free(out);
+
+    return 0;
+}
@@ -0,0 +1,653 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "BenchHarness.h"
+#include "../InstrumentAPI.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define BENCH_NUM_COUNTERS 4
+
+/**
+ * Hardware counters read around each run, fd is -1 for counters the kernel refused
+ */
+typedef struct benchCounters {
+    int fds[BENCH_NUM_COUNTERS];
+    unsigned long long values[BENCH_NUM_COUNTERS];
+    bool available;
+} BenchCounters;
+
+/**
+ * Everything parsed from the command line
+ */
+typedef struct benchOptions {
+    long sizes[32];
+    int numSizes;
+    bool workloads[BENCH_NUM_WORKLOADS];
+    bool distributions[BENCH_NUM_DISTRIBUTIONS];
+    double zipfExponent;
+    unsigned long long seed;
+    int repeat;
+} BenchOptions;
+
+/**
+ * Precomputed constants of the rejection-inversion Zipf sampler, which
+ * needs no table so it works up to the largest sizes
+ */
+typedef struct zipfSampler {
+    long n;
+    double exponent;
+    double hIntegralX1;
+    double hIntegralN;
+    double s;
+} ZipfSampler;
+
+/**
+ * Measurements of one run
+ */
+typedef struct benchResult {
+    long ops;
+    long hits;    //Successful lookups, or elements visited by scans
+    double seconds;
+    long sampleEvery;
+    unsigned long long* samples;
+    long numSamples;
+} BenchResult;
+
+static const char* workloadNames[BENCH_NUM_WORKLOADS] = {"insert", "lookup", "delete", "scan"};
+static const char* distributionNames[BENCH_NUM_DISTRIBUTIONS] = {"uniform", "zipf", "sorted", "adversarial"};
+static const char* counterNames[BENCH_NUM_COUNTERS] = {"cycles", "instructions", "cacheMisses", "branchMisses"};
+
+static unsigned long long randomState;
+
+int benchCompareKeys(const void* a, const void* b) {
+    long first = *(const long*)a;
+    long second = *(const long*)b;
+
+    return (first > second) - (first < second);
+}
+
+void benchNoDelete(void* data) {
+    (void)data;
+}
+
+static unsigned long long nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * xorshift64*, fast and good enough to shuffle and sample keys
+ */
+static unsigned long long nextRandom(void) {
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return randomState * 2685821657736338717ULL;
+}
+
+static long randomBelow(long n) {
+    return (long)(nextRandom() % (unsigned long long)n);
+}
+
+static double randomUnit(void) {
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void shuffle(long* values, long n) {
+    for (long i = n - 1; i > 0; i--) {
+        long j = randomBelow(i + 1);
+        long tmp = values[i];
+        values[i] = values[j];
+        values[j] = tmp;
+    }
+}
+
+/**
+ * log1p(x) / x, continuous at 0
+ */
+static double helper1(double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+/**
+ * expm1(x) / x, continuous at 0
+ */
+static double helper2(double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3.0) * (1 + 0.25 * x));
+}
+
+static double zipfH(ZipfSampler* zipf, double x) {
+    return exp(-zipf->exponent * log(x));
+}
+
+static double zipfHIntegral(ZipfSampler* zipf, double x) {
+    double logX = log(x);
+    return helper2((1 - zipf->exponent) * logX) * logX;
+}
+
+static double zipfHIntegralInverse(ZipfSampler* zipf, double x) {
+    double t = x * (1 - zipf->exponent);
+    if (t < -1) {
+        t = -1;
+    }
+    return exp(helper1(t) * x);
+}
+
+static void initZipf(ZipfSampler* zipf, long n, double exponent) {
+    zipf->n = n;
+    zipf->exponent = exponent;
+    zipf->hIntegralX1 = zipfHIntegral(zipf, 1.5) - 1;
+    zipf->hIntegralN = zipfHIntegral(zipf, n + 0.5);
+    zipf->s = 2 - zipfHIntegralInverse(zipf, zipfHIntegral(zipf, 2.5) - zipfH(zipf, 2));
+}
+
+/**
+ * Draws a rank in [0, n), rank 0 being the most frequent
+ */
+static long sampleZipf(ZipfSampler* zipf) {
+    while (true) {
+        double u = zipf->hIntegralN + randomUnit() * (zipf->hIntegralX1 - zipf->hIntegralN);
+        double x = zipfHIntegralInverse(zipf, u);
+        long k = (long)(x + 0.5);
+        if (k < 1) {
+            k = 1;
+        }
+        else if (k > zipf->n) {
+            k = zipf->n;
+        }
+        if (k - x <= zipf->s || u >= zipfHIntegral(zipf, k + 0.5) - zipfH(zipf, k)) {
+            return k - 1;
+        }
+    }
+}
+
+/**
+ * Fills keys with n distinct keys in the order they are inserted
+ */
+static void generateKeys(BenchDistribution distribution, long* keys, long n) {
+    if (distribution == BENCH_ADVERSARIAL) {
+        //Smallest, largest, second smallest, second largest...
+        long lo = 0;
+        long hi = n - 1;
+        for (long i = 0; i < n; i++) {
+            keys[i] = (i % 2 == 0 ? lo++ : hi--) * BENCH_ADVERSARIAL_STRIDE;
+        }
+        return;
+    }
+
+    for (long i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    if (distribution != BENCH_SORTED) {
+        shuffle(keys, n);
+    }
+}
+
+/**
+ * Fills stream with the n keys a lookup or delete run operates on, in order.
+ * Keys are inserted shuffled for uniform and zipf, so the hottest Zipf ranks
+ * land on keys spread over the whole range.
+ */
+static void generateStream(BenchDistribution distribution, BenchWorkload workload, long* keys, long n, long** stream, ZipfSampler* zipf) {
+    for (long i = 0; i < n; i++) {
+        stream[i] = &keys[i];
+    }
+
+    if (distribution == BENCH_UNIFORM) {
+        if (workload == BENCH_DELETE) {
+            //Every key deleted once, in a different random order than inserted
+            for (long i = n - 1; i > 0; i--) {
+                long j = randomBelow(i + 1);
+                long* tmp = stream[i];
+                stream[i] = stream[j];
+                stream[j] = tmp;
+            }
+        }
+        else {
+            for (long i = 0; i < n; i++) {
+                stream[i] = &keys[randomBelow(n)];
+            }
+        }
+    }
+    else if (distribution == BENCH_ZIPF) {
+        //Deletes of hot keys after the first one miss, like lookups of removed keys
+        for (long i = 0; i < n; i++) {
+            stream[i] = &keys[sampleZipf(zipf)];
+        }
+    }
+}
+
+static void openCounters(BenchCounters* counters) {
+    counters->available = false;
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        counters->fds[i] = -1;
+        counters->values[i] = 0;
+    }
+
+#ifdef __linux__
+    static const unsigned long long configs[BENCH_NUM_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        //Fails in containers and VMs without a PMU, results then report null counters
+        counters->fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (counters->fds[i] >= 0) {
+            counters->available = true;
+        }
+    }
+#endif
+}
+
+static void startCounters(BenchCounters* counters) {
+#ifdef __linux__
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        if (counters->fds[i] >= 0) {
+            ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)counters;
+#endif
+}
+
+static void stopCounters(BenchCounters* counters) {
+#ifdef __linux__
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        counters->values[i] = 0;
+        if (counters->fds[i] >= 0) {
+            ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(counters->fds[i], &counters->values[i], sizeof(counters->values[i])) != sizeof(counters->values[i])) {
+                counters->values[i] = 0;
+            }
+        }
+    }
+#else
+    (void)counters;
+#endif
+}
+
+static void closeCounters(BenchCounters* counters) {
+#ifdef __linux__
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        if (counters->fds[i] >= 0) {
+            close(counters->fds[i]);
+        }
+    }
+#else
+    (void)counters;
+#endif
+}
+
+/**
+ * Parses a size such as 5000, 100K or 10M
+ */
+static long parseSize(const char* text) {
+    char* end;
+    double value = strtod(text, &end);
+
+    if (*end == 'K' || *end == 'k') {
+        value *= 1000;
+    }
+    else if (*end == 'M' || *end == 'm') {
+        value *= 1000000;
+    }
+
+    return (long)value;
+}
+
+/**
+ * Marks the names listed in a comma separated list
+ * @return false if a name is unknown
+ */
+static bool parseNames(const char* text, const char* names[], int numNames, bool selected[]) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+
+    for (int i = 0; i < numNames; i++) {
+        selected[i] = false;
+    }
+
+    for (char* name = strtok(buffer, ","); name != NULL; name = strtok(NULL, ",")) {
+        int i = 0;
+        while (i < numNames && strcmp(name, names[i]) != 0) {
+            i++;
+        }
+        if (i == numNames) {
+            fprintf(stderr, "Unknown name %s\n", name);
+            return false;
+        }
+        selected[i] = true;
+    }
+
+    return true;
+}
+
+static bool parseOptions(BenchOptions* options, int argc, char** argv) {
+    long defaultSizes[] = {1000, 10000, 100000, 1000000};
+
+    options->numSizes = 4;
+    for (int i = 0; i < options->numSizes; i++) {
+        options->sizes[i] = defaultSizes[i];
+    }
+    for (int i = 0; i < BENCH_NUM_WORKLOADS; i++) {
+        options->workloads[i] = true;
+    }
+    for (int i = 0; i < BENCH_NUM_DISTRIBUTIONS; i++) {
+        options->distributions[i] = true;
+    }
+    options->zipfExponent = BENCH_DEFAULT_ZIPF;
+    options->seed = 42;
+    options->repeat = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return false;
+        }
+
+        const char* value = argv[++i];
+        if (strcmp(argv[i - 1], "--sizes") == 0) {
+            char buffer[256];
+            snprintf(buffer, sizeof(buffer), "%s", value);
+            options->numSizes = 0;
+            for (char* size = strtok(buffer, ","); size != NULL && options->numSizes < 32; size = strtok(NULL, ",")) {
+                options->sizes[options->numSizes] = parseSize(size);
+                if (options->sizes[options->numSizes] < 1) {
+                    fprintf(stderr, "Bad size %s\n", size);
+                    return false;
+                }
+                options->numSizes++;
+            }
+        }
+        else if (strcmp(argv[i - 1], "--workloads") == 0) {
+            if (!parseNames(value, workloadNames, BENCH_NUM_WORKLOADS, options->workloads)) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i - 1], "--distributions") == 0) {
+            if (!parseNames(value, distributionNames, BENCH_NUM_DISTRIBUTIONS, options->distributions)) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i - 1], "--zipf") == 0) {
+            options->zipfExponent = atof(value);
+        }
+        else if (strcmp(argv[i - 1], "--seed") == 0) {
+            options->seed = strtoull(value, NULL, 10);
+        }
+        else if (strcmp(argv[i - 1], "--repeat") == 0) {
+            options->repeat = atoi(value) < 1 ? 1 : atoi(value);
+        }
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i - 1]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Times n operations on the structure, every sampleEvery-th one individually
+ */
+static void timeOperations(const BenchTarget* target, BenchWorkload workload, void* structure, long** stream, long n, BenchResult* result) {
+    long hits = 0;
+    long next = 0;
+    unsigned long long start = nowNs();
+
+    for (long i = 0; i < n; i++) {
+        bool sampled = i == next;
+        unsigned long long before = sampled ? nowNs() : 0;
+
+        if (workload == BENCH_INSERT) {
+            target->insert(structure, stream[i]);
+        }
+        else if (workload == BENCH_LOOKUP) {
+            hits += target->lookup(structure, stream[i]) != NULL;
+        }
+        else {
+            target->remove(structure, stream[i]);
+        }
+
+        if (sampled) {
+            result->samples[result->numSamples++] = nowNs() - before;
+            next += result->sampleEvery;
+        }
+    }
+
+    result->seconds = (nowNs() - start) / 1e9;
+    result->ops = n;
+    result->hits = hits;
+}
+
+/**
+ * Times full scans, enough of them to visit about ten million elements
+ */
+static void timeScans(const BenchTarget* target, void* structure, long n, BenchResult* result) {
+    long scans = 10000000 / n;
+    if (scans < 1) {
+        scans = 1;
+    }
+    else if (scans > 1000) {
+        scans = 1000;
+    }
+
+    long visited = 0;
+    unsigned long long start = nowNs();
+    for (long i = 0; i < scans; i++) {
+        unsigned long long before = nowNs();
+        visited += target->scan(structure);
+        result->samples[result->numSamples++] = nowNs() - before;
+    }
+
+    result->seconds = (nowNs() - start) / 1e9;
+    result->ops = visited;
+    result->hits = visited;
+    result->sampleEvery = 1;
+}
+
+static int compareSamples(const void* a, const void* b) {
+    unsigned long long first = *(const unsigned long long*)a;
+    unsigned long long second = *(const unsigned long long*)b;
+
+    return (first > second) - (first < second);
+}
+
+static unsigned long long percentile(BenchResult* result, double fraction) {
+    long i = (long)(fraction * (result->numSamples - 1) + 0.5);
+    return result->samples[i];
+}
+
+static void printResult(const char* name, BenchWorkload workload, BenchDistribution distribution, long size, BenchResult* result, BenchCounters* counters, const char* stats, bool first) {
+    qsort(result->samples, result->numSamples, sizeof(unsigned long long), compareSamples);
+
+    printf("%s  {\"structure\": \"%s\", \"workload\": \"%s\", \"distribution\": \"%s\", \"size\": %ld, \"ops\": %ld, \"hits\": %ld, "
+           "\"seconds\": %.6f, \"opsPerSecond\": %.0f, \"sampleEvery\": %ld, ",
+           first ? "" : ",\n", name, workloadNames[workload], distributionNames[distribution], size, result->ops, result->hits,
+           result->seconds, result->seconds > 0 ? result->ops / result->seconds : 0, result->sampleEvery);
+    printf("\"latencyNs\": {\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}, ",
+           percentile(result, 0.5), percentile(result, 0.9), percentile(result, 0.99), percentile(result, 0.999),
+           result->samples[result->numSamples - 1]);
+
+    if (!counters->available) {
+        printf("\"counters\": null");
+    }
+    else {
+        printf("\"counters\": {");
+        bool firstCounter = true;
+        for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+            if (counters->fds[i] >= 0) {
+                printf("%s\"%s\": %llu", firstCounter ? "" : ", ", counterNames[i], counters->values[i]);
+                firstCounter = false;
+            }
+        }
+        printf("}");
+    }
+
+    if (stats != NULL) {
+        printf(", \"instrumentation\": %s", stats);
+    }
+    printf("}");
+}
+
+/**
+ * Fills a new structure with every key, untimed
+ */
+static void* createFilled(const BenchTarget* target, long* keys, long n) {
+    void* structure = target->create(keys, n);
+
+    if (structure != NULL && target->insert != NULL) {
+        for (long i = 0; i < n; i++) {
+            target->insert(structure, &keys[i]);
+        }
+    }
+
+    return structure;
+}
+
+/**
+ * Checks if a target has what a workload needs
+ */
+static bool supports(const BenchTarget* target, BenchWorkload workload) {
+    switch (workload) {
+        case BENCH_INSERT:
+            return target->insert != NULL;
+        case BENCH_LOOKUP:
+            return target->lookup != NULL;
+        case BENCH_DELETE:
+            return target->remove != NULL;
+        default:
+            return target->scan != NULL;
+    }
+}
+
+int runBenchmarks(const char* benchmark, const BenchTarget targets[], int numTargets, int argc, char** argv) {
+    BenchOptions options;
+    if (!parseOptions(&options, argc, argv)) {
+        fprintf(stderr, "Usage: %s [--sizes 1K,100K,10M] [--workloads insert,lookup,delete,scan] "
+                        "[--distributions uniform,zipf,sorted,adversarial] [--zipf exponent] [--seed n] [--repeat n]\n", argv[0]);
+        return 1;
+    }
+
+    BenchCounters counters;
+    openCounters(&counters);
+
+    printf("{\"benchmark\": \"%s\", \"seed\": %llu, \"zipfExponent\": %.3f, \"countersAvailable\": %s, \"results\": [\n",
+           benchmark, options.seed, options.zipfExponent, counters.available ? "true" : "false");
+
+    bool first = true;
+    for (int s = 0; s < options.numSizes; s++) {
+        long n = options.sizes[s];
+        long* keys = malloc(sizeof(long) * n);
+        long** stream = malloc(sizeof(long*) * n);
+        BenchResult result;
+        //Room for one sample per operation up to the limit, and for up to 1000 scans
+        long maxSamples = n < BENCH_MAX_SAMPLES ? n : BENCH_MAX_SAMPLES;
+        result.samples = malloc(sizeof(unsigned long long) * (maxSamples > 1000 ? maxSamples : 1000));
+        if (keys == NULL || stream == NULL || result.samples == NULL) {
+            fprintf(stderr, "Not enough memory for %ld keys\n", n);
+            free(keys);
+            free(stream);
+            free(result.samples);
+            continue;
+        }
+
+        ZipfSampler zipf;
+        initZipf(&zipf, n, options.zipfExponent);
+
+        for (int d = 0; d < BENCH_NUM_DISTRIBUTIONS; d++) {
+            if (!options.distributions[d]) {
+                continue;
+            }
+
+            for (int t = 0; t < numTargets; t++) {
+                const BenchTarget* target = &targets[t];
+                if (target->maxSize > 0 && n > target->maxSize) {
+                    continue;
+                }
+
+                for (int w = 0; w < BENCH_NUM_WORKLOADS; w++) {
+                    if (!options.workloads[w] || !supports(target, w)) {
+                        continue;
+                    }
+
+                    for (int r = 0; r < options.repeat; r++) {
+                        //Same keys for every target and workload of one size, distribution and repetition
+                        randomState = options.seed * 0x9E3779B97F4A7C15ULL + (unsigned long long)(n * 31 + d * 7 + r + 1);
+                        generateKeys(d, keys, n);
+
+                        void* structure;
+                        if (w == BENCH_INSERT) {
+                            structure = target->create(keys, n);
+                            for (long i = 0; i < n; i++) {
+                                stream[i] = &keys[i];
+                            }
+                        }
+                        else {
+                            structure = createFilled(target, keys, n);
+                            generateStream(d, w, keys, n, stream, &zipf);
+                        }
+                        if (structure == NULL) {
+                            fprintf(stderr, "%s: could not create a structure of %ld keys\n", target->name, n);
+                            continue;
+                        }
+
+                        result.numSamples = 0;
+                        result.sampleEvery = (n + BENCH_MAX_SAMPLES - 1) / BENCH_MAX_SAMPLES;
+
+                        resetStats();
+                        startCounters(&counters);
+                        if (w == BENCH_SCAN) {
+                            timeScans(target, structure, n, &result);
+                        }
+                        else {
+                            timeOperations(target, w, structure, stream, n, &result);
+                        }
+                        stopCounters(&counters);
+
+                        //Statistics of the timed operations only, taken before destroy adds its own
+                        char* stats = statsEnabled() ? statsToJSON() : NULL;
+
+                        target->destroy(structure);
+
+                        printResult(target->name, w, d, n, &result, &counters, stats, first);
+                        free(stats);
+                        first = false;
+                        fflush(stdout);
+                    }
+                }
+            }
+        }
+
+        free(keys);
+        free(stream);
+        free(result.samples);
+    }
+    printf("\n]}\n");
+
+    closeCounters(&counters);
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#ifndef BENCH_BENCHHARNESS_H
+#define BENCH_BENCHHARNESS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+/**
+ * Most latency samples kept per run, longer runs time every k-th operation
+ */
+#define BENCH_MAX_SAMPLES 1000000
+
+/**
+ * Gap between adversarial keys, a multiple of every power of two table size up to it
+ */
+#define BENCH_ADVERSARIAL_STRIDE 1024
+
+/**
+ * Zipf exponent used unless --zipf is given
+ */
+#define BENCH_DEFAULT_ZIPF 0.99
+
+/**
+ * Operation timed by a run
+ */
+typedef enum benchWorkload {
+    BENCH_INSERT,
+    BENCH_LOOKUP,
+    BENCH_DELETE,
+    BENCH_SCAN,
+    BENCH_NUM_WORKLOADS
+} BenchWorkload;
+
+/**
+ * Order and skew of the keys a run uses.
+ * BENCH_UNIFORM: keys inserted in random order, looked up and deleted uniformly at random
+ * BENCH_ZIPF: keys inserted in random order, lookups and deletes favour a few keys spread over the key range
+ * BENCH_SORTED: keys inserted, looked up and deleted in ascending order
+ * BENCH_ADVERSARIAL: multiples of BENCH_ADVERSARIAL_STRIDE alternating between the smallest
+ * and largest remaining key, which degenerates unbalanced trees and collides in power of two tables
+ */
+typedef enum benchDistribution {
+    BENCH_UNIFORM,
+    BENCH_ZIPF,
+    BENCH_SORTED,
+    BENCH_ADVERSARIAL,
+    BENCH_NUM_DISTRIBUTIONS
+} BenchDistribution;
+
+/**
+ * One structure under test. Keys are passed as pointers into an array that
+ * outlives the structure, so they can be stored as data without copying.
+ * Any operation may be NULL, workloads needing it are skipped. Structures
+ * without insert are bulk built: create must fill them with every key.
+ */
+typedef struct benchTarget {
+    const char* name;
+    long maxSize;    //Largest size worth running, 0 for no limit. Structures with O(n) operations set it low
+    void* (*create)(long* keys, long numKeys);    //keys holds every key the run will use, in insertion order
+    void (*insert)(void* structure, long* key);
+    void* (*lookup)(void* structure, long* key);
+    void (*remove)(void* structure, long* key);
+    long (*scan)(void* structure);    //Visits every element, returns how many there were
+    void (*destroy)(void* structure);
+} BenchTarget;
+
+/**
+ * Orders keys with their numeric value
+ * @param const void* a pointer to a long
+ * @param const void* b pointer to a long
+ * @return negative, 0 or positive like strcmp
+ */
+int benchCompareKeys(const void* a, const void* b);
+
+/**
+ * Delete function for structures that do not own their keys
+ * @param void* data
+ * @return void
+ */
+void benchNoDelete(void* data);
+
+/**
+ * Runs every selected workload and distribution at every selected size for
+ * each target and prints the results as one JSON object on stdout.
+ * Options: --sizes 1K,100K,10M (K and M suffixes, 1K to 100M)
+ *          --workloads insert,lookup,delete,scan
+ *          --distributions uniform,zipf,sorted,adversarial
+ *          --zipf exponent, --seed n, --repeat n
+ * @param const char* benchmark name reported in the output
+ * @param BenchTarget targets[]
+ * @param int numTargets
+ * @param int argc
+ * @param char** argv
+ * @return exit status for main
+ */
+int runBenchmarks(const char* benchmark, const BenchTarget targets[], int numTargets, int argc, char** argv);
+
+#endif //BENCH_BENCHHARNESS_H
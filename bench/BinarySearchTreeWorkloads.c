@@ -0,0 +1,66 @@
+/**
+ * Insert, lookup, delete and scan workloads for every mode of
+ * BinarySearchTreeAPI. Sorted and adversarial keys make the unbalanced
+ * mode quadratic, so it skips sizes above 10K.
+ * Usage: BinarySearchTreeWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../BinarySearchTreeAPI.h"
+#include "BenchHarness.h"
+
+static void* createUnbalanced(long* keys, long numKeys) {
+    (void)keys;
+    (void)numKeys;
+    return createBinTreeWithMode(benchCompareKeys, NULL, NULL, TREE_UNBALANCED);
+}
+
+static void* createAVL(long* keys, long numKeys) {
+    (void)keys;
+    (void)numKeys;
+    return createBinTreeWithMode(benchCompareKeys, NULL, NULL, TREE_AVL);
+}
+
+static void* createSplay(long* keys, long numKeys) {
+    (void)keys;
+    (void)numKeys;
+    return createBinTreeWithMode(benchCompareKeys, NULL, NULL, TREE_SPLAY);
+}
+
+static void insertTree(void* structure, long* key) {
+    addToTree(structure, key);
+}
+
+static void* lookupTree(void* structure, long* key) {
+    return findInTree(structure, key);
+}
+
+static void removeTree(void* structure, long* key) {
+    removeFromTree(structure, key);
+}
+
+static int countElement(void* data, void* context) {
+    (void)data;
+    (*(long*)context)++;
+    return 0;
+}
+
+static long scanTree(void* structure) {
+    long count = 0;
+    visitInOrder(structure, countElement, &count);
+    return count;
+}
+
+static void destroyTree(void* structure) {
+    destroyBinTree(structure);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"BinarySearchTree/unbalanced", 10000, createUnbalanced, insertTree, lookupTree, removeTree, scanTree, destroyTree},
+        {"BinarySearchTree/avl", 0, createAVL, insertTree, lookupTree, removeTree, scanTree, destroyTree},
+        {"BinarySearchTree/splay", 0, createSplay, insertTree, lookupTree, removeTree, scanTree, destroyTree}
+    };
+
+    return runBenchmarks("BinarySearchTree", targets, 3, argc, argv);
+}
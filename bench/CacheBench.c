@@ -0,0 +1,178 @@
+/**
+ * Benchmark for CacheAPI: hit ratio and throughput of each policy on a
+ * Zipfian read-through workload interrupted by one-off scans, then read
+ * throughput of the sharded cache per thread count.
+ * Usage: CacheBench [keys] [operations] [capacity] [maxThreads]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "../CacheAPI.h"
+
+#define KEY_CHARS 24
+#define SCAN_EVERY 100000    //Operations between scans
+#define SCAN_LENGTH 20000    //Distinct cold keys read by one scan
+
+static const char* policyNames[] = {"LRU", "SLRU", "CLOCK"};
+
+typedef struct worker {
+    ShardedCache* cache;
+    char (*names)[KEY_CHARS];
+    int* stream;
+    long operations;
+    long hits;
+} Worker;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long nextRandom(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * Draws operations keys with a Zipf(0.99) distribution over numKeys by
+ * inverting the cumulative distribution
+ */
+static int* zipfStream(long numKeys, long operations, unsigned long long* state) {
+    double* cumulative = malloc(sizeof(double) * numKeys);
+    int* stream = malloc(sizeof(int) * operations);
+    double total = 0;
+
+    for (long i = 0; i < numKeys; i++) {
+        total += 1.0 / pow(i + 1, 0.99);
+        cumulative[i] = total;
+    }
+    for (long i = 0; i < operations; i++) {
+        double target = (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0) * total;
+        long lo = 0;
+        long hi = numKeys - 1;
+        while (lo < hi) {
+            long mid = (lo + hi) / 2;
+            if (cumulative[mid] < target) {
+                lo = mid + 1;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        //Spread the popular keys over the key space
+        stream[i] = (int)((lo * 2654435761UL) % numKeys);
+    }
+
+    free(cumulative);
+    return stream;
+}
+
+static void countHit(void* data, void* context) {
+    (void)data;
+    (*(long*)context)++;
+}
+
+static void* readWorker(void* arg) {
+    Worker* worker = arg;
+    long hits = 0;
+
+    for (long i = 0; i < worker->operations; i++) {
+        const char* key = worker->names[worker->stream[i]];
+        if (!readFromShardedCache(worker->cache, key, countHit, &hits)) {
+            putInShardedCache(worker->cache, key, (void*)key, 1);
+        }
+    }
+
+    worker->hits = hits;
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    long numKeys = argc > 1 ? atol(argv[1]) : 1000000;
+    long operations = argc > 2 ? atol(argv[2]) : 5000000;
+    long capacity = argc > 3 ? atol(argv[3]) : numKeys / 10;
+    int maxThreads = argc > 4 ? atoi(argv[4]) : 8;
+    unsigned long long state = 88172645463325252ULL;
+
+    //Scans read keys past numKeys that are never read again
+    long scanKeys = operations / SCAN_EVERY * SCAN_LENGTH;
+    char (*names)[KEY_CHARS] = malloc(sizeof(*names) * (numKeys + scanKeys));
+    for (long i = 0; i < numKeys + scanKeys; i++) {
+        snprintf(names[i], KEY_CHARS, "key%ld", i);
+    }
+    int* stream = zipfStream(numKeys, operations, &state);
+
+    printf("{\"benchmark\": \"Cache\", \"keys\": %ld, \"operations\": %ld, \"capacity\": %ld, \"scanEvery\": %d, \"scanLength\": %d, \"results\": [\n",
+           numKeys, operations, capacity, SCAN_EVERY, SCAN_LENGTH);
+
+    for (int policy = CACHE_LRU; policy <= CACHE_CLOCK; policy++) {
+        Cache* cache = createCache(capacity, policy, NULL);
+        long hits = 0;
+        long nextScan = numKeys;
+
+        double start = now();
+        for (long i = 0; i < operations; i++) {
+            const char* key = names[stream[i]];
+            if (getFromCache(cache, key) != NULL) {
+                hits++;
+            }
+            else {
+                putInCache(cache, key, (void*)key, 1);
+            }
+
+            if (i % SCAN_EVERY == SCAN_EVERY - 1) {
+                for (long j = 0; j < SCAN_LENGTH; j++, nextScan++) {
+                    if (getFromCache(cache, names[nextScan]) == NULL) {
+                        putInCache(cache, names[nextScan], names[nextScan], 1);
+                    }
+                }
+            }
+        }
+        double elapsed = now() - start;
+
+        printf("  {\"policy\": \"%s\", \"threads\": 1, \"sharded\": false, \"hitRatio\": %.4f, \"nsPerOperation\": %.1f, \"evictions\": %zu},\n",
+               policyNames[policy], (double)hits / operations, elapsed * 1e9 / (operations + scanKeys), cache->evictions);
+        destroyCache(cache);
+    }
+
+    //Read-through without scans, every thread reading the same skewed stream
+    for (int policy = CACHE_LRU; policy <= CACHE_CLOCK; policy++) {
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            ShardedCache* cache = createShardedCache(capacity, policy, NULL, 4 * threads);
+            pthread_t* ids = malloc(sizeof(pthread_t) * threads);
+            Worker* workers = malloc(sizeof(Worker) * threads);
+
+            double start = now();
+            for (int t = 0; t < threads; t++) {
+                workers[t] = (Worker){cache, names, stream, operations, 0};
+                pthread_create(&ids[t], NULL, readWorker, &workers[t]);
+            }
+            long hits = 0;
+            for (int t = 0; t < threads; t++) {
+                pthread_join(ids[t], NULL);
+                hits += workers[t].hits;
+            }
+            double elapsed = now() - start;
+
+            bool last = policy == CACHE_CLOCK && threads * 2 > maxThreads;
+            printf("  {\"policy\": \"%s\", \"threads\": %d, \"sharded\": true, \"shards\": %d, \"hitRatio\": %.4f, \"operationsPerSecond\": %.0f}%s\n",
+                   policyNames[policy], threads, cache->numShards, (double)hits / (operations * threads),
+                   operations * threads / elapsed, last ? "" : ",");
+
+            destroyShardedCache(cache);
+            free(ids);
+            free(workers);
+        }
+    }
+    printf("]}\n");
+
+    free(stream);
+    free(names);
+
+    return 0;
+}
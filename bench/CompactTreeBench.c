@@ -0,0 +1,97 @@
+/**
+ * Benchmark for CompactTreeAPI against an AVL Tree on random long keys:
+ * build time, point lookups, half of them misses, and the bytes per node
+ * each layout holds. The compact tree runs once storing pointers to the
+ * keys and once storing the keys inline.
+ * Usage: CompactTreeBench [keys] [lookups]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../BinarySearchTreeAPI.h"
+#include "../CompactTreeAPI.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long nextRandom(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int compareLongs(const void* a, const void* b) {
+    long x = *(const long*)a;
+    long y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+static size_t totalBytes(MemoryUsage usage) {
+    return usage.payload + usage.metadata + usage.slack;
+}
+
+static void printResult(const char* structure, double build, double find, long lookups, long hits, MemoryUsage usage, long n, bool last) {
+    printf("  {\"structure\": \"%s\", \"buildSeconds\": %.3f, \"nsPerLookup\": %.1f, \"hits\": %ld, "
+           "\"bytes\": %zu, \"bytesPerNode\": %.1f, \"payload\": %zu, \"metadata\": %zu, \"slack\": %zu}%s\n",
+           structure, build, find * 1e9 / lookups, hits, totalBytes(usage), (double)totalBytes(usage) / n,
+           usage.payload, usage.metadata, usage.slack, last ? "" : ",");
+}
+
+int main(int argc, char** argv) {
+    long n = argc > 1 ? atol(argv[1]) : 1000000;
+    long lookups = argc > 2 ? atol(argv[2]) : 10000000;
+    unsigned long long state = 88172645463325252ULL;
+
+    //Keys are even so that odd probes miss
+    long* keys = malloc(sizeof(long) * n);
+    long* probes = malloc(sizeof(long) * lookups);
+    for (long i = 0; i < n; i++) {
+        keys[i] = (long)(nextRandom(&state) >> 2) * 2;
+    }
+    for (long i = 0; i < lookups; i++) {
+        probes[i] = keys[nextRandom(&state) % n] + (long)(nextRandom(&state) & 1);
+    }
+
+    printf("{\"benchmark\": \"CompactTree\", \"keys\": %ld, \"lookups\": %ld, \"results\": [\n", n, lookups);
+
+    double start = now();
+    Tree* tree = createBinTreeWithMode(compareLongs, NULL, NULL, TREE_AVL);
+    for (long i = 0; i < n; i++) {
+        addToTree(tree, &keys[i]);
+    }
+    double build = now() - start;
+    long hits = 0;
+    start = now();
+    for (long i = 0; i < lookups; i++) {
+        hits += findInTree(tree, &probes[i]) != NULL;
+    }
+    printResult("Tree/avl", build, now() - start, lookups, hits, getTreeMemoryUsage(tree), n, false);
+    destroyBinTree(tree);
+
+    for (int inlined = 0; inlined <= 1; inlined++) {
+        start = now();
+        CompactTree* compact = createCompactTree(compareLongs, NULL, NULL, inlined ? sizeof(long) : 0, NULL);
+        for (long i = 0; i < n; i++) {
+            addToCompactTree(compact, &keys[i]);
+        }
+        build = now() - start;
+        hits = 0;
+        start = now();
+        for (long i = 0; i < lookups; i++) {
+            hits += findInCompactTree(compact, &probes[i]) != NULL;
+        }
+        printResult(inlined ? "CompactTree/inline" : "CompactTree/pointer", build, now() - start, lookups, hits,
+                    getCompactTreeMemoryUsage(compact), n, inlined);
+        destroyCompactTree(compact);
+    }
+    printf("]}\n");
+
+    free(keys);
+    free(probes);
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * Insert, lookup, delete and scan workloads for CompactTreeAPI, storing
+ * pointers to the keys and storing the keys inline in the nodes.
+ * Usage: CompactTreeWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../CompactTreeAPI.h"
+#include "BenchHarness.h"
+
+static void* createPointers(long* keys, long numKeys) {
+    (void)keys;
+    (void)numKeys;
+    return createCompactTree(benchCompareKeys, NULL, NULL, 0, NULL);
+}
+
+static void* createInline(long* keys, long numKeys) {
+    (void)keys;
+    (void)numKeys;
+    return createCompactTree(benchCompareKeys, NULL, NULL, sizeof(long), NULL);
+}
+
+static void insertTree(void* structure, long* key) {
+    addToCompactTree(structure, key);
+}
+
+static void* lookupTree(void* structure, long* key) {
+    return findInCompactTree(structure, key);
+}
+
+static void removeTree(void* structure, long* key) {
+    removeFromCompactTree(structure, key);
+}
+
+static int countElement(void* data, void* context) {
+    (void)data;
+    (*(long*)context)++;
+    return 0;
+}
+
+static long scanTree(void* structure) {
+    long count = 0;
+    visitCompactTreeInOrder(structure, countElement, &count);
+    return count;
+}
+
+static void destroyTree(void* structure) {
+    destroyCompactTree(structure);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"CompactTree/pointer", 0, createPointers, insertTree, lookupTree, removeTree, scanTree, destroyTree},
+        {"CompactTree/inline", 0, createInline, insertTree, lookupTree, removeTree, scanTree, destroyTree}
+    };
+
+    return runBenchmarks("CompactTree", targets, 2, argc, argv);
+}
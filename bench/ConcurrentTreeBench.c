@@ -0,0 +1,158 @@
+/**
+ * Benchmark for ConcurrentTreeAPI: operations per second per thread count
+ * with 90% lookups and 10% writes (half adds, half removes) over a fixed key
+ * range, against an AVL Tree behind a reader-writer lock.
+ * Usage: ConcurrentTreeBench [keys] [opsPerThread] [maxThreads]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "../ConcurrentTreeAPI.h"
+
+typedef struct worker {
+    ConcurrentTree* concurrent;
+    Tree* locked;
+    pthread_rwlock_t* lock;
+    long* keys;    //Every key lives here for the whole run, so nothing is freed by the trees
+    long numKeys;
+    long ops;
+    unsigned int seed;
+} Worker;
+
+static void noDelete(void* data) {
+    (void)data;
+}
+
+static int compareKeys(const void* a, const void* b) {
+    long first = *(const long*)a;
+    long second = *(const long*)b;
+
+    return (first > second) - (first < second);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned int nextRandom(unsigned int* seed) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+static void* concurrentWorker(void* arg) {
+    Worker* worker = arg;
+
+    for (long i = 0; i < worker->ops; i++) {
+        unsigned int r = nextRandom(&worker->seed);
+        long* key = &worker->keys[r % worker->numKeys];
+        unsigned int op = (r >> 24) % 20;
+
+        if (op == 0) {
+            addToConcurrentTree(worker->concurrent, key);
+        }
+        else if (op == 1) {
+            removeFromConcurrentTree(worker->concurrent, key);
+        }
+        else {
+            findInConcurrentTree(worker->concurrent, key);
+        }
+    }
+
+    return NULL;
+}
+
+static void* lockedWorker(void* arg) {
+    Worker* worker = arg;
+
+    for (long i = 0; i < worker->ops; i++) {
+        unsigned int r = nextRandom(&worker->seed);
+        long* key = &worker->keys[r % worker->numKeys];
+        unsigned int op = (r >> 24) % 20;
+
+        if (op < 2) {
+            pthread_rwlock_wrlock(worker->lock);
+            if (op == 0) {
+                addToTree(worker->locked, key);
+            }
+            else if (findInTree(worker->locked, key) != NULL) {
+                //removeFromTree reports every call on stdout, which would time printf
+                Tree* tree = worker->locked;
+                tree->root = removeFromTreeSub(tree->root, key, tree->compareFunc, noDelete);
+                if (tree->root != NULL) {
+                    tree->root->parent = NULL;
+                }
+                tree->count--;
+            }
+            pthread_rwlock_unlock(worker->lock);
+        }
+        else {
+            pthread_rwlock_rdlock(worker->lock);
+            findInTree(worker->locked, key);
+            pthread_rwlock_unlock(worker->lock);
+        }
+    }
+
+    return NULL;
+}
+
+static double run(void* (*body)(void*), Worker* base, int numThreads) {
+    pthread_t threads[numThreads];
+    Worker workers[numThreads];
+
+    double start = now();
+    for (int i = 0; i < numThreads; i++) {
+        workers[i] = *base;
+        workers[i].seed = 2654435761u * (i + 1);
+        pthread_create(&threads[i], NULL, body, &workers[i]);
+    }
+    for (int i = 0; i < numThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    return base->ops * numThreads / (now() - start);
+}
+
+int main(int argc, char** argv) {
+    long numKeys = argc > 1 ? atol(argv[1]) : 1000000;
+    long ops = argc > 2 ? atol(argv[2]) : 1000000;
+    int maxThreads = argc > 3 ? atoi(argv[3]) : 8;
+
+    long* keys = malloc(sizeof(long) * numKeys);
+    for (long i = 0; i < numKeys; i++) {
+        keys[i] = i;
+    }
+
+    printf("{\"benchmark\": \"ConcurrentTree\", \"keys\": %ld, \"writePercent\": 10, \"results\": [\n", numKeys);
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        //Both trees start half full so adds and removes both find work
+        ConcurrentTree* concurrent = createConcurrentTree(compareKeys, noDelete);
+        Tree* locked = createBinTreeWithMode(compareKeys, noDelete, NULL, TREE_AVL);
+        pthread_rwlock_t lock;
+        pthread_rwlock_init(&lock, NULL);
+        for (long i = 0; i < numKeys; i += 2) {
+            addToConcurrentTree(concurrent, &keys[i]);
+            addToTree(locked, &keys[i]);
+        }
+
+        Worker base = {concurrent, locked, &lock, keys, numKeys, ops, 0};
+        double concurrentRate = run(concurrentWorker, &base, numThreads);
+        double lockedRate = run(lockedWorker, &base, numThreads);
+
+        printf("  {\"threads\": %d, \"concurrentOpsPerSecond\": %.0f, \"rwlockTreeOpsPerSecond\": %.0f}%s\n",
+               numThreads, concurrentRate, lockedRate, numThreads * 2 <= maxThreads ? "," : "");
+
+        destroyConcurrentTree(concurrent);
+        destroyBinTree(locked);
+        pthread_rwlock_destroy(&lock);
+    }
+    printf("]}\n");
+
+    free(keys);
+
+    return 0;
+}
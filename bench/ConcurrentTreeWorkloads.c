@@ -0,0 +1,40 @@
+/**
+ * Single threaded insert, lookup and delete workloads for ConcurrentTreeAPI,
+ * the cost of its synchronization without contention.
+ * bench/ConcurrentTreeBench.c measures scaling with threads.
+ * Usage: ConcurrentTreeWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../ConcurrentTreeAPI.h"
+#include "BenchHarness.h"
+
+static void* createConcurrent(long* keys, long numKeys) {
+    (void)keys;
+    (void)numKeys;
+    return createConcurrentTree(benchCompareKeys, benchNoDelete);
+}
+
+static void insertConcurrent(void* structure, long* key) {
+    addToConcurrentTree(structure, key);
+}
+
+static void* lookupConcurrent(void* structure, long* key) {
+    return findInConcurrentTree(structure, key);
+}
+
+static void removeConcurrent(void* structure, long* key) {
+    removeFromConcurrentTree(structure, key);
+}
+
+static void destroyConcurrent(void* structure) {
+    destroyConcurrentTree(structure);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"ConcurrentTree", 0, createConcurrent, insertConcurrent, lookupConcurrent, removeConcurrent, NULL, destroyConcurrent}
+    };
+
+    return runBenchmarks("ConcurrentTree", targets, 1, argc, argv);
+}
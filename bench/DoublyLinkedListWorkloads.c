@@ -0,0 +1,59 @@
+/**
+ * Insert, lookup, delete and scan workloads for DoublyLinkedListAPI.
+ * Lookups and deletes walk the list, so sizes above 10K are skipped.
+ * Usage: DoublyLinkedListWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../DoublyLinkedListAPI.h"
+#include "BenchHarness.h"
+
+static bool equalKeys(const void* first, const void* second) {
+    return *(const long*)first == *(const long*)second;
+}
+
+static void* createList(long* keys, long numKeys) {
+    (void)keys;
+    (void)numKeys;
+
+    List* list = malloc(sizeof(List));
+    *list = initializeList(NULL, benchNoDelete, benchCompareKeys);
+
+    return list;
+}
+
+static void insertList(void* structure, long* key) {
+    insertBack(structure, key);
+}
+
+static void* lookupList(void* structure, long* key) {
+    return findElement(*(List*)structure, equalKeys, key);
+}
+
+static void removeList(void* structure, long* key) {
+    deleteDataFromList(structure, key);
+}
+
+static long scanList(void* structure) {
+    ListIterator iter = createIterator(*(List*)structure);
+    long count = 0;
+
+    while (nextElement(&iter) != NULL) {
+        count++;
+    }
+
+    return count;
+}
+
+static void destroyList(void* structure) {
+    clearList(structure);
+    free(structure);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"DoublyLinkedList", 10000, createList, insertList, lookupList, removeList, scanList, destroyList}
+    };
+
+    return runBenchmarks("DoublyLinkedList", targets, 1, argc, argv);
+}
@@ -0,0 +1,66 @@
+/**
+ * Lookup workloads for FrozenTreeAPI snapshots, searched with the compare
+ * function and with integer keys. Snapshots are read-only and built in bulk.
+ * Usage: FrozenTreeWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../FrozenTreeAPI.h"
+#include "BenchHarness.h"
+
+static int compareKeyPointers(const void* a, const void* b) {
+    return benchCompareKeys(*(const TreeDataPtr*)a, *(const TreeDataPtr*)b);
+}
+
+static long long keyOf(const void* data) {
+    return *(const long*)data;
+}
+
+/**
+ * Builds a balanced tree of every key and takes a snapshot of it
+ */
+static FrozenTree* freezeKeys(long* keys, long numKeys, KeyFunc key) {
+    TreeDataPtr* sorted = malloc(sizeof(TreeDataPtr) * numKeys);
+    for (long i = 0; i < numKeys; i++) {
+        sorted[i] = &keys[i];
+    }
+    qsort(sorted, numKeys, sizeof(TreeDataPtr), compareKeyPointers);
+
+    Tree* tree = buildTreeFromSorted(sorted, numKeys, benchCompareKeys, NULL, NULL, TREE_AVL);
+    FrozenTree* frozen = key != NULL ? freezeTreeWithKeys(tree, key) : freezeTree(tree);
+
+    //The snapshot shares the keys, not the nodes
+    destroyBinTree(tree);
+    free(sorted);
+
+    return frozen;
+}
+
+static void* createFrozen(long* keys, long numKeys) {
+    return freezeKeys(keys, numKeys, NULL);
+}
+
+static void* createFrozenWithKeys(long* keys, long numKeys) {
+    return freezeKeys(keys, numKeys, keyOf);
+}
+
+static void* lookupFrozen(void* structure, long* key) {
+    return findInFrozenTree(structure, key);
+}
+
+static void* lookupFrozenKey(void* structure, long* key) {
+    return findKeyInFrozenTree(structure, *key);
+}
+
+static void destroyFrozen(void* structure) {
+    destroyFrozenTree(structure);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"FrozenTree", 0, createFrozen, NULL, lookupFrozen, NULL, NULL, destroyFrozen},
+        {"FrozenTree/keys", 0, createFrozenWithKeys, NULL, lookupFrozenKey, NULL, NULL, destroyFrozen}
+    };
+
+    return runBenchmarks("FrozenTree", targets, 2, argc, argv);
+}
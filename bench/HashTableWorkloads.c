@@ -0,0 +1,71 @@
+/**
+ * Insert, lookup, delete and scan workloads for HashTableAPI. Keys are
+ * stored as their decimal strings in a table twice the number of keys.
+ * Usage: HashTableWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../HashTableAPI.h"
+#include "BenchHarness.h"
+
+#define KEY_CHARS 24
+
+typedef struct hashBench {
+    HTable* table;
+    long* keys;
+    char (*names)[KEY_CHARS];    //Decimal string of keys[i] at names[i], the table stores pointers to them
+} HashBench;
+
+static void* createHash(long* keys, long numKeys) {
+    HashBench* bench = malloc(sizeof(HashBench));
+    bench->keys = keys;
+    bench->names = malloc(sizeof(*bench->names) * numKeys);
+    for (long i = 0; i < numKeys; i++) {
+        snprintf(bench->names[i], KEY_CHARS, "%ld", keys[i]);
+    }
+    //Open addressing without resizing, so leave room for every key
+    bench->table = createTable(numKeys * 2 + 16, hashNode, destroyNodeData, printNodeData);
+
+    return bench;
+}
+
+static void insertHash(void* structure, long* key) {
+    HashBench* bench = structure;
+    insertData(bench->table, bench->names[key - bench->keys], key);
+}
+
+static void* lookupHash(void* structure, long* key) {
+    HashBench* bench = structure;
+    return lookupData(bench->table, bench->names[key - bench->keys]);
+}
+
+static void removeHash(void* structure, long* key) {
+    HashBench* bench = structure;
+    removeData(bench->table, bench->names[key - bench->keys]);
+}
+
+static long scanHash(void* structure) {
+    HashBench* bench = structure;
+    long count = 0;
+
+    for (size_t i = 0; i < bench->table->size; i++) {
+        count += bench->table->table[i] != NULL;
+    }
+
+    return count;
+}
+
+static void destroyHash(void* structure) {
+    HashBench* bench = structure;
+    destroyTable(bench->table);
+    free(bench->names);
+    free(bench);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"HashTable", 0, createHash, insertHash, lookupHash, removeHash, scanHash, destroyHash}
+    };
+
+    return runBenchmarks("HashTable", targets, 1, argc, argv);
+}
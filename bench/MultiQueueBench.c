@@ -0,0 +1,164 @@
+/**
+ * Benchmark for MultiQueueAPI: pop throughput per thread count and the rank
+ * error caused by relaxed ordering.
+ * Usage: MultiQueueBench [items] [maxThreads]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../MultiQueueAPI.h"
+
+typedef struct worker {
+    MultiQueue* queue;
+    long* popped;    //Priorities in the order this worker popped them, NULL to skip recording
+    long* sequence;    //Global pop order of each recorded pop
+    int numPopped;
+} Worker;
+
+static atomic_long popSequence;
+
+static void noDelete(void* data) {
+    (void)data;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* popWorker(void* arg) {
+    Worker* worker = arg;
+    long priority;
+
+    while (multiQueuePop(worker->queue, &priority) != NULL) {
+        if (worker->popped != NULL) {
+            worker->popped[worker->numPopped] = priority;
+            worker->sequence[worker->numPopped] = atomic_fetch_add(&popSequence, 1);
+        }
+        worker->numPopped++;
+    }
+
+    return NULL;
+}
+
+static MultiQueue* fillQueue(int numThreads, long items) {
+    MultiQueue* queue = createMultiQueue(numThreads, MULTIQUEUE_DEFAULT_FACTOR, noDelete);
+
+    //Priorities are a shuffled permutation of 0..items-1 so every rank is known
+    long* keys = malloc(sizeof(long) * items);
+    for (long i = 0; i < items; i++) {
+        keys[i] = i;
+    }
+    srand(42);
+    for (long i = items - 1; i > 0; i--) {
+        long j = ((long)rand() * RAND_MAX + rand()) % (i + 1);
+        long tmp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = tmp;
+    }
+    for (long i = 0; i < items; i++) {
+        multiQueueInsert(queue, keys[i], (void*)(keys[i] + 1));
+    }
+    free(keys);
+
+    return queue;
+}
+
+static double runPops(int numThreads, long items, Worker* workers) {
+    MultiQueue* queue = fillQueue(numThreads, items);
+    pthread_t threads[numThreads];
+
+    atomic_store(&popSequence, 0);
+    double start = now();
+    for (int i = 0; i < numThreads; i++) {
+        workers[i].queue = queue;
+        workers[i].numPopped = 0;
+        pthread_create(&threads[i], NULL, popWorker, &workers[i]);
+    }
+    for (int i = 0; i < numThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now() - start;
+
+    destroyMultiQueue(queue);
+
+    return elapsed;
+}
+
+/**
+ * Replays the pops in global order and measures how many smaller priorities
+ * were still in the queue when each one was removed, using a Fenwick tree.
+ * The global order is taken after each pop returns, so a thread preempted in
+ * between inflates the error; run with no more threads than cores.
+ */
+static void rankError(long items, Worker* workers, int numThreads, double* mean, long* max) {
+    long* order = malloc(sizeof(long) * items);
+    int* tree = calloc(items + 1, sizeof(int));
+
+    for (int t = 0; t < numThreads; t++) {
+        for (int i = 0; i < workers[t].numPopped; i++) {
+            order[workers[t].sequence[i]] = workers[t].popped[i];
+        }
+    }
+
+    double total = 0;
+    *max = 0;
+    for (long i = 0; i < items; i++) {
+        long smallerRemoved = 0;
+        for (long j = order[i]; j > 0; j -= j & -j) {
+            smallerRemoved += tree[j];
+        }
+        long error = order[i] - smallerRemoved;
+        total += error;
+        if (error > *max) {
+            *max = error;
+        }
+        for (long j = order[i] + 1; j <= items; j += j & -j) {
+            tree[j]++;
+        }
+    }
+    *mean = total / items;
+
+    free(order);
+    free(tree);
+}
+
+int main(int argc, char** argv) {
+    long items = argc > 1 ? atol(argv[1]) : 1000000;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : 8;
+
+    printf("{\"benchmark\": \"MultiQueue\", \"items\": %ld, \"results\": [\n", items);
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        Worker workers[numThreads];
+        for (int i = 0; i < numThreads; i++) {
+            workers[i].popped = malloc(sizeof(long) * items);
+            workers[i].sequence = malloc(sizeof(long) * items);
+        }
+
+        //Throughput is measured without recording so it only times the queue
+        Worker timed[numThreads];
+        for (int i = 0; i < numThreads; i++) {
+            timed[i].popped = NULL;
+            timed[i].sequence = NULL;
+        }
+        double elapsed = runPops(numThreads, items, timed);
+
+        double mean;
+        long max;
+        runPops(numThreads, items, workers);
+        rankError(items, workers, numThreads, &mean, &max);
+
+        printf("  {\"threads\": %d, \"heaps\": %d, \"popsPerSecond\": %.0f, \"meanRankError\": %.2f, \"maxRankError\": %ld}%s\n",
+               numThreads, numThreads * MULTIQUEUE_DEFAULT_FACTOR < 2 ? 2 : numThreads * MULTIQUEUE_DEFAULT_FACTOR,
+               items / elapsed, mean, max, numThreads * 2 <= maxThreads ? "," : "");
+
+        for (int i = 0; i < numThreads; i++) {
+            free(workers[i].popped);
+            free(workers[i].sequence);
+        }
+    }
+    printf("]}\n");
+
+    return 0;
+}
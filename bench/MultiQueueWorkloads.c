@@ -0,0 +1,37 @@
+/**
+ * Single threaded insert and delete-min workloads for MultiQueueAPI with the
+ * key as priority. bench/MultiQueueBench.c measures scaling with threads.
+ * Usage: MultiQueueWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../MultiQueueAPI.h"
+#include "BenchHarness.h"
+
+static void* createMulti(long* keys, long numKeys) {
+    (void)keys;
+    (void)numKeys;
+    return createMultiQueue(1, 0, benchNoDelete);
+}
+
+static void insertMulti(void* structure, long* key) {
+    multiQueueInsert(structure, *key, key);
+}
+
+static void popMulti(void* structure, long* key) {
+    long priority;
+    (void)key;
+    multiQueuePop(structure, &priority);
+}
+
+static void destroyMulti(void* structure) {
+    destroyMultiQueue(structure);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"MultiQueue", 0, createMulti, insertMulti, NULL, popMulti, NULL, destroyMulti}
+    };
+
+    return runBenchmarks("MultiQueue", targets, 1, argc, argv);
+}
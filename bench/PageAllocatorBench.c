@@ -0,0 +1,218 @@
+/**
+ * Benchmark for page allocator backings: builds a hash table and an AVL tree
+ * of random keys with their slots and nodes from malloc and from page
+ * allocators with base, transparent huge and explicit huge pages and with
+ * each NUMA placement, then times random lookups and counts the data TLB
+ * misses they take. The keys themselves stay in malloc memory for every
+ * backing. TLB counts are null where perf_event_open is not allowed, and
+ * the stats of each allocator tell which backing the system really granted.
+ * Usage: PageAllocatorBench [keys] [lookups]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "../BinarySearchTreeAPI.h"
+#include "../HashTableAPI.h"
+
+#define KEY_CHARS 16
+
+/**
+ * One backing under test, a NULL name ends the list
+ */
+typedef struct backing {
+    const char* name;
+    bool usesMalloc;
+    PagePolicy policy;
+} Backing;
+
+static int compareKeys(const void* a, const void* b) {
+    long first = *(const long*)a;
+    long second = *(const long*)b;
+
+    return (first > second) - (first < second);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long nextRandom(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * Opens a counter of data TLB read misses in user space
+ * @return file descriptor, -1 if the kernel or a container does not allow it
+ */
+static int openTlbCounter(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void startCounter(int fd) {
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+/**
+ * Stops a counter
+ * @return the count, -1 if there is no counter
+ */
+static long long stopCounter(int fd) {
+    long long value = -1;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &value, sizeof(value)) != sizeof(value)) {
+            value = -1;
+        }
+    }
+    return value;
+}
+
+/**
+ * Reads AnonHugePages of the whole process, the anonymous memory the kernel backs with transparent huge pages
+ * @return kilobytes, 0 if it cannot be read
+ */
+static size_t transparentHugeKilobytes(void) {
+    FILE* rollup = fopen("/proc/self/smaps_rollup", "r");
+    if (rollup == NULL) {
+        return 0;
+    }
+
+    char line[128];
+    size_t kilobytes = 0;
+    while (fgets(line, sizeof(line), rollup) != NULL) {
+        if (sscanf(line, "AnonHugePages: %zu kB", &kilobytes) == 1) {
+            break;
+        }
+    }
+
+    fclose(rollup);
+    return kilobytes;
+}
+
+static void printTlbMisses(const char* structure, long long misses, long lookups) {
+    if (misses < 0) {
+        printf("\"%sTlbMissesPerLookup\": null", structure);
+    }
+    else {
+        printf("\"%sTlbMissesPerLookup\": %.3f", structure, (double)misses / lookups);
+    }
+}
+
+int main(int argc, char** argv) {
+    long n = argc > 1 ? atol(argv[1]) : 4000000;
+    long lookups = argc > 2 ? atol(argv[2]) : 10000000;
+    unsigned long long state = 88172645463325252ULL;
+
+    long* keys = malloc(sizeof(long) * n);
+    char (*names)[KEY_CHARS] = malloc(sizeof(*names) * n);
+    long* probes = malloc(sizeof(long) * lookups);
+    for (long i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    for (long i = n - 1; i > 0; i--) {
+        long j = nextRandom(&state) % (i + 1);
+        long tmp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = tmp;
+    }
+    for (long i = 0; i < n; i++) {
+        snprintf(names[i], KEY_CHARS, "k%ld", keys[i]);
+    }
+    for (long i = 0; i < lookups; i++) {
+        probes[i] = nextRandom(&state) % n;
+    }
+
+    const Backing backings[] = {
+        {"malloc", true, {PAGES_SMALL, NUMA_DEFAULT, 0}},
+        {"basePages", false, {PAGES_SMALL, NUMA_DEFAULT, 0}},
+        {"transparentHuge", false, {PAGES_TRANSPARENT, NUMA_DEFAULT, 0}},
+        {"explicitHuge", false, {PAGES_EXPLICIT, NUMA_DEFAULT, 0}},
+        {"transparentHugeLocal", false, {PAGES_TRANSPARENT, NUMA_LOCAL, 0}},
+        {"transparentHugeInterleaved", false, {PAGES_TRANSPARENT, NUMA_INTERLEAVE, 0}},
+        {NULL, false, {PAGES_SMALL, NUMA_DEFAULT, 0}}
+    };
+
+    int tlbCounter = openTlbCounter();
+
+    printf("{\"benchmark\": \"PageAllocator\", \"keys\": %ld, \"lookups\": %ld, \"results\": [\n", n, lookups);
+    for (int b = 0; backings[b].name != NULL; b++) {
+        Allocator* allocator = backings[b].usesMalloc ? NULL : createPageAllocator(backings[b].policy);
+        size_t hugeBefore = transparentHugeKilobytes();
+
+        HTable* table = createTableWithAllocator(n * 2 + 16, hashNode, destroyNodeData, printNodeData, allocator);
+        Tree* tree = createBinTreeWithAllocator(compareKeys, NULL, NULL, TREE_AVL, allocator);
+        for (long i = 0; i < n; i++) {
+            insertData(table, names[i], &keys[i]);
+            addToTree(tree, &keys[i]);
+        }
+        size_t hugeKilobytes = transparentHugeKilobytes() - hugeBefore;
+
+        long tableHits = 0;
+        startCounter(tlbCounter);
+        double start = now();
+        for (long i = 0; i < lookups; i++) {
+            tableHits += lookupData(table, names[probes[i]]) != NULL;
+        }
+        double tableSeconds = now() - start;
+        long long tableMisses = stopCounter(tlbCounter);
+
+        long treeHits = 0;
+        startCounter(tlbCounter);
+        start = now();
+        for (long i = 0; i < lookups; i++) {
+            treeHits += findInTree(tree, &keys[probes[i]]) != NULL;
+        }
+        double treeSeconds = now() - start;
+        long long treeMisses = stopCounter(tlbCounter);
+
+        if (tableHits != lookups || treeHits != lookups) {
+            fprintf(stderr, "%s: %ld table and %ld tree hits of %ld\n", backings[b].name, tableHits, treeHits, lookups);
+        }
+
+        PageStats stats = getPageAllocatorStats(allocator);
+        printf("  {\"backing\": \"%s\", \"tableNsPerLookup\": %.1f, ", backings[b].name, tableSeconds * 1e9 / lookups);
+        printTlbMisses("table", tableMisses, lookups);
+        printf(", \"treeNsPerLookup\": %.1f, ", treeSeconds * 1e9 / lookups);
+        printTlbMisses("tree", treeMisses, lookups);
+        printf(", \"mappedBytes\": %zu, \"explicitHugeBytes\": %zu, \"transparentHugeBytes\": %zu, \"anonHugeKilobytes\": %zu, "
+               "\"placedBytes\": %zu, \"numaNodes\": %d}%s\n",
+               stats.mappedBytes, stats.explicitHugeBytes, stats.transparentHugeBytes, hugeKilobytes,
+               stats.placedBytes, stats.numaNodes, backings[b + 1].name != NULL ? "," : "");
+
+        destroyBinTree(tree);
+        destroyTable(table);
+        destroyPageAllocator(allocator);
+    }
+    printf("]}\n");
+
+    if (tlbCounter >= 0) {
+        close(tlbCounter);
+    }
+    free(keys);
+    free(names);
+    free(probes);
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * Benchmark for visitParallel: summing every element of a large tree with
+ * one context per thread, against a single threaded visitInOrder.
+ * The default 50M nodes take about 3GB, pass a smaller count on small machines.
+ * Usage: ParallelVisitBench [keys] [maxThreads]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../BinarySearchTreeAPI.h"
+
+typedef struct sumContext {
+    long long sum;
+    char padding[56];    //Keeps each thread's running total on its own cache line
+} SumContext;
+
+static void noDelete(void* data) {
+    (void)data;
+}
+
+static int compareKeys(const void* a, const void* b) {
+    long first = *(const long*)a;
+    long second = *(const long*)b;
+
+    return (first > second) - (first < second);
+}
+
+static int addToSum(void* data, void* context) {
+    ((SumContext*)context)->sum += *(long*)data;
+    return 0;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    long numKeys = argc > 1 ? atol(argv[1]) : 50000000;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : 8;
+
+    long* keys = malloc(sizeof(long) * numKeys);
+    TreeDataPtr* data = malloc(sizeof(TreeDataPtr) * numKeys);
+    for (long i = 0; i < numKeys; i++) {
+        keys[i] = i;
+        data[i] = &keys[i];
+    }
+    Tree* tree = buildTreeFromSorted(data, numKeys, compareKeys, noDelete, NULL, TREE_AVL);
+    free(data);
+
+    SumContext single = {0};
+    double start = now();
+    visitInOrder(tree, addToSum, &single);
+    double singleElapsed = now() - start;
+
+    printf("{\"benchmark\": \"ParallelVisit\", \"keys\": %ld, \"inOrderSeconds\": %.3f, \"results\": [\n", numKeys, singleElapsed);
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        SumContext* sums = calloc(numThreads, sizeof(SumContext));
+        void* contexts[numThreads];
+        for (int i = 0; i < numThreads; i++) {
+            contexts[i] = &sums[i];
+        }
+
+        start = now();
+        visitParallel(tree, addToSum, contexts, numThreads);
+        double elapsed = now() - start;
+
+        long long total = 0;
+        for (int i = 0; i < numThreads; i++) {
+            total += sums[i].sum;
+        }
+
+        printf("  {\"threads\": %d, \"seconds\": %.3f, \"speedup\": %.2f, \"sumMatches\": %s}%s\n",
+               numThreads, elapsed, singleElapsed / elapsed, total == single.sum ? "true" : "false",
+               numThreads * 2 <= maxThreads ? "," : "");
+        free(sums);
+    }
+    printf("]}\n");
+
+    destroyBinTree(tree);
+    free(keys);
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * Insert, lookup, delete and scan workloads for PersistentTreeAPI. Each
+ * update makes a new version and releases the previous one, so the cost
+ * includes copying the path and freeing the replaced nodes.
+ * Usage: PersistentTreeWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../PersistentTreeAPI.h"
+#include "BenchHarness.h"
+
+typedef struct persistentBench {
+    PersistentTree* version;
+    TreeDataPtr* buffer;    //Scan output, one slot per key
+    long numKeys;
+} PersistentBench;
+
+static void* createPersistent(long* keys, long numKeys) {
+    (void)keys;
+
+    PersistentBench* bench = malloc(sizeof(PersistentBench));
+    bench->version = createPersistentTree(benchCompareKeys, benchNoDelete, NULL);
+    bench->buffer = malloc(sizeof(TreeDataPtr) * numKeys);
+    bench->numKeys = numKeys;
+
+    return bench;
+}
+
+/**
+ * Makes next the current version unless it could not be created
+ */
+static void replaceVersion(PersistentBench* bench, PersistentTree* next) {
+    if (next != NULL) {
+        releasePersistentTree(bench->version);
+        bench->version = next;
+    }
+}
+
+static void insertPersistent(void* structure, long* key) {
+    PersistentBench* bench = structure;
+    replaceVersion(bench, addToPersistentTree(bench->version, key));
+}
+
+static void* lookupPersistent(void* structure, long* key) {
+    return findInPersistentTree(((PersistentBench*)structure)->version, key);
+}
+
+static void removePersistent(void* structure, long* key) {
+    PersistentBench* bench = structure;
+    replaceVersion(bench, removeFromPersistentTree(bench->version, key));
+}
+
+static long scanPersistent(void* structure) {
+    PersistentBench* bench = structure;
+    return persistentTreeToArray(bench->version, bench->buffer, (int)bench->numKeys);
+}
+
+static void destroyPersistent(void* structure) {
+    PersistentBench* bench = structure;
+    releasePersistentTree(bench->version);
+    free(bench->buffer);
+    free(bench);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"PersistentTree", 0, createPersistent, insertPersistent, lookupPersistent, removePersistent, scanPersistent, destroyPersistent}
+    };
+
+    return runBenchmarks("PersistentTree", targets, 1, argc, argv);
+}
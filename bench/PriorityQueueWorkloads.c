@@ -0,0 +1,37 @@
+/**
+ * Insert and delete-min workloads for the heap mode of PriorityQueueAPI.
+ * The delete workload pops the best item, whatever the key.
+ * Usage: PriorityQueueWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../PriorityQueueAPI.h"
+#include "BenchHarness.h"
+
+static void* createHeap(long* keys, long numKeys) {
+    (void)keys;
+    (void)numKeys;
+
+    return createQueueFromArray(NULL, benchNoDelete, benchCompareKeys, NULL, 0);
+}
+
+static void insertHeap(void* structure, long* key) {
+    insert(structure, key);
+}
+
+static void popHeap(void* structure, long* key) {
+    (void)key;
+    pop(structure);
+}
+
+static void destroyHeap(void* structure) {
+    destroy(structure);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"PriorityQueue/heap", 0, createHeap, insertHeap, NULL, popHeap, NULL, destroyHeap}
+    };
+
+    return runBenchmarks("PriorityQueue", targets, 1, argc, argv);
+}
@@ -0,0 +1,126 @@
+/**
+ * Benchmark for RadixTreeAPI against HashTableAPI on hierarchical string keys
+ * of the form tenant/user/item: point lookups, half of them misses, one
+ * tenant's prefix scan against filtering every slot of the table, and the
+ * bytes each structure holds.
+ * Usage: RadixTreeBench [keys] [lookups]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../HashTableAPI.h"
+#include "../RadixTreeAPI.h"
+
+//Room for both fields at the full width of a long
+#define KEY_CHARS 64
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long nextRandom(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int countKey(const char* key, void* data, void* context) {
+    (void)key;
+    (void)data;
+    (*(long*)context)++;
+    return 0;
+}
+
+static size_t totalBytes(MemoryUsage usage) {
+    return usage.payload + usage.metadata + usage.slack;
+}
+
+int main(int argc, char** argv) {
+    long n = argc > 1 ? atol(argv[1]) : 1000000;
+    long lookups = argc > 2 ? atol(argv[2]) : 10000000;
+    long tenants = n / 10000 + 1;
+    unsigned long long state = 88172645463325252ULL;
+
+    //Every other user number is left out so half of the probes miss
+    char (*keys)[KEY_CHARS] = malloc(sizeof(*keys) * n);
+    char (*probes)[KEY_CHARS] = malloc(sizeof(*probes) * lookups);
+    for (long i = 0; i < n; i++) {
+        snprintf(keys[i], KEY_CHARS, "tenant%04ld/user%08ld/profile", i % tenants, 2 * (i / tenants));
+    }
+    for (long i = 0; i < lookups; i++) {
+        long k = nextRandom(&state) % (2 * n);
+        snprintf(probes[i], KEY_CHARS, "tenant%04ld/user%08ld/profile", (k / 2) % tenants, 2 * ((k / 2) / tenants) + (k & 1));
+    }
+
+    double start = now();
+    HTable* table = createTable(n * 2 + 16, hashNode, destroyNodeData, printNodeData);
+    for (long i = 0; i < n; i++) {
+        insertData(table, keys[i], keys[i]);
+    }
+    double tableBuild = now() - start;
+
+    start = now();
+    RadixTree* radixTree = createRadixTree(NULL);
+    for (long i = 0; i < n; i++) {
+        addToRadixTree(radixTree, keys[i], keys[i]);
+    }
+    double radixBuild = now() - start;
+
+    long tableHits = 0;
+    start = now();
+    for (long i = 0; i < lookups; i++) {
+        tableHits += lookupData(table, probes[i]) != NULL;
+    }
+    double tableFind = now() - start;
+
+    long radixHits = 0;
+    start = now();
+    for (long i = 0; i < lookups; i++) {
+        radixHits += findInRadixTree(radixTree, probes[i]) != NULL;
+    }
+    double radixFind = now() - start;
+
+    //Everything stored for one tenant
+    char prefix[KEY_CHARS];
+    snprintf(prefix, KEY_CHARS, "tenant%04ld/", tenants / 2);
+    size_t prefixLength = strlen(prefix);
+
+    long tableMatches = 0;
+    start = now();
+    for (size_t i = 0; i < table->size; i++) {
+        if (table->table[i] != NULL && strncmp(table->table[i]->key, prefix, prefixLength) == 0) {
+            tableMatches++;
+        }
+    }
+    double tableScan = now() - start;
+
+    long radixMatches = 0;
+    start = now();
+    visitRadixPrefix(radixTree, prefix, countKey, &radixMatches);
+    double radixScan = now() - start;
+
+    MemoryUsage tableUsage = getTableMemoryUsage(table);
+    MemoryUsage radixUsage = getRadixTreeMemoryUsage(radixTree);
+
+    printf("{\"benchmark\": \"RadixTree\", \"keys\": %ld, \"lookups\": %ld, \"tenants\": %ld, \"results\": [\n", n, lookups, tenants);
+    printf("  {\"structure\": \"HashTable\", \"buildSeconds\": %.3f, \"nsPerLookup\": %.1f, \"hits\": %ld, \"prefixScanSeconds\": %.6f, \"prefixMatches\": %ld, "
+           "\"bytes\": %zu, \"payload\": %zu, \"metadata\": %zu, \"slack\": %zu},\n",
+           tableBuild, tableFind * 1e9 / lookups, tableHits, tableScan, tableMatches,
+           totalBytes(tableUsage), tableUsage.payload, tableUsage.metadata, tableUsage.slack);
+    printf("  {\"structure\": \"RadixTree\", \"buildSeconds\": %.3f, \"nsPerLookup\": %.1f, \"hits\": %ld, \"prefixScanSeconds\": %.6f, \"prefixMatches\": %ld, "
+           "\"bytes\": %zu, \"payload\": %zu, \"metadata\": %zu, \"slack\": %zu}\n",
+           radixBuild, radixFind * 1e9 / lookups, radixHits, radixScan, radixMatches,
+           totalBytes(radixUsage), radixUsage.payload, radixUsage.metadata, radixUsage.slack);
+    printf("]}\n");
+
+    destroyRadixTree(radixTree);
+    destroyTable(table);
+    free(keys);
+    free(probes);
+
+    return 0;
+}
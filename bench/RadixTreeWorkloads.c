@@ -0,0 +1,76 @@
+/**
+ * Insert, lookup, delete and scan workloads for RadixTreeAPI. Keys are
+ * stored as zero padded decimal strings, so string order is numeric order
+ * and neighbouring keys share long prefixes.
+ * Usage: RadixTreeWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../RadixTreeAPI.h"
+#include "BenchHarness.h"
+
+#define KEY_CHARS 24
+
+typedef struct radixBench {
+    RadixTree* tree;
+    long* keys;
+    char (*names)[KEY_CHARS];    //Padded string of keys[i] at names[i], the tree stores pointers to them
+} RadixBench;
+
+static void* createRadix(long* keys, long numKeys) {
+    RadixBench* bench = malloc(sizeof(RadixBench));
+    bench->keys = keys;
+    bench->names = malloc(sizeof(*bench->names) * numKeys);
+    for (long i = 0; i < numKeys; i++) {
+        snprintf(bench->names[i], KEY_CHARS, "%020ld", keys[i]);
+    }
+    bench->tree = createRadixTree(NULL);
+
+    return bench;
+}
+
+static void insertRadix(void* structure, long* key) {
+    RadixBench* bench = structure;
+    addToRadixTree(bench->tree, bench->names[key - bench->keys], key);
+}
+
+static void* lookupRadix(void* structure, long* key) {
+    RadixBench* bench = structure;
+    return findInRadixTree(bench->tree, bench->names[key - bench->keys]);
+}
+
+static void removeRadix(void* structure, long* key) {
+    RadixBench* bench = structure;
+    removeFromRadixTree(bench->tree, bench->names[key - bench->keys]);
+}
+
+static int countKey(const char* key, void* data, void* context) {
+    (void)key;
+    (void)data;
+    (*(long*)context)++;
+    return 0;
+}
+
+static long scanRadix(void* structure) {
+    RadixBench* bench = structure;
+    long count = 0;
+
+    visitRadixTree(bench->tree, countKey, &count);
+
+    return count;
+}
+
+static void destroyRadix(void* structure) {
+    RadixBench* bench = structure;
+    destroyRadixTree(bench->tree);
+    free(bench->names);
+    free(bench);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"RadixTree", 0, createRadix, insertRadix, lookupRadix, removeRadix, scanRadix, destroyRadix}
+    };
+
+    return runBenchmarks("RadixTree", targets, 1, argc, argv);
+}
@@ -0,0 +1,160 @@
+/**
+ * Benchmark for TREE_SPLAY: findInTree with Zipf distributed keys, comparing
+ * the average depth of the node found and the comparisons per lookup against
+ * the unbalanced and AVL modes built from the same shuffled keys.
+ * The hottest keys are spread over the key range at random. The default
+ * exponent of 1.2 sends about 90% of lookups to 1% of a million keys.
+ * Usage: SplayTreeBench [keys] [lookups] [zipfExponent]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../BinarySearchTreeAPI.h"
+
+static long comparisons;
+
+static void noDelete(void* data) {
+    (void)data;
+}
+
+static int compareKeys(const void* a, const void* b) {
+    long first = *(const long*)a;
+    long second = *(const long*)b;
+
+    comparisons++;
+    return (first > second) - (first < second);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double uniform(void) {
+    return ((double)rand() * RAND_MAX + rand()) / ((double)RAND_MAX * RAND_MAX + RAND_MAX + 1);
+}
+
+static void shuffle(long* values, long n) {
+    for (long i = n - 1; i > 0; i--) {
+        long j = (long)(uniform() * (i + 1));
+        long tmp = values[i];
+        values[i] = values[j];
+        values[j] = tmp;
+    }
+}
+
+/**
+ * Draws lookups from a Zipf distribution over ranks, then maps each rank to a random key
+ */
+static long* zipfLookups(long numKeys, long lookups, double exponent) {
+    double* cdf = malloc(sizeof(double) * numKeys);
+    long* keyOfRank = malloc(sizeof(long) * numKeys);
+    long* result = malloc(sizeof(long) * lookups);
+
+    double total = 0;
+    for (long i = 0; i < numKeys; i++) {
+        total += 1.0 / pow(i + 1, exponent);
+        cdf[i] = total;
+        keyOfRank[i] = i;
+    }
+    shuffle(keyOfRank, numKeys);
+
+    for (long i = 0; i < lookups; i++) {
+        double target = uniform() * total;
+        long lo = 0;
+        long hi = numKeys - 1;
+        while (lo < hi) {
+            long mid = (lo + hi) / 2;
+            if (cdf[mid] < target) {
+                lo = mid + 1;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        result[i] = keyOfRank[lo];
+    }
+
+    free(cdf);
+    free(keyOfRank);
+    return result;
+}
+
+/**
+ * Depth of the node holding key, counting the root as 0
+ */
+static int depthOf(Tree* tree, long key) {
+    int depth = 0;
+
+    for (TreeNode* node = tree->root; node != NULL; depth++) {
+        long nodeKey = *(long*)node->data;
+        if (nodeKey == key) {
+            return depth;
+        }
+        node = nodeKey < key ? node->right : node->left;
+    }
+
+    return depth;
+}
+
+int main(int argc, char** argv) {
+    long numKeys = argc > 1 ? atol(argv[1]) : 1000000;
+    long lookups = argc > 2 ? atol(argv[2]) : 10000000;
+    double exponent = argc > 3 ? atof(argv[3]) : 1.2;
+
+    srand(42);
+    long* keys = malloc(sizeof(long) * numKeys);
+    for (long i = 0; i < numKeys; i++) {
+        keys[i] = i;
+    }
+    long* queries = zipfLookups(numKeys, lookups, exponent);
+    shuffle(keys, numKeys);
+
+    const char* names[] = {"unbalanced", "avl", "splay"};
+    TreeMode modes[] = {TREE_UNBALANCED, TREE_AVL, TREE_SPLAY};
+
+    printf("{\"benchmark\": \"SplayTree\", \"keys\": %ld, \"lookups\": %ld, \"zipfExponent\": %.2f, \"results\": [\n",
+           numKeys, lookups, exponent);
+    for (int m = 0; m < 3; m++) {
+        Tree* tree = createBinTreeWithMode(compareKeys, noDelete, NULL, modes[m]);
+        for (long i = 0; i < numKeys; i++) {
+            addToTree(tree, &keys[i]);
+        }
+
+        //A tenth of the lookups warm the tree up, so splay mode is measured once hot keys have risen
+        long warmup = lookups / 10;
+        for (long i = 0; i < warmup; i++) {
+            findInTree(tree, &queries[i]);
+        }
+
+        comparisons = 0;
+        double start = now();
+        for (long i = warmup; i < lookups; i++) {
+            findInTree(tree, &queries[i]);
+        }
+        double elapsed = now() - start;
+        long timed = lookups - warmup;
+
+        //Depth is sampled on the warm-up lookups replayed afterwards, outside the timed loop
+        long sampled = warmup < 100000 ? warmup : 100000;
+        double depthTotal = 0;
+        for (long i = 0; i < sampled; i++) {
+            depthTotal += depthOf(tree, queries[i]);
+            findInTree(tree, &queries[i]);
+        }
+
+        printf("  {\"mode\": \"%s\", \"averageDepth\": %.2f, \"comparisonsPerLookup\": %.2f, \"lookupsPerSecond\": %.0f, \"height\": %d}%s\n",
+               names[m], sampled > 0 ? depthTotal / sampled : 0.0, timed > 0 ? (double)comparisons / timed : 0.0,
+               timed > 0 ? timed / elapsed : 0.0, getHeight(tree->root), m < 2 ? "," : "");
+
+        destroyBinTree(tree);
+    }
+    printf("]}\n");
+
+    free(keys);
+    free(queries);
+
+    return 0;
+}
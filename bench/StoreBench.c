@@ -0,0 +1,157 @@
+/**
+ * Benchmark for StoreAPI: ingest throughput with background flushes and
+ * compactions, random gets of stored and missing keys with the runs probed
+ * and skipped per get, and range scan throughput. Ends with the write
+ * amplification of the ingest.
+ * Usage: StoreBench [keys] [valueBytes] [gets] [memtableBytes] [directory]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "../StoreAPI.h"
+
+#define KEY_CHARS 24
+#define SCAN_KEYS 1000    //Keys read by one range scan
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long nextRandom(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int countKey(const char* key, const void* value, size_t length, void* context) {
+    (void)key;
+    (void)value;
+    (void)length;
+    return ++*(long*)context >= SCAN_KEYS;
+}
+
+/**
+ * Deletes the files of a store and then its directory
+ */
+static void removeDirectory(const char* path) {
+    DIR* directory = opendir(path);
+    struct dirent* file;
+
+    while (directory != NULL && (file = readdir(directory)) != NULL) {
+        if (file->d_name[0] != '.') {
+            size_t length = strlen(path) + strlen(file->d_name) + 2;
+            char* name = malloc(length);
+            if (name != NULL) {
+                snprintf(name, length, "%s/%s", path, file->d_name);
+                unlink(name);
+                free(name);
+            }
+        }
+    }
+    if (directory != NULL) {
+        closedir(directory);
+    }
+    rmdir(path);
+}
+
+/**
+ * Times gets of random keys, with the key prefix for stored ones and miss for missing ones
+ */
+static void timeGets(Store* store, long numKeys, long gets, bool stored, unsigned long long* state, bool last) {
+    StoreStats before = getStoreStats(store);
+    char key[KEY_CHARS];
+    long found = 0;
+
+    double start = now();
+    for (long i = 0; i < gets; i++) {
+        snprintf(key, KEY_CHARS, stored ? "key%012lld" : "miss%011lld", (long long)(nextRandom(state) % numKeys));
+        void* value = getFromStore(store, key, NULL);
+        if (value != NULL) {
+            found++;
+            free(value);
+        }
+    }
+    double elapsed = now() - start;
+
+    StoreStats after = getStoreStats(store);
+    printf("  {\"phase\": \"get\", \"keys\": \"%s\", \"gets\": %ld, \"found\": %ld, \"nsPerGet\": %.1f, \"runs\": %d, \"runsProbedPerGet\": %.3f, \"bloomSkipsPerGet\": %.3f}%s\n",
+           stored ? "stored" : "missing", gets, found, elapsed * 1e9 / gets, after.runs,
+           (double)(after.runsProbed - before.runsProbed) / gets, (double)(after.bloomSkips - before.bloomSkips) / gets, last ? "" : ",");
+}
+
+int main(int argc, char** argv) {
+    long numKeys = argc > 1 ? atol(argv[1]) : 1000000;
+    long valueBytes = argc > 2 ? atol(argv[2]) : 100;
+    long gets = argc > 3 ? atol(argv[3]) : 200000;
+    size_t memtableBytes = argc > 4 ? (size_t)atol(argv[4]) : STORE_DEFAULT_MEMTABLE_BYTES;
+    char directory[] = "/tmp/StoreBenchXXXXXX";
+    const char* path = argc > 5 ? argv[5] : mkdtemp(directory);
+    unsigned long long state = 88172645463325252ULL;
+
+    Store* store = path != NULL ? openStore(path, memtableBytes) : NULL;
+    if (store == NULL) {
+        fprintf(stderr, "StoreBench: cannot open a store in %s\n", path != NULL ? path : "/tmp");
+        return 1;
+    }
+
+    char* value = malloc(valueBytes > 0 ? valueBytes : 1);
+    memset(value, 'v', valueBytes);
+    char key[KEY_CHARS];
+
+    printf("{\"benchmark\": \"Store\", \"keys\": %ld, \"valueBytes\": %ld, \"memtableBytes\": %zu, \"results\": [\n",
+           numKeys, valueBytes, memtableBytes);
+
+    //Keys arrive in random order, so every run overlaps every other one
+    double start = now();
+    for (long i = 0; i < numKeys; i++) {
+        snprintf(key, KEY_CHARS, "key%012lld", (long long)(nextRandom(&state) % numKeys));
+        putInStore(store, key, value, valueBytes);
+    }
+    double putElapsed = now() - start;
+    flushStore(store);
+    waitForStore(store);
+    double ingestElapsed = now() - start;
+
+    StoreStats stats = getStoreStats(store);
+    printf("  {\"phase\": \"ingest\", \"putsPerSecond\": %.0f, \"mbPerSecond\": %.1f, \"secondsWithCompaction\": %.3f, \"flushes\": %zu, \"compactions\": %zu, \"runs\": %d},\n",
+           numKeys / putElapsed, numKeys * (double)(valueBytes + 15) / putElapsed / 1e6, ingestElapsed,
+           stats.flushes, stats.compactions, stats.runs);
+
+    timeGets(store, numKeys, gets, true, &state, false);
+    timeGets(store, numKeys, gets, false, &state, false);
+
+    long scans = gets / SCAN_KEYS > 0 ? gets / SCAN_KEYS : 1;
+    long scanned = 0;
+    start = now();
+    for (long i = 0; i < scans; i++) {
+        long count = 0;
+        snprintf(key, KEY_CHARS, "key%012lld", (long long)(nextRandom(&state) % numKeys));
+        visitStoreRange(store, key, NULL, countKey, &count);
+        scanned += count;
+    }
+    double elapsed = now() - start;
+    printf("  {\"phase\": \"scan\", \"scans\": %ld, \"keysPerScan\": %.1f, \"nsPerKey\": %.1f},\n",
+           scans, (double)scanned / scans, elapsed * 1e9 / (scanned > 0 ? scanned : 1));
+
+    stats = getStoreStats(store);
+    double userBytes = numKeys * (double)(valueBytes + 15);
+    printf("  {\"phase\": \"total\", \"runs\": %d, \"runBytes\": %zu, \"bytesWritten\": %zu, \"writeAmplification\": %.2f}\n",
+           stats.runs, stats.runBytes, stats.bytesWritten, stats.bytesWritten / userBytes);
+    printf("]}\n");
+
+    closeStore(store);
+    free(value);
+
+    //Remove the store unless the caller picked the directory
+    if (argc <= 5) {
+        removeDirectory(directory);
+    }
+
+    return 0;
+}
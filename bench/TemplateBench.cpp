@@ -0,0 +1,177 @@
+/**
+ * Benchmark for the header-only templates in cpp/ against the C APIs they
+ * mirror. The C structures store void pointers and call compare and hash
+ * through function pointers; the templates store the elements inline and
+ * get the comparator and hasher as template parameters, so the same
+ * algorithms run with every call inlined. Both sides get the same keys in
+ * the same order.
+ * TemplateQueueBench does the same for the priority queue and sorted list.
+ * Usage: TemplateBench [keys] [lookups]
+ */
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "../cpp/HashTable.hpp"
+#include "../cpp/Tree.hpp"
+
+//The C headers use C11 spellings C++ does not have
+#define _Alignas(n) alignas(n)
+extern "C" {
+#include "../BinarySearchTreeAPI.h"
+#include "../HashTableAPI.h"
+}
+#undef _Alignas
+
+#define KEY_CHARS 24
+
+static int results = 0;
+
+static double benchNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long benchRandom(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void printBenchResult(const char* structure, const char* operation, double cSeconds, double templateSeconds, long operations, long check) {
+    printf("%s\n  {\"structure\": \"%s\", \"operation\": \"%s\", \"operations\": %ld, \"check\": %ld, "
+           "\"cNsPerOp\": %.1f, \"templateNsPerOp\": %.1f, \"speedup\": %.2f}",
+           results++ > 0 ? "," : "", structure, operation, operations, check, cSeconds * 1e9 / operations, templateSeconds * 1e9 / operations,
+           cSeconds / templateSeconds);
+}
+
+//Same djb2 as hashNode, lower casing every byte, but without the modulo
+struct Djb2Hash {
+    std::size_t operator()(std::string_view key) const {
+        unsigned long hash = 5381;
+        for (char c : key) {
+            hash = ((hash << 5) + hash) + std::tolower(static_cast<unsigned char>(c));
+        }
+        return hash;
+    }
+};
+
+static int compareLong(const void* first, const void* second) {
+    long a = *static_cast<const long*>(first);
+    long b = *static_cast<const long*>(second);
+    return (a > b) - (a < b);
+}
+
+static void benchTree(const std::vector<long>& values, const std::vector<long>& probes) {
+    long n = static_cast<long>(values.size());
+    long lookups = static_cast<long>(probes.size());
+
+    double start = benchNow();
+    Tree* cTree = createBinTreeWithMode(compareLong, NULL, NULL, TREE_AVL);
+    for (long i = 0; i < n; i++) {
+        addToTree(cTree, const_cast<long*>(&values[i]));
+    }
+    double cBuild = benchNow() - start;
+
+    long cHits = 0;
+    start = benchNow();
+    for (long i = 0; i < lookups; i++) {
+        cHits += findInTree(cTree, const_cast<long*>(&probes[i])) != NULL;
+    }
+    double cFind = benchNow() - start;
+    destroyBinTree(cTree);
+
+    start = benchNow();
+    ds::Tree<long> tree;
+    for (long i = 0; i < n; i++) {
+        tree.insert(values[i]);
+    }
+    double templateBuild = benchNow() - start;
+
+    long templateHits = 0;
+    start = benchNow();
+    for (long i = 0; i < lookups; i++) {
+        templateHits += tree.find(probes[i]) != nullptr;
+    }
+    double templateFind = benchNow() - start;
+
+    printBenchResult("Tree", "insert", cBuild, templateBuild, n, n);
+    printBenchResult("Tree", "find", cFind, templateFind, lookups, templateHits == cHits ? templateHits : -1);
+}
+
+static void benchHashTable(const std::vector<long>& values, const std::vector<long>& probes) {
+    long n = static_cast<long>(values.size());
+    long lookups = static_cast<long>(probes.size());
+
+    std::vector<char> keys(n * KEY_CHARS);
+    std::vector<char> probeKeys(lookups * KEY_CHARS);
+    for (long i = 0; i < n; i++) {
+        snprintf(&keys[i * KEY_CHARS], KEY_CHARS, "key%ld", values[i]);
+    }
+    for (long i = 0; i < lookups; i++) {
+        snprintf(&probeKeys[i * KEY_CHARS], KEY_CHARS, "key%ld", probes[i]);
+    }
+
+    double start = benchNow();
+    HTable* cTable = createTable(n * 2 + 16, hashNode, destroyNodeData, printNodeData);
+    for (long i = 0; i < n; i++) {
+        insertData(cTable, &keys[i * KEY_CHARS], &keys[i * KEY_CHARS]);
+    }
+    double cBuild = benchNow() - start;
+
+    long cHits = 0;
+    start = benchNow();
+    for (long i = 0; i < lookups; i++) {
+        cHits += lookupData(cTable, &probeKeys[i * KEY_CHARS]) != NULL;
+    }
+    double cFind = benchNow() - start;
+    destroyTable(cTable);
+
+    start = benchNow();
+    ds::HashTable<std::string_view, const char*, Djb2Hash> table(n * 2 + 16);
+    for (long i = 0; i < n; i++) {
+        table.insert(&keys[i * KEY_CHARS], &keys[i * KEY_CHARS]);
+    }
+    double templateBuild = benchNow() - start;
+
+    long templateHits = 0;
+    start = benchNow();
+    for (long i = 0; i < lookups; i++) {
+        templateHits += table.find(&probeKeys[i * KEY_CHARS]) != nullptr;
+    }
+    double templateFind = benchNow() - start;
+
+    printBenchResult("HashTable", "insert", cBuild, templateBuild, n, n);
+    printBenchResult("HashTable", "lookup", cFind, templateFind, lookups, templateHits == cHits ? templateHits : -1);
+}
+
+int main(int argc, char** argv) {
+    long n = argc > 1 ? atol(argv[1]) : 1000000;
+    long lookups = argc > 2 ? atol(argv[2]) : 5000000;
+    unsigned long long state = 88172645463325252ULL;
+
+    //Distinct even values in random order, probes are half hits and half odd misses
+    std::vector<long> values(n);
+    for (long i = 0; i < n; i++) {
+        values[i] = 2 * i;
+    }
+    for (long i = n - 1; i > 0; i--) {
+        std::swap(values[i], values[benchRandom(&state) % (i + 1)]);
+    }
+    std::vector<long> probes(lookups);
+    for (long i = 0; i < lookups; i++) {
+        probes[i] = benchRandom(&state) % (2 * n);
+    }
+
+    printf("{\"benchmark\": \"Template\", \"keys\": %ld, \"lookups\": %ld, \"results\": [", n, lookups);
+    benchTree(values, probes);
+    benchHashTable(values, probes);
+    printf("\n]}\n");
+
+    return 0;
+}
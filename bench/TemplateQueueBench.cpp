@@ -0,0 +1,145 @@
+/**
+ * Benchmark for the PriorityQueue and List templates in cpp/ against
+ * PriorityQueueAPI and DoublyLinkedListAPI, like TemplateBench does for the
+ * tree and hash table. It is its own program because PriorityQueueAPI and
+ * BinarySearchTreeAPI both define insert. Both sides get the same values in
+ * the same order; the sorted list gets the first listItems of them.
+ * Usage: TemplateQueueBench [items] [listItems]
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <utility>
+#include <vector>
+#include "../cpp/List.hpp"
+#include "../cpp/PriorityQueue.hpp"
+
+//The C headers use C11 spellings C++ does not have
+#define _Alignas(n) alignas(n)
+extern "C" {
+#include "../PriorityQueueAPI.h"
+}
+#undef _Alignas
+
+static int results = 0;
+
+static double benchNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long benchRandom(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void printBenchResult(const char* structure, const char* operation, double cSeconds, double templateSeconds, long operations, long check) {
+    printf("%s\n  {\"structure\": \"%s\", \"operation\": \"%s\", \"operations\": %ld, \"check\": %ld, "
+           "\"cNsPerOp\": %.1f, \"templateNsPerOp\": %.1f, \"speedup\": %.2f}",
+           results++ > 0 ? "," : "", structure, operation, operations, check, cSeconds * 1e9 / operations, templateSeconds * 1e9 / operations,
+           cSeconds / templateSeconds);
+}
+
+static int compareLong(const void* first, const void* second) {
+    long a = *static_cast<const long*>(first);
+    long b = *static_cast<const long*>(second);
+    return (a > b) - (a < b);
+}
+
+static void benchQueue(const std::vector<long>& values) {
+    long n = static_cast<long>(values.size());
+
+    double start = benchNow();
+    Queue* cQueue = createQueueFromArray(NULL, NULL, compareLong, NULL, 0);
+    for (long i = 0; i < n; i++) {
+        insert(cQueue, const_cast<long*>(&values[i]));
+    }
+    double cInsert = benchNow() - start;
+
+    long cSum = 0;
+    start = benchNow();
+    for (long i = 0; i < n; i++) {
+        cSum += *static_cast<long*>(peek(cQueue)) * (i & 1 ? -1 : 1);
+        pop(cQueue);
+    }
+    double cPop = benchNow() - start;
+    destroy(cQueue);
+
+    start = benchNow();
+    ds::PriorityQueue<long> queue;
+    for (long i = 0; i < n; i++) {
+        queue.insert(values[i]);
+    }
+    double templateInsert = benchNow() - start;
+
+    long templateSum = 0;
+    start = benchNow();
+    for (long i = 0; i < n; i++) {
+        templateSum += queue.pop() * (i & 1 ? -1 : 1);
+    }
+    double templatePop = benchNow() - start;
+
+    printBenchResult("PriorityQueue", "insert", cInsert, templateInsert, n, n);
+    printBenchResult("PriorityQueue", "pop", cPop, templatePop, n, templateSum == cSum ? n : -1);
+}
+
+static void benchList(const std::vector<long>& values) {
+    long n = static_cast<long>(values.size());
+
+    double start = benchNow();
+    List cList = initializeList(NULL, NULL, compareLong);
+    for (long i = 0; i < n; i++) {
+        insertSorted(&cList, const_cast<long*>(&values[i]));
+    }
+    double cInsert = benchNow() - start;
+
+    long cSum = 0;
+    start = benchNow();
+    for (long i = 0; i < n; i++) {
+        cSum += *static_cast<long*>(removeFromFront(&cList)) * (i & 1 ? -1 : 1);
+    }
+    double cPop = benchNow() - start;
+    clearList(&cList);
+
+    start = benchNow();
+    ds::List<long> list;
+    for (long i = 0; i < n; i++) {
+        list.insertSorted(values[i]);
+    }
+    double templateInsert = benchNow() - start;
+
+    long templateSum = 0;
+    start = benchNow();
+    for (long i = 0; i < n; i++) {
+        templateSum += list.popFront() * (i & 1 ? -1 : 1);
+    }
+    double templatePop = benchNow() - start;
+
+    printBenchResult("List", "insertSorted", cInsert, templateInsert, n, n);
+    printBenchResult("List", "popFront", cPop, templatePop, n, templateSum == cSum ? n : -1);
+}
+
+int main(int argc, char** argv) {
+    long n = argc > 1 ? atol(argv[1]) : 1000000;
+    long listItems = argc > 2 ? atol(argv[2]) : 10000;
+    unsigned long long state = 88172645463325252ULL;
+
+    std::vector<long> values(n);
+    for (long i = 0; i < n; i++) {
+        values[i] = i;
+    }
+    for (long i = n - 1; i > 0; i--) {
+        std::swap(values[i], values[benchRandom(&state) % (i + 1)]);
+    }
+
+    printf("{\"benchmark\": \"TemplateQueue\", \"items\": %ld, \"listItems\": %ld, \"results\": [", n, listItems);
+    benchQueue(values);
+    benchList(std::vector<long>(values.begin(), values.begin() + std::min(n, listItems)));
+    printf("\n]}\n");
+
+    return 0;
+}
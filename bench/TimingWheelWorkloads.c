@@ -0,0 +1,55 @@
+/**
+ * Schedule and cancel workloads for TimingWheelAPI, each key being the
+ * deadline of one timer. Insert schedules, delete cancels.
+ * Usage: TimingWheelWorkloads [options], see runBenchmarks in BenchHarness.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../TimingWheelAPI.h"
+#include "BenchHarness.h"
+
+typedef struct wheelBench {
+    TimingWheel* wheel;
+    long* keys;
+    Timer** timers;    //Handle of the timer scheduled for keys[i], NULL once cancelled
+} WheelBench;
+
+static void* createWheel(long* keys, long numKeys) {
+    WheelBench* bench = malloc(sizeof(WheelBench));
+    bench->wheel = createTimingWheel(benchNoDelete, 0);
+    bench->keys = keys;
+    bench->timers = calloc(numKeys, sizeof(Timer*));
+
+    return bench;
+}
+
+static void scheduleWheel(void* structure, long* key) {
+    WheelBench* bench = structure;
+    //Deadline 0 would be due at once
+    bench->timers[key - bench->keys] = scheduleTimer(bench->wheel, (TimerTick)*key + 1, key);
+}
+
+static void cancelWheel(void* structure, long* key) {
+    WheelBench* bench = structure;
+    Timer** timer = &bench->timers[key - bench->keys];
+
+    if (*timer != NULL) {
+        cancelTimer(bench->wheel, *timer);
+        *timer = NULL;
+    }
+}
+
+static void destroyWheel(void* structure) {
+    WheelBench* bench = structure;
+    destroyTimingWheel(bench->wheel);
+    free(bench->timers);
+    free(bench);
+}
+
+int main(int argc, char** argv) {
+    BenchTarget targets[] = {
+        {"TimingWheel", 0, createWheel, scheduleWheel, NULL, cancelWheel, NULL, destroyWheel}
+    };
+
+    return runBenchmarks("TimingWheel", targets, 1, argc, argv);
+}
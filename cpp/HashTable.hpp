@@ -0,0 +1,175 @@
+#ifndef DATASTRUCTURES_HASHTABLE_HPP
+#define DATASTRUCTURES_HASHTABLE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace ds {
+
+/**
+ * Open addressing hash table with linear probing, like HashTableAPI, with the
+ * hash and equality functions as template parameters so probes inline them.
+ * Keys and values are stored in the slots. The table doubles once half full
+ * and removal shifts the rest of the probe run back, so lookups never stop
+ * early on a hole left by a removed key.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename Eq = std::equal_to<K>>
+class HashTable {
+public:
+    /**
+     * Creates an empty table
+     * @param capacity number of slots to start with, rounded up to a power of two
+     * @param hash hasher, default constructed unless given
+     * @param equal key equality, default constructed unless given
+     */
+    explicit HashTable(std::size_t capacity = 16, Hash hash = Hash(), Eq equal = Eq())
+        : slots(roundUp(capacity)), count(0), hasher(std::move(hash)), equals(std::move(equal)) {}
+
+    HashTable(const HashTable&) = delete;
+    HashTable& operator=(const HashTable&) = delete;
+    HashTable(HashTable&&) noexcept = default;
+    HashTable& operator=(HashTable&&) noexcept = default;
+
+    /**
+     * Adds value under key. Duplicate keys are not added.
+     * @param key
+     * @param value
+     * @return false if key was already in the table
+     */
+    bool insert(K key, V value) {
+        if ((count + 1) * 2 > slots.size()) {
+            grow();
+        }
+
+        std::size_t hash = hasher(key);
+        std::size_t mask = slots.size() - 1;
+        for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+            if (!slots[i]) {
+                slots[i].emplace(Entry{hash, std::move(key), std::move(value)});
+                count++;
+                return true;
+            }
+            if (slots[i]->hash == hash && equals(slots[i]->key, key)) {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * Searches the table for key
+     * @param key
+     * @return nullptr if fail, otherwise the stored value
+     */
+    V* find(const K& key) {
+        std::size_t hash = hasher(key);
+        std::size_t mask = slots.size() - 1;
+
+        for (std::size_t i = hash & mask; slots[i]; i = (i + 1) & mask) {
+            if (slots[i]->hash == hash && equals(slots[i]->key, key)) {
+                return &slots[i]->value;
+            }
+        }
+
+        return nullptr;
+    }
+
+    const V* find(const K& key) const {
+        return const_cast<HashTable*>(this)->find(key);
+    }
+
+    /**
+     * Removes key and its value
+     * @param key
+     * @return false if key was not in the table
+     */
+    bool remove(const K& key) {
+        std::size_t hash = hasher(key);
+        std::size_t mask = slots.size() - 1;
+        std::size_t hole = hash & mask;
+
+        while (slots[hole] && !(slots[hole]->hash == hash && equals(slots[hole]->key, key))) {
+            hole = (hole + 1) & mask;
+        }
+        if (!slots[hole]) {
+            return false;
+        }
+        slots[hole].reset();
+        count--;
+
+        //Move back every later entry of the run whose home slot is not between the hole and itself
+        for (std::size_t i = (hole + 1) & mask; slots[i]; i = (i + 1) & mask) {
+            std::size_t home = slots[i]->hash & mask;
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                slots[hole] = std::move(slots[i]);
+                slots[i].reset();
+                hole = i;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Calls visit(key, value) on every entry in slot order
+     * @param visit
+     */
+    template <typename Visit>
+    void forEach(Visit&& visit) {
+        for (auto& slot : slots) {
+            if (slot) {
+                visit(static_cast<const K&>(slot->key), slot->value);
+            }
+        }
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    std::size_t capacity() const {
+        return slots.size();
+    }
+
+private:
+    struct Entry {
+        std::size_t hash;
+        K key;
+        V value;
+    };
+
+    static std::size_t roundUp(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    void grow() {
+        std::vector<std::optional<Entry>> old(slots.size() * 2);
+        old.swap(slots);
+
+        std::size_t mask = slots.size() - 1;
+        for (auto& slot : old) {
+            if (slot) {
+                std::size_t i = slot->hash & mask;
+                while (slots[i]) {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = std::move(slot);
+            }
+        }
+    }
+
+    std::vector<std::optional<Entry>> slots;
+    std::size_t count;
+    Hash hasher;
+    Eq equals;
+};
+
+}
+
+#endif //DATASTRUCTURES_HASHTABLE_HPP
@@ -0,0 +1,246 @@
+#ifndef DATASTRUCTURES_LIST_HPP
+#define DATASTRUCTURES_LIST_HPP
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+namespace ds {
+
+/**
+ * Doubly linked list, like DoublyLinkedListAPI, holding its elements in the
+ * nodes. The comparator is a template parameter so insertSorted and remove
+ * inline it; elements are equal when neither compares less than the other.
+ */
+template <typename T, typename Cmp = std::less<T>>
+class List {
+    struct Node {
+        T value;
+        Node* previous;
+        Node* next;
+    };
+
+public:
+    /**
+     * Bidirectional iterator from head to tail
+     */
+    class Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        explicit Iterator(Node* node = nullptr, const List* list = nullptr) : node(node), list(list) {}
+
+        T& operator*() const {
+            return node->value;
+        }
+
+        T* operator->() const {
+            return &node->value;
+        }
+
+        Iterator& operator++() {
+            node = node->next;
+            return *this;
+        }
+
+        Iterator& operator--() {
+            node = node != nullptr ? node->previous : list->tail;
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return node == other.node;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return node != other.node;
+        }
+
+    private:
+        Node* node;
+        const List* list;    //To step back from end()
+    };
+
+    explicit List(Cmp compare = Cmp()) : head(nullptr), tail(nullptr), length(0), less(std::move(compare)) {}
+
+    List(const List&) = delete;
+    List& operator=(const List&) = delete;
+
+    List(List&& other) noexcept : head(other.head), tail(other.tail), length(other.length), less(std::move(other.less)) {
+        other.head = other.tail = nullptr;
+        other.length = 0;
+    }
+
+    List& operator=(List&& other) noexcept {
+        if (this != &other) {
+            clear();
+            std::swap(head, other.head);
+            std::swap(tail, other.tail);
+            std::swap(length, other.length);
+            less = std::move(other.less);
+        }
+        return *this;
+    }
+
+    ~List() {
+        clear();
+    }
+
+    void insertFront(T value) {
+        Node* node = new Node{std::move(value), nullptr, head};
+        if (head != nullptr) {
+            head->previous = node;
+        }
+        else {
+            tail = node;
+        }
+        head = node;
+        length++;
+    }
+
+    void insertBack(T value) {
+        Node* node = new Node{std::move(value), tail, nullptr};
+        if (tail != nullptr) {
+            tail->next = node;
+        }
+        else {
+            head = node;
+        }
+        tail = node;
+        length++;
+    }
+
+    /**
+     * Places value immediately before the first element not less than it
+     * @param value
+     */
+    void insertSorted(T value) {
+        if (head == nullptr || !less(head->value, value)) {
+            insertFront(std::move(value));
+            return;
+        }
+        if (less(tail->value, value)) {
+            insertBack(std::move(value));
+            return;
+        }
+
+        Node* current = head->next;
+        while (less(current->value, value)) {
+            current = current->next;
+        }
+
+        Node* node = new Node{std::move(value), current->previous, current};
+        current->previous->next = node;
+        current->previous = node;
+        length++;
+    }
+
+    /**
+     * Removes the first element equal to value
+     * @param value
+     * @return false if no element was equal
+     */
+    bool remove(const T& value) {
+        for (Node* node = head; node != nullptr; node = node->next) {
+            if (!less(node->value, value) && !less(value, node->value)) {
+                unlink(node);
+                delete node;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Removes the first element and returns it
+     * @pre the list is not empty
+     * @return the element that was at the head
+     */
+    T popFront() {
+        Node* node = head;
+        unlink(node);
+        T value = std::move(node->value);
+        delete node;
+        return value;
+    }
+
+    /**
+     * Finds the first element matching a predicate
+     * @param match called with each element until it returns true
+     * @return nullptr if nothing matched, otherwise the element
+     */
+    template <typename Predicate>
+    T* findIf(Predicate&& match) {
+        for (Node* node = head; node != nullptr; node = node->next) {
+            if (match(static_cast<const T&>(node->value))) {
+                return &node->value;
+            }
+        }
+        return nullptr;
+    }
+
+    void clear() {
+        while (head != nullptr) {
+            Node* next = head->next;
+            delete head;
+            head = next;
+        }
+        tail = nullptr;
+        length = 0;
+    }
+
+    T& front() {
+        return head->value;
+    }
+
+    T& back() {
+        return tail->value;
+    }
+
+    std::size_t size() const {
+        return length;
+    }
+
+    bool empty() const {
+        return length == 0;
+    }
+
+    Iterator begin() const {
+        return Iterator(head, this);
+    }
+
+    Iterator end() const {
+        return Iterator(nullptr, this);
+    }
+
+private:
+    void unlink(Node* node) {
+        if (node->previous != nullptr) {
+            node->previous->next = node->next;
+        }
+        else {
+            head = node->next;
+        }
+        if (node->next != nullptr) {
+            node->next->previous = node->previous;
+        }
+        else {
+            tail = node->previous;
+        }
+        length--;
+    }
+
+    Node* head;
+    Node* tail;
+    std::size_t length;
+    Cmp less;
+};
+
+}
+
+#endif //DATASTRUCTURES_LIST_HPP
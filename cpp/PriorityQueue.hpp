@@ -0,0 +1,123 @@
+#ifndef DATASTRUCTURES_PRIORITYQUEUE_HPP
+#define DATASTRUCTURES_PRIORITYQUEUE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace ds {
+
+/**
+ * Array binary heap, like the heap mode of PriorityQueueAPI, holding its
+ * elements in the array. The best element is the one that compares least,
+ * as with compareFunction, and the comparator is a template parameter so
+ * every sift step inlines it.
+ */
+template <typename T, typename Cmp = std::less<T>>
+class PriorityQueue {
+public:
+    explicit PriorityQueue(Cmp compare = Cmp()) : less(std::move(compare)) {}
+
+    /**
+     * Creates a queue holding items, heapified in O(n) like createQueueFromArray
+     * @param items
+     * @param compare
+     */
+    explicit PriorityQueue(std::vector<T> items, Cmp compare = Cmp()) : heap(std::move(items)), less(std::move(compare)) {
+        for (std::size_t i = heap.size() / 2; i-- > 0;) {
+            siftDown(i);
+        }
+    }
+
+    void insert(T value) {
+        heap.push_back(std::move(value));
+        siftUp(heap.size() - 1);
+    }
+
+    /**
+     * Removes the best element and returns it
+     * @pre the queue is not empty
+     * @return the element that was on top
+     */
+    T pop() {
+        T top = std::move(heap.front());
+        if (heap.size() > 1) {
+            heap.front() = std::move(heap.back());
+        }
+        heap.pop_back();
+        if (!heap.empty()) {
+            siftDown(0);
+        }
+        return top;
+    }
+
+    /**
+     * Removes up to k of the best elements, best first, like popBatch
+     * @param k
+     * @param out output iterator receiving the elements
+     * @return number of elements written to out
+     */
+    template <typename OutputIt>
+    std::size_t popBatch(std::size_t k, OutputIt out) {
+        std::size_t n = 0;
+        for (; n < k && !heap.empty(); n++) {
+            *out++ = pop();
+        }
+        return n;
+    }
+
+    const T& peek() const {
+        return heap.front();
+    }
+
+    std::size_t size() const {
+        return heap.size();
+    }
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+private:
+    //Moves a hole up instead of swapping, the element is written once at the end
+    void siftUp(std::size_t i) {
+        T value = std::move(heap[i]);
+        while (i > 0) {
+            std::size_t parent = (i - 1) / 2;
+            if (!less(value, heap[parent])) {
+                break;
+            }
+            heap[i] = std::move(heap[parent]);
+            i = parent;
+        }
+        heap[i] = std::move(value);
+    }
+
+    void siftDown(std::size_t i) {
+        std::size_t n = heap.size();
+        T value = std::move(heap[i]);
+        for (;;) {
+            std::size_t child = 2 * i + 1;
+            if (child >= n) {
+                break;
+            }
+            if (child + 1 < n && less(heap[child + 1], heap[child])) {
+                child++;
+            }
+            if (!less(heap[child], value)) {
+                break;
+            }
+            heap[i] = std::move(heap[child]);
+            i = child;
+        }
+        heap[i] = std::move(value);
+    }
+
+    std::vector<T> heap;
+    Cmp less;
+};
+
+}
+
+#endif //DATASTRUCTURES_PRIORITYQUEUE_HPP
@@ -0,0 +1,332 @@
+#ifndef DATASTRUCTURES_TREE_HPP
+#define DATASTRUCTURES_TREE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+namespace ds {
+
+/**
+ * AVL tree, like the TREE_AVL mode of BinarySearchTreeAPI, holding its
+ * elements in the nodes. The comparator is a template parameter so every
+ * step down the tree inlines it; elements are equal when neither compares
+ * less than the other. Duplicates are not added, like addToTree.
+ */
+template <typename T, typename Cmp = std::less<T>>
+class Tree {
+    struct Node {
+        T value;
+        Node* left;
+        Node* right;
+        Node* parent;
+        int height;
+    };
+
+public:
+    /**
+     * In order iterator, following parent pointers between nodes
+     */
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        explicit Iterator(Node* node = nullptr) : node(node) {}
+
+        const T& operator*() const {
+            return node->value;
+        }
+
+        const T* operator->() const {
+            return &node->value;
+        }
+
+        Iterator& operator++() {
+            if (node->right != nullptr) {
+                node = node->right;
+                while (node->left != nullptr) {
+                    node = node->left;
+                }
+                return *this;
+            }
+            while (node->parent != nullptr && node->parent->right == node) {
+                node = node->parent;
+            }
+            node = node->parent;
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return node == other.node;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return node != other.node;
+        }
+
+    private:
+        Node* node;
+    };
+
+    explicit Tree(Cmp compare = Cmp()) : root(nullptr), count(0), less(std::move(compare)) {}
+
+    Tree(const Tree&) = delete;
+    Tree& operator=(const Tree&) = delete;
+
+    Tree(Tree&& other) noexcept : root(other.root), count(other.count), less(std::move(other.less)) {
+        other.root = nullptr;
+        other.count = 0;
+    }
+
+    Tree& operator=(Tree&& other) noexcept {
+        if (this != &other) {
+            clear();
+            std::swap(root, other.root);
+            std::swap(count, other.count);
+            less = std::move(other.less);
+        }
+        return *this;
+    }
+
+    ~Tree() {
+        clear();
+    }
+
+    /**
+     * Adds value and rebalances the path above it
+     * @param value
+     * @return false if an equal element was already in the tree
+     */
+    bool insert(T value) {
+        Node* parent = nullptr;
+        Node** link = &root;
+
+        while (*link != nullptr) {
+            parent = *link;
+            if (less(value, parent->value)) {
+                link = &parent->left;
+            }
+            else if (less(parent->value, value)) {
+                link = &parent->right;
+            }
+            else {
+                return false;
+            }
+        }
+
+        *link = new Node{std::move(value), nullptr, nullptr, parent, 1};
+        count++;
+        retrace(parent);
+        return true;
+    }
+
+    /**
+     * Searches the tree for value
+     * @param value
+     * @return nullptr if fail, otherwise the stored element
+     */
+    const T* find(const T& value) const {
+        const Node* node = findNode(value);
+        return node != nullptr ? &node->value : nullptr;
+    }
+
+    /**
+     * Removes the element equal to value. A node with two children takes the
+     * element of its successor, whose node is removed instead, so pointers
+     * to the successor element are invalidated.
+     * @param value
+     * @return false if no element was equal
+     */
+    bool remove(const T& value) {
+        Node* node = findNode(value);
+        if (node == nullptr) {
+            return false;
+        }
+
+        if (node->left != nullptr && node->right != nullptr) {
+            Node* successor = node->right;
+            while (successor->left != nullptr) {
+                successor = successor->left;
+            }
+            node->value = std::move(successor->value);
+            node = successor;
+        }
+
+        Node* child = node->left != nullptr ? node->left : node->right;
+        Node* parent = node->parent;
+        replaceChild(parent, node, child);
+        delete node;
+        count--;
+        retrace(parent);
+        return true;
+    }
+
+    /**
+     * Calls visit on every element in order until it returns false
+     * @param visit
+     * @return false if visit stopped the traversal
+     */
+    template <typename Visit>
+    bool visitInOrder(Visit&& visit) const {
+        for (const T& value : *this) {
+            if (!visit(value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void clear() {
+        //Rotate left children up until there are none, then free down the right spine
+        Node* node = root;
+        while (node != nullptr) {
+            if (node->left != nullptr) {
+                Node* left = node->left;
+                node->left = left->right;
+                left->right = node;
+                node = left;
+            }
+            else {
+                Node* right = node->right;
+                delete node;
+                node = right;
+            }
+        }
+        root = nullptr;
+        count = 0;
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    int height() const {
+        return heightOf(root);
+    }
+
+    Iterator begin() const {
+        Node* node = root;
+        while (node != nullptr && node->left != nullptr) {
+            node = node->left;
+        }
+        return Iterator(node);
+    }
+
+    Iterator end() const {
+        return Iterator(nullptr);
+    }
+
+private:
+    Node* findNode(const T& value) const {
+        Node* node = root;
+
+        while (node != nullptr) {
+            if (less(value, node->value)) {
+                node = node->left;
+            }
+            else if (less(node->value, value)) {
+                node = node->right;
+            }
+            else {
+                return node;
+            }
+        }
+
+        return nullptr;
+    }
+
+    static int heightOf(const Node* node) {
+        return node != nullptr ? node->height : 0;
+    }
+
+    static void updateHeight(Node* node) {
+        node->height = 1 + std::max(heightOf(node->left), heightOf(node->right));
+    }
+
+    void replaceChild(Node* parent, Node* oldChild, Node* newChild) {
+        if (parent == nullptr) {
+            root = newChild;
+        }
+        else if (parent->left == oldChild) {
+            parent->left = newChild;
+        }
+        else {
+            parent->right = newChild;
+        }
+        if (newChild != nullptr) {
+            newChild->parent = parent;
+        }
+    }
+
+    Node* rotateLeft(Node* node) {
+        Node* right = node->right;
+        replaceChild(node->parent, node, right);
+        node->right = right->left;
+        if (right->left != nullptr) {
+            right->left->parent = node;
+        }
+        right->left = node;
+        node->parent = right;
+        updateHeight(node);
+        updateHeight(right);
+        return right;
+    }
+
+    Node* rotateRight(Node* node) {
+        Node* left = node->left;
+        replaceChild(node->parent, node, left);
+        node->left = left->right;
+        if (left->right != nullptr) {
+            left->right->parent = node;
+        }
+        left->right = node;
+        node->parent = left;
+        updateHeight(node);
+        updateHeight(left);
+        return left;
+    }
+
+    Node* rebalance(Node* node) {
+        updateHeight(node);
+        int balance = heightOf(node->left) - heightOf(node->right);
+
+        if (balance > 1) {
+            if (heightOf(node->left->left) < heightOf(node->left->right)) {
+                rotateLeft(node->left);
+            }
+            return rotateRight(node);
+        }
+        if (balance < -1) {
+            if (heightOf(node->right->right) < heightOf(node->right->left)) {
+                rotateRight(node->right);
+            }
+            return rotateLeft(node);
+        }
+        return node;
+    }
+
+    //Rebalances every node from node up to the root
+    void retrace(Node* node) {
+        while (node != nullptr) {
+            node = rebalance(node)->parent;
+        }
+    }
+
+    Node* root;
+    std::size_t count;
+    Cmp less;
+};
+
+}
+
+#endif //DATASTRUCTURES_TREE_HPP
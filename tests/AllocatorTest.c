@@ -0,0 +1,235 @@
+/**
+ * Round-trip checks for AllocatorAPI: objects of every size class, and
+ * beyond, are filled with a pattern of their own and must keep it while
+ * others are allocated and released, so no two live objects overlap. The
+ * slab allocator is also run with objects released by another thread than
+ * the one that allocated them, the arena is reused after a reset, and page
+ * allocators of every backing give their large mappings back on release.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../AllocatorAPI.h"
+#include "TestHarness.h"
+
+#define NUM_OBJECTS 20000
+#define NUM_THREADS 4
+#define ROUNDS 10    //Batches each slab thread hands to the next
+
+typedef struct object {
+    unsigned char* memory;
+    size_t size;
+} Object;
+
+static Object objects[NUM_OBJECTS];
+static Object* handoff[NUM_THREADS];    //Objects each thread allocated for the next one to release
+static pthread_barrier_t barrier;
+
+/**
+ * Sizes from 1 byte over every slab class to a few objects too big for any
+ */
+static size_t randomSize(unsigned long long* state) {
+    return 1 + nextRandom(state) % (SLAB_MAX_BYTES + 256);
+}
+
+static void fill(Object* object, int id) {
+    memset(object->memory, (unsigned char)(id * 31 + 7), object->size);
+}
+
+static bool intact(const Object* object, int id) {
+    for (size_t i = 0; i < object->size; i++) {
+        if (object->memory[i] != (unsigned char)(id * 31 + 7)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Allocates every object, replaces a random half and checks all patterns survived
+ */
+static void testAllocator(Allocator* allocator, size_t alignment) {
+    unsigned long long state = TEST_SEED;
+
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        objects[i].size = randomSize(&state);
+        objects[i].memory = allocatorAlloc(allocator, objects[i].size);
+        CHECK(objects[i].memory != NULL);
+        CHECK((uintptr_t)objects[i].memory % alignment == 0);
+        fill(&objects[i], i);
+    }
+
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        if (nextRandom(&state) % 2 == 0) {
+            allocatorRelease(allocator, objects[i].memory, objects[i].size);
+            objects[i].size = randomSize(&state);
+            objects[i].memory = allocatorAlloc(allocator, objects[i].size);
+            CHECK(objects[i].memory != NULL);
+            fill(&objects[i], i);
+        }
+    }
+
+    int broken = 0;
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        broken += !intact(&objects[i], i);
+        CHECK(allocatorFootprint(allocator, objects[i].size) >= objects[i].size);
+    }
+    CHECK(broken == 0);
+
+    if (allocatorReleasesEach(allocator)) {
+        for (int i = 0; i < NUM_OBJECTS; i++) {
+            allocatorRelease(allocator, objects[i].memory, objects[i].size);
+        }
+    }
+}
+
+/**
+ * Runs the object checks on a page allocator, then large objects and bulk
+ * arrays, which have mappings of their own that go when they are released
+ */
+static void testPageAllocator(PageBacking backing, NumaPlacement placement) {
+    PagePolicy policy = {backing, placement, 1024 * 1024};
+    Allocator* pages = createPageAllocator(policy);
+    CHECK(pages != NULL);
+    testAllocator(pages, SLAB_CLASS_BYTES);
+
+    PageStats before = getPageAllocatorStats(pages);
+    CHECK(before.mappedBytes >= 1024 * 1024);
+    CHECK(before.numaNodes >= 1);
+
+    Object large = {allocatorAlloc(pages, PAGE_SMALL_MAX_BYTES + 1), PAGE_SMALL_MAX_BYTES + 1};
+    Object bulk = {allocatorAllocBulk(pages, 3 * 1024 * 1024), 3 * 1024 * 1024};
+    CHECK(large.memory != NULL && bulk.memory != NULL);
+    fill(&large, 1);
+    fill(&bulk, 2);
+    CHECK(intact(&large, 1) && intact(&bulk, 2));
+    CHECK(getPageAllocatorStats(pages).mappedBytes >= before.mappedBytes + large.size + bulk.size);
+    CHECK(allocatorBulkFootprint(pages, bulk.size) >= bulk.size);
+
+    allocatorRelease(pages, large.memory, large.size);
+    allocatorReleaseBulk(pages, bulk.memory, bulk.size);
+    CHECK(getPageAllocatorStats(pages).mappedBytes == before.mappedBytes);
+
+    destroyPageAllocator(pages);
+}
+
+/**
+ * Allocates objects, hands them to the next thread, and releases the ones handed to it
+ */
+static void* slabWorker(void* argument) {
+    int thread = (int)(long)argument;
+    unsigned long long state = TEST_SEED + thread;
+    Allocator* slab = getSlabAllocator();
+    int broken = 0;
+
+    for (int round = 0; round < ROUNDS; round++) {
+        Object* mine = handoff[thread];
+        for (int i = 0; i < NUM_OBJECTS / NUM_THREADS; i++) {
+            mine[i].size = randomSize(&state);
+            mine[i].memory = allocatorAlloc(slab, mine[i].size);
+            fill(&mine[i], thread * NUM_OBJECTS + i);
+        }
+        pthread_barrier_wait(&barrier);
+
+        int previous = (thread + NUM_THREADS - 1) % NUM_THREADS;
+        Object* theirs = handoff[previous];
+        for (int i = 0; i < NUM_OBJECTS / NUM_THREADS; i++) {
+            broken += !intact(&theirs[i], previous * NUM_OBJECTS + i);
+            allocatorRelease(slab, theirs[i].memory, theirs[i].size);
+        }
+        pthread_barrier_wait(&barrier);
+    }
+
+    return (void*)(long)broken;
+}
+
+/**
+ * Releases objects another thread allocated, and nothing else, then exits
+ */
+static void* releaseOnly(void* argument) {
+    Object* released = argument;
+    for (int i = 0; i < SLAB_CACHE_LIMIT / 4; i++) {
+        allocatorRelease(getSlabAllocator(), released[i].memory, released[i].size);
+    }
+    return NULL;
+}
+
+static void* allocateOne(void* argument) {
+    return allocatorAlloc(getSlabAllocator(), *(size_t*)argument);
+}
+
+/**
+ * Objects freed by a thread that never allocated go back to the shared pool
+ * when it exits, so a new thread is handed them before any fresh slab.
+ * Must run before anything else fills the shared pool.
+ */
+static void testReleaseOnlyThread(void) {
+    static Object released[SLAB_CACHE_LIMIT / 4];
+    size_t size = SLAB_MAX_BYTES;
+    for (int i = 0; i < SLAB_CACHE_LIMIT / 4; i++) {
+        released[i].size = size;
+        released[i].memory = allocatorAlloc(getSlabAllocator(), size);
+        CHECK(released[i].memory != NULL);
+    }
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, releaseOnly, released);
+    pthread_join(thread, NULL);
+
+    void* reused;
+    pthread_create(&thread, NULL, allocateOne, &size);
+    pthread_join(thread, &reused);
+    bool found = false;
+    for (int i = 0; i < SLAB_CACHE_LIMIT / 4; i++) {
+        found |= reused == released[i].memory;
+    }
+    CHECK(found);
+}
+
+int main(void) {
+    testReleaseOnlyThread();
+    testAllocator(NULL, sizeof(void*));
+    testAllocator(getSlabAllocator(), SLAB_CLASS_BYTES);
+
+    Allocator* arena = createArenaAllocator(0);
+    CHECK(arena != NULL);
+    CHECK(!allocatorReleasesEach(arena));
+    testAllocator(arena, 16);
+    resetArenaAllocator(arena);
+    testAllocator(arena, 16);
+    destroyArenaAllocator(arena);
+
+    //A chunk smaller than some objects still serves them
+    arena = createArenaAllocator(256);
+    CHECK(arena != NULL);
+    testAllocator(arena, 16);
+    destroyArenaAllocator(arena);
+
+    //Backings the system cannot give fall back, so every one must work here
+    testPageAllocator(PAGES_SMALL, NUMA_DEFAULT);
+    testPageAllocator(PAGES_TRANSPARENT, NUMA_LOCAL);
+    testPageAllocator(PAGES_EXPLICIT, NUMA_INTERLEAVE);
+    CHECK(getPageAllocatorStats(NULL).mappedBytes == 0);
+
+    pthread_barrier_init(&barrier, NULL, NUM_THREADS);
+    pthread_t threads[NUM_THREADS];
+    for (long t = 0; t < NUM_THREADS; t++) {
+        handoff[t] = malloc(sizeof(Object) * (NUM_OBJECTS / NUM_THREADS));
+        pthread_create(&threads[t], NULL, slabWorker, (void*)t);
+    }
+    long broken = 0;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        void* result;
+        pthread_join(threads[t], &result);
+        broken += (long)result;
+    }
+    CHECK(broken == 0);
+    for (int t = 0; t < NUM_THREADS; t++) {
+        free(handoff[t]);
+    }
+    pthread_barrier_destroy(&barrier);
+
+    return TEST_RESULT();
+}
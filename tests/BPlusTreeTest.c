@@ -0,0 +1,161 @@
+/**
+ * Round-trip checks for BPlusTreeAPI: enough keys in ascending, descending
+ * and shuffled order to split leaves, inner nodes and the root several times,
+ * then finds, ordered scans and removes. Node allocation is made to fail at
+ * every step of a split to check that a failed add leaves the tree unchanged.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../BPlusTreeAPI.h"
+#include "TestHarness.h"
+
+#define NUM_KEYS 20000
+
+//Number of node allocations that succeed before the next one fails, -1 for no failure
+static int allocationsLeft = -1;
+
+/**
+ * Replaces the C library's aligned_alloc, which the tree allocates its nodes with
+ */
+void* aligned_alloc(size_t alignment, size_t size) {
+    if (allocationsLeft == 0) {
+        return NULL;
+    }
+    if (allocationsLeft > 0) {
+        allocationsLeft--;
+    }
+
+    void* memory;
+    return posix_memalign(&memory, alignment, size) == 0 ? memory : NULL;
+}
+
+static void noDelete(void* data) {
+    (void)data;
+}
+
+/**
+ * Checks that the tree holds exactly the keys marked in present, each with its own address as data
+ */
+static void checkContents(BPlusTree* tree, BPlusKey* keys, const bool* present) {
+    int expected = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        void* found = findInBPlusTree(tree, keys[i]);
+        CHECK(found == (present[i] ? &keys[i] : NULL));
+        expected += present[i];
+    }
+    CHECK(tree->count == expected);
+
+    //The leaf chain must hold the same keys in increasing order
+    BPlusIterator iter = createBPlusIterator(tree, LLONG_MIN);
+    BPlusKey key;
+    BPlusKey last = LLONG_MIN;
+    int scanned = 0;
+    while (nextBPlusElement(&iter, &key) != NULL) {
+        CHECK(scanned == 0 || key > last);
+        last = key;
+        scanned++;
+    }
+    CHECK(scanned == expected);
+}
+
+static void testOrder(BPlusKey* keys, const char* order) {
+    bool* present = calloc(NUM_KEYS, sizeof(bool));
+    BPlusTree* tree = createBPlusTree(noDelete);
+
+    for (int i = 0; i < NUM_KEYS; i++) {
+        CHECK(addToBPlusTree(tree, keys[i], &keys[i]));
+        present[i] = true;
+    }
+    CHECK(tree->height >= 3);
+    checkContents(tree, keys, present);
+
+    //Duplicates keep the first data
+    CHECK(addToBPlusTree(tree, keys[0], NULL));
+    CHECK(findInBPlusTree(tree, keys[0]) == &keys[0]);
+    CHECK(!addToBPlusTree(tree, BPLUS_EMPTY_KEY, NULL));
+
+    //Keys 2 * i + 1 fall in the middle of the first range
+    void* out[16];
+    int n = rangeScanBPlusTree(tree, 100, 131, out, 16);
+    CHECK(n == 16);
+    for (int i = 0; i < n; i++) {
+        CHECK(*(BPlusKey*)out[i] == 101 + 2 * i);
+    }
+
+    for (int i = 0; i < NUM_KEYS; i += 2) {
+        removeFromBPlusTree(tree, keys[i]);
+        present[i] = false;
+    }
+    removeFromBPlusTree(tree, 0);
+    checkContents(tree, keys, present);
+
+    for (int i = 0; i < NUM_KEYS; i += 2) {
+        CHECK(addToBPlusTree(tree, keys[i], &keys[i]));
+        present[i] = true;
+    }
+    checkContents(tree, keys, present);
+
+    if (testFailures > 0) {
+        fprintf(stderr, "failed with %s keys\n", order);
+    }
+    destroyBPlusTree(tree);
+    free(present);
+}
+
+/**
+ * Adds ascending keys letting 0, 1, 2... node allocations succeed until the
+ * add goes through, so every split, up to the ones growing the root, fails
+ * once at each of its allocations first
+ */
+static void testFailedSplits(BPlusKey* keys, int numKeys) {
+    bool* present = calloc(NUM_KEYS, sizeof(bool));
+    BPlusTree* tree = createBPlusTree(noDelete);
+    int failures = 0;
+
+    for (int i = 0; i < numKeys; i++) {
+        for (int budget = 0;; budget++) {
+            allocationsLeft = budget;
+            bool stored = addToBPlusTree(tree, keys[i], &keys[i]);
+            allocationsLeft = -1;
+            if (stored) {
+                break;
+            }
+            failures++;
+            checkContents(tree, keys, present);
+        }
+        present[i] = true;
+    }
+    CHECK(failures > 0);
+    CHECK(tree->height >= 3);
+    checkContents(tree, keys, present);
+
+    destroyBPlusTree(tree);
+    free(present);
+}
+
+int main(void) {
+    BPlusKey* keys = malloc(sizeof(BPlusKey) * NUM_KEYS);
+
+    for (int i = 0; i < NUM_KEYS; i++) {
+        keys[i] = 2 * i + 1;
+    }
+    testOrder(keys, "ascending");
+    testFailedSplits(keys, 3000);
+
+    for (int i = 0; i < NUM_KEYS; i++) {
+        keys[i] = 2 * (NUM_KEYS - 1 - i) + 1;
+    }
+    testOrder(keys, "descending");
+
+    unsigned long long state = TEST_SEED;
+    for (int i = NUM_KEYS - 1; i > 0; i--) {
+        int j = (int)(nextRandom(&state) % (i + 1));
+        BPlusKey swap = keys[i];
+        keys[i] = keys[j];
+        keys[j] = swap;
+    }
+    testOrder(keys, "shuffled");
+
+    free(keys);
+    return TEST_RESULT();
+}
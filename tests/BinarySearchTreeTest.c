@@ -0,0 +1,571 @@
+/**
+ * Round-trip checks for BinarySearchTreeAPI in every mode: shuffled adds,
+ * finds, in-order visits, removes and compactTree, rank and select on the
+ * balanced modes, and interval tree overlap queries against a linear scan.
+ * After each phase every node's height, size, parent and AVL balance is checked.
+ * Pre and post order visits follow recursive walks, and visitParallel sees
+ * every node once from any number of threads. Iterators walk forwards and
+ * backwards from every kind of bound, and select, rank and range counts are
+ * compared with a sorted model, batched lookups with single ones. Trees built
+ * from sorted data of every awkward size must come out complete and ordered.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "../BinarySearchTreeAPI.h"
+#include "TestHarness.h"
+
+#define NUM_KEYS 5000
+#define NUM_INTERVALS 2000
+#define NUM_QUERIES 500
+#define MAX_THREADS 8
+
+/**
+ * Data handed out in visit order, and where a visit should stop
+ */
+typedef struct visitLog {
+    int* order[NUM_KEYS];
+    int count;
+    int stopAfter;    //Number of visits before returning nonzero, 0 to visit everything
+} VisitLog;
+
+typedef struct interval {
+    long long start;
+    long long end;
+} Interval;
+
+static unsigned long long state = TEST_SEED;
+static int deleted = 0;
+
+static int compareInts(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static void countDelete(void* data) {
+    (void)data;
+    deleted++;
+}
+
+static int checkIncreasing(void* data, void* context) {
+    int* last = context;
+    CHECK(*(int*)data > *last);
+    *last = *(int*)data;
+    return 0;
+}
+
+/**
+ * Checks the stored height, size and parent of every node below treeNode, and
+ * on height balanced modes that the subtrees of each node differ by at most one
+ * @return number of nodes checked
+ */
+static int checkSubtree(TreeNode* treeNode, TreeNode* parent, TreeMode mode) {
+    if (treeNode == NULL) {
+        return 0;
+    }
+
+    CHECK(treeNode->parent == parent);
+    int left = checkSubtree(treeNode->left, treeNode, mode);
+    int right = checkSubtree(treeNode->right, treeNode, mode);
+    int leftHeight = getHeight(treeNode->left);
+    int rightHeight = getHeight(treeNode->right);
+
+    CHECK(treeNode->height == (leftHeight > rightHeight ? leftHeight : rightHeight) + 1);
+    CHECK(treeNode->size == left + right + 1);
+    if (mode == TREE_AVL || mode == TREE_INTERVAL) {
+        CHECK(abs(leftHeight - rightHeight) <= 1);
+    }
+
+    return left + right + 1;
+}
+
+static void checkShape(Tree* tree) {
+    CHECK(checkSubtree(tree->root, NULL, tree->mode) == tree->count);
+}
+
+static int logVisit(void* data, void* context) {
+    VisitLog* log = context;
+    log->order[log->count++] = data;
+    return log->count == log->stopAfter ? log->count : 0;
+}
+
+/**
+ * Recursive reference traversal: pre order when pre is set, post order otherwise
+ */
+static void collect(TreeNode* treeNode, bool pre, VisitLog* log) {
+    if (treeNode == NULL) {
+        return;
+    }
+    if (pre) {
+        log->order[log->count++] = treeNode->data;
+    }
+    collect(treeNode->left, pre, log);
+    collect(treeNode->right, pre, log);
+    if (!pre) {
+        log->order[log->count++] = treeNode->data;
+    }
+}
+
+/**
+ * Compares visitPreOrder and visitPostOrder with recursive walks, and checks
+ * a nonzero return from visit stops each traversal there
+ */
+static void checkOrders(Tree* tree) {
+    static VisitLog expected;
+    static VisitLog visited;
+    int (*const visitors[])(Tree*, VisitFunc, void*) = {visitPreOrder, visitPostOrder, visitInOrder};
+
+    for (int v = 0; v < 3; v++) {
+        expected.count = 0;
+        if (v < 2) {
+            collect(tree->root, v == 0, &expected);
+        }
+        visited.count = 0;
+        visited.stopAfter = 0;
+        CHECK(visitors[v](tree, logVisit, &visited) == 0);
+        CHECK(visited.count == tree->count);
+        for (int i = 0; v < 2 && i < expected.count; i++) {
+            CHECK(visited.order[i] == expected.order[i]);
+        }
+
+        int stopAfter = tree->count / 3 + 1;
+        visited.count = 0;
+        visited.stopAfter = stopAfter;
+        CHECK(visitors[v](tree, logVisit, &visited) == stopAfter);
+        CHECK(visited.count == stopAfter);
+    }
+}
+
+static int countParallel(void* data, void* context) {
+    atomic_int* seen = context;
+    atomic_fetch_add(&seen[(*(int*)data - 1) / 2], 1);
+    atomic_fetch_add(&seen[NUM_KEYS], 1);    //Last slot counts the visits of the thread
+    return 0;
+}
+
+static int stopParallel(void* data, void* context) {
+    countParallel(data, context);
+    return 5;
+}
+
+/**
+ * Every node visited exactly once across the threads, and visits stop once one returns nonzero
+ */
+static void checkParallel(Tree* tree) {
+    static atomic_int seen[MAX_THREADS][NUM_KEYS + 1];
+    void* contexts[MAX_THREADS];
+    int threadCounts[] = {1, 2, 3, 4, MAX_THREADS};
+
+    for (int t = 0; t < (int)(sizeof(threadCounts) / sizeof(threadCounts[0])); t++) {
+        int numThreads = threadCounts[t];
+        for (int i = 0; i < MAX_THREADS; i++) {
+            for (int j = 0; j <= NUM_KEYS; j++) {
+                atomic_store(&seen[i][j], 0);
+            }
+            contexts[i] = seen[i];
+        }
+
+        CHECK(visitParallel(tree, countParallel, contexts, numThreads) == 0);
+        int total = 0;
+        int wrong = 0;
+        for (int j = 0; j < NUM_KEYS; j++) {
+            int times = 0;
+            for (int i = 0; i < numThreads; i++) {
+                times += atomic_load(&seen[i][j]);
+            }
+            int key = 2 * j + 1;
+            wrong += times != (findInTreeSub(tree->root, &key, compareInts) != NULL);
+        }
+        for (int i = 0; i < numThreads; i++) {
+            total += atomic_load(&seen[i][NUM_KEYS]);
+        }
+        CHECK(wrong == 0);
+        CHECK(total == tree->count);
+
+        //Each thread stops at its own first visit, if the others have not stopped it already
+        for (int i = 0; i < numThreads; i++) {
+            atomic_store(&seen[i][NUM_KEYS], 0);
+        }
+        CHECK(visitParallel(tree, stopParallel, contexts, numThreads) == 5);
+        total = 0;
+        for (int i = 0; i < numThreads; i++) {
+            total += atomic_load(&seen[i][NUM_KEYS]);
+        }
+        CHECK(total >= 1 && total <= numThreads);
+    }
+}
+
+static void testMode(TreeMode mode, int* keys) {
+    Tree* tree = createBinTreeWithMode(compareInts, NULL, NULL, mode);
+    static VisitLog empty = {.stopAfter = 1};
+    CHECK(visitPreOrder(tree, logVisit, &empty) == 0);
+    CHECK(visitPostOrder(tree, logVisit, &empty) == 0);
+    CHECK(visitParallel(tree, logVisit, NULL, 4) == 0);
+    CHECK(empty.count == 0);
+
+    for (int i = 0; i < NUM_KEYS; i++) {
+        addToTree(tree, &keys[i]);
+    }
+    addToTree(tree, &keys[0]);
+    CHECK(tree->count == NUM_KEYS);
+    checkShape(tree);
+
+    for (int i = 0; i < NUM_KEYS; i += 3) {
+        removeFromTree(tree, &keys[i]);
+    }
+    int missing = -1;
+    removeFromTree(tree, &missing);
+    CHECK(tree->count == NUM_KEYS - (NUM_KEYS + 2) / 3);
+    checkShape(tree);
+    checkOrders(tree);
+    checkParallel(tree);
+
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < NUM_KEYS; i++) {
+            int* found = findInTree(tree, &keys[i]);
+            CHECK(found == (i % 3 == 0 ? NULL : &keys[i]));
+        }
+        int last = -1;
+        CHECK(visitInOrder(tree, checkIncreasing, &last) == 0);
+
+        //Select and rank are inverses on the size augmented modes
+        if (mode != TREE_UNBALANCED) {
+            int* third = treeSelect(tree, 2);
+            CHECK(third != NULL && treeRank(tree, third) == 2);
+        }
+
+        //The same checks again on the compacted nodes
+        CHECK(compactTree(tree));
+        checkShape(tree);
+    }
+
+    destroyBinTree(tree);
+}
+
+/**
+ * Fills model with the keys left after removing every third one, sorted.
+ * Keys are the odd numbers below 2 * NUM_KEYS.
+ * @return number of keys in model
+ */
+static int keptKeys(const int* keys, int* model) {
+    static bool removed[NUM_KEYS];
+    for (int i = 0; i < NUM_KEYS; i += 3) {
+        removed[(keys[i] - 1) / 2] = true;
+    }
+    int stored = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        if (!removed[i]) {
+            model[stored++] = 2 * i + 1;
+        }
+    }
+    return stored;
+}
+
+/**
+ * Checks nextTreeElement gives model[from..to-1] and then stops
+ */
+static void walkForward(TreeIterator iter, const int* model, int from, int to) {
+    for (int i = from; i < to; i++) {
+        int* data = nextTreeElement(&iter);
+        CHECK(data != NULL && *data == model[i]);
+    }
+    CHECK(nextTreeElement(&iter) == NULL);
+}
+
+/**
+ * Checks prevTreeElement gives model[from-1] down to model[0] and then stops
+ */
+static void walkBackward(TreeIterator iter, const int* model, int from) {
+    for (int i = from - 1; i >= 0; i--) {
+        int* data = prevTreeElement(&iter);
+        CHECK(data != NULL && *data == model[i]);
+    }
+    CHECK(prevTreeElement(&iter) == NULL);
+}
+
+/**
+ * Walks both ways from the lower and upper bound of probes inside and outside
+ * the key range, and over ranges, comparing with the sorted keys still stored
+ */
+static void testIterators(TreeMode mode, int* keys) {
+    Tree* tree = createBinTreeWithMode(compareInts, NULL, NULL, mode);
+    TreeIterator iter = createTreeIterator(tree);
+    int probe = 1;
+    CHECK(nextTreeElement(&iter) == NULL);
+    CHECK(prevTreeElement(&iter) == NULL);
+    iter = treeLowerBound(tree, &probe);
+    CHECK(nextTreeElement(&iter) == NULL);
+    iter = treeUpperBound(tree, &probe);
+    CHECK(prevTreeElement(&iter) == NULL);
+
+    for (int i = 0; i < NUM_KEYS; i++) {
+        addToTree(tree, &keys[i]);
+    }
+    for (int i = 0; i < NUM_KEYS; i += 3) {
+        removeFromTree(tree, &keys[i]);
+    }
+
+    static int model[NUM_KEYS];
+    int stored = keptKeys(keys, model);
+    CHECK(tree->count == stored);
+
+    walkForward(createTreeIterator(tree), model, 0, stored);
+    iter = createTreeIterator(tree);
+    while (nextTreeElement(&iter) != NULL) {
+    }
+    walkBackward(iter, model, stored);
+
+    //Even probes fall between keys, odd ones on kept or removed keys
+    int probes[] = {-5, 0, 1, 2, 3, model[0], model[stored - 1], 2 * NUM_KEYS - 1, 2 * NUM_KEYS, 2 * NUM_KEYS + 7};
+    int numProbes = (int)(sizeof(probes) / sizeof(probes[0]));
+    for (int q = 0; q < numProbes + 100; q++) {
+        probe = q < numProbes ? probes[q] : (int)(nextRandom(&state) % (2 * NUM_KEYS + 2));
+        int lower = 0;
+        while (lower < stored && model[lower] < probe) {
+            lower++;
+        }
+        int upper = lower;
+        while (upper < stored && model[upper] <= probe) {
+            upper++;
+        }
+
+        walkForward(treeLowerBound(tree, &probe), model, lower, stored);
+        walkBackward(treeLowerBound(tree, &probe), model, lower);
+        walkForward(treeUpperBound(tree, &probe), model, upper, stored);
+        walkBackward(treeUpperBound(tree, &probe), model, upper);
+
+        //A range stops after hi going forwards
+        int hi = probe + (int)(nextRandom(&state) % 200) - 20;
+        int end = lower;
+        while (end < stored && model[end] <= hi) {
+            end++;
+        }
+        walkForward(treeRangeIterator(tree, &probe, &hi), model, lower, end);
+    }
+
+    destroyBinTree(tree);
+}
+
+/**
+ * Checks select and rank of every stored key, rank of the gaps between them
+ * and range counts over random ranges, including empty and reversed ones
+ */
+static void checkOrderStatistics(Tree* tree, int* model, int stored) {
+    for (int i = 0; i < stored; i++) {
+        int* data = treeSelect(tree, i);
+        CHECK(data != NULL && *data == model[i]);
+        CHECK(treeRank(tree, &model[i]) == i);
+        int gap = model[i] + 1;
+        CHECK(treeRank(tree, &gap) == i + 1);
+    }
+    CHECK(treeSelect(tree, -1) == NULL);
+    CHECK(treeSelect(tree, stored) == NULL);
+
+    for (int q = 0; q < NUM_QUERIES; q++) {
+        int lo = (int)(nextRandom(&state) % (2 * NUM_KEYS + 20)) - 10;
+        int hi = lo + (int)(nextRandom(&state) % 400) - 20;
+        int expected = 0;
+        for (int i = 0; i < stored; i++) {
+            expected += model[i] >= lo && model[i] <= hi;
+        }
+        CHECK(treeRangeCount(tree, &lo, &hi) == expected);
+    }
+}
+
+static void testOrderStatistics(TreeMode mode, int* keys) {
+    Tree* tree = createBinTreeWithMode(compareInts, NULL, NULL, mode);
+    int zero = 0;
+    CHECK(treeSelect(tree, 0) == NULL);
+    CHECK(treeRank(tree, &zero) == 0);
+    CHECK(treeRangeCount(tree, &zero, &zero) == 0);
+
+    for (int i = 0; i < NUM_KEYS; i++) {
+        addToTree(tree, &keys[i]);
+    }
+    for (int i = 0; i < NUM_KEYS; i += 3) {
+        removeFromTree(tree, &keys[i]);
+    }
+
+    static int model[NUM_KEYS];
+    int stored = keptKeys(keys, model);
+    checkOrderStatistics(tree, model, stored);
+    CHECK(compactTree(tree));
+    checkOrderStatistics(tree, model, stored);
+
+    destroyBinTree(tree);
+}
+
+/**
+ * Looks up batches around TREE_BATCH_LOOKUPS with findManyInTree, about half
+ * of the keys missing, and compares each result with findInTree
+ */
+static void testFindMany(TreeMode mode, int* keys) {
+    Tree* tree = createBinTreeWithMode(compareInts, NULL, NULL, mode);
+    for (int i = 0; i < NUM_KEYS; i++) {
+        addToTree(tree, &keys[i]);
+    }
+    for (int i = 0; i < NUM_KEYS; i += 3) {
+        removeFromTree(tree, &keys[i]);
+    }
+
+    static int probes[1000];
+    TreeDataPtr batch[1000];
+    TreeDataPtr out[1000];
+    int sizes[] = {0, 1, TREE_BATCH_LOOKUPS - 1, TREE_BATCH_LOOKUPS, TREE_BATCH_LOOKUPS + 1, 1000};
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int n = sizes[s];
+        for (int i = 0; i < n; i++) {
+            //Odd probes are kept or removed keys, even ones were never added
+            probes[i] = (int)(nextRandom(&state) % (2 * NUM_KEYS + 10)) - 5;
+            batch[i] = &probes[i];
+            out[i] = &probes[i];
+        }
+
+        int found = findManyInTree(tree, batch, n, out);
+        int expected = 0;
+        for (int i = 0; i < n; i++) {
+            int* single = findInTree(tree, &probes[i]);
+            CHECK(out[i] == single);
+            expected += single != NULL;
+        }
+        CHECK(found == expected);
+    }
+
+    destroyBinTree(tree);
+}
+
+/**
+ * Builds trees of 0, 1, 2^k - 1 and 2^k keys, checks they are complete and
+ * ordered, then changes them and lets destroyBinTree delete what is left
+ */
+static void testBuild(void) {
+    static int values[1024 + 64];
+    TreeDataPtr data[1024];
+    for (int i = 0; i < 1024 + 64; i++) {
+        values[i] = 2 * i;
+    }
+    for (int i = 0; i < 1024; i++) {
+        data[i] = &values[i];
+    }
+
+    int sizes[] = {0, 1, 2, 3, 4, 7, 8, 255, 256, 1023, 1024};
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int n = sizes[s];
+        Tree* tree = buildTreeFromSorted(data, n, compareInts, countDelete, NULL, TREE_AVL);
+        CHECK(tree != NULL && tree->count == n);
+
+        //Height of a complete tree is floor(log2 n) + 1
+        int height = 0;
+        while ((1 << height) <= n) {
+            height++;
+        }
+        CHECK(getHeight(tree->root) == height);
+        checkShape(tree);
+        int last = -1;
+        CHECK(visitInOrder(tree, checkIncreasing, &last) == 0);
+        CHECK(last == (n > 0 ? values[n - 1] : -1));
+
+        //Nodes added outside the block and removed from inside it are freed alike
+        for (int i = 0; i < 64; i++) {
+            addToTree(tree, &values[1024 + i]);
+        }
+        for (int i = 0; i < n; i += 2) {
+            removeFromTree(tree, &values[i]);
+        }
+        checkShape(tree);
+        deleted = 0;
+        int left = tree->count;
+        destroyBinTree(tree);
+        CHECK(deleted == left);
+    }
+
+    CHECK(buildTreeFromSorted(data, 4, compareInts, NULL, NULL, TREE_INTERVAL) == NULL);
+}
+
+static int compareIntervals(const void* a, const void* b) {
+    const Interval* x = a;
+    const Interval* y = b;
+    if (x->start != y->start) {
+        return (x->start > y->start) - (x->start < y->start);
+    }
+    return (x > y) - (x < y);
+}
+
+static long long startOf(const void* data) {
+    return ((const Interval*)data)->start;
+}
+
+static long long endOf(const void* data) {
+    return ((const Interval*)data)->end;
+}
+
+static void testIntervals(void) {
+    Interval* intervals = malloc(sizeof(Interval) * NUM_INTERVALS);
+    Tree* tree = createIntervalTree(compareIntervals, NULL, NULL, startOf, endOf);
+    TreeDataPtr* out = malloc(sizeof(TreeDataPtr) * NUM_INTERVALS);
+
+    for (int i = 0; i < NUM_INTERVALS; i++) {
+        intervals[i].start = (long long)(nextRandom(&state) % 100000);
+        intervals[i].end = intervals[i].start + (long long)(nextRandom(&state) % 2000);
+        addToTree(tree, &intervals[i]);
+    }
+    for (int i = 0; i < NUM_INTERVALS; i += 4) {
+        removeFromTree(tree, &intervals[i]);
+    }
+    checkShape(tree);
+
+    for (int q = 0; q < NUM_QUERIES; q++) {
+        long long lo = (long long)(nextRandom(&state) % 100000);
+        long long hi = lo + (long long)(nextRandom(&state) % 500);
+
+        int expected = 0;
+        for (int i = 0; i < NUM_INTERVALS; i++) {
+            expected += i % 4 != 0 && intervals[i].start <= hi && intervals[i].end >= lo;
+        }
+
+        int found = findOverlapping(tree, lo, hi, out, NUM_INTERVALS);
+        CHECK(found == expected);
+        for (int i = 0; i < found; i++) {
+            Interval* interval = out[i];
+            CHECK(interval->start <= hi && interval->end >= lo);
+            CHECK((interval - intervals) % 4 != 0);
+            CHECK(i == 0 || compareIntervals(out[i - 1], interval) < 0);
+        }
+    }
+
+    destroyBinTree(tree);
+    free(intervals);
+    free(out);
+}
+
+int main(void) {
+    int* keys = malloc(sizeof(int) * NUM_KEYS);
+    for (int i = 0; i < NUM_KEYS; i++) {
+        keys[i] = 2 * i + 1;
+    }
+    for (int i = NUM_KEYS - 1; i > 0; i--) {
+        int j = (int)(nextRandom(&state) % (i + 1));
+        int swap = keys[i];
+        keys[i] = keys[j];
+        keys[j] = swap;
+    }
+
+    testMode(TREE_UNBALANCED, keys);
+    testMode(TREE_AVL, keys);
+    testMode(TREE_SPLAY, keys);
+    testIterators(TREE_UNBALANCED, keys);
+    testIterators(TREE_AVL, keys);
+    testIterators(TREE_SPLAY, keys);
+    testOrderStatistics(TREE_UNBALANCED, keys);
+    testOrderStatistics(TREE_AVL, keys);
+    testOrderStatistics(TREE_SPLAY, keys);
+    testFindMany(TREE_UNBALANCED, keys);
+    testFindMany(TREE_AVL, keys);
+    testFindMany(TREE_SPLAY, keys);
+    testBuild();
+    testIntervals();
+
+    free(keys);
+    return TEST_RESULT();
+}
@@ -0,0 +1,227 @@
+/**
+ * Round-trip checks for CacheAPI: each policy evicts what it should in a
+ * small cache, SLRU keeps its hot entries through a scan, and random puts,
+ * gets and removes keep the byte count within capacity with every piece of
+ * data deleted exactly once. The sharded cache runs the same accounting
+ * from several threads.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "../CacheAPI.h"
+#include "TestHarness.h"
+
+#define NUM_RECORDS 40000
+#define NUM_KEYS 500
+#define KEY_CHARS 16
+#define NUM_THREADS 4
+
+typedef struct record {
+    int key;
+    atomic_int deletes;
+} Record;
+
+static Record records[NUM_RECORDS];
+static atomic_int nextRecord;
+static ShardedCache* shared;
+
+static void deleteRecord(void* data) {
+    atomic_fetch_add(&((Record*)data)->deletes, 1);
+}
+
+static Record* newRecord(int key) {
+    Record* record = &records[atomic_fetch_add(&nextRecord, 1)];
+    record->key = key;
+    return record;
+}
+
+/**
+ * Checks every record handed to a cache was deleted once, and the ones it refused never
+ */
+static void checkDeletes(const bool* accepted) {
+    int wrong = 0;
+    for (int i = 0; i < atomic_load(&nextRecord); i++) {
+        wrong += atomic_load(&records[i].deletes) != (accepted[i] ? 1 : 0);
+        atomic_store(&records[i].deletes, 0);
+    }
+    CHECK(wrong == 0);
+    atomic_store(&nextRecord, 0);
+}
+
+/**
+ * Fills a ten entry cache with k0 to k9, uses k0 and adds k10
+ */
+static Cache* fillAndOverflow(CachePolicy policy) {
+    Cache* cache = createCache(10, policy, NULL);
+    char key[KEY_CHARS];
+    static int values[11];
+    for (int i = 0; i <= 10; i++) {
+        snprintf(key, KEY_CHARS, "k%d", i);
+        CHECK(putInCache(cache, key, &values[i], 1));
+        if (i == 9) {
+            CHECK(getFromCache(cache, "k0") == &values[0]);
+        }
+    }
+    CHECK(cache->count == 10 && cache->bytes == 10 && cache->evictions == 1);
+    CHECK(peekInCache(cache, "k0") == &values[0]);
+    CHECK(peekInCache(cache, "k10") == &values[10]);
+    return cache;
+}
+
+static void testEvictionOrder(void) {
+    //LRU evicts the least recently used, k1 once k0 was used
+    Cache* lru = fillAndOverflow(CACHE_LRU);
+    CHECK(peekInCache(lru, "k1") == NULL);
+    CHECK(touchInCache(lru, "k2"));
+    CHECK(evictFromCache(lru));
+    CHECK(peekInCache(lru, "k2") != NULL && peekInCache(lru, "k3") == NULL);
+    CHECK(!touchInCache(lru, "k1"));
+    destroyCache(lru);
+
+    //CLOCK gives the used k0 a second chance
+    Cache* clock = fillAndOverflow(CACHE_CLOCK);
+    int missing = 0;
+    for (int i = 1; i < 10; i++) {
+        char key[KEY_CHARS];
+        snprintf(key, KEY_CHARS, "k%d", i);
+        missing += peekInCache(clock, key) == NULL;
+    }
+    CHECK(missing == 1);
+    destroyCache(clock);
+
+    //A scan of new keys only churns SLRU's probation, the protected entries stay
+    Cache* slru = createCache(100, CACHE_SLRU, NULL);
+    static int hot[50];
+    static int cold;
+    char key[KEY_CHARS];
+    for (int i = 0; i < 50; i++) {
+        snprintf(key, KEY_CHARS, "hot%d", i);
+        putInCache(slru, key, &hot[i], 1);
+        getFromCache(slru, key);
+    }
+    for (int i = 0; i < 1000; i++) {
+        snprintf(key, KEY_CHARS, "cold%d", i);
+        CHECK(putInCache(slru, key, &cold, 1));
+    }
+    for (int i = 0; i < 50; i++) {
+        snprintf(key, KEY_CHARS, "hot%d", i);
+        CHECK(peekInCache(slru, key) == &hot[i]);
+    }
+    CHECK(slru->bytes <= slru->capacity);
+    CHECK(!putInCache(slru, "huge", &cold, 101));
+    destroyCache(slru);
+}
+
+/**
+ * Random puts, replacements, gets and removes against the capacity and the delete counts
+ */
+static void testAccounting(CachePolicy policy) {
+    static bool accepted[NUM_RECORDS];
+    unsigned long long state = TEST_SEED + policy;
+    char key[KEY_CHARS];
+    Cache* cache = createCache(2000, policy, deleteRecord);
+    CHECK(cache != NULL);
+
+    for (int i = 0; i < NUM_RECORDS / 2; i++) {
+        int k = (int)(nextRandom(&state) % NUM_KEYS);
+        snprintf(key, KEY_CHARS, "key%d", k);
+        switch (nextRandom(&state) % 4) {
+            case 0:
+                removeFromCache(cache, key);
+                break;
+            case 1: {
+                Record* found = getFromCache(cache, key);
+                CHECK(found == NULL || found->key == k);
+                break;
+            }
+            default: {
+                Record* record = newRecord(k);
+                size_t size = 1 + nextRandom(&state) % 64;
+                accepted[record - records] = putInCache(cache, key, record, size);
+                CHECK(accepted[record - records]);
+                CHECK(getFromCache(cache, key) == record);
+                break;
+            }
+        }
+        CHECK(cache->bytes <= cache->capacity);
+    }
+
+    size_t counted = 0;
+    for (int k = 0; k < NUM_KEYS; k++) {
+        snprintf(key, KEY_CHARS, "key%d", k);
+        counted += peekInCache(cache, key) != NULL;
+    }
+    CHECK(counted == cache->count);
+    CHECK(getCacheMemoryUsage(cache).payload > 0);
+
+    destroyCache(cache);
+    checkDeletes(accepted);
+}
+
+static void readRecord(void* data, void* context) {
+    *(int*)context = ((Record*)data)->key;
+}
+
+static bool sharedAccepted[NUM_RECORDS];
+
+static void* worker(void* argument) {
+    unsigned long long state = TEST_SEED + (long)argument;
+    char key[KEY_CHARS];
+    int wrong = 0;
+
+    for (int i = 0; i < NUM_RECORDS / NUM_THREADS / 2; i++) {
+        int k = (int)(nextRandom(&state) % NUM_KEYS);
+        snprintf(key, KEY_CHARS, "key%d", k);
+        int seen = -1;
+        switch (nextRandom(&state) % 4) {
+            case 0:
+                removeFromShardedCache(shared, key);
+                break;
+            case 1:
+                if (readFromShardedCache(shared, key, readRecord, &seen)) {
+                    wrong += seen != k;
+                }
+                break;
+            default: {
+                Record* record = newRecord(k);
+                sharedAccepted[record - records] = putInShardedCache(shared, key, record, 1 + nextRandom(&state) % 64);
+                break;
+            }
+        }
+    }
+    return (void*)(long)wrong;
+}
+
+int main(void) {
+    testEvictionOrder();
+    testAccounting(CACHE_LRU);
+    testAccounting(CACHE_SLRU);
+    testAccounting(CACHE_CLOCK);
+
+    CachePolicy policies[] = {CACHE_LRU, CACHE_CLOCK};
+    for (int p = 0; p < 2; p++) {
+        shared = createShardedCache(4000, policies[p], deleteRecord, 8);
+        CHECK(shared != NULL);
+        pthread_t threads[NUM_THREADS];
+        for (long t = 0; t < NUM_THREADS; t++) {
+            pthread_create(&threads[t], NULL, worker, (void*)t);
+        }
+        long wrong = 0;
+        for (int t = 0; t < NUM_THREADS; t++) {
+            void* result;
+            pthread_join(threads[t], &result);
+            wrong += (long)result;
+        }
+        CHECK(wrong == 0);
+        for (int s = 0; s < shared->numShards; s++) {
+            CHECK(shared->shards[s].cache.bytes <= shared->shards[s].cache.capacity);
+        }
+        destroyShardedCache(shared);
+        checkDeletes(sharedAccepted);
+        memset(sharedAccepted, 0, sizeof(sharedAccepted));
+    }
+
+    return TEST_RESULT();
+}
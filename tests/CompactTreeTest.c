@@ -0,0 +1,154 @@
+/**
+ * Round-trip checks for CompactTreeAPI: pointer and inline trees grow past
+ * one chunk through ascending and random adds, stay in order and balanced,
+ * reuse the slots of removed nodes, and delete every piece of data once.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../CompactTreeAPI.h"
+#include "TestHarness.h"
+
+#define NUM_KEYS ((int)(COMPACT_CHUNK_NODES + COMPACT_CHUNK_NODES / 2))    //Enough for a second chunk
+
+typedef struct wide {
+    long long key;
+    char padding[20];    //Makes an inline node stride that is not a power of two
+} Wide;
+
+typedef struct orderCheck {
+    long long previous;
+    size_t visited;
+    bool ordered;
+} OrderCheck;
+
+static size_t deleted = 0;
+
+static int compareWide(const void* first, const void* second) {
+    long long a = ((const Wide*)first)->key;
+    long long b = ((const Wide*)second)->key;
+    return (a > b) - (a < b);
+}
+
+static void countDelete(void* data) {
+    (void)data;
+    deleted++;
+}
+
+static void printWide(void* data) {
+    printf("%lld ", ((Wide*)data)->key);
+}
+
+static int checkOrder(void* data, void* context) {
+    OrderCheck* check = context;
+    check->ordered &= check->visited == 0 || check->previous < ((Wide*)data)->key;
+    check->ordered &= ((Wide*)data)->padding[0] == (char)((Wide*)data)->key;
+    check->previous = ((Wide*)data)->key;
+    check->visited++;
+    return 0;
+}
+
+/**
+ * Height of the subtree at index, checking the AVL condition and the parent links on the way
+ */
+static uint32_t checkBalance(CompactTree* tree, uint32_t index, uint32_t parent, bool* balanced) {
+    if (index == COMPACT_NIL) {
+        return 0;
+    }
+    CompactNode* node = (CompactNode*)(tree->chunks[index >> COMPACT_CHUNK_SHIFT] + (size_t)(index & (COMPACT_CHUNK_NODES - 1)) * tree->stride);
+    uint32_t left = checkBalance(tree, node->left, index, balanced);
+    uint32_t right = checkBalance(tree, node->right, index, balanced);
+    *balanced &= node->parent == parent;
+    *balanced &= (left > right ? left - right : right - left) <= 1;
+    *balanced &= node->height == 1 + (left > right ? left : right);
+    return node->height;
+}
+
+static void checkTree(CompactTree* tree, size_t expected) {
+    OrderCheck check = {0, 0, true};
+    CHECK(visitCompactTreeInOrder(tree, checkOrder, &check) == 0);
+    CHECK(check.ordered && check.visited == expected);
+    CHECK(tree->count == expected);
+    bool balanced = true;
+    checkBalance(tree, tree->root, COMPACT_NIL, &balanced);
+    CHECK(balanced);
+}
+
+/**
+ * Adds keys 0 to n - 1 in the given order, removes the even ones and adds them back
+ */
+static void testTree(size_t inlineBytes, const long long* order, int n) {
+    static Wide values[NUM_KEYS];
+    CompactTree* tree = createCompactTree(compareWide, countDelete, printWide, inlineBytes, NULL);
+    CHECK(tree != NULL);
+    deleted = 0;
+
+    for (int i = 0; i < n; i++) {
+        values[i].key = i;
+        values[i].padding[0] = (char)i;
+        CHECK(addToCompactTree(tree, &values[order[i]]));
+    }
+    checkTree(tree, n);
+    CHECK(tree->numChunks >= 2);
+
+    //A duplicate is not added
+    Wide duplicate = values[n / 2];
+    CHECK(addToCompactTree(tree, &duplicate));
+    CHECK(tree->count == (size_t)n);
+
+    for (int i = 0; i < n; i++) {
+        Wide* found = findInCompactTree(tree, &values[i]);
+        CHECK(found != NULL && found->key == i);
+        CHECK(inlineBytes > 0 ? found != &values[i] : found == &values[i]);
+    }
+    Wide missing = {n, {0}};
+    CHECK(findInCompactTree(tree, &missing) == NULL);
+
+    uint32_t used = tree->used;
+    for (int i = 0; i < n; i += 2) {
+        removeFromCompactTree(tree, &values[order[i]]);
+    }
+    removeFromCompactTree(tree, &missing);
+    checkTree(tree, n / 2);
+    CHECK(deleted == (size_t)(n + 1) / 2);
+    for (int i = 0; i < n; i += 2) {
+        CHECK(findInCompactTree(tree, &values[order[i]]) == NULL);
+    }
+
+    //The freed slots come back before the pool grows
+    for (int i = 0; i < n; i += 2) {
+        CHECK(addToCompactTree(tree, &values[order[i]]));
+    }
+    checkTree(tree, n);
+    CHECK(tree->used == used);
+
+    MemoryUsage usage = getCompactTreeMemoryUsage(tree);
+    CHECK(usage.payload == (size_t)n * (inlineBytes > 0 ? inlineBytes : sizeof(void*)));
+
+    destroyCompactTree(tree);
+    CHECK(deleted == (size_t)(n + 1) / 2 + n);
+}
+
+int main(void) {
+    static long long ascending[NUM_KEYS];
+    static long long shuffled[NUM_KEYS];
+    unsigned long long state = TEST_SEED;
+
+    for (int i = 0; i < NUM_KEYS; i++) {
+        ascending[i] = i;
+        shuffled[i] = i;
+    }
+    for (int i = NUM_KEYS - 1; i > 0; i--) {
+        int other = (int)(nextRandom(&state) % (i + 1));
+        long long swap = shuffled[i];
+        shuffled[i] = shuffled[other];
+        shuffled[other] = swap;
+    }
+
+    testTree(0, ascending, NUM_KEYS);
+    testTree(0, shuffled, NUM_KEYS);
+    testTree(sizeof(Wide), ascending, NUM_KEYS);
+    testTree(sizeof(Wide), shuffled, NUM_KEYS);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,122 @@
+/**
+ * Round-trip checks for ConcurrentTreeAPI: threads add and remove keys of
+ * their own while finding everyone's, and afterwards the tree holds exactly
+ * the keys each thread's model says, with every removed item deleted once.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "../ConcurrentTreeAPI.h"
+#include "TestHarness.h"
+
+#define NUM_THREADS 4
+#define NUM_KEYS 4000    //Thread t owns the keys equal to t modulo NUM_THREADS
+#define OPERATIONS 40000
+
+static int values[NUM_KEYS];
+static bool present[NUM_KEYS];    //Written only by the thread owning the key
+static atomic_int deleted;
+static atomic_int wrongFinds;
+static atomic_int removes;
+static ConcurrentTree* shared;
+
+static int compareInts(const void* first, const void* second) {
+    int a = *(const int*)first;
+    int b = *(const int*)second;
+    return (a > b) - (a < b);
+}
+
+static void countDelete(void* toBeDeleted) {
+    (void)toBeDeleted;
+    atomic_fetch_add(&deleted, 1);
+}
+
+/**
+ * Adds and removes the keys of one thread, finding a random key after each change
+ */
+static void* worker(void* argument) {
+    int thread = (int)(long)argument;
+    unsigned long long state = TEST_SEED + thread;
+
+    for (int i = 0; i < OPERATIONS; i++) {
+        unsigned long long random = nextRandom(&state);
+        int key = (int)(random % (NUM_KEYS / NUM_THREADS)) * NUM_THREADS + thread;
+
+        if (present[key]) {
+            removeFromConcurrentTree(shared, &values[key]);
+            present[key] = false;
+            atomic_fetch_add(&removes, 1);
+        }
+        else {
+            addToConcurrentTree(shared, &values[key]);
+            present[key] = true;
+        }
+        if (findInConcurrentTree(shared, &values[key]) != (present[key] ? &values[key] : NULL)) {
+            atomic_fetch_add(&wrongFinds, 1);
+        }
+
+        //Keys of other threads may come and go, but a find never returns a different key
+        int other = (int)((random >> 32) % NUM_KEYS);
+        enterConcurrentTree();
+        int* found = findInConcurrentTree(shared, &values[other]);
+        if (found != NULL && found != &values[other]) {
+            atomic_fetch_add(&wrongFinds, 1);
+        }
+        exitConcurrentTree();
+    }
+    return NULL;
+}
+
+int main(void) {
+    for (int i = 0; i < NUM_KEYS; i++) {
+        values[i] = i;
+    }
+
+    shared = createConcurrentTree(compareInts, countDelete);
+    CHECK(shared != NULL);
+
+    //Duplicates are not added
+    addToConcurrentTree(shared, &values[0]);
+    addToConcurrentTree(shared, &values[0]);
+    CHECK(getConcurrentTreeCount(shared) == 1);
+    removeFromConcurrentTree(shared, &values[0]);
+    CHECK(getConcurrentTreeCount(shared) == 0);
+    CHECK(findInConcurrentTree(shared, &values[0]) == NULL);
+    atomic_fetch_add(&removes, 1);
+
+    pthread_t threads[NUM_THREADS];
+    for (long t = 0; t < NUM_THREADS; t++) {
+        pthread_create(&threads[t], NULL, worker, (void*)t);
+    }
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    CHECK(atomic_load(&wrongFinds) == 0);
+
+    int stored = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        CHECK(findInConcurrentTree(shared, &values[i]) == (present[i] ? &values[i] : NULL));
+        stored += present[i];
+    }
+    CHECK(getConcurrentTreeCount(shared) == stored);
+
+    //Destroying deletes what is left and what was retired but not yet reclaimed
+    destroyConcurrentTree(shared);
+    CHECK(atomic_load(&deleted) == atomic_load(&removes) + stored);
+
+    //Without a delete function, removed and remaining data is left to the caller
+    ConcurrentTree* borrowed = createConcurrentTree(compareInts, NULL);
+    CHECK(borrowed != NULL);
+    for (int i = 0; i < 100; i++) {
+        addToConcurrentTree(borrowed, &values[i]);
+    }
+    for (int i = 0; i < 100; i += 2) {
+        removeFromConcurrentTree(borrowed, &values[i]);
+    }
+    CHECK(getConcurrentTreeCount(borrowed) == 50);
+    destroyConcurrentTree(borrowed);
+    CHECK(values[0] == 0 && values[99] == 99);
+
+    return TEST_RESULT();
+}
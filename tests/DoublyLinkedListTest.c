@@ -0,0 +1,236 @@
+/**
+ * Round-trip checks for DoublyLinkedListAPI: random inserts at both ends,
+ * removes from the front and by value keep the list equal to an array model,
+ * walked forwards and backwards, before and after compactList, with the
+ * memory usage following the nodes in and out of the compacted block. A
+ * sorted list is filled with insertSorted and drained with removeFromFront,
+ * and batched lookups must agree with single ones.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../DoublyLinkedListAPI.h"
+#include "TestHarness.h"
+
+#define NUM_VALUES 2000
+#define NUM_OPERATIONS 20000
+
+static int deleted = 0;
+
+static int compareInts(const void* first, const void* second) {
+    int a = *(const int*)first;
+    int b = *(const int*)second;
+    return (a > b) - (a < b);
+}
+
+static void countDelete(void* toBeDeleted) {
+    (void)toBeDeleted;
+    deleted++;
+}
+
+static bool sameInt(const void* first, const void* second) {
+    return *(const int*)first == *(const int*)second;
+}
+
+static char* printNothing(void* toBePrinted) {
+    (void)toBePrinted;
+    return NULL;
+}
+
+/**
+ * Checks the list holds model[0..n-1] in order from both ends, and its memory usage
+ */
+static void checkList(List* list, int** model, int n) {
+    CHECK(getLength(*list) == n);
+    CHECK(getFromFront(*list) == (n > 0 ? model[0] : NULL));
+    CHECK(getFromBack(*list) == (n > 0 ? model[n - 1] : NULL));
+
+    ListIterator iter = createIterator(*list);
+    int wrong = 0;
+    for (int i = 0; i < n; i++) {
+        wrong += nextElement(&iter) != model[i];
+    }
+    CHECK(nextElement(&iter) == NULL);
+
+    Node* node = list->tail;
+    for (int i = n - 1; i >= 0 && node != NULL; i--) {
+        wrong += node->data != model[i];
+        node = node->previous;
+    }
+    CHECK(node == NULL);
+    CHECK(wrong == 0);
+
+    MemoryUsage usage = getListMemoryUsage(*list);
+    CHECK(usage.payload == sizeof(void*) * n);
+    CHECK(usage.metadata == 2 * sizeof(Node*) * n);
+}
+
+/**
+ * Removes model[i] and closes the gap
+ */
+static void removeAt(int** model, int* n, int i) {
+    memmove(&model[i], &model[i + 1], sizeof(int*) * (*n - i - 1));
+    (*n)--;
+}
+
+/**
+ * Applies random inserts and removes to the list and the model alike
+ */
+static void churn(List* list, int* values, bool* inList, int** model, int* n, unsigned long long* state) {
+    for (int op = 0; op < NUM_OPERATIONS; op++) {
+        int choice = (int)(nextRandom(state) % 4);
+        int value = (int)(nextRandom(state) % NUM_VALUES);
+
+        if (choice == 0 && !inList[value]) {
+            insertFront(list, &values[value]);
+            memmove(&model[1], &model[0], sizeof(int*) * *n);
+            model[0] = &values[value];
+            (*n)++;
+            inList[value] = true;
+        }
+        else if (choice == 1 && !inList[value]) {
+            insertBack(list, &values[value]);
+            model[(*n)++] = &values[value];
+            inList[value] = true;
+        }
+        else if (choice == 2) {
+            int* front = removeFromFront(list);
+            CHECK(front == (*n > 0 ? model[0] : NULL));
+            if (*n > 0) {
+                inList[*model[0]] = false;
+                removeAt(model, n, 0);
+            }
+        }
+        else if (choice == 3) {
+            int* removed = deleteDataFromList(list, &values[value]);
+            CHECK(removed == (inList[value] ? &values[value] : NULL));
+            for (int i = 0; inList[value] && i < *n; i++) {
+                if (model[i] == &values[value]) {
+                    removeAt(model, n, i);
+                    inList[value] = false;
+                }
+            }
+        }
+    }
+}
+
+static void testUnsorted(void) {
+    static int values[NUM_VALUES];
+    static bool inList[NUM_VALUES];
+    static int* model[NUM_VALUES];
+    int n = 0;
+    unsigned long long state = TEST_SEED;
+    for (int i = 0; i < NUM_VALUES; i++) {
+        values[i] = i;
+    }
+
+    List list = initializeList(printNothing, countDelete, compareInts);
+    checkList(&list, model, 0);
+    CHECK(removeFromFront(&list) == NULL);
+    CHECK(compactList(&list));
+
+    churn(&list, values, inList, model, &n, &state);
+    checkList(&list, model, n);
+
+    //All nodes in the block, and none of it spare beyond the allocator's rounding
+    CHECK(compactList(&list));
+    checkList(&list, model, n);
+    CHECK(list.blockSize == n);
+    size_t rounding = getListMemoryUsage(list).slack;
+    CHECK(rounding == allocatorBulkFootprint(NULL, sizeof(Node) * n) - sizeof(Node) * n);
+
+    //Removed block nodes stay as slack until the next compaction
+    int removed = 0;
+    while (removed < n / 4) {
+        CHECK(removeFromFront(&list) == model[0]);
+        inList[*model[0]] = false;
+        removeAt(model, &n, 0);
+        removed++;
+    }
+    checkList(&list, model, n);
+    CHECK(getListMemoryUsage(list).slack == rounding + sizeof(Node) * removed);
+
+    //Nodes from before and after the compaction mixed, then compacted again
+    churn(&list, values, inList, model, &n, &state);
+    checkList(&list, model, n);
+    CHECK(compactList(&list));
+    checkList(&list, model, n);
+
+    deleted = 0;
+    clearList(&list);
+    CHECK(deleted == n);
+    checkList(&list, model, 0);
+    CHECK(compactList(&list));
+}
+
+/**
+ * Looks up batches of values, about half of them missing, with findManyInList
+ * and compares each result with findElement
+ */
+static void testFindMany(void) {
+    static int values[NUM_VALUES];
+    static int probes[1000];
+    const void* records[1000];
+    void* out[1000];
+    unsigned long long state = TEST_SEED;
+    List list = initializeList(printNothing, NULL, compareInts);
+    for (int i = 0; i < NUM_VALUES; i++) {
+        values[i] = 2 * i;
+        insertBack(&list, &values[i]);
+    }
+
+    int sizes[] = {0, 1, 15, 16, 17, 1000};
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int n = sizes[s];
+        for (int i = 0; i < n; i++) {
+            probes[i] = (int)(nextRandom(&state) % (2 * NUM_VALUES + 10)) - 5;
+            records[i] = &probes[i];
+            out[i] = &probes[i];
+        }
+
+        int found = findManyInList(list, sameInt, records, n, out);
+        int expected = 0;
+        for (int i = 0; i < n; i++) {
+            void* single = findElement(list, sameInt, &probes[i]);
+            CHECK(out[i] == single);
+            expected += single != NULL;
+        }
+        CHECK(found == expected);
+    }
+
+    clearList(&list);
+}
+
+static void testSorted(void) {
+    static int values[NUM_VALUES];
+    unsigned long long state = TEST_SEED;
+    List list = initializeList(printNothing, countDelete, compareInts);
+
+    for (int i = 0; i < NUM_VALUES; i++) {
+        values[i] = (int)(nextRandom(&state) % 500);    //Repeats, so equal values are covered
+        insertSorted(&list, &values[i]);
+    }
+    CHECK(getLength(list) == NUM_VALUES);
+    CHECK(compactList(&list));
+
+    int last = -1;
+    int taken = 0;
+    int* front;
+    while ((front = removeFromFront(&list)) != NULL) {
+        CHECK(*front >= last);
+        last = *front;
+        taken++;
+    }
+    CHECK(taken == NUM_VALUES);
+    CHECK(getLength(list) == 0);
+    CHECK(list.head == NULL && list.tail == NULL);
+    clearList(&list);
+}
+
+int main(void) {
+    testUnsorted();
+    testSorted();
+    testFindMany();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,68 @@
+/**
+ * Round-trip checks for FrozenTreeAPI: snapshots of every size up to a few
+ * full levels, and one larger, answer lower bound, find and key lookups for
+ * every query in and around their range the same way a sorted array does.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../FrozenTreeAPI.h"
+#include "TestHarness.h"
+
+#define MAX_SMALL 70
+#define LARGE 5000
+
+static int compareInts(const void* first, const void* second) {
+    int a = *(const int*)first;
+    int b = *(const int*)second;
+    return (a > b) - (a < b);
+}
+
+static long long intKey(const void* data) {
+    return *(const int*)data;
+}
+
+static void printInt(void* data) {
+    printf("%d ", *(int*)data);
+}
+
+/**
+ * Freezes a tree holding 0, 2, ..., 2(n - 1) and queries every value from -1 to 2n
+ */
+static void testSize(int n, int values[]) {
+    Tree* tree = createBinTreeWithMode(compareInts, NULL, printInt, TREE_AVL);
+    for (int i = n - 1; i >= 0; i--) {
+        values[i] = 2 * i;
+        addToTree(tree, &values[i]);
+    }
+
+    FrozenTree* frozen = freezeTree(tree);
+    FrozenTree* keyed = freezeTreeWithKeys(tree, intKey);
+    CHECK(frozen != NULL && keyed != NULL);
+    CHECK(frozen->count == n && keyed->count == n);
+    CHECK(findKeyInFrozenTree(frozen, 0) == NULL);
+
+    for (int query = -1; query <= 2 * n; query++) {
+        int* lower = frozenLowerBound(frozen, &query);
+        int expectedLower = query < 0 ? 0 : (query + 1) / 2;
+        CHECK(lower == (expectedLower < n ? &values[expectedLower] : NULL));
+
+        int* expected = query >= 0 && query % 2 == 0 && query / 2 < n ? &values[query / 2] : NULL;
+        CHECK(findInFrozenTree(frozen, &query) == expected);
+        CHECK(findKeyInFrozenTree(keyed, query) == expected);
+    }
+
+    destroyFrozenTree(frozen);
+    destroyFrozenTree(keyed);
+    destroyBinTree(tree);
+}
+
+int main(void) {
+    static int values[LARGE];
+
+    for (int n = 0; n <= MAX_SMALL; n++) {
+        testSize(n, values);
+    }
+    testSize(LARGE, values);
+
+    return TEST_RESULT();
+}
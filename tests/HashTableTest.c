@@ -0,0 +1,198 @@
+/**
+ * Round-trip checks for HashTableAPI: keys sharing a probe run, including one
+ * that wraps past the last slot, removed from the front, middle and end of
+ * the run, then looked up, removed and inserted again. compactTable is run
+ * on tables created with a custom hash function and with none.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../HashTableAPI.h"
+#include "TestHarness.h"
+
+#define TABLE_SIZE 16
+#define RUN_LENGTH 6
+#define KEY_CHARS 16
+
+/**
+ * Counts the slots holding key, a key inserted twice shows up twice
+ */
+static int countCopies(HTable* table, string key) {
+    int copies = 0;
+    for (size_t i = 0; i < table->size; i++) {
+        copies += table->table[i] != NULL && strcmp(table->table[i]->key, key) == 0;
+    }
+    return copies;
+}
+
+/**
+ * Fills keys with RUN_LENGTH names hashing to home
+ */
+static void findCollidingKeys(char keys[][KEY_CHARS], size_t home) {
+    int found = 0;
+    for (int i = 0; found < RUN_LENGTH; i++) {
+        snprintf(keys[found], KEY_CHARS, "key%d", i);
+        if ((size_t)hashNode(TABLE_SIZE, keys[found]) == home) {
+            found++;
+        }
+    }
+}
+
+/**
+ * Removes the key at position victim of a colliding run and checks the rest of the run
+ */
+static void testRemoveFromRun(size_t home, int victim) {
+    char keys[RUN_LENGTH][KEY_CHARS];
+    findCollidingKeys(keys, home);
+
+    HTable* table = createTable(TABLE_SIZE, hashNode, destroyNodeData, printNodeData);
+    for (int i = 0; i < RUN_LENGTH; i++) {
+        insertData(table, keys[i], keys[i]);
+    }
+
+    removeData(table, keys[victim]);
+    for (int i = 0; i < RUN_LENGTH; i++) {
+        Node* node = lookupData(table, keys[i]);
+        CHECK((node != NULL) == (i != victim));
+        CHECK(node == NULL || node->data == keys[i]);
+    }
+
+    //Inserting a key still in the run must not add a second copy, and the removed one comes back once
+    for (int i = 0; i < RUN_LENGTH; i++) {
+        if (i != victim) {
+            removeData(table, keys[i]);
+            CHECK(lookupData(table, keys[i]) == NULL);
+            insertData(table, keys[i], keys[i]);
+        }
+    }
+    insertData(table, keys[victim], keys[victim]);
+    for (int i = 0; i < RUN_LENGTH; i++) {
+        CHECK(countCopies(table, keys[i]) == 1);
+        CHECK(lookupData(table, keys[i]) != NULL);
+    }
+
+    //Emptying the run leaves every slot free
+    for (int i = 0; i < RUN_LENGTH; i++) {
+        removeData(table, keys[i]);
+    }
+    for (size_t i = 0; i < table->size; i++) {
+        CHECK(table->table[i] == NULL);
+    }
+
+    destroyTable(table);
+}
+
+/**
+ * Two interleaved runs with different homes, removing from the first must not strand the second
+ */
+static void testInterleavedRuns(void) {
+    char first[RUN_LENGTH][KEY_CHARS];
+    char second[RUN_LENGTH][KEY_CHARS];
+    findCollidingKeys(first, 3);
+    findCollidingKeys(second, 5);
+
+    HTable* table = createTable(TABLE_SIZE, hashNode, destroyNodeData, printNodeData);
+    for (int i = 0; i < RUN_LENGTH; i++) {
+        insertData(table, first[i], first[i]);
+        insertData(table, second[i], second[i]);
+    }
+
+    for (int i = 0; i < RUN_LENGTH; i += 2) {
+        removeData(table, first[i]);
+    }
+    for (int i = 0; i < RUN_LENGTH; i++) {
+        CHECK((lookupData(table, first[i]) != NULL) == (i % 2 == 1));
+        CHECK(lookupData(table, second[i]) != NULL);
+    }
+
+    destroyTable(table);
+}
+
+/**
+ * Hash that agrees with hashNode on nothing, compactTable must not place nodes with it
+ */
+static int lengthHash(size_t tableSize, string key) {
+    return (int)(strlen(key) * 7 % tableSize);
+}
+
+static void testCompact(int (*hashFunction)(size_t tableSize, string key)) {
+    char keys[200][KEY_CHARS];
+    HTable* table = createTable(512, hashFunction, destroyNodeData, printNodeData);
+
+    for (int i = 0; i < 200; i++) {
+        snprintf(keys[i], KEY_CHARS, "key%d", i);
+        insertData(table, keys[i], keys[i]);
+    }
+    for (int i = 0; i < 200; i += 2) {
+        removeData(table, keys[i]);
+    }
+
+    //Shrinks to twice the nodes, then to exactly the nodes so every slot is used
+    for (size_t newSize = 0; newSize <= 100; newSize += 100) {
+        CHECK(compactTable(table, newSize));
+        for (int i = 0; i < 200; i++) {
+            Node* node = lookupData(table, keys[i]);
+            CHECK((node != NULL) == (i % 2 == 1));
+            CHECK(node == NULL || node->data == keys[i]);
+        }
+    }
+    CHECK(table->size == 100);
+
+    //The compacted table keeps working for removes and inserts
+    for (int i = 1; i < 200; i += 4) {
+        removeData(table, keys[i]);
+    }
+    for (int i = 0; i < 200; i += 4) {
+        insertData(table, keys[i], keys[i]);
+    }
+    for (int i = 0; i < 200; i++) {
+        CHECK((lookupData(table, keys[i]) != NULL) == (i % 4 == 0 || i % 4 == 3));
+        CHECK(countCopies(table, keys[i]) <= 1);
+    }
+
+    destroyTable(table);
+}
+
+static void* mallocObject(void* state, size_t size) {
+    (void)state;
+    return malloc(size);
+}
+
+static void freeObject(void* state, void* toRelease, size_t size) {
+    (void)state;
+    (void)size;
+    free(toRelease);
+}
+
+static void* failBulk(void* state, size_t size) {
+    (void)state;
+    (void)size;
+    return NULL;
+}
+
+/**
+ * A slot array the allocator cannot give, as when huge pages run out, makes creation fail cleanly
+ */
+static void testFailedCreate(void) {
+    Allocator failing = {mallocObject, freeObject, NULL, failBulk, freeObject};
+    CHECK(createTableWithAllocator(TABLE_SIZE, hashNode, destroyNodeData, printNodeData, &failing) == NULL);
+
+    HTable* table = createTableWithAllocator(TABLE_SIZE, hashNode, destroyNodeData, printNodeData, NULL);
+    CHECK(table != NULL);
+    destroyTable(table);
+}
+
+int main(void) {
+    for (int victim = 0; victim < RUN_LENGTH; victim++) {
+        testRemoveFromRun(3, victim);
+        //This run wraps from the last slots back to the first ones
+        testRemoveFromRun(TABLE_SIZE - 2, victim);
+    }
+    testInterleavedRuns();
+    testCompact(hashNode);
+    testCompact(lengthHash);
+    testCompact(NULL);
+    testFailedCreate();
+
+    return TEST_RESULT();
+}
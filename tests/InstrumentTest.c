@@ -0,0 +1,251 @@
+/**
+ * Round-trip checks for InstrumentAPI, built with DS_INSTRUMENT together with
+ * the list it drives: list operations record the values they should, values
+ * land in the right power of two bucket up to the last one, threads that
+ * exit keep their totals and hand their block to the next thread, and
+ * statsToJSON gives valid JSON before and after resetStats.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
+#include "../InstrumentAPI.h"
+#include "../DoublyLinkedListAPI.h"
+#include "TestHarness.h"
+
+#define NUM_VALUES 100
+#define NUM_THREADS 4
+#define VALUES_PER_THREAD 1000
+
+static int compareInts(const void* first, const void* second) {
+    int a = *(const int*)first;
+    int b = *(const int*)second;
+    return (a > b) - (a < b);
+}
+
+/**
+ * Index of the bucket holding value, bucket b holding [2^(b-1), 2^b)
+ */
+static int expectedBucket(unsigned long long value) {
+    int bucket = 0;
+    while (value != 0 && bucket < STAT_BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    return value > 1 ? STAT_BUCKETS - 1 : bucket;
+}
+
+static void skipSpace(const char** text) {
+    while (isspace((unsigned char)**text)) {
+        (*text)++;
+    }
+}
+
+static bool parseValue(const char** text);
+
+static bool parseString(const char** text) {
+    if (**text != '"') {
+        return false;
+    }
+    for ((*text)++; **text != '"'; (*text)++) {
+        if (**text == '\0' || **text == '\\') {
+            return false;
+        }
+    }
+    (*text)++;
+    return true;
+}
+
+/**
+ * Accepts the subset of JSON statsToJSON writes: objects, strings without
+ * escapes, numbers and true or false
+ */
+static bool parseValue(const char** text) {
+    skipSpace(text);
+    if (**text == '{') {
+        (*text)++;
+        skipSpace(text);
+        if (**text == '}') {
+            (*text)++;
+            return true;
+        }
+        while (true) {
+            skipSpace(text);
+            if (!parseString(text)) {
+                return false;
+            }
+            skipSpace(text);
+            if (**text != ':') {
+                return false;
+            }
+            (*text)++;
+            if (!parseValue(text)) {
+                return false;
+            }
+            skipSpace(text);
+            if (**text == '}') {
+                (*text)++;
+                return true;
+            }
+            if (**text != ',') {
+                return false;
+            }
+            (*text)++;
+        }
+    }
+    if (**text == '"') {
+        return parseString(text);
+    }
+    if (strncmp(*text, "true", 4) == 0 || strncmp(*text, "false", 5) == 0) {
+        *text += **text == 't' ? 4 : 5;
+        return true;
+    }
+
+    char* end;
+    strtod(*text, &end);
+    if (end == *text) {
+        return false;
+    }
+    *text = end;
+    return true;
+}
+
+static bool validJSON(const char* text) {
+    if (text == NULL || !parseValue(&text)) {
+        return false;
+    }
+    skipSpace(&text);
+    return *text == '\0';
+}
+
+/**
+ * Inserts and removes list nodes and checks the allocations and frees recorded
+ */
+static void testListStats(void) {
+    static int values[NUM_VALUES];
+    List list = initializeList(NULL, NULL, compareInts);
+    for (int i = 0; i < NUM_VALUES; i++) {
+        values[i] = i;
+        insertBack(&list, &values[i]);
+    }
+    for (int i = 0; i < NUM_VALUES; i += 2) {
+        deleteDataFromList(&list, &values[i]);
+    }
+
+    StatSummary allocs;
+    getStats(STATS_LIST, STAT_ALLOCS, &allocs);
+    CHECK(allocs.count == NUM_VALUES);
+    CHECK(allocs.sum == sizeof(Node) * NUM_VALUES);
+    CHECK(allocs.max == sizeof(Node));
+    CHECK(allocs.histogram[expectedBucket(sizeof(Node))] == NUM_VALUES);
+
+    StatSummary frees;
+    getStats(STATS_LIST, STAT_FREES, &frees);
+    CHECK(frees.count == NUM_VALUES / 2);
+    CHECK(frees.sum == sizeof(Node) * (NUM_VALUES / 2));
+
+    //Value i is found after i / 2 + 1 compares, the even ones before it being gone
+    StatSummary compares;
+    getStats(STATS_LIST, STAT_COMPARES, &compares);
+    CHECK(compares.count == NUM_VALUES / 2);
+    CHECK(compares.max == NUM_VALUES / 2);
+
+    clearList(&list);
+    getStats(STATS_LIST, STAT_FREES, &frees);
+    CHECK(frees.count == NUM_VALUES);
+}
+
+static void testBuckets(void) {
+    unsigned long long values[] = {0, 1, 2, 3, 4, 1ULL << 30, (1ULL << 31) - 1, 1ULL << 31, (1ULL << 31) + 1, 1ULL << 40, ULLONG_MAX};
+    int buckets[] = {0, 1, 2, 2, 3, STAT_BUCKETS - 1, STAT_BUCKETS - 1, STAT_BUCKETS - 1, STAT_BUCKETS - 1, STAT_BUCKETS - 1, STAT_BUCKETS - 1};
+    int numValues = (int)(sizeof(values) / sizeof(values[0]));
+
+    for (int i = 0; i < numValues; i++) {
+        CHECK(expectedBucket(values[i]) == buckets[i]);
+        resetStats();
+        recordStat(STATS_TREE, STAT_DEPTH, values[i]);
+
+        StatSummary summary;
+        getStats(STATS_TREE, STAT_DEPTH, &summary);
+        CHECK(summary.count == 1 && summary.sum == values[i] && summary.max == values[i]);
+        for (int b = 0; b < STAT_BUCKETS; b++) {
+            CHECK(summary.histogram[b] == (b == buckets[i] ? 1ULL : 0ULL));
+        }
+    }
+}
+
+static void* recordDepths(void* argument) {
+    int count = (int)(long)argument;
+    for (int i = 1; i <= count; i++) {
+        recordStat(STATS_TREE, STAT_DEPTH, (unsigned long long)i);
+    }
+    return NULL;
+}
+
+/**
+ * Totals of exited threads stay, and a new thread adds to the block one left
+ */
+static void testThreads(void) {
+    resetStats();
+    pthread_t threads[NUM_THREADS];
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_create(&threads[t], NULL, recordDepths, (void*)(long)VALUES_PER_THREAD);
+    }
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    StatSummary summary;
+    getStats(STATS_TREE, STAT_DEPTH, &summary);
+    CHECK(summary.count == NUM_THREADS * VALUES_PER_THREAD);
+    CHECK(summary.sum == NUM_THREADS * (VALUES_PER_THREAD * (VALUES_PER_THREAD + 1ULL) / 2));
+    CHECK(summary.max == VALUES_PER_THREAD);
+
+    //One at a time, so each thread claims the block the one before released
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_create(&threads[t], NULL, recordDepths, (void*)(long)(VALUES_PER_THREAD * 2));
+        pthread_join(threads[t], NULL);
+    }
+    getStats(STATS_TREE, STAT_DEPTH, &summary);
+    CHECK(summary.count == NUM_THREADS * VALUES_PER_THREAD * 3);
+    CHECK(summary.max == VALUES_PER_THREAD * 2);
+}
+
+static void testJSON(void) {
+    char* json = statsToJSON();
+    CHECK(validJSON(json));
+    CHECK(json != NULL && strstr(json, "\"enabled\": true") != NULL);
+    CHECK(json != NULL && strstr(json, "\"tree\": {\"depth\": {\"count\": ") != NULL);
+    free(json);
+
+    resetStats();
+    json = statsToJSON();
+    CHECK(json != NULL && strcmp(json, "{\"enabled\": true, \"stats\": {}}") == 0);
+    free(json);
+
+    //Every structure and kind at once
+    for (int s = 0; s < STATS_NUM_STRUCTURES; s++) {
+        for (int k = 0; k < STAT_NUM_KINDS; k++) {
+            recordStat(s, k, (unsigned long long)(s * STAT_NUM_KINDS + k) << 20);
+        }
+    }
+    json = statsToJSON();
+    CHECK(validJSON(json));
+    free(json);
+
+    CHECK(!validJSON("{\"a\": 1,}"));
+    CHECK(!validJSON("{\"a\" 1}"));
+}
+
+int main(void) {
+    CHECK(statsEnabled());
+
+    testListStats();
+    testBuckets();
+    testThreads();
+    testJSON();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,100 @@
+/**
+ * Round-trip checks for MultiQueueAPI: every inserted item is popped exactly
+ * once with its own priority, by one thread and by several threads inserting
+ * and popping at the same time, and an empty queue pops NULL.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "../MultiQueueAPI.h"
+#include "TestHarness.h"
+
+#define NUM_THREADS 4
+#define ITEMS_PER_THREAD 20000
+#define NUM_ITEMS (NUM_THREADS * ITEMS_PER_THREAD)
+
+static long priorities[NUM_ITEMS];    //Priority inserted with &priorities[i]
+static atomic_int popped[NUM_ITEMS];
+static atomic_int wrongPriorities;
+static MultiQueue* shared;
+
+/**
+ * Records one popped item, checking it carries the priority it was inserted with
+ */
+static void recordPop(void* data, long priority) {
+    long* item = data;
+    if (*item != priority) {
+        atomic_fetch_add(&wrongPriorities, 1);
+    }
+    atomic_fetch_add(&popped[item - priorities], 1);
+}
+
+/**
+ * Inserts its share of the items, popping one after every second insert
+ */
+static void* worker(void* argument) {
+    int first = (int)(long)argument * ITEMS_PER_THREAD;
+    for (int i = first; i < first + ITEMS_PER_THREAD; i++) {
+        multiQueueInsert(shared, priorities[i], &priorities[i]);
+        long priority;
+        void* data = i % 2 == 1 ? multiQueuePop(shared, &priority) : NULL;
+        if (data != NULL) {
+            recordPop(data, priority);
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        priorities[i] = (long)((i * 2654435761u) % 100000) - 50000;
+    }
+
+    //One thread: what goes in comes out, and then the queue is empty
+    MultiQueue* queue = createMultiQueue(1, MULTIQUEUE_DEFAULT_FACTOR, NULL);
+    CHECK(queue != NULL);
+    long priority = 0;
+    CHECK(multiQueuePop(queue, &priority) == NULL);
+    for (int i = 0; i < ITEMS_PER_THREAD; i++) {
+        CHECK(multiQueueInsert(queue, priorities[i], &priorities[i]));
+    }
+    CHECK(getMultiQueueCount(queue) == ITEMS_PER_THREAD);
+    void* data;
+    while ((data = multiQueuePop(queue, &priority)) != NULL) {
+        recordPop(data, priority);
+    }
+    CHECK(getMultiQueueCount(queue) == 0);
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        CHECK(atomic_load(&popped[i]) == (i < ITEMS_PER_THREAD));
+        atomic_store(&popped[i], 0);
+    }
+    //Items still queued are left to their owner when there is no delete function
+    CHECK(multiQueueInsert(queue, 0, &priorities[0]));
+    destroyMultiQueue(queue);
+
+    //Several threads inserting and popping, the rest drained afterwards
+    shared = createMultiQueue(NUM_THREADS, MULTIQUEUE_DEFAULT_FACTOR, NULL);
+    CHECK(shared != NULL);
+    pthread_t threads[NUM_THREADS];
+    for (long t = 0; t < NUM_THREADS; t++) {
+        pthread_create(&threads[t], NULL, worker, (void*)t);
+    }
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    while ((data = multiQueuePop(shared, &priority)) != NULL) {
+        recordPop(data, priority);
+    }
+    CHECK(getMultiQueueCount(shared) == 0);
+
+    int missing = 0;
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        missing += atomic_load(&popped[i]) != 1;
+    }
+    CHECK(missing == 0);
+    CHECK(atomic_load(&wrongPriorities) == 0);
+
+    destroyMultiQueue(shared);
+    return TEST_RESULT();
+}
@@ -0,0 +1,144 @@
+/**
+ * Round-trip checks for PersistentTreeAPI: a chain of versions made by
+ * random adds and removes, each checked against its own model after every
+ * later version was made, then released out of order with every piece of
+ * data deleted exactly once, when its last version goes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../PersistentTreeAPI.h"
+#include "TestHarness.h"
+
+#define NUM_KEYS 200
+#define NUM_VERSIONS 400
+
+static int allocated = 0;
+static int deleted = 0;
+
+static int compareInts(const void* first, const void* second) {
+    int a = *(const int*)first;
+    int b = *(const int*)second;
+    return (a > b) - (a < b);
+}
+
+static void deleteInt(void* data) {
+    deleted++;
+    free(data);
+}
+
+static void printInt(void* data) {
+    printf("%d ", *(int*)data);
+}
+
+/**
+ * Fewest nodes an AVL tree of the given height can have
+ */
+static long minimumAVLSize(int height) {
+    long smaller = 0;
+    long size = height > 0 ? 1 : 0;
+    for (int h = 2; h <= height; h++) {
+        long next = size + smaller + 1;
+        smaller = size;
+        size = next;
+    }
+    return size;
+}
+
+/**
+ * Checks a version holds exactly the keys marked in present, in order and with an AVL height
+ */
+static void checkVersion(PersistentTree* version, const bool* present) {
+    static TreeDataPtr out[NUM_KEYS];
+    int expected = 0;
+    for (int key = 0; key < NUM_KEYS; key++) {
+        int* found = findInPersistentTree(version, &key);
+        CHECK((found != NULL) == present[key]);
+        CHECK(found == NULL || *found == key);
+        expected += present[key];
+    }
+
+    CHECK(getPersistentTreeSize(version) == expected);
+    CHECK(persistentTreeToArray(version, out, NUM_KEYS) == expected);
+    for (int i = 1; i < expected; i++) {
+        CHECK(*(int*)out[i - 1] < *(int*)out[i]);
+    }
+    CHECK(minimumAVLSize(getPersistentTreeHeight(version)) <= expected);
+}
+
+int main(void) {
+    static PersistentTree* versions[NUM_VERSIONS];
+    static bool models[NUM_VERSIONS][NUM_KEYS];
+    unsigned long long state = TEST_SEED;
+
+    versions[0] = createPersistentTree(compareInts, deleteInt, printInt);
+    CHECK(versions[0] != NULL);
+    CHECK(getPersistentTreeHeight(versions[0]) == 0);
+
+    //Each version changes one key of the one before, most of the time by adding
+    for (int v = 1; v < NUM_VERSIONS; v++) {
+        int key = (int)(nextRandom(&state) % NUM_KEYS);
+        memcpy(models[v], models[v - 1], sizeof(models[v]));
+        if (models[v][key] && nextRandom(&state) % 3 == 0) {
+            versions[v] = removeFromPersistentTree(versions[v - 1], &key);
+            models[v][key] = false;
+        }
+        else if (!models[v][key]) {
+            int* data = malloc(sizeof(int));
+            *data = key;
+            allocated++;
+            versions[v] = addToPersistentTree(versions[v - 1], data);
+            models[v][key] = true;
+        }
+        else {
+            versions[v] = snapshotPersistentTree(versions[v - 1]);
+        }
+        CHECK(versions[v] != NULL);
+    }
+
+    //Later versions must not have changed any earlier one
+    for (int v = 0; v < NUM_VERSIONS; v++) {
+        checkVersion(versions[v], models[v]);
+    }
+
+    //Release in a shuffled order, the versions still held stay intact
+    int order[NUM_VERSIONS];
+    for (int v = 0; v < NUM_VERSIONS; v++) {
+        order[v] = v;
+    }
+    for (int v = NUM_VERSIONS - 1; v > 0; v--) {
+        int other = (int)(nextRandom(&state) % (v + 1));
+        int swap = order[v];
+        order[v] = order[other];
+        order[other] = swap;
+    }
+    for (int i = 0; i < NUM_VERSIONS; i++) {
+        releasePersistentTree(versions[order[i]]);
+        versions[order[i]] = NULL;
+        if (i == NUM_VERSIONS / 2) {
+            for (int v = 0; v < NUM_VERSIONS; v++) {
+                if (versions[v] != NULL) {
+                    checkVersion(versions[v], models[v]);
+                }
+            }
+            CHECK(deleted < allocated);
+        }
+    }
+    CHECK(deleted == allocated);
+
+    //Without a delete function, data whose last version is released stays with the caller
+    int keys[] = {3, 1, 2};
+    PersistentTree* borrowed = createPersistentTree(compareInts, NULL, printInt);
+    for (int i = 0; i < 3 && borrowed != NULL; i++) {
+        PersistentTree* next = addToPersistentTree(borrowed, &keys[i]);
+        releasePersistentTree(borrowed);
+        borrowed = next;
+    }
+    CHECK(borrowed != NULL && getPersistentTreeSize(borrowed) == 3);
+    PersistentTree* smaller = removeFromPersistentTree(borrowed, &keys[0]);
+    releasePersistentTree(borrowed);
+    releasePersistentTree(smaller);
+    CHECK(deleted == allocated);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,133 @@
+/**
+ * Round-trip checks for PriorityQueueAPI: the sorted list queue, a heap
+ * loaded with createQueueFromArray and a bounded top-k queue give back the
+ * same items best first through peek, pop and popBatch, with deleteNode and
+ * compactQueue in between.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "../PriorityQueueAPI.h"
+#include "TestHarness.h"
+
+#define NUM_ITEMS 3000
+#define BOUND 100
+#define BATCH 64
+
+static int deleted = 0;
+
+static int compareInts(const void* first, const void* second) {
+    int a = *(const int*)first;
+    int b = *(const int*)second;
+    return (a > b) - (a < b);
+}
+
+static void countDelete(void* toBeDeleted) {
+    (void)toBeDeleted;
+    deleted++;
+}
+
+static char* printNothing(void* toBePrinted) {
+    (void)toBePrinted;
+    return NULL;
+}
+
+/**
+ * Empties queue with peek and pop, then popBatch, checking the items come out in order
+ * @return number of items taken out
+ */
+static int drainInOrder(Queue* queue) {
+    int taken = 0;
+    int last = -1;
+
+    //Half one at a time, the rest in batches
+    while (isEmpty(queue) == 1 && taken < queue->count) {
+        int* top = peek(queue);
+        CHECK(*top >= last);
+        last = *top;
+        pop(queue);
+        taken++;
+    }
+
+    void* out[BATCH];
+    int popped;
+    while ((popped = popBatch(queue, BATCH, out)) > 0) {
+        for (int i = 0; i < popped; i++) {
+            CHECK(*(int*)out[i] >= last);
+            last = *(int*)out[i];
+        }
+        taken += popped;
+    }
+
+    CHECK(isEmpty(queue) == 0);
+    CHECK(peek(queue) == NULL);
+    return taken;
+}
+
+int main(void) {
+    static int values[NUM_ITEMS];
+    void* items[NUM_ITEMS];
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        values[i] = (int)((i * 2654435761u) % 1000);    //Repeats, so equal items are covered
+        items[i] = &values[i];
+    }
+
+    Queue* list = createQueue(printNothing, countDelete, compareInts);
+    CHECK(list != NULL);
+    for (int i = 0; i < NUM_ITEMS / 10; i++) {
+        CHECK(insert(list, items[i]));
+    }
+    deleteNode(list, items[7]);
+    CHECK(list->count == NUM_ITEMS / 10 - 1);
+    CHECK(compactQueue(list));
+    CHECK(drainInOrder(list) == NUM_ITEMS / 10 - 1);
+    destroy(list);
+
+    Queue* heap = createQueueFromArray(printNothing, countDelete, compareInts, items, NUM_ITEMS);
+    CHECK(heap != NULL);
+    CHECK(heap->count == NUM_ITEMS);
+    CHECK(*(int*)peek(heap) == 0);
+    deleteNode(heap, items[3]);
+    CHECK(heap->count == NUM_ITEMS - 1);
+    CHECK(insert(heap, items[3]));
+    CHECK(compactQueue(heap));
+    CHECK(heap->capacity == heap->count);
+    CHECK(drainInOrder(heap) == NUM_ITEMS);
+    CHECK(insert(heap, items[0]));
+    CHECK(peek(heap) == items[0]);
+    destroy(heap);
+
+    //Top-k keeps the BOUND smallest and hands every other item to the delete function
+    Queue* bounded = createBoundedQueue(printNothing, countDelete, compareInts, BOUND);
+    CHECK(bounded != NULL);
+    deleted = 0;
+    int best = values[0];
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        CHECK(insert(bounded, items[i]));
+        best = values[i] < best ? values[i] : best;
+        //Peeking finds the best kept item and leaves the worst on top for the next insert
+        CHECK(*(int*)peek(bounded) == best);
+        CHECK(bounded->order == -1);
+    }
+    CHECK(bounded->count == BOUND);
+    CHECK(deleted == NUM_ITEMS - BOUND);
+
+    int smaller = 0;
+    int kept[BOUND];
+    void* out[BOUND];
+    CHECK(popBatch(bounded, BOUND, out) == BOUND);
+    for (int i = 0; i < BOUND; i++) {
+        kept[i] = *(int*)out[i];
+        CHECK(i == 0 || kept[i - 1] <= kept[i]);
+    }
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        smaller += values[i] < kept[BOUND - 1];
+    }
+    CHECK(smaller < BOUND);
+    CHECK(isEmpty(bounded) == 0);
+    destroy(bounded);
+
+    CHECK(createBoundedQueue(printNothing, countDelete, compareInts, 0) == NULL);
+    CHECK(createBoundedQueue(printNothing, countDelete, compareInts, -1) == NULL);
+
+    return TEST_RESULT();
+}
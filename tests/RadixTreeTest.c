@@ -0,0 +1,152 @@
+/**
+ * Round-trip checks for RadixTreeAPI: keys sharing long prefixes added,
+ * found and removed until every node type has grown and shrunk again,
+ * longest prefix matches, and prefix and range visits in strcmp order.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../RadixTreeAPI.h"
+#include "TestHarness.h"
+
+#define NUM_KEYS 600
+#define KEY_CHARS 32
+
+typedef struct visitCheck {
+    const char* previous;    //Last key visited, NULL before the first
+    int visited;
+    bool ordered;
+} VisitCheck;
+
+static int checkOrder(const char* key, void* data, void* context) {
+    VisitCheck* check = context;
+    check->ordered &= check->previous == NULL || strcmp(check->previous, key) < 0;
+    check->ordered &= strcmp(key, data) == 0;
+    check->previous = key;
+    check->visited++;
+    return 0;
+}
+
+static int stopAtThird(const char* key, void* data, void* context) {
+    (void)key;
+    (void)data;
+    return ++*(int*)context == 3 ? 7 : 0;
+}
+
+/**
+ * Counts the keys in [lo, hi] with lo and hi NULL for no bound, the expected size of a range visit
+ */
+static int countInRange(char keys[][KEY_CHARS], int numKeys, const char* lo, const char* hi, const char* prefix) {
+    int count = 0;
+    for (int i = 0; i < numKeys; i++) {
+        if ((lo == NULL || strcmp(keys[i], lo) >= 0) && (hi == NULL || strcmp(keys[i], hi) <= 0)
+            && (prefix == NULL || strncmp(keys[i], prefix, strlen(prefix)) == 0)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+int main(void) {
+    static char keys[NUM_KEYS][KEY_CHARS];
+    RadixTree* tree = createRadixTree(NULL);
+    CHECK(tree != NULL);
+
+    //Fan outs of up to 256 below "/a/" and chains of single children below "/b/"
+    for (int i = 0; i < NUM_KEYS; i++) {
+        if (i % 2 == 0) {
+            snprintf(keys[i], KEY_CHARS, "/a/%c%d", (char)(1 + i / 2 % 255), i);
+        } else {
+            snprintf(keys[i], KEY_CHARS, "/b/long/shared/path/%d", i);
+        }
+        addToRadixTree(tree, keys[i], keys[i]);
+    }
+    CHECK(tree->count == NUM_KEYS);
+
+    //Duplicates are not added
+    char duplicate[KEY_CHARS];
+    strcpy(duplicate, keys[5]);
+    addToRadixTree(tree, duplicate, duplicate);
+    CHECK(tree->count == NUM_KEYS);
+    CHECK(findInRadixTree(tree, keys[5]) == keys[5]);
+
+    for (int i = 0; i < NUM_KEYS; i++) {
+        CHECK(findInRadixTree(tree, keys[i]) == keys[i]);
+    }
+    CHECK(findInRadixTree(tree, "/a/") == NULL);
+    CHECK(findInRadixTree(tree, "/b/long/shared/path/") == NULL);
+    CHECK(findInRadixTree(tree, "/b/long/shared/path/1x") == NULL);
+
+    VisitCheck all = {NULL, 0, true};
+    CHECK(visitRadixTree(tree, checkOrder, &all) == 0);
+    CHECK(all.ordered && all.visited == NUM_KEYS);
+
+    int calls = 0;
+    CHECK(visitRadixTree(tree, stopAtThird, &calls) == 7);
+    CHECK(calls == 3);
+
+    VisitCheck prefix = {NULL, 0, true};
+    CHECK(visitRadixPrefix(tree, "/b/long/shared/path/1", checkOrder, &prefix) == 0);
+    CHECK(prefix.ordered && prefix.visited == countInRange(keys, NUM_KEYS, NULL, NULL, "/b/long/shared/path/1"));
+
+    VisitCheck none = {NULL, 0, true};
+    CHECK(visitRadixPrefix(tree, "/c", checkOrder, &none) == 0);
+    CHECK(none.visited == 0);
+
+    const char* bounds[][2] = {{NULL, NULL}, {"/a/\x10", "/a/\x40"}, {"/b/long/shared/path/3", NULL},
+                               {NULL, "/a/\x05"}, {"/a/zz", "/b/"}, {"/b/z", NULL}};
+    for (size_t i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+        VisitCheck range = {NULL, 0, true};
+        CHECK(visitRadixRange(tree, bounds[i][0], bounds[i][1], checkOrder, &range) == 0);
+        CHECK(range.ordered && range.visited == countInRange(keys, NUM_KEYS, bounds[i][0], bounds[i][1], NULL));
+    }
+
+    //Longest prefix, byte wise and the key itself included
+    char shortKey[] = "/b/";
+    char midKey[] = "/b/long/";
+    addToRadixTree(tree, shortKey, shortKey);
+    addToRadixTree(tree, midKey, midKey);
+    char* matched = NULL;
+    CHECK(findLongestPrefixInRadixTree(tree, "/b/long/shared/path/11/x", &matched) == keys[11]);
+    CHECK(matched == keys[11]);
+    CHECK(findLongestPrefixInRadixTree(tree, "/b/long/shared/pa", &matched) == midKey);
+    CHECK(matched == midKey);
+    CHECK(findLongestPrefixInRadixTree(tree, "/b/lo", NULL) == shortKey);
+    CHECK(findLongestPrefixInRadixTree(tree, "/b", NULL) == NULL);
+    CHECK(findLongestPrefixInRadixTree(tree, "/c/long/", NULL) == NULL);
+    removeFromRadixTree(tree, midKey);
+    CHECK(findLongestPrefixInRadixTree(tree, "/b/long/shared", NULL) == shortKey);
+    removeFromRadixTree(tree, shortKey);
+    CHECK(tree->count == NUM_KEYS);
+
+    //Remove half, so wide nodes shrink and chains merge, then the rest
+    for (int i = 0; i < NUM_KEYS; i += 2) {
+        removeFromRadixTree(tree, keys[i]);
+    }
+    removeFromRadixTree(tree, "/a/missing");
+    CHECK(tree->count == NUM_KEYS / 2);
+    for (int i = 0; i < NUM_KEYS; i++) {
+        CHECK(findInRadixTree(tree, keys[i]) == (i % 2 == 0 ? NULL : keys[i]));
+    }
+    VisitCheck half = {NULL, 0, true};
+    visitRadixTree(tree, checkOrder, &half);
+    CHECK(half.ordered && half.visited == NUM_KEYS / 2);
+
+    for (int i = 1; i < NUM_KEYS; i += 2) {
+        removeFromRadixTree(tree, keys[i]);
+    }
+    CHECK(tree->count == 0);
+    CHECK(findInRadixTree(tree, keys[1]) == NULL);
+
+    //The emptied tree takes keys again
+    for (int i = 0; i < NUM_KEYS; i++) {
+        addToRadixTree(tree, keys[i], keys[i]);
+    }
+    CHECK(tree->count == NUM_KEYS);
+    for (int i = 0; i < NUM_KEYS; i++) {
+        CHECK(findInRadixTree(tree, keys[i]) == keys[i]);
+    }
+
+    destroyRadixTree(tree);
+    return TEST_RESULT();
+}
@@ -0,0 +1,151 @@
+/**
+ * Round-trip checks for StoreAPI: random puts and removes checked against an
+ * array model through gets and range visits, before and after the background
+ * flushes and compactions, and again after the store is closed and reopened.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "../StoreAPI.h"
+#include "TestHarness.h"
+
+#define NUM_KEYS 2000
+#define KEY_CHARS 16
+#define ROUNDS 4
+#define OPERATIONS 8000
+#define MEMTABLE_BYTES 16384    //Small enough that every round flushes several runs
+
+static char* model[NUM_KEYS];    //Value stored under each key, NULL if it is not in the store
+
+typedef struct rangeCheck {
+    int previous;    //Index of the last key visited
+    int visited;
+    bool matches;
+} RangeCheck;
+
+static int checkEntry(const char* key, const void* value, size_t length, void* context) {
+    RangeCheck* check = context;
+    int index = atoi(key + 1);
+    check->matches &= index > check->previous && model[index] != NULL
+                      && length == strlen(model[index]) && (length == 0 || memcmp(value, model[index], length) == 0);
+    check->previous = index;
+    check->visited++;
+    return 0;
+}
+
+/**
+ * Checks every key with a get, and the whole store and one slice of it with range visits
+ */
+static void checkStore(Store* store) {
+    char key[KEY_CHARS];
+    for (int i = 0; i < NUM_KEYS; i++) {
+        snprintf(key, KEY_CHARS, "k%05d", i);
+        size_t length = 0;
+        char* value = getFromStore(store, key, &length);
+        CHECK((value != NULL) == (model[i] != NULL));
+        CHECK(value == NULL || (length == strlen(model[i]) && memcmp(value, model[i], length) == 0));
+        free(value);
+    }
+
+    int stored = 0;
+    int inSlice = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        stored += model[i] != NULL;
+        inSlice += model[i] != NULL && i >= 500 && i <= 999;
+    }
+
+    RangeCheck all = {-1, 0, true};
+    CHECK(visitStoreRange(store, NULL, NULL, checkEntry, &all) == 0);
+    CHECK(all.matches && all.visited == stored);
+
+    RangeCheck slice = {499, 0, true};
+    CHECK(visitStoreRange(store, "k00500", "k00999", checkEntry, &slice) == 0);
+    CHECK(slice.matches && slice.visited == inSlice);
+}
+
+/**
+ * Deletes the files of a store and then its directory
+ */
+static void removeDirectory(const char* path) {
+    DIR* directory = opendir(path);
+    struct dirent* file;
+
+    while (directory != NULL && (file = readdir(directory)) != NULL) {
+        if (file->d_name[0] != '.') {
+            size_t length = strlen(path) + strlen(file->d_name) + 2;
+            char* name = malloc(length);
+            if (name != NULL) {
+                snprintf(name, length, "%s/%s", path, file->d_name);
+                unlink(name);
+                free(name);
+            }
+        }
+    }
+    if (directory != NULL) {
+        closedir(directory);
+    }
+    rmdir(path);
+}
+
+int main(void) {
+    char directory[] = "/tmp/StoreTestXXXXXX";
+    if (mkdtemp(directory) == NULL) {
+        fprintf(stderr, "StoreTest: cannot create a directory in /tmp\n");
+        return 1;
+    }
+
+    unsigned long long state = TEST_SEED;
+    char key[KEY_CHARS];
+    Store* store = openStore(directory, MEMTABLE_BYTES);
+    CHECK(store != NULL);
+
+    for (int round = 0; round < ROUNDS && store != NULL; round++) {
+        for (int i = 0; i < OPERATIONS; i++) {
+            int index = (int)(nextRandom(&state) % NUM_KEYS);
+            snprintf(key, KEY_CHARS, "k%05d", index);
+            free(model[index]);
+            model[index] = NULL;
+
+            if (nextRandom(&state) % 4 == 0) {
+                CHECK(removeFromStore(store, key));
+            }
+            else {
+                char value[48];
+                int length = (int)(nextRandom(&state) % 40);
+                for (int j = 0; j < length; j++) {
+                    value[j] = (char)('a' + nextRandom(&state) % 26);
+                }
+                value[length] = '\0';
+                CHECK(putInStore(store, key, value, length));
+                model[index] = strdup(value);
+            }
+        }
+        checkStore(store);
+
+        CHECK(flushStore(store));
+        CHECK(waitForStore(store));
+        checkStore(store);
+
+        //Everything written must survive a reopen
+        CHECK(closeStore(store));
+        store = openStore(directory, MEMTABLE_BYTES);
+        CHECK(store != NULL);
+        if (store != NULL) {
+            checkStore(store);
+        }
+    }
+
+    StoreStats stats = getStoreStats(store);
+    CHECK(stats.runs > 0);
+    if (store != NULL) {
+        CHECK(closeStore(store));
+    }
+
+    removeDirectory(directory);
+    for (int i = 0; i < NUM_KEYS; i++) {
+        free(model[i]);
+    }
+    return TEST_RESULT();
+}
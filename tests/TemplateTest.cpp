@@ -0,0 +1,168 @@
+/**
+ * Round-trip checks for the header-only templates in cpp/: random inserts
+ * and removes checked against the standard containers. The hash table runs
+ * with a hasher that piles keys into a few probe runs, so removal has to
+ * close the gaps it leaves.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "../cpp/HashTable.hpp"
+#include "../cpp/List.hpp"
+#include "../cpp/PriorityQueue.hpp"
+#include "../cpp/Tree.hpp"
+#include "TestHarness.h"
+
+namespace {
+
+constexpr int NUM_KEYS = 2000;
+constexpr int OPERATIONS = 20000;
+
+/**
+ * Sends every key to one of eight home slots
+ */
+struct CollidingHash {
+    std::size_t operator()(int key) const {
+        return static_cast<std::size_t>(key % 8) * 97;
+    }
+};
+
+template <typename Hash>
+void testHashTable() {
+    ds::HashTable<int, std::string, Hash> table(4);
+    std::map<int, std::string> model;
+    unsigned long long state = TEST_SEED;
+
+    for (int i = 0; i < OPERATIONS; i++) {
+        int key = static_cast<int>(nextRandom(&state) % (NUM_KEYS / 4));
+        if (nextRandom(&state) % 3 == 0) {
+            CHECK(table.remove(key) == (model.erase(key) == 1));
+        }
+        else {
+            std::string value = std::to_string(i);
+            CHECK(table.insert(key, value) == model.emplace(key, value).second);
+        }
+        CHECK(table.size() == model.size());
+    }
+
+    for (int key = 0; key < NUM_KEYS / 4; key++) {
+        const std::string* found = table.find(key);
+        auto expected = model.find(key);
+        CHECK((found != nullptr) == (expected != model.end()));
+        CHECK(found == nullptr || *found == expected->second);
+    }
+
+    std::size_t visited = 0;
+    table.forEach([&](const int& key, std::string& value) {
+        CHECK(model.count(key) == 1 && model[key] == value);
+        visited++;
+    });
+    CHECK(visited == model.size());
+}
+
+void testTree() {
+    ds::Tree<int> tree;
+    std::set<int> model;
+    unsigned long long state = TEST_SEED;
+
+    for (int i = 0; i < OPERATIONS; i++) {
+        int key = static_cast<int>(nextRandom(&state) % NUM_KEYS);
+        if (nextRandom(&state) % 3 == 0) {
+            CHECK(tree.remove(key) == (model.erase(key) == 1));
+        }
+        else {
+            CHECK(tree.insert(key) == model.insert(key).second);
+        }
+    }
+
+    CHECK(tree.size() == model.size());
+    CHECK(std::equal(tree.begin(), tree.end(), model.begin(), model.end()));
+    for (int key = 0; key < NUM_KEYS; key++) {
+        const int* found = tree.find(key);
+        CHECK((found != nullptr) == (model.count(key) == 1));
+    }
+
+    //An AVL tree of n elements is never taller than about 1.44 log2(n)
+    int limit = 0;
+    for (std::size_t n = tree.size() + 2; n > 1; n /= 2) {
+        limit++;
+    }
+    CHECK(tree.height() <= limit * 3 / 2);
+
+    int stops = 0;
+    CHECK(!tree.visitInOrder([&](int) { return ++stops < 5; }));
+    CHECK(stops == 5);
+
+    tree.clear();
+    CHECK(tree.empty() && tree.begin() == tree.end());
+}
+
+void testPriorityQueue() {
+    unsigned long long state = TEST_SEED;
+    std::vector<int> items;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        items.push_back(static_cast<int>(nextRandom(&state) % 500));
+    }
+
+    ds::PriorityQueue<int> queue(items);
+    for (int i = 0; i < NUM_KEYS / 2; i++) {
+        int value = static_cast<int>(nextRandom(&state) % 500);
+        queue.insert(value);
+        items.push_back(value);
+    }
+    std::sort(items.begin(), items.end());
+
+    std::vector<int> popped;
+    while (popped.size() < items.size() / 2) {
+        CHECK(queue.peek() == items[popped.size()]);
+        popped.push_back(queue.pop());
+    }
+    CHECK(queue.popBatch(items.size(), std::back_inserter(popped)) == items.size() - items.size() / 2);
+    CHECK(queue.empty());
+    CHECK(popped == items);
+}
+
+void testList() {
+    ds::List<int> list;
+    std::multiset<int> model;
+    unsigned long long state = TEST_SEED;
+
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int value = static_cast<int>(nextRandom(&state) % 300);
+        list.insertSorted(value);
+        model.insert(value);
+    }
+    for (int value = 0; value < 300; value += 7) {
+        bool present = model.count(value) > 0;
+        if (present) {
+            model.erase(model.find(value));
+        }
+        CHECK(list.remove(value) == present);
+    }
+
+    CHECK(list.size() == model.size());
+    CHECK(std::equal(list.begin(), list.end(), model.begin(), model.end()));
+    int* found = list.findIf([](const int& value) { return value > 150; });
+    CHECK(found != nullptr && *found == *model.upper_bound(150));
+
+    list.insertFront(-1);
+    list.insertBack(1000);
+    CHECK(list.front() == -1 && list.back() == 1000);
+    CHECK(list.popFront() == -1);
+    CHECK(list.popFront() == *model.begin());
+}
+
+}  // namespace
+
+int main() {
+    testHashTable<std::hash<int>>();
+    testHashTable<CollidingHash>();
+    testTree();
+    testPriorityQueue();
+    testList();
+    return TEST_RESULT();
+}
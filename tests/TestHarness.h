@@ -0,0 +1,44 @@
+/**
+ * Minimal checks for the round-trip tests in tests/. Unlike assert, CHECK
+ * stays on in Release builds and a failed check does not stop the test,
+ * so one run reports every broken expectation.
+ */
+#ifndef TESTS_TESTHARNESS_H
+#define TESTS_TESTHARNESS_H
+
+#include <stdio.h>
+
+static int testFailures = 0;
+
+/**
+ * Reports condition with its file and line if it does not hold
+ */
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+/**
+ * Seed of the xorshift generators, so every run of a test sees the same keys
+ */
+#define TEST_SEED 88172645463325252ULL
+
+/**
+ * Advances a xorshift generator and returns its next value
+ */
+static inline unsigned long long nextRandom(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * Exit status for main: 0 when every check held
+ */
+#define TEST_RESULT() (testFailures == 0 ? 0 : 1)
+
+#endif //TESTS_TESTHARNESS_H
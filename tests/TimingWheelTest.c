@@ -0,0 +1,109 @@
+/**
+ * Round-trip checks for TimingWheelAPI: timers spread over every level of
+ * the wheel, some cancelled, come due exactly once, neither before nor after
+ * the advance that reaches their deadline, while time moves in uneven steps.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "../TimingWheelAPI.h"
+#include "TestHarness.h"
+
+#define NUM_TIMERS 5000
+#define BATCH 64
+
+typedef struct expected {
+    TimerTick deadline;
+    Timer* handle;
+    int collected;    //Times the timer came due
+    bool cancelled;
+} Expected;
+
+/**
+ * Collects every due timer, checking it was due in (previous, now]
+ */
+static void drain(TimingWheel* wheel, TimerTick previous) {
+    void* out[BATCH];
+    int collected;
+    while ((collected = collectExpired(wheel, out, BATCH)) > 0) {
+        for (int i = 0; i < collected; i++) {
+            Expected* timer = out[i];
+            CHECK(!timer->cancelled);
+            CHECK(timer->deadline <= wheel->now);
+            CHECK(timer->deadline > previous || previous == 0);
+            timer->collected++;
+        }
+    }
+}
+
+int main(void) {
+    static Expected timers[NUM_TIMERS];
+    unsigned long long state = TEST_SEED;
+    TimerTick start = 1000;
+    TimingWheel* wheel = createTimingWheel(NULL, start);
+    CHECK(wheel != NULL);
+    CHECK(nextTimerDeadline(wheel) == ULLONG_MAX);
+
+    //Deadlines from the past to 2^40 ticks ahead, so every level and the cascades are used
+    for (int i = 0; i < NUM_TIMERS; i++) {
+        int bits = (int)(nextRandom(&state) % 40);
+        timers[i].deadline = start - 10 + nextRandom(&state) % (2ULL << bits);
+        timers[i].handle = scheduleTimer(wheel, timers[i].deadline, &timers[i]);
+        CHECK(timers[i].handle != NULL);
+    }
+    CHECK(getTimerCount(wheel) == NUM_TIMERS);
+
+    int cancelled = 0;
+    for (int i = 0; i < NUM_TIMERS; i += 3) {
+        CHECK(cancelTimer(wheel, timers[i].handle) == &timers[i]);
+        timers[i].cancelled = true;
+        cancelled++;
+    }
+    CHECK(getTimerCount(wheel) == NUM_TIMERS - cancelled);
+
+    //Timers already due at creation time come out first
+    drain(wheel, 0);
+
+    TimerTick previous = wheel->now;
+    while (getTimerCount(wheel) > 0) {
+        TimerTick earliest = ULLONG_MAX;
+        for (int i = 0; i < NUM_TIMERS; i++) {
+            if (!timers[i].cancelled && timers[i].collected == 0 && timers[i].deadline < earliest) {
+                earliest = timers[i].deadline;
+            }
+        }
+        CHECK(nextTimerDeadline(wheel) <= earliest);
+
+        //Steps of one tick up to far jumps, sometimes landing right on the earliest deadline
+        TimerTick step = 1 + nextRandom(&state) % (1ULL << (nextRandom(&state) % 36));
+        TimerTick target = nextRandom(&state) % 2 == 0 && earliest != ULLONG_MAX ? earliest : previous + step;
+        if (target <= previous) {
+            target = previous + 1;
+        }
+        advanceTimingWheel(wheel, target);
+        CHECK(wheel->now == target);
+        drain(wheel, previous);
+        previous = target;
+    }
+
+    for (int i = 0; i < NUM_TIMERS; i++) {
+        CHECK(timers[i].collected == (timers[i].cancelled ? 0 : 1));
+    }
+    CHECK(nextTimerDeadline(wheel) == ULLONG_MAX);
+
+    //expireTimers advances and collects in one call
+    Expected late = {previous + 100, NULL, 0, false};
+    late.handle = scheduleTimer(wheel, late.deadline, &late);
+    void* out[BATCH];
+    CHECK(expireTimers(wheel, previous + 99, out, BATCH) == 0);
+    CHECK(expireTimers(wheel, previous + 100, out, BATCH) == 1);
+    CHECK(out[0] == &late);
+
+    //Pending timers are released with the wheel even without a delete function
+    CHECK(scheduleTimer(wheel, wheel->now, &late) != NULL);
+    CHECK(scheduleTimer(wheel, previous + 1000, &late) != NULL);
+    CHECK(scheduleTimer(wheel, previous + (1ULL << 30), &late) != NULL);
+
+    destroyTimingWheel(wheel);
+    return TEST_RESULT();
+}